@@ -16,12 +16,19 @@
 # specify `all` as our default rule
 all:
 
-# Directory for built output.
-BUILDDIR ?= build
-
 # Build settings.
 include $(TOCK_USERLAND_BASE_DIR)/Configuration.mk
 
+# Directory for built output, one per build profile.
+BUILDDIR ?= build$(BUILD_VARIANT)
+
+# Size reports (`make size-report`). Baselines are saved per build profile by
+# `make size-baseline`, and can be committed with the app so that size growth
+# is caught in review. Set `SIZE_GROWTH_LIMIT` to a number of bytes to make
+# `size-report` fail if flash use grows by more than that.
+SIZE_REPORT := $(TOCK_USERLAND_BASE_DIR)/tools/size_report/size_report.py
+SIZE_BASELINE_DIR ?= size-baseline$(BUILD_VARIANT)
+
 # Helper functions.
 include $(TOCK_USERLAND_BASE_DIR)/Helpers.mk
 
@@ -101,7 +108,7 @@ endif
 
 # Add arch-specific dependencies for the library to ensure the library is built.
 # Use the $(LIBNAME)_BUILDDIR as build directory, if set.
-$$(notdir $(1))_BUILDDIR ?= $(1)/build
+$$(notdir $(1))_BUILDDIR ?= $(1)/build$$(BUILD_VARIANT)
 $$(foreach arch, $$(TOCK_ARCHS), $$(eval LIBS_$$(arch) += $$($(notdir $(1))_BUILDDIR)/$$(arch)/$(notdir $(1)).a))
 
 # Generate rule for building the library.
@@ -245,6 +252,25 @@ size-$(1)-$(2):	$$(BUILDDIR)/$(1)/$(2).elf
 
 size::	size-$(1)-$(2)
 
+# Per-library and per-symbol size breakdown from the linker map, compared with
+# the baseline saved by `make size-baseline`, if there is one.
+.PHONY: size-report-$(1)-$(2)
+size-report-$(1)-$(2): $$(BUILDDIR)/$(1)/$(2).elf
+	$$(Q)$$(SIZE_REPORT) $$(if $$(SIZE_GROWTH_LIMIT),--limit $$(SIZE_GROWTH_LIMIT))\
+	    --baseline $$(SIZE_BASELINE_DIR)/$(2).json\
+	    --output $$(BUILDDIR)/$(1)/$(2).size.json\
+	    $$(BUILDDIR)/$(1)/$(2).Map
+
+size-report::	size-report-$(1)-$(2)
+
+.PHONY: size-baseline-$(1)-$(2)
+size-baseline-$(1)-$(2): $$(BUILDDIR)/$(1)/$(2).elf
+	$$(Q)mkdir -p $$(SIZE_BASELINE_DIR)
+	$$(Q)$$(SIZE_REPORT) --output $$(SIZE_BASELINE_DIR)/$(2).json $$(BUILDDIR)/$(1)/$(2).Map > /dev/null
+	@echo Saved size baseline $$(SIZE_BASELINE_DIR)/$(2).json
+
+size-baseline::	size-baseline-$(1)-$(2)
+
 
 ############################################################################################
 # DEBUGGING STUFF
@@ -373,8 +399,20 @@ SIZE_RULES = $(addprefix size-,$(TOCK_ARCH_FAMILIES))
 .PHONY:	all
 all:	$(BUILDDIR)/$(PACKAGE_NAME).tab $(SIZE_RULES)
 
-# The size target accumulates dependencies in the platform build rule creation
-.PHONY: size
+# The size, size-report and size-baseline targets accumulate dependencies in
+# the platform build rule creation
+.PHONY: size size-report size-baseline
+
+# Build the app with each build profile and report its size, to choose the
+# profile that fits. Run the app (or a benchmark such as
+# `examples/benchmarks/compute`) built with each profile to compare speed.
+BUILD_PROFILES := size balanced speed
+.PHONY: size-profiles
+size-profiles:
+	$(Q)for profile in $(BUILD_PROFILES); do\
+	  echo "$$(tput bold)Build profile $$profile$$(tput sgr0)";\
+	  $(MAKE) --no-print-directory BUILD_PROFILE=$$profile $(SIZE_RULES) || exit 1;\
+	done
 
 # Generate helpful output for debugging userland applications.
 .PHONY: debug
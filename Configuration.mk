@@ -160,6 +160,52 @@ else
 endif
 
 
+# Build profiles.
+#
+# `BUILD_PROFILE` selects how the app and every library it is linked with are
+# optimized, trading flash for speed:
+#
+#   - `size` (default): `-Os`.
+#   - `balanced`: `-O2` with link-time optimization.
+#   - `speed`: `-O3` with link-time optimization.
+#
+# Link-time optimization (LTO) compiles the app, libtock, libtock-sync and any
+# `EXTERN_LIBS` as one program, so calls into the libraries can be inlined and
+# unused code dropped across them. `LTO=1` or `LTO=0` overrides the profile's
+# choice. It is only used with GCC. Libraries are built with
+# `-ffat-lto-objects` so their archives also link without LTO, and the final
+# link is run with the same PIC flags as the compile, so code generated at link
+# time keeps the Tock PIC conventions.
+#
+# Builds with any other settings than the default go in their own build
+# directories (`build/<profile>[-lto]`), so switching profiles never mixes
+# objects compiled with different flags.
+BUILD_PROFILE ?= size
+ifeq ($(BUILD_PROFILE),size)
+  OPTIMIZATION_FLAGS := -Os
+  LTO_DEFAULT := 0
+else ifeq ($(BUILD_PROFILE),balanced)
+  OPTIMIZATION_FLAGS := -O2
+  LTO_DEFAULT := 1
+else ifeq ($(BUILD_PROFILE),speed)
+  OPTIMIZATION_FLAGS := -O3
+  LTO_DEFAULT := 1
+else
+  $(error Unknown BUILD_PROFILE "$(BUILD_PROFILE)", expected size, balanced or speed)
+endif
+USE_LTO := $(if $(LTO),$(LTO),$(LTO_DEFAULT))
+
+ifeq ($(BUILD_PROFILE)-$(USE_LTO),size-0)
+  BUILD_VARIANT :=
+else ifeq ($(USE_LTO),1)
+  BUILD_VARIANT := /$(BUILD_PROFILE)-lto
+else
+  BUILD_VARIANT := /$(BUILD_PROFILE)
+endif
+
+# Libraries built by a sub-make (`EXTERN_LIBS`) must use the same profile.
+export BUILD_PROFILE LTO
+
 # Flags for building app Assembly, C, and C++ files used by all architectures.
 # n.b. CPPFLAGS are shared for C and C++ sources (it's short for C PreProcessor,
 # and C++ uses the C preprocessor). To specify flags for only C or C++, use
@@ -179,7 +225,7 @@ override CFLAGS  += -std=gnu2x
 override CPPFLAGS += \
       -frecord-gcc-switches\
       -gdwarf-2\
-      -Os\
+      $(OPTIMIZATION_FLAGS)\
       -fdata-sections -ffunction-sections\
       -fstack-usage\
       -D_FORTIFY_SOURCE=2\
@@ -206,6 +252,11 @@ LAYOUT ?= $(TOCK_USERLAND_BASE_DIR)/userland_generic.ld
 # will be greater than the allocated stack size.
 override CPPFLAGS_gcc += -Wstack-usage=$(STACK_SIZE)
 
+# Link-time optimization, see `BUILD_PROFILE` above.
+ifeq ($(USE_LTO),1)
+  override CPPFLAGS_gcc += -flto=auto -ffat-lto-objects
+endif
+
 # Generic PIC flags for architectures with compiler support for FDPIC. Note!
 # These flags are not sufficient for full PIC support as Tock requires. The
 # `-fPIC` flag generally only allows the .text and .data sections to be at
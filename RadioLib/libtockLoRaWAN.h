@@ -0,0 +1,290 @@
+/*
+  RadioLib Non-Arduino Tock Library LoRaWAN uplink service
+
+  Licensed under the MIT License
+
+  Wraps a RadioLib `LoRaWANNode` with:
+
+   - Session persistence: the join nonces and the session (keys, frame
+     counters) are stored in the Tock key-value store, so a restarted app
+     resumes its session instead of spending seconds of airtime re-joining.
+   - Uplink batching: readings are queued and packed into the largest uplink
+     the current data rate allows.
+   - A duty-cycle budget: uplinks are only attempted when the regional (or
+     network fair-use) airtime budget allows it.
+   - Airtime and energy metrics per uplink and per reading.
+
+  Usage:
+
+    TockLoRaWANService lorawan(&node);
+    lorawan.setDutyCycleBudget(TOCK_LORAWAN_BUDGET_TTN_FAIR_USE);
+    lorawan.join(joinEUI, devEUI, nwkKey, appKey);
+
+    for (;;) {
+      lorawan.queueReading(record, record_len);
+      lorawan.poll();
+      ...
+    }
+*/
+
+#ifndef TOCK_RADIOLIB_LORAWAN_H
+#define TOCK_RADIOLIB_LORAWAN_H
+
+#include <string.h>
+
+// include RadioLib
+#include <RadioLib.h>
+
+#include "libtock-sync/storage/kv.h"
+
+// Size of the queue holding readings waiting to be sent. Every reading uses one
+// byte of framing in addition to its payload.
+#ifndef TOCK_LORAWAN_QUEUE_SIZE
+#define TOCK_LORAWAN_QUEUE_SIZE 512
+#endif
+
+// LoRaWAN port used for batched uplinks.
+#ifndef TOCK_LORAWAN_FPORT
+#define TOCK_LORAWAN_FPORT 1
+#endif
+
+// Common duty-cycle budgets, in milliseconds of airtime per hour.
+//
+// EU868 sub-bands allow 1% duty cycle. The Things Network fair-use policy
+// allows 30 seconds of uplink airtime per day, i.e. 1250 ms per hour.
+#define TOCK_LORAWAN_BUDGET_EU868_1_PERCENT 36000
+#define TOCK_LORAWAN_BUDGET_TTN_FAIR_USE    1250
+
+// Keys used in the key-value store.
+#define TOCK_LORAWAN_KV_KEY_NONCES  "lorawan-nonces"
+#define TOCK_LORAWAN_KV_KEY_SESSION "lorawan-session"
+
+typedef struct {
+  // Number of successful joins and resumed sessions.
+  uint32_t joins;
+  uint32_t sessions_restored;
+  // Number of uplinks sent and how many failed.
+  uint32_t uplinks;
+  uint32_t uplink_errors;
+  // Readings queued, sent, and dropped because the queue was full.
+  uint32_t readings_queued;
+  uint32_t readings_sent;
+  uint32_t readings_dropped;
+  // Payload bytes sent over all uplinks.
+  uint32_t payload_bytes;
+  // Total time on air of all uplinks, in milliseconds.
+  uint32_t airtime_ms;
+  // Estimated radio energy of all uplinks, in microjoules.
+  uint64_t energy_uj;
+} tock_lorawan_stats_t;
+
+class TockLoRaWANService {
+  public:
+    // `tx_current_ma` and `supply_mv` are used to estimate the energy consumed
+    // while transmitting. The defaults match an SX1262 at 14 dBm.
+    TockLoRaWANService(LoRaWANNode* node, uint32_t tx_current_ma = 45, uint32_t supply_mv = 3300)
+      : node_(node), tx_current_ma_(tx_current_ma), supply_mv_(supply_mv) {
+      memset(&stats_, 0, sizeof(stats_));
+    }
+
+    // Set the airtime budget in milliseconds per hour. RadioLib enforces the
+    // budget and `poll()` will not attempt an uplink before it allows one.
+    void setDutyCycleBudget(uint32_t ms_per_hour) {
+      node_->setDutyCycle(true, ms_per_hour);
+    }
+
+    // Join the network, resuming a persisted session if one exists.
+    //
+    // Returns `RADIOLIB_LORAWAN_NEW_SESSION` or
+    // `RADIOLIB_LORAWAN_SESSION_RESTORED` on success, or a RadioLib error code.
+    int16_t join(uint64_t joinEUI, uint64_t devEUI, uint8_t* nwkKey, uint8_t* appKey) {
+      int16_t state;
+
+      node_->beginOTAA(joinEUI, devEUI, nwkKey, appKey);
+
+      // The nonces must be restored before the session, as RadioLib checks
+      // that the session belongs to them.
+      if (loadBuffer(TOCK_LORAWAN_KV_KEY_NONCES, buffer_, RADIOLIB_LORAWAN_NONCES_BUF_SIZE)) {
+        state = node_->setBufferNonces(buffer_);
+        if (state == RADIOLIB_ERR_NONE &&
+            loadBuffer(TOCK_LORAWAN_KV_KEY_SESSION, buffer_, RADIOLIB_LORAWAN_SESSION_BUF_SIZE)) {
+          node_->setBufferSession(buffer_);
+        }
+      }
+
+      state = node_->activateOTAA();
+      if (state == RADIOLIB_LORAWAN_SESSION_RESTORED) {
+        stats_.sessions_restored++;
+      } else if (state == RADIOLIB_LORAWAN_NEW_SESSION) {
+        stats_.joins++;
+        // A new join changes the nonces, save them right away so that a
+        // restart before the first uplink still resumes.
+        storeBuffer(TOCK_LORAWAN_KV_KEY_NONCES, node_->getBufferNonces(), RADIOLIB_LORAWAN_NONCES_BUF_SIZE);
+        storeSession();
+      }
+      return state;
+    }
+
+    // Add a reading to the uplink queue. Readings are sent whole and in order;
+    // the concatenation of readings must be a valid payload for the
+    // application (for example, CayenneLPP records).
+    //
+    // Returns false and counts a drop if the reading does not fit.
+    bool queueReading(const uint8_t* data, uint8_t len) {
+      if (len == 0 || queue_len_ + 1 + len > TOCK_LORAWAN_QUEUE_SIZE) {
+        stats_.readings_dropped++;
+        return false;
+      }
+      queue_[queue_len_] = len;
+      memcpy(&queue_[queue_len_ + 1], data, len);
+      queue_len_ += 1 + len;
+      queued_readings_++;
+      stats_.readings_queued++;
+      return true;
+    }
+
+    // Number of readings waiting to be sent.
+    uint32_t queuedReadings() {
+      return queued_readings_;
+    }
+
+    // Milliseconds until the duty-cycle budget allows the next uplink.
+    uint32_t timeUntilUplink() {
+      return node_->timeUntilUplink();
+    }
+
+    // Send an uplink if one is worthwhile and allowed.
+    //
+    // Without `force` an uplink is only sent once the queued readings fill a
+    // maximum-size frame at the current data rate, so each uplink's preamble
+    // and header overhead is shared by as many readings as possible. With
+    // `force`, any queued readings are sent as soon as the budget allows.
+    //
+    // Returns the number of readings sent, or a negative RadioLib error code.
+    int poll(bool force = false) {
+      if (queued_readings_ == 0) return 0;
+      if (node_->timeUntilUplink() > 0) return 0;
+
+      uint8_t max_len = node_->getMaxPayloadLen();
+      // `getMaxPayloadLen()` returns a `uint8_t`, so this always fits.
+      uint8_t frame[UINT8_MAX];
+      uint8_t frame_len = 0;
+      uint32_t consumed = 0;
+      uint32_t readings = 0;
+
+      // Pack whole readings into the frame.
+      while (consumed < queue_len_) {
+        uint8_t len = queue_[consumed];
+        if (frame_len + len > max_len) break;
+        memcpy(&frame[frame_len], &queue_[consumed + 1], len);
+        frame_len += len;
+        consumed  += 1 + len;
+        readings++;
+      }
+
+      if (readings == 0) {
+        // The oldest reading can never fit at this data rate.
+        dropReadings(queue_[0] + 1, 1);
+        stats_.readings_dropped++;
+        return 0;
+      }
+
+      // Wait for a full frame unless asked to flush.
+      if (!force && consumed == queue_len_ && frame_len + minReadingLen() <= max_len) {
+        return 0;
+      }
+
+      int16_t state = node_->sendReceive(frame, frame_len, TOCK_LORAWAN_FPORT);
+
+      // Account the airtime whether or not a downlink was received.
+      uint32_t toa = node_->getLastToA();
+      stats_.airtime_ms += toa;
+      stats_.energy_uj  += (uint64_t) toa * tx_current_ma_ * supply_mv_ / 1000;
+
+      if (state < RADIOLIB_ERR_NONE) {
+        stats_.uplink_errors++;
+        return state;
+      }
+
+      stats_.uplinks++;
+      stats_.readings_sent += readings;
+      stats_.payload_bytes += frame_len;
+      dropReadings(consumed, readings);
+
+      // Persist the frame counters so a restart does not reuse them.
+      storeSession();
+
+      return readings;
+    }
+
+    const tock_lorawan_stats_t* stats() {
+      return &stats_;
+    }
+
+    // Average airtime per delivered reading, in microseconds.
+    uint32_t airtimePerReadingUs() {
+      if (stats_.readings_sent == 0) return 0;
+      return (uint32_t) ((uint64_t) stats_.airtime_ms * 1000 / stats_.readings_sent);
+    }
+
+    // Average energy per delivered reading, in microjoules.
+    uint32_t energyPerReadingUj() {
+      if (stats_.readings_sent == 0) return 0;
+      return (uint32_t) (stats_.energy_uj / stats_.readings_sent);
+    }
+
+    // Forget the persisted session, forcing a new join on the next boot.
+    void forgetSession() {
+      libtocksync_kv_delete((const uint8_t*) TOCK_LORAWAN_KV_KEY_NONCES, strlen(TOCK_LORAWAN_KV_KEY_NONCES));
+      libtocksync_kv_delete((const uint8_t*) TOCK_LORAWAN_KV_KEY_SESSION, strlen(TOCK_LORAWAN_KV_KEY_SESSION));
+    }
+
+  private:
+    bool loadBuffer(const char* key, uint8_t* buf, uint32_t len) {
+      uint32_t value_len = 0;
+      if (!libtocksync_kv_exists()) return false;
+      returncode_t ret = libtocksync_kv_get((const uint8_t*) key, strlen(key), buf, len, &value_len);
+      return ret == RETURNCODE_SUCCESS && value_len == len;
+    }
+
+    void storeBuffer(const char* key, const uint8_t* buf, uint32_t len) {
+      if (!libtocksync_kv_exists()) return;
+      libtocksync_kv_set((const uint8_t*) key, strlen(key), buf, len);
+    }
+
+    void storeSession() {
+      storeBuffer(TOCK_LORAWAN_KV_KEY_SESSION, node_->getBufferSession(), RADIOLIB_LORAWAN_SESSION_BUF_SIZE);
+    }
+
+    // Length of the smallest queued reading.
+    uint8_t minReadingLen() {
+      uint8_t min_len = 0xFF;
+      for (uint32_t i = 0; i < queue_len_; i += 1 + queue_[i]) {
+        if (queue_[i] < min_len) min_len = queue_[i];
+      }
+      return min_len;
+    }
+
+    // Remove `bytes` bytes holding `readings` readings from the queue head.
+    void dropReadings(uint32_t bytes, uint32_t readings) {
+      memmove(queue_, &queue_[bytes], queue_len_ - bytes);
+      queue_len_       -= bytes;
+      queued_readings_ -= readings;
+    }
+
+    LoRaWANNode* node_;
+    uint32_t tx_current_ma_;
+    uint32_t supply_mv_;
+
+    uint8_t queue_[TOCK_LORAWAN_QUEUE_SIZE];
+    uint32_t queue_len_       = 0;
+    uint32_t queued_readings_ = 0;
+
+    // Scratch space for restoring persisted buffers.
+    uint8_t buffer_[RADIOLIB_LORAWAN_SESSION_BUF_SIZE > RADIOLIB_LORAWAN_NONCES_BUF_SIZE ?
+                    RADIOLIB_LORAWAN_SESSION_BUF_SIZE : RADIOLIB_LORAWAN_NONCES_BUF_SIZE];
+
+    tock_lorawan_stats_t stats_;
+};
+
+#endif
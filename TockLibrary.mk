@@ -29,8 +29,9 @@ $(call check_defined, LIBNAME)
 $(call check_defined, $(LIBNAME)_DIR)
 $(call check_defined, $(LIBNAME)_SRCS)
 
-# directory for built output
-$(LIBNAME)_BUILDDIR := $($(LIBNAME)_DIR)/build
+# directory for built output, one per build profile and, for libraries with
+# their own build options, one per `$(LIBNAME)_BUILD_VARIANT`
+$(LIBNAME)_BUILDDIR := $($(LIBNAME)_DIR)/build$(BUILD_VARIANT)$($(LIBNAME)_BUILD_VARIANT)
 
 # Handle complex paths.
 #
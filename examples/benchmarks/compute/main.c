@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock/services/benchmark.h>
+
+// CPU-bound kernels typical of sensor apps, to compare build profiles. Build
+// and run once per profile:
+//
+//   make BUILD_PROFILE=size
+//   make BUILD_PROFILE=speed
+
+#define SAMPLES 64
+#define TAPS 16
+
+static uint8_t data[256];
+static int32_t samples[SAMPLES + TAPS];
+static int32_t filtered[SAMPLES];
+static int32_t values[SAMPLES];
+
+// Low-pass filter coefficients in Q15.
+static const int16_t taps[TAPS] = {
+  -120, -340, -510, 0, 1650, 4210, 6800, 8100, 8100, 6800, 4210, 1650, 0, -510, -340, -120,
+};
+
+static volatile uint32_t sink;
+
+static void bench_crc32(__attribute__ ((unused)) void* context) {
+  uint32_t crc = 0xffffffff;
+  for (size_t i = 0; i < sizeof(data); i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+    }
+  }
+  sink = ~crc;
+}
+
+static void bench_fir(__attribute__ ((unused)) void* context) {
+  for (int i = 0; i < SAMPLES; i++) {
+    int32_t acc = 0;
+    for (int t = 0; t < TAPS; t++) {
+      acc += samples[i + t] * taps[t];
+    }
+    filtered[i] = acc >> 15;
+  }
+  sink = (uint32_t) filtered[SAMPLES / 2];
+}
+
+static void bench_sort(__attribute__ ((unused)) void* context) {
+  memcpy(values, samples, sizeof(values));
+  for (int i = 1; i < SAMPLES; i++) {
+    int32_t v = values[i];
+    int j     = i - 1;
+    while (j >= 0 && values[j] > v) {
+      values[j + 1] = values[j];
+      j--;
+    }
+    values[j + 1] = v;
+  }
+  sink = (uint32_t) values[SAMPLES / 2];
+}
+
+static void bench_snprintf(__attribute__ ((unused)) void* context) {
+  char text[48];
+  snprintf(text, sizeof(text), "t=%ld v=%d.%02d", (long) samples[3], (int) samples[5], (int) (samples[7] & 63));
+  sink = (uint8_t) text[4];
+}
+
+int main(void) {
+  uint32_t x = 1;
+  for (size_t i = 0; i < sizeof(data); i++) {
+    x       = x * 1103515245 + 12345;
+    data[i] = x >> 24;
+  }
+  for (int i = 0; i < SAMPLES + TAPS; i++) {
+    x          = x * 1103515245 + 12345;
+    samples[i] = (int32_t) (x >> 20) - 2048;
+  }
+
+  printf("{\"profile\":\"%s\",\"lto\":%d}\n", BUILD_PROFILE_NAME, BUILD_LTO);
+
+  libtock_benchmark_t benchmarks[] = {
+    LIBTOCK_BENCHMARK(crc32_256_bytes, bench_crc32, NULL),
+    LIBTOCK_BENCHMARK(fir_16_taps_64_samples, bench_fir, NULL),
+    LIBTOCK_BENCHMARK(insertion_sort_64, bench_sort, NULL),
+    LIBTOCK_BENCHMARK(snprintf, bench_snprintf, NULL),
+  };
+  libtock_benchmark_run_all(benchmarks, sizeof(benchmarks) / sizeof(benchmarks[0]));
+  return 0;
+}
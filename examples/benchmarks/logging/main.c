@@ -0,0 +1,64 @@
+#include <stdio.h>
+
+#include <libtock/services/benchmark.h>
+#include <libtock/services/log.h>
+
+// Cost of a binary log call compared to formatting the same message with
+// snprintf. The log buffer is emptied after every call, so only the encoding
+// is measured, not the console transfer.
+
+static uint8_t log_buffer[256];
+static char text[128];
+
+static volatile int sample = 1234;
+static const char* sensor  = "sensor0";
+// Keeps the compiler from turning snprintf into a string copy.
+static const char* volatile empty = "";
+
+static void discard_log(void) {
+  const uint8_t* data;
+  libtock_log_consume(libtock_log_peek(&data));
+}
+
+static void bench_log_no_args(__attribute__ ((unused)) void* context) {
+  libtock_log_info("link up");
+  discard_log();
+}
+
+static void bench_snprintf_no_args(__attribute__ ((unused)) void* context) {
+  snprintf(text, sizeof(text), "link up%s\n", empty);
+}
+
+static void bench_log_3_args(__attribute__ ((unused)) void* context) {
+  libtock_log_info("sample %d from %s: %u mV", sample, sensor, 3300u);
+  discard_log();
+}
+
+static void bench_snprintf_3_args(__attribute__ ((unused)) void* context) {
+  snprintf(text, sizeof(text), "sample %d from %s: %u mV\n", sample, sensor, 3300u);
+}
+
+int main(void) {
+  libtock_log_init(log_buffer, sizeof(log_buffer), LIBTOCK_LOG_OUTPUT_MANUAL);
+
+  libtock_benchmark_t benchmarks[] = {
+    LIBTOCK_BENCHMARK(log_no_args, bench_log_no_args, NULL),
+    LIBTOCK_BENCHMARK(snprintf_no_args, bench_snprintf_no_args, NULL),
+    LIBTOCK_BENCHMARK(log_3_args, bench_log_3_args, NULL),
+    LIBTOCK_BENCHMARK(snprintf_3_args, bench_snprintf_3_args, NULL),
+  };
+  libtock_benchmark_run_all(benchmarks, sizeof(benchmarks) / sizeof(benchmarks[0]));
+
+  // Bytes each message puts on the console.
+  libtock_log_info("sample %d from %s: %u mV", sample, sensor, 3300u);
+  uint32_t log_bytes = libtock_log_pending();
+  discard_log();
+  int text_bytes = snprintf(text, sizeof(text), "sample %d from %s: %u mV\n", sample, sensor, 3300u);
+  printf("{\"message\":\"sample\",\"log_bytes\":%lu,\"printf_bytes\":%d}\n", (unsigned long) log_bytes, text_bytes);
+
+  libtock_log_info("link up");
+  log_bytes = libtock_log_pending();
+  discard_log();
+  printf("{\"message\":\"link_up\",\"log_bytes\":%lu,\"printf_bytes\":%d}\n", (unsigned long) log_bytes, 8);
+  return 0;
+}
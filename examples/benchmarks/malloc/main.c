@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <libtock/services/benchmark.h>
+#include <libtock/tock.h>
+
+#ifdef USE_LIBALLOC
+#include <liballoc/alloc.h>
+#endif
+
+// Allocator benchmarks: fixed-size malloc/free pairs, a churn of mixed sizes
+// like a network stack or interpreter would make, and a growing realloc.
+// After the timed runs the app reports how much `brk` the allocator took.
+
+#define SLOTS 32
+
+static void* slots[SLOTS];
+static uint32_t seed = 1;
+
+static uint32_t next_random(void) {
+  seed = seed * 1103515245 + 12345;
+  return seed >> 16;
+}
+
+static uintptr_t heap_break(void) {
+  // memop 1 is sbrk, so an increment of 0 returns the current break.
+  return (uintptr_t) memop(1, 0).data;
+}
+
+static void bench_malloc_free(void* context) {
+  free(malloc((size_t) context));
+}
+
+// Replace a random slot with a block of a random size, mostly small.
+static void bench_churn(__attribute__ ((unused)) void* context) {
+  uint32_t r    = next_random();
+  uint32_t slot = r % SLOTS;
+  size_t size   = (r & 0x700) == 0 ? 256 + (r >> 4) % 1024 : 8 + (r >> 4) % 120;
+  free(slots[slot]);
+  slots[slot] = malloc(size);
+}
+
+static void free_slots(__attribute__ ((unused)) void* context) {
+  for (int i = 0; i < SLOTS; i++) {
+    free(slots[i]);
+    slots[i] = NULL;
+  }
+}
+
+// Grow a buffer 64 bytes at a time, like a string builder, then free it.
+static void bench_realloc(__attribute__ ((unused)) void* context) {
+  void* buffer = NULL;
+  for (size_t size = 64; size <= 1024; size += 64) {
+    buffer = realloc(buffer, size);
+  }
+  free(buffer);
+}
+
+int main(void) {
+  uintptr_t start = heap_break();
+
+  libtock_benchmark_t benchmarks[] = {
+    LIBTOCK_BENCHMARK(malloc_free_16, bench_malloc_free, (void*) 16),
+    LIBTOCK_BENCHMARK(malloc_free_200, bench_malloc_free, (void*) 200),
+    LIBTOCK_BENCHMARK(malloc_free_2048, bench_malloc_free, (void*) 2048),
+    {
+      .name     = "churn",
+      .body     = bench_churn,
+      .teardown = free_slots,
+    },
+    LIBTOCK_BENCHMARK(realloc_64_to_1024, bench_realloc, NULL),
+  };
+  libtock_benchmark_run_all(benchmarks, sizeof(benchmarks) / sizeof(benchmarks[0]));
+
+  // Heap taken at the peak of the churn, and what is left once it is freed.
+  for (int i = 0; i < 256; i++) {
+    bench_churn(NULL);
+  }
+  uintptr_t peak = heap_break();
+  free_slots(NULL);
+  uintptr_t after = heap_break();
+
+#ifdef USE_LIBALLOC
+  const char* allocator = "liballoc";
+#else
+  const char* allocator = "newlib";
+#endif
+  printf("{\"allocator\":\"%s\",\"heap_peak\":%lu,\"heap_after_free\":%lu}\n",
+         allocator, (unsigned long) (peak - start), (unsigned long) (after - start));
+
+#ifdef USE_LIBALLOC
+  libtock_alloc_stats_t stats;
+  libtock_alloc_get_stats(&stats);
+  printf("{\"heap_high_water\":%lu,\"allocations\":%lu,\"frees\":%lu,\"failed\":%lu,\"fragmentation\":%lu}\n",
+         (unsigned long) stats.heap_high_water, (unsigned long) stats.total_allocations,
+         (unsigned long) stats.total_frees, (unsigned long) stats.failed_allocations,
+         (unsigned long) stats.fragmentation_percent);
+#endif
+  return 0;
+}
@@ -0,0 +1,29 @@
+#include <stdio.h>
+
+#include <libtock-sync/services/alarm.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/tock.h>
+
+// Reports how long crt0 took to start this process, then restarts it so that
+// every restart produces a sample.
+
+// Give crt0 some data to load and BSS to zero.
+static uint8_t zeroed[4096];
+static uint32_t initialized[64] = {1};
+
+int main(void) {
+  uint32_t ticks = libtock_startup_ticks();
+  uint32_t frequency = 0;
+  libtock_alarm_command_get_frequency(&frequency);
+
+  unsigned long us = frequency != 0 ? (unsigned long) ((uint64_t) ticks * 1000000 / frequency) : 0;
+  printf("{\"startup_ticks\":%lu,\"hz\":%lu,\"us\":%lu,\"bss\":%u,\"data\":%u}\n",
+         (unsigned long) ticks, (unsigned long) frequency, us,
+         (unsigned) sizeof(zeroed), (unsigned) sizeof(initialized));
+
+  zeroed[0]++;
+  initialized[0]++;
+  libtocksync_alarm_delay_ms(1000);
+  tock_restart(0);
+  return 0;
+}
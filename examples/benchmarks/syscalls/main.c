@@ -0,0 +1,110 @@
+#include <stdlib.h>
+
+#include <libtock-sync/crypto/sha.h>
+#include <libtock-sync/peripherals/crc.h>
+#include <libtock-sync/peripherals/rng.h>
+#include <libtock/crypto/syscalls/sha_syscalls.h>
+#include <libtock/interface/syscalls/console_syscalls.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/peripherals/syscalls/crc_syscalls.h>
+#include <libtock/services/benchmark.h>
+#include <libtock/tock.h>
+
+// Core syscalls and blocking drivers. Every syscall here either does nothing
+// or undoes itself, so the benchmarks can run any number of times.
+
+static uint8_t buffer[64];
+
+static void bench_empty(__attribute__ ((unused)) void* context) {}
+
+static void bench_command(__attribute__ ((unused)) void* context) {
+  // Command 0 only checks that the driver exists.
+  command(DRIVER_NUM_ALARM, 0, 0, 0);
+}
+
+static void bench_yield_no_wait(__attribute__ ((unused)) void* context) {
+  yield_no_wait();
+}
+
+static void bench_memop(__attribute__ ((unused)) void* context) {
+  // sbrk(0)
+  memop(1, 0);
+}
+
+static void noop_upcall(__attribute__ ((unused)) int   arg0,
+                        __attribute__ ((unused)) int   arg1,
+                        __attribute__ ((unused)) int   arg2,
+                        __attribute__ ((unused)) void* ud) {}
+
+// The console subscribes to its write upcall before every write, so it is safe
+// to clear it here.
+static void bench_subscribe(__attribute__ ((unused)) void* context) {
+  subscribe(DRIVER_NUM_CONSOLE, 1, noop_upcall, NULL);
+  subscribe(DRIVER_NUM_CONSOLE, 1, NULL, NULL);
+}
+
+static void bench_allow_ro(__attribute__ ((unused)) void* context) {
+  allow_ro_return_t ret = allow_readonly(DRIVER_NUM_CONSOLE, 1, buffer, sizeof(buffer));
+  ret = allow_readonly(DRIVER_NUM_CONSOLE, 1, NULL, 0);
+  (void) ret;
+}
+
+static void bench_allow_rw(__attribute__ ((unused)) void* context) {
+  allow_rw_return_t ret = allow_readwrite(DRIVER_NUM_CONSOLE, 1, buffer, sizeof(buffer));
+  ret = allow_readwrite(DRIVER_NUM_CONSOLE, 1, NULL, 0);
+  (void) ret;
+}
+
+static void bench_alarm_read(__attribute__ ((unused)) void* context) {
+  uint32_t ticks;
+  libtock_alarm_command_read(&ticks);
+}
+
+static void bench_malloc_free(__attribute__ ((unused)) void* context) {
+  free(malloc(32));
+}
+
+static void bench_rng(__attribute__ ((unused)) void* context) {
+  int received;
+  libtocksync_rng_get_random_bytes(buffer, sizeof(buffer), 4, &received);
+}
+
+static void bench_crc(__attribute__ ((unused)) void* context) {
+  uint32_t crc;
+  libtocksync_crc_compute(buffer, sizeof(buffer), LIBTOCK_CRC_32, &crc);
+}
+
+static void bench_sha(__attribute__ ((unused)) void* context) {
+  uint8_t hash[32];
+  libtocksync_sha_simple_hash(LIBTOCK_SHA256, buffer, sizeof(buffer), hash, sizeof(hash));
+}
+
+int main(void) {
+  libtock_benchmark_t benchmarks[12] = {
+    LIBTOCK_BENCHMARK(empty, bench_empty, NULL),
+    LIBTOCK_BENCHMARK(command, bench_command, NULL),
+    LIBTOCK_BENCHMARK(yield_no_wait, bench_yield_no_wait, NULL),
+    LIBTOCK_BENCHMARK(memop, bench_memop, NULL),
+    LIBTOCK_BENCHMARK(subscribe_pair, bench_subscribe, NULL),
+    LIBTOCK_BENCHMARK(allow_ro_pair, bench_allow_ro, NULL),
+    LIBTOCK_BENCHMARK(allow_rw_pair, bench_allow_rw, NULL),
+    LIBTOCK_BENCHMARK(alarm_read, bench_alarm_read, NULL),
+    LIBTOCK_BENCHMARK(malloc_free_32, bench_malloc_free, NULL),
+  };
+  uint32_t count = 9;
+
+  // Blocking drivers, each a full command, upcall and yield round trip.
+  if (libtocksync_rng_exists()) {
+    benchmarks[count++] = (libtock_benchmark_t) LIBTOCK_BENCHMARK(rng_4_bytes, bench_rng, NULL);
+  }
+  // Only with the driver, not libtock-sync's software fallbacks.
+  if (libtock_crc_driver_exists()) {
+    benchmarks[count++] = (libtock_benchmark_t) LIBTOCK_BENCHMARK(crc32_64_bytes, bench_crc, NULL);
+  }
+  if (libtock_sha_driver_exists()) {
+    benchmarks[count++] = (libtock_benchmark_t) LIBTOCK_BENCHMARK(sha256_64_bytes, bench_sha, NULL);
+  }
+
+  libtock_benchmark_run_all(benchmarks, count);
+  return 0;
+}
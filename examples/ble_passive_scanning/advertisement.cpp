@@ -59,7 +59,11 @@ bool Advertisement::pduRxAddSet() const {
 }
 
 const char* Advertisement::pduTypeStr() const {
-  switch (pduType()) {
+  return pduTypeStr(pduType());
+}
+
+const char* Advertisement::pduTypeStr(unsigned char type) {
+  switch (type) {
     case 0:
       return "ADV_IND";
     case 1:
@@ -35,6 +35,7 @@ class Advertisement {
     bool operator!=(const Advertisement& other) const;
     unsigned char pduType() const;
     const char* pduTypeStr() const;
+    static const char* pduTypeStr(unsigned char type);
     bool pduTxAddSet() const;
     bool pduRxAddSet() const;
     unsigned char pduLength() const;
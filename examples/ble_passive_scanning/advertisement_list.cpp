@@ -1,44 +1,31 @@
 #include "advertisement_list.h"
 
-AdvertisementList::AdvertisementList()
-  : currentSize_(0) {
-  list_.resize(MAX_SIZE);
+AdvertisementList::AdvertisementList() {
+  libtock_ble_adv_table_init(&table_, devices_, MAX_SIZE, slots_, TABLE_SLOTS);
 }
 
-bool AdvertisementList::tryAdd(const Advertisement& advertisement) {
-  if (currentSize_ < MAX_SIZE && !containsDevice(advertisement)) {
-    list_.push_front(advertisement);
-    currentSize_ += 1;
-    return true;
-  } else {
-    return false;
-  }
-}
-
-bool AdvertisementList::containsDevice(const Advertisement& advertisement) const {
-  for (auto it = list_.begin(); it != list_.end(); ++it) {
-    if (it->device_detected(advertisement)) {
-      return true;
-    }
-  }
-  return false;
+// Records the advertisement without allocating, so this can be called from
+// the scan upcall however many advertisements arrive.
+libtock_ble_adv_update_t AdvertisementList::update(const libtock_ble_scan_packet_t* packet) {
+  return libtock_ble_adv_table_update(&table_, packet->pdu, packet->len, packet->rssi, packet->timestamp, nullptr);
 }
 
-bool AdvertisementList::tryUpdateData(const Advertisement& advertisement) {
-  for (auto it = list_.begin(); it != list_.end(); ++it) {
-    if (*it != advertisement) {
-      list_.remove(*it);
-      list_.push_front(advertisement);
-      return true;
-    }
-  }
-  return false;
-}
-
-void AdvertisementList::printList() const {
+void AdvertisementList::printList() {
   printf("--------------------------LIST-------------------------\r\n\r\n");
-  for (auto it = list_.begin(); it != list_.end(); ++it) {
-    it->print();
+  for (libtock_ble_adv_device_t* d = libtock_ble_adv_table_newest(&table_); d != nullptr;
+       d = libtock_ble_adv_table_older(&table_, d)) {
+    printf("Address: %02x %02x %02x %02x %02x %02x (%s)\r\n", d->address[5], d->address[4],
+           d->address[3], d->address[2], d->address[1], d->address[0],
+           d->random_address ? "random" : "public");
+    printf("PDU Type: %d %s\r\n", d->pdu_type, Advertisement::pduTypeStr(d->pdu_type));
+    printf("Seen: %lu times\r\n", static_cast<unsigned long>(d->seen));
+    printf("Data: ");
+    for (int i = 0; i < d->data_len; i++) {
+      printf("%02x ", d->data[i]);
+    }
+    printf("\r\n\r\n");
   }
+  printf("%d devices, %lu advertisements, %lu dropped\r\n", table_.count,
+         static_cast<unsigned long>(table_.updates), static_cast<unsigned long>(table_.evictions));
   printf("--------------------------END---------------------------\r\n\r\n");
 }
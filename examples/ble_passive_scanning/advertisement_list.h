@@ -1,24 +1,26 @@
 #pragma once
 
-#include <forward_list>
+#include <libtock/net/ble_adv_table.h>
 #include "advertisement.h"
 
 // this is left outside the class because it doesn't work
 // code-generation bug?!
-const int MAX_SIZE = 10;
+const int MAX_SIZE = 32;
+const int TABLE_SLOTS = 2 * MAX_SIZE;
 
+// Devices heard by the scanner, kept in a fixed-size hash table. When it is
+// full, the device heard least recently is dropped.
 class AdvertisementList {
   private:
-    int currentSize_;
-    std::forward_list<Advertisement> list_;
-    bool containsDevice(const Advertisement& advertisement) const;
-  
+    libtock_ble_adv_device_t devices_[MAX_SIZE];
+    uint16_t slots_[TABLE_SLOTS];
+    libtock_ble_adv_table_t table_;
+
   public:
     // Constructor
     AdvertisementList();
 
     // Methods
-    bool tryAdd(const Advertisement& advertisement);
-    bool tryUpdateData(const Advertisement& advertisement);
-    void printList() const;
+    libtock_ble_adv_update_t update(const libtock_ble_scan_packet_t* packet);
+    void printList();
 };
@@ -10,39 +10,40 @@
  * Passive scanner for Bluetooth Low Energy advertisements
  */
 
-const int BUF_SIZE = 39;
-static unsigned char scan[BUF_SIZE];
+// Capture buffers rotated by the scanner.
+const int NUM_PACKETS = 4;
+static libtock_ble_scan_packet_t packets[NUM_PACKETS];
+static libtock_ble_scanner_t scanner;
 AdvertisementList list;
+static bool new_device = false;
 
-static void callback(int result, int len, __attribute__((unused)) int unused2,
-                     __attribute__((unused)) void* ud) {
-  if (result == RETURNCODE_SUCCESS) {
-    if (Advertisement::checkScanResult(scan, len)) {
-      Advertisement advertisement(scan, len);
-
-      if (list.tryAdd(advertisement)) {
-        list.printList();
-      }
-      // FIXME: add this to get dynamic behavior i.e, update every time new advertisement is detected
-      // but might it fill the print buffer, use at your own risk
-      // else if (list.tryUpdateData(advertisement)) {
-      //   list.printList();
-      // }
-    }
+static void callback(libtock_ble_scan_packet_t* packet, __attribute__((unused)) void* ud) {
+  if (list.update(packet) == LIBTOCK_BLE_ADV_NEW) {
+    new_device = true;
   }
+  libtock_ble_scan_release(&scanner, packet);
 }
 
 int main(void) {
   printf("[Tutorial] BLE Passive Scanner\r\n");
 
-  // using the pre-configured advertisement interval
-  int err = ble_start_passive_scan(scan, BUF_SIZE, callback);
+  // using the pre-configured advertisement interval, without a filter
+  returncode_t err = libtock_ble_scan_start(&scanner, packets, NUM_PACKETS, nullptr, callback, nullptr);
 
   if (err < RETURNCODE_SUCCESS) {
-    printf("ble_start_passive_scan, error: %s\r\n", tock_strrcode(static_cast<returncode_t>(err)));
+    printf("libtock_ble_scan_start, error: %s\r\n", tock_strrcode(err));
   }
 
+  // Print outside of the upcall whenever a new device shows up. Printing
+  // every changed advertisement as well can overrun the console at high
+  // rates.
   while (1) {
-    yield();
+    yield_for(&new_device);
+    new_device = false;
+    list.printList();
+    printf("Scanner: %lu received, %lu dropped, %lu errors\r\n\r\n",
+           static_cast<unsigned long>(scanner.counters.received),
+           static_cast<unsigned long>(scanner.counters.dropped),
+           static_cast<unsigned long>(scanner.counters.errors));
   }
 }
@@ -12,6 +12,9 @@
 // include the hardware abstraction layer
 #include "libtockHal.h"
 
+// include the batching, session-persisting uplink service
+#include "libtockLoRaWAN.h"
+
 // Include some libtock-c helpers
 #include <libtock-sync/sensors/humidity.h>
 #include <libtock-sync/sensors/temperature.h>
@@ -28,6 +31,11 @@
 
 #define MAX_SIZE 10
 
+// Read the sensors every minute and force out whatever is queued at least once
+// an hour, even if it does not fill a full uplink.
+#define READING_INTERVAL_MINUTES 1
+#define MAX_BATCH_MINUTES        60
+
 // the entry point for the program
 int main(void) {
   CayenneLPP Payload(MAX_SIZE);
@@ -58,22 +66,28 @@ int main(void) {
     return 1;
   }
 
-  node.beginOTAA(joinEUI, devEUI, nwkKey, appKey);
+  TockLoRaWANService lorawan(&node);
+
+  // Respect The Things Network fair-use policy.
+  lorawan.setDutyCycleBudget(TOCK_LORAWAN_BUDGET_TTN_FAIR_USE);
 
-  state = node.activateOTAA();
+  state = lorawan.join(joinEUI, devEUI, nwkKey, appKey);
 
-  if (state != RADIOLIB_LORAWAN_NEW_SESSION) {
+  if (state == RADIOLIB_LORAWAN_SESSION_RESTORED) {
+    printf("session restored\r\n");
+  } else if (state == RADIOLIB_LORAWAN_NEW_SESSION) {
+    printf("joined\r\n");
+  } else {
     printf("activateOTAA failed, code %d\r\n", state);
     return 1;
   }
 
-  printf("success!\r\n");
-
   hal->detachInterrupt(RADIOLIB_RADIO_DIO_1);
   hal->pinMode(RADIOLIB_RADIO_DIO_1, TOCK_RADIOLIB_PIN_INPUT);
 
   int temp = 0;
   int humi = 0;
+  int minutes_since_uplink = 0;
 
   // loop forever
   for ( ;;) {
@@ -86,21 +100,23 @@ int main(void) {
     Payload.addTemperature(0, temp);
     Payload.addRelativeHumidity(0, humi);
 
-    printf("[SX1261] Transmitting\r\n");
+    lorawan.queueReading(Payload.getBuffer(), Payload.getSize());
 
-    state = node.sendReceive(Payload.getBuffer(), Payload.getSize());
+    state = lorawan.poll(minutes_since_uplink >= MAX_BATCH_MINUTES);
 
     if (state > 0) {
+      const tock_lorawan_stats_t* stats = lorawan.stats();
+
       // the packet was successfully transmitted
-      printf("success!\r\n");
-    } else {
+      printf("[SX1261] Sent %d readings, %lu ms on air, %lu uJ/reading\r\n",
+             state, stats->airtime_ms, lorawan.energyPerReadingUj());
+      minutes_since_uplink = 0;
+    } else if (state < 0) {
       printf("failed, code %d\r\n", state);
     }
 
-    printf("Waiting 60 minutes before transmitting again\r\n");
-    for (int i = 0; i < 60; i++) {
-      hal->delay(60 * 1000);
-    }
+    hal->delay(READING_INTERVAL_MINUTES * 60 * 1000);
+    minutes_since_uplink += READING_INTERVAL_MINUTES;
   }
 
   return 0;
@@ -1,63 +1,66 @@
-#include <ctype.h>
-#include <stdbool.h>
-#include <stdlib.h>
+#include <stdio.h>
 
 #include <lua/lauxlib.h>
 #include <lua/lua.h>
 #include <lua/lualib.h>
+#include <ltock/ltock.h>
 
 #include <libtock-sync/services/alarm.h>
 
-// POSIX wrapper for `nanosleep` to make this compilable and runnable on
-// Linux/OS X/BSD for testing.
-#if defined(__unix__)
-#include <time.h>
-void libtocksync_alarm_delay_ms(int ms) {
-  struct timespec ts;
-  ts.tv_sec  = 0;
-  ts.tv_nsec = (long)ms * 1000 * 1000;
-  nanosleep(&ts, NULL);
-}
+// All of the memory Lua may use. A script needing more fails with "not enough
+// memory" rather than taking memory from the rest of the app.
+static uint8_t lua_memory[16 * 1024];
+static libtock_lua_arena_t arena;
 
-#endif
+static void print_error(lua_State* L) {
+  printf("Lua error: %s\n", lua_tostring(L, -1));
+  lua_pop(L, 1);
+}
 
 int main(void) {
+  if (!libtock_lua_arena_init(&arena, lua_memory, sizeof(lua_memory))) {
+    return -1;
+  }
+
   // Open lua
-  lua_State* L = luaL_newstate();
+  lua_State* L = libtock_lua_newstate(&arena);
+  if (L == NULL) {
+    printf("Out of memory\n");
+    return -1;
+  }
 
   luaL_requiref(L, "_G", luaopen_base, true);
+  luaL_requiref(L, LUA_STRLIBNAME, luaopen_string, true);
+  lua_pop(L, 2);
+  libtock_lua_open_libs(L);
 
-  // Execution of a lua string
-  int err;
-  err = luaL_loadstring(L, "main = function() print(\"Hello from Lua!\") end");
+  // Collect sooner than Lua's default, which lets the heap double between
+  // cycles.
+  libtock_lua_gc_tune(L, 100, 200);
 
+  // Run main.lua, which the build compiled to bytecode.
+  int err = libtock_lua_load_script(L, "main");
+  if (err == LUA_OK) {
+    err = lua_pcall(L, 0, 0, 0);
+  }
   if (err != LUA_OK) {
-    switch (err) {
-      case LUA_ERRSYNTAX:
-        printf("Syntax error\n");
-        break;
-      case LUA_ERRMEM:
-        printf("Out of memory\n");
-        break;
-      case LUA_ERRGCMM:
-        printf("Garbage collection error\n");
-        break;
-      default:
-        printf("Unknown error %d\n", err);
-        break;
-    }
+    print_error(L);
     return -1;
   }
 
-  lua_call(L, 0, 0);
-
   while (1) {
     lua_getglobal(L, "main");
-    lua_call(L, 0, 0);
+    if (lua_pcall(L, 0, 0, 0) != LUA_OK) {
+      print_error(L);
+    }
+
+    // Do some collection work while idle rather than while the script runs.
+    libtock_lua_gc_idle(L, 1);
 
     int kb    = lua_gc(L, LUA_GCCOUNT, 0);
-    int bytes = lua_gc(L, LUA_GCCOUNT, 0);
-    printf("> %dKB and %d bytes used\n", kb, bytes);
+    int bytes = lua_gc(L, LUA_GCCOUNTB, 0);
+    printf("> %dKB and %d bytes used, at most %lu of %u bytes\n", kb, bytes,
+           (unsigned long) arena.high_water, (unsigned) sizeof(lua_memory));
     libtocksync_alarm_delay_ms(500);
   }
 
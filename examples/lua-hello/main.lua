@@ -0,0 +1,15 @@
+-- Runs once at startup. The app then calls `main` every half second.
+
+local count = 0
+
+function main()
+  count = count + 1
+  print("Hello from Lua! (" .. count .. ", " .. alarm.now_ms() .. " ms)")
+
+  local temperature, err = sensors.temperature()
+  if temperature then
+    print(string.format("  temperature %.2f C", temperature / 100))
+  else
+    print("  no temperature: " .. err)
+  end
+end
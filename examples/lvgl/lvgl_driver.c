@@ -1,6 +1,7 @@
 #include <lvgl/lvgl.h>
 
 #include <libtock-sync/display/screen.h>
+#include <libtock-sync/services/screen_flush.h>
 #include <libtock/sensors/touch.h>
 #include <libtock/services/alarm.h>
 #include <libtock/tock.h>
@@ -19,17 +20,29 @@ static uint16_t touch_x = 0, touch_y = 0;
 /* screen driver */
 static void screen_lvgl_driver(lv_display_t* disp, const lv_area_t* area,
                                uint8_t* buffer) {
-  void* ud = lv_display_get_user_data(disp);
-  uint32_t buffer_size = (uint32_t)ud;
   int32_t x, y;
   x = area->x1;
   y = area->y1;
   int w = area->x2 - area->x1 + 1;
   int h = area->y2 - area->y1 + 1;
-  libtocksync_screen_set_frame(x, y, w, h);
-  libtocksync_screen_write(buffer, buffer_size, (w * h) * PIXEL_SIZE);
 
-  lv_display_flush_ready(disp);           /* Indicate you are ready with the flushing*/
+  // Start the transfer and return, LVGL renders into the other buffer while
+  // this one is sent to the screen. `flush_done` tells LVGL when it is done.
+  returncode_t ret = libtock_screen_flush_submit(buffer, x, y, w, h, (w * h) * PIXEL_SIZE,
+                                                 lv_display_flush_is_last(disp));
+  if (ret != RETURNCODE_SUCCESS) {
+    lv_display_flush_ready(disp);
+  }
+}
+
+static void flush_done(__attribute__ ((unused)) returncode_t ret, __attribute__ ((unused)) uint8_t* buffer) {
+  lv_display_flush_ready(display_device); /* Indicate you are ready with the flushing*/
+}
+
+static void flush_wait(__attribute__ ((unused)) lv_display_t* disp) {
+  // LVGL busy-waits for `lv_display_flush_ready` by default, which would never
+  // let the screen upcall run.
+  libtocksync_screen_flush_wait();
 }
 
 static void touch_event(libtock_touch_status_t status, uint16_t x, uint16_t y) {
@@ -61,9 +74,16 @@ int lvgl_driver_init(int buffer_lines) {
   int error = libtock_screen_get_resolution(&width, &height);
   if (error != RETURNCODE_SUCCESS) return error;
 
+  // Two render buffers so drawing overlaps the screen transfer.
   uint32_t buffer_size = width * buffer_lines * PIXEL_SIZE;
-  uint8_t* buffer      = NULL;
-  error = libtock_screen_buffer_init(buffer_size, &buffer);
+  uint8_t* buffer_a    = NULL;
+  uint8_t* buffer_b    = NULL;
+  error = libtock_screen_buffer_init(buffer_size, &buffer_a);
+  if (error != RETURNCODE_SUCCESS) return error;
+  error = libtock_screen_buffer_init(buffer_size, &buffer_b);
+  if (error != RETURNCODE_SUCCESS) return error;
+
+  error = libtock_screen_flush_init(buffer_a, buffer_b, buffer_size, flush_done);
   if (error != RETURNCODE_SUCCESS) return error;
 
   /* initialize littlevgl */
@@ -72,10 +92,10 @@ int lvgl_driver_init(int buffer_lines) {
   display_device = lv_display_create(width, height);
   lv_display_set_color_format(display_device, LV_COLOR_FORMAT_RGB565);
   lv_display_set_flush_cb(display_device, screen_lvgl_driver);
+  lv_display_set_flush_wait_cb(display_device, flush_wait);
   lv_display_set_antialiasing(display_device, false);
 
-  lv_display_set_buffers(display_device, buffer, NULL, buffer_size, LV_DISPLAY_RENDER_MODE_PARTIAL);
-  lv_display_set_user_data(display_device, (void*)buffer_size);
+  lv_display_set_buffers(display_device, buffer_a, buffer_b, buffer_size, LV_DISPLAY_RENDER_MODE_PARTIAL);
 
   lv_tick_set_cb(tick_cb);
 
@@ -4,6 +4,7 @@
 
 #include <libtock-sync/display/screen.h>
 #include <libtock-sync/services/alarm.h>
+#include <libtock/services/screen_flush.h>
 #include <libtock/peripherals/syscalls/alarm_syscalls.h>
 
 #include "lvgl_driver.h"
@@ -14,6 +15,12 @@ static void tick_cb(lv_timer_t* timer) {
   seconds++;
   lv_obj_t* label1 = lv_timer_get_user_data(timer);
   lv_label_set_text_fmt(label1, "%lu", seconds);
+
+  if (seconds % 10 == 0) {
+    uint32_t fps = libtock_screen_flush_fps_x100();
+    printf("%lu.%02lu fps, %lu bytes/frame\n", fps / 100, fps % 100, libtock_screen_flush_bytes_per_frame());
+    libtock_screen_flush_reset_stats();
+  }
 }
 
 static void event_handler(lv_event_t* e) {
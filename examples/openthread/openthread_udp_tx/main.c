@@ -33,6 +33,9 @@ static void stateChangeCallback(uint32_t flags, void* context);
 // helper utility to print ip address
 static void print_ip_addr(otInstance* instance);
 
+// helper utility to print radio transmit statistics
+static void print_tx_stats(uint32_t elapsed_ms);
+
 int main(__attribute__((unused)) int argc, __attribute__((unused)) char* argv[]) {
   otSysInit(argc, argv);
   otInstance* instance;
@@ -66,8 +69,10 @@ int main(__attribute__((unused)) int argc, __attribute__((unused)) char* argv[])
   /* Start the Thread stack (CLI cmd -> thread start) */
   otThreadSetEnabled(instance, true);
 
-  uint32_t prev_time = 0;
-  uint32_t curr_time = 0;
+  uint32_t prev_time  = 0;
+  uint32_t curr_time  = 0;
+  uint32_t start_time = otPlatAlarmMilliGetNow();
+  uint32_t sent       = 0;
 
   for ( ;;) {
     // Send UDP packet every 2.5 seconds
@@ -75,6 +80,11 @@ int main(__attribute__((unused)) int argc, __attribute__((unused)) char* argv[])
     if (curr_time - prev_time > 2500) {
       sendUdp(instance);
       prev_time = curr_time;
+
+      // Report radio statistics every 10 packets
+      if (++sent % 10 == 0) {
+        print_tx_stats(curr_time - start_time);
+      }
     }
 
     // main loop work
@@ -188,3 +198,16 @@ static void print_ip_addr(otInstance* instance) {
     printf("%s\n", addr_string);
   }
 }
+
+static void print_tx_stats(uint32_t elapsed_ms) {
+  otTockTxStats stats;
+  otTockGetTxStats(&stats);
+
+  // Delivered frames per second and retries per frame, in hundredths.
+  uint32_t rate_x100    = elapsed_ms == 0 ? 0 : (uint32_t) ((uint64_t) stats.delivered * 100000 / elapsed_ms);
+  uint32_t retries_x100 = stats.frames == 0 ? 0 : stats.retries * 100 / stats.frames;
+
+  printf("tx: %lu frames, %lu delivered (%lu.%02lu/s), %lu.%02lu retries/frame, %lu no ack, %lu busy, %lu failed\n",
+         stats.frames, stats.delivered, rate_x100 / 100, rate_x100 % 100,
+         retries_x100 / 100, retries_x100 % 100, stats.no_ack, stats.channel_access_failures, stats.failed);
+}
@@ -1,8 +1,20 @@
 #include <libtock-sync/services/unit_test.h>
 #include <libtock/tock.h>
 
+// Number of test runners to run at the same time. Set with
+// `CFLAGS += -DUNIT_TEST_PARALLEL=4` for suites whose runners do not share
+// peripherals.
+#ifndef UNIT_TEST_PARALLEL
+#define UNIT_TEST_PARALLEL 1
+#endif
+
+// Print JSON lines with per-test timing and memory use instead of text.
+#ifndef UNIT_TEST_JSON
+#define UNIT_TEST_JSON 0
+#endif
+
 int main(void) {
-  unit_test_service();
+  unit_test_service_with_options(UNIT_TEST_PARALLEL, UNIT_TEST_JSON ? UnitTestJsonLines : UnitTestText);
 
   while (1) {
     yield();
@@ -0,0 +1,34 @@
+#include <stdio.h>
+
+#include <libtock-sync/interface/console_buffered.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+
+static uint8_t console_buffer[256];
+
+static void print_burst(const char* mode) {
+  uint32_t start, end;
+  libtock_alarm_command_read(&start);
+  for (int i = 0; i < 16; i++) {
+    printf("%s line %d\n", mode, i);
+  }
+  libtock_alarm_command_read(&end);
+  printf("%s: 16 lines in %lu ticks\n", mode, (unsigned long) (end - start));
+}
+
+int main(void) {
+  print_burst("blocking");
+
+  libtocksync_console_buffered_enable(console_buffer, sizeof(console_buffer), LIBTOCKSYNC_CONSOLE_BLOCK);
+  print_burst("buffered");
+  libtocksync_console_buffered_flush();
+
+  libtocksync_console_buffered_stats_t stats;
+  libtocksync_console_buffered_get_stats(&stats);
+  libtocksync_console_buffered_disable();
+
+  printf("bytes %lu, dropped %lu, transfers %lu, blocked %lu, high water %lu\n",
+         (unsigned long) stats.bytes_buffered, (unsigned long) stats.bytes_dropped,
+         (unsigned long) stats.transfers, (unsigned long) stats.blocked,
+         (unsigned long) stats.high_water);
+  return 0;
+}
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock-sync/crypto/aes.h>
+#include <libtock-sync/crypto/hmac.h>
+#include <libtock-sync/crypto/sha.h>
+#include <libtock-sync/peripherals/crc.h>
+#include <libtock/crypto/aes128_software.h>
+#include <libtock/crypto/hmac_sha256_software.h>
+#include <libtock/crypto/sha256_software.h>
+#include <libtock/crypto/syscalls/aes_syscalls.h>
+#include <libtock/crypto/syscalls/hmac_syscalls.h>
+#include <libtock/crypto/syscalls/sha_syscalls.h>
+#include <libtock/peripherals/crc_software.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/peripherals/syscalls/crc_syscalls.h>
+#include <libtock/services/alarm.h>
+#include <libtock/tock.h>
+
+#define INPUT_LEN 2048
+
+static uint8_t input[INPUT_LEN];
+static uint8_t hw_out[INPUT_LEN];
+static uint8_t sw_out[INPUT_LEN];
+
+static uint8_t key[16] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                          0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+static uint8_t iv[16] = {0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+                         0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff};
+
+static bool failed = false;
+
+static uint32_t now_ticks(void) {
+  uint32_t ticks;
+  libtock_alarm_command_read(&ticks);
+  return ticks;
+}
+
+static uint32_t bytes_per_second(uint32_t start) {
+  uint32_t ms = libtock_alarm_ticks_to_ms(now_ticks() - start);
+  if (ms == 0) ms = 1;
+  return (uint32_t) ((uint64_t) INPUT_LEN * 1000 / ms);
+}
+
+// Print one line. `hw_rate` is 0 if there is no driver, `ret` is the driver's
+// result, and `match` whether the driver and software outputs agree.
+static void report(const char* label, bool hw, returncode_t ret, uint32_t hw_rate, bool match, uint32_t sw_rate) {
+  printf("%-12s  ", label);
+  if (!hw) {
+    printf("hw         -        ");
+  } else if (ret != RETURNCODE_SUCCESS) {
+    printf("hw  %-16s", tock_strrcode(ret));
+    failed = true;
+  } else {
+    printf("hw  %8lu bytes/s ", (unsigned long) hw_rate);
+  }
+  printf("  sw  %8lu bytes/s", (unsigned long) sw_rate);
+  if (hw && ret == RETURNCODE_SUCCESS && !match) {
+    printf("  MISMATCH");
+    failed = true;
+  }
+  printf("\n");
+}
+
+static void test_sha(void) {
+  bool hw = libtock_sha_driver_exists();
+  returncode_t ret = RETURNCODE_SUCCESS;
+  uint32_t start, hw_rate = 0, sw_rate;
+
+  if (hw) {
+    start   = now_ticks();
+    ret     = libtocksync_sha_simple_hash(LIBTOCK_SHA256, input, INPUT_LEN, hw_out, 32);
+    hw_rate = bytes_per_second(start);
+  }
+
+  start = now_ticks();
+  libtock_sha256_software(input, INPUT_LEN, sw_out);
+  sw_rate = bytes_per_second(start);
+
+  report("SHA-256", hw, ret, hw_rate, memcmp(hw_out, sw_out, 32) == 0, sw_rate);
+}
+
+static void test_hmac(void) {
+  bool hw = libtock_hmac_driver_exists();
+  returncode_t ret = RETURNCODE_SUCCESS;
+  uint32_t start, hw_rate = 0, sw_rate;
+
+  if (hw) {
+    start   = now_ticks();
+    ret     = libtocksync_hmac_simple(LIBTOCK_HMAC_SHA256, key, sizeof(key), input, INPUT_LEN, hw_out, 32);
+    hw_rate = bytes_per_second(start);
+  }
+
+  start = now_ticks();
+  libtock_hmac_sha256_software(key, sizeof(key), input, INPUT_LEN, sw_out);
+  sw_rate = bytes_per_second(start);
+
+  report("HMAC-SHA256", hw, ret, hw_rate, memcmp(hw_out, sw_out, 32) == 0, sw_rate);
+}
+
+static void test_aes(void) {
+  bool hw = libtock_aes_driver_exists();
+  returncode_t ret = RETURNCODE_SUCCESS;
+  uint32_t start, hw_rate = 0, sw_rate;
+  libtock_aes128_software_t ctx;
+
+  if (hw) {
+    start   = now_ticks();
+    ret     = libtocksync_aes_crypt(LIBTOCK_AES128Ctr, true, key, sizeof(key), iv, sizeof(iv),
+                                    input, hw_out, INPUT_LEN);
+    hw_rate = bytes_per_second(start);
+  }
+
+  start = now_ticks();
+  libtock_aes128_software_init(&ctx, LIBTOCK_AES128_SOFTWARE_CTR, true, key, iv);
+  libtock_aes128_software_crypt(&ctx, input, sw_out, INPUT_LEN);
+  sw_rate = bytes_per_second(start);
+
+  report("AES-128 CTR", hw, ret, hw_rate, memcmp(hw_out, sw_out, INPUT_LEN) == 0, sw_rate);
+}
+
+static void test_crc(void) {
+  bool hw = libtock_crc_driver_exists();
+  returncode_t ret = RETURNCODE_SUCCESS;
+  uint32_t start, hw_rate = 0, sw_rate;
+  uint32_t hw_crc = 0, sw_crc;
+
+  if (hw) {
+    start   = now_ticks();
+    ret     = libtocksync_crc_compute(input, INPUT_LEN, LIBTOCK_CRC_32, &hw_crc);
+    hw_rate = bytes_per_second(start);
+  }
+
+  start   = now_ticks();
+  sw_crc  = libtock_crc_software_compute(input, INPUT_LEN, LIBTOCK_CRC_32);
+  sw_rate = bytes_per_second(start);
+
+  report("CRC-32", hw, ret, hw_rate, hw_crc == sw_crc, sw_rate);
+}
+
+int main(void) {
+  printf("[TEST] Software crypto, %d byte input\n", INPUT_LEN);
+
+  for (int i = 0; i < INPUT_LEN; i++) {
+    input[i] = i * 7 + (i >> 8);
+  }
+
+  test_sha();
+  test_hmac();
+  test_aes();
+  test_crc();
+
+  printf(failed ? "[FAIL]\n" : "[OK]\n");
+  return 0;
+}
@@ -0,0 +1,64 @@
+#include <stdio.h>
+
+#include <libtock-sync/services/alarm.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/services/alarm.h>
+#include <libtock/services/ipc_channel.h>
+#include <libtock/tock.h>
+
+#define DURATION_MS 2000
+#define MESSAGE_LEN 8
+
+static uint8_t buf[512] __attribute__((aligned(512)));
+static libtock_ipc_channel_t channel;
+
+static uint32_t acked  = 0;
+static bool ack_fired = false;
+
+static void on_ack(libtock_ipc_channel_t* ch) {
+  uint32_t count;
+  size_t len;
+  while (libtock_ipc_channel_receive(ch, &count, sizeof(count), &len) == RETURNCODE_SUCCESS) {
+    acked += count;
+  }
+  ack_fired = true;
+}
+
+static uint32_t now_ms(void) {
+  uint32_t ticks;
+  libtock_alarm_command_read(&ticks);
+  return libtock_alarm_ticks_to_ms(ticks);
+}
+
+int main(void) {
+  returncode_t ret;
+
+  // Give the service time to register.
+  libtocksync_alarm_delay_ms(500);
+
+  ret = libtock_ipc_channel_client_init(&channel, "org.tockos.tests.ipc_channel", buf, sizeof(buf), on_ack);
+  if (ret != RETURNCODE_SUCCESS) {
+    printf("[ipc channel] Unable to connect to service: %s\n", tock_strrcode(ret));
+    return -1;
+  }
+  printf("[ipc channel] %d byte messages, max message %d bytes\n",
+         MESSAGE_LEN, (int) libtock_ipc_channel_max_message(&channel));
+
+  uint8_t msg[MESSAGE_LEN] = {0};
+  uint32_t start = now_ms();
+  while (now_ms() - start < DURATION_MS) {
+    // Fill the ring, then wait for the service to drain it.
+    while (libtock_ipc_channel_send(&channel, msg, sizeof(msg)) == RETURNCODE_SUCCESS) {
+      msg[0]++;
+    }
+    ack_fired = false;
+    yield_for(&ack_fired);
+  }
+  uint32_t elapsed = now_ms() - start;
+
+  printf("sent:          %lu\n", (unsigned long) channel.stats.sent);
+  printf("acknowledged:  %lu\n", (unsigned long) acked);
+  printf("notifications: %lu\n", (unsigned long) channel.stats.notifications);
+  printf("messages/s:    %lu\n", (unsigned long) (acked * 1000 / elapsed));
+  return 0;
+}
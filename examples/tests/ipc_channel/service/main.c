@@ -0,0 +1,31 @@
+#include <stdio.h>
+
+#include <libtock/services/ipc_channel.h>
+#include <libtock/tock.h>
+
+// Receives messages and acknowledges each batch with the number of messages
+// received, so the client knows the ring has space again.
+static void on_message(libtock_ipc_channel_t* channel) {
+  uint8_t msg[64];
+  size_t len;
+  uint32_t count = 0;
+
+  while (libtock_ipc_channel_receive(channel, msg, sizeof(msg), &len) == RETURNCODE_SUCCESS) {
+    count++;
+  }
+  if (count > 0) {
+    libtock_ipc_channel_send(channel, &count, sizeof(count));
+  }
+}
+
+int main(void) {
+  returncode_t ret = libtock_ipc_channel_service_init("org.tockos.tests.ipc_channel", on_message);
+  if (ret != RETURNCODE_SUCCESS) {
+    printf("[ipc channel service] Unable to register: %s\n", tock_strrcode(ret));
+    return -1;
+  }
+
+  while (1) {
+    yield();
+  }
+}
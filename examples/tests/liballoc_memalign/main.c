@@ -0,0 +1,36 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <liballoc/alloc.h>
+
+static int failures = 0;
+
+static void check_aligned(void* ptr, size_t alignment, size_t size, const char* when) {
+  if (ptr == NULL || ((uintptr_t) ptr % alignment) != 0) {
+    printf("memalign(%u, %u) %s: %p is not aligned\n", (unsigned) alignment, (unsigned) size, when, ptr);
+    failures++;
+    return;
+  }
+  memset(ptr, 0xa5, size);
+}
+
+int main(void) {
+  // This must be the first allocation, so nothing may print before it.
+  void* first = libtock_alloc_memalign(16, 16);
+  check_aligned(first, 16, 16, "on a fresh heap");
+
+  static const size_t alignments[] = { 16, 32, 64, 128, 256, 512 };
+  for (size_t i = 0; i < sizeof(alignments) / sizeof(alignments[0]); i++) {
+    size_t alignment = alignments[i];
+    check_aligned(libtock_alloc_memalign(alignment, alignment), alignment, alignment, "small");
+    check_aligned(libtock_alloc_memalign(alignment, 3 * alignment), alignment, 3 * alignment, "large");
+  }
+
+  if (failures == 0) {
+    printf("liballoc_memalign: success\n");
+  } else {
+    printf("liballoc_memalign: %d failures\n", failures);
+  }
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libtock/services/memory_profile.h>
+
+// Have crt0 paint the stack so the deepest use can be found.
+const bool libtock_crt0_paint_stack = true;
+
+// Bytes of stack each level of `recurse` uses, at least.
+#define FRAME_SIZE 112
+
+static int failures = 0;
+
+// Use about `depth` * 128 bytes of stack.
+static int __attribute__ ((noinline)) recurse(int depth) {
+  volatile uint8_t frame[FRAME_SIZE];
+  memset((uint8_t*) frame, depth, sizeof(frame));
+  if (depth == 0) {
+    return frame[0];
+  }
+  return recurse(depth - 1) + frame[depth % sizeof(frame)];
+}
+
+static void check(bool ok, const char* what) {
+  if (!ok) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+int main(void) {
+  printf("[TEST] Memory Profile\n");
+  libtock_memory_profile_t before, after;
+  libtock_memory_profile_get(&before);
+  libtock_memory_profile_print();
+  check(!before.stack_sampled_only, "stack was painted");
+  check(before.stack_used > 0 && before.stack_used < before.stack_size, "stack use is within the stack");
+
+  recurse(8);
+  libtock_memory_profile_get(&after);
+  libtock_memory_profile_print();
+  check(after.stack_used >= before.stack_used + 8 * FRAME_SIZE, "recursion is measured");
+  check(after.stack_used < after.stack_size, "deeper stack use is within the stack");
+
+  libtock_memory_profile_reset_stack();
+  check(libtock_memory_profile_stack_used_since_reset() == 0, "nothing used right after a reset");
+  recurse(4);
+  uint32_t since_reset = libtock_memory_profile_stack_used_since_reset();
+  check(since_reset >= 4 * FRAME_SIZE && since_reset < after.stack_used, "stack use since a reset");
+
+  void* blocks[4];
+  for (int i = 0; i < 4; i++) {
+    blocks[i] = malloc(1024);
+  }
+  for (int i = 0; i < 4; i++) {
+    free(blocks[i]);
+  }
+  libtock_memory_profile_get(&after);
+  libtock_memory_profile_print();
+  check(after.heap_high_water >= 4 * 1024, "heap high water covers the allocations");
+  check(after.heap_used <= after.heap_high_water, "heap use is below the high water");
+
+  if (failures == 0) {
+    printf("[TEST] Memory Profile: pass\n");
+  } else {
+    printf("[TEST] Memory Profile: %d checks failed\n", failures);
+  }
+  return 0;
+}
@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock-sync/crypto/hmac.h>
+#include <libtock-sync/crypto/sha.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/services/alarm.h>
+#include <libtock/tock.h>
+
+#define INPUT_LEN 4096
+#define CHUNK_LEN 512
+#define HASH_LEN  32
+
+static uint8_t input[INPUT_LEN];
+static uint8_t chunk_a[CHUNK_LEN];
+static uint8_t chunk_b[CHUNK_LEN];
+static uint8_t key[16] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xA0, 0xA1};
+
+static uint8_t oneshot_hash[HASH_LEN];
+static uint8_t stream_hash[HASH_LEN];
+
+// Input source standing in for flash or an SD card: copies the next chunk of
+// `input`.
+static uint32_t read_chunk(void* context, uint8_t* buffer, uint32_t length) {
+  uint32_t* offset = (uint32_t*) context;
+  uint32_t remaining = INPUT_LEN - *offset;
+  if (length > remaining) length = remaining;
+
+  memcpy(buffer, &input[*offset], length);
+  *offset += length;
+  return length;
+}
+
+static uint32_t now_ticks(void) {
+  uint32_t ticks;
+  libtock_alarm_command_read(&ticks);
+  return ticks;
+}
+
+static void report(const char* label, returncode_t ret, uint32_t start, bool match) {
+  uint32_t ms = libtock_alarm_ticks_to_ms(now_ticks() - start);
+  if (ret != RETURNCODE_SUCCESS) {
+    printf("%-24s failed: %s\n", label, tock_strrcode(ret));
+    return;
+  }
+  if (ms == 0) ms = 1;
+  printf("%-24s %6lu bytes/s %s\n", label, (unsigned long) (INPUT_LEN * 1000 / ms), match ? "" : "MISMATCH");
+}
+
+static void test_sha(void) {
+  returncode_t ret;
+  uint32_t start, offset;
+
+  start = now_ticks();
+  ret   = libtocksync_sha_simple_hash(LIBTOCK_SHA256, input, INPUT_LEN, oneshot_hash, HASH_LEN);
+  report("SHA one-shot", ret, start, true);
+
+  offset = 0;
+  start  = now_ticks();
+  ret    = libtocksync_sha_stream(LIBTOCK_SHA256, read_chunk, &offset, chunk_a, NULL, CHUNK_LEN,
+                                  stream_hash, HASH_LEN);
+  report("SHA stream", ret, start, memcmp(oneshot_hash, stream_hash, HASH_LEN) == 0);
+
+  offset = 0;
+  start  = now_ticks();
+  ret    = libtocksync_sha_stream(LIBTOCK_SHA256, read_chunk, &offset, chunk_a, chunk_b, CHUNK_LEN,
+                                  stream_hash, HASH_LEN);
+  report("SHA stream (2 buffers)", ret, start, memcmp(oneshot_hash, stream_hash, HASH_LEN) == 0);
+}
+
+static void test_hmac(void) {
+  returncode_t ret;
+  uint32_t start, offset;
+
+  start = now_ticks();
+  ret   = libtocksync_hmac_simple(LIBTOCK_HMAC_SHA256, key, sizeof(key), input, INPUT_LEN,
+                                  oneshot_hash, HASH_LEN);
+  report("HMAC one-shot", ret, start, true);
+
+  offset = 0;
+  start  = now_ticks();
+  ret    = libtocksync_hmac_stream(LIBTOCK_HMAC_SHA256, key, sizeof(key), read_chunk, &offset,
+                                   chunk_a, NULL, CHUNK_LEN, stream_hash, HASH_LEN);
+  report("HMAC stream", ret, start, memcmp(oneshot_hash, stream_hash, HASH_LEN) == 0);
+
+  offset = 0;
+  start  = now_ticks();
+  ret    = libtocksync_hmac_stream(LIBTOCK_HMAC_SHA256, key, sizeof(key), read_chunk, &offset,
+                                   chunk_a, chunk_b, CHUNK_LEN, stream_hash, HASH_LEN);
+  report("HMAC stream (2 buffers)", ret, start, memcmp(oneshot_hash, stream_hash, HASH_LEN) == 0);
+}
+
+int main(void) {
+  printf("[TEST] SHA/HMAC streaming, %d bytes in %d byte chunks\n", INPUT_LEN, CHUNK_LEN);
+
+  for (int i = 0; i < INPUT_LEN; i++) {
+    input[i] = i * 7 + (i >> 8);
+  }
+
+  if (libtocksync_sha_exists()) {
+    test_sha();
+  } else {
+    printf("No SHA driver.\n");
+  }
+
+  if (libtocksync_hmac_exists()) {
+    test_hmac();
+  } else {
+    printf("No HMAC driver.\n");
+  }
+
+  return 0;
+}
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock-sync/display/text_screen.h>
+#include <libtock-sync/services/text_screen_frame.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/services/alarm.h>
+#include <libtock/tock.h>
+
+#define ITERATIONS 20
+
+static uint32_t width, height;
+static char lines[4][21];
+
+// Fill the status lines for update `i`. Only the counter changes between
+// updates, like a typical status display.
+static void make_lines(int i) {
+  snprintf(lines[0], sizeof(lines[0]), "Tock status");
+  snprintf(lines[1], sizeof(lines[1]), "Count: %d", i);
+  snprintf(lines[2], sizeof(lines[2]), "Temp: 21.5C");
+  snprintf(lines[3], sizeof(lines[3]), "Link: up");
+}
+
+static uint32_t update_per_line(int i) {
+  uint8_t buffer[21];
+  uint32_t ops = 0;
+
+  make_lines(i);
+  for (uint32_t row = 0; row < height && row < 4; row++) {
+    uint32_t len = strlen(lines[row]);
+    memset(buffer, ' ', width);
+    memcpy(buffer, lines[row], len);
+    libtocksync_text_screen_set_cursor(0, row);
+    libtocksync_text_screen_write(buffer, width, width);
+    ops += 2;
+  }
+  return ops;
+}
+
+static uint32_t update_frame(libtock_text_screen_frame_t* frame, int i) {
+  make_lines(i);
+  for (uint32_t row = 0; row < height && row < 4; row++) {
+    libtock_text_screen_frame_set_line(frame, row, lines[row]);
+  }
+  libtocksync_text_screen_frame_commit(frame);
+  // With nothing to send, the commit issues no operations and
+  // `last_update_ops` still describes the previous one.
+  if (frame->num_ops == 0) return 0;
+  return frame->last_update_ops;
+}
+
+static uint32_t now_ms(void) {
+  uint32_t ticks;
+  libtock_alarm_command_read(&ticks);
+  return libtock_alarm_ticks_to_ms(ticks);
+}
+
+int main(void) {
+  returncode_t ret;
+
+  ret = libtocksync_text_screen_get_size(&width, &height);
+  if (ret != RETURNCODE_SUCCESS) {
+    printf("[text screen frame] No text screen: %s\n", tock_strrcode(ret));
+    return -1;
+  }
+  if (width > 20) width = 20;
+  printf("[text screen frame] %lux%lu screen\n", width, height);
+
+  libtocksync_text_screen_display_on();
+  libtocksync_text_screen_clear();
+
+  uint32_t ops   = 0;
+  uint32_t start = now_ms();
+  for (int i = 0; i < ITERATIONS; i++) {
+    ops += update_per_line(i);
+  }
+  uint32_t per_line_ms = (now_ms() - start) / ITERATIONS;
+  printf("per-line updates: %lu ms (%lu operations)\n", per_line_ms, ops / ITERATIONS);
+
+  libtock_text_screen_frame_t frame;
+  ret = libtock_text_screen_frame_init(&frame, width, height);
+  if (ret != RETURNCODE_SUCCESS) {
+    printf("[text screen frame] Could not set up a %lux%lu frame: %s\n", width, height, tock_strrcode(ret));
+    return -1;
+  }
+
+  // The first commit clears and draws the whole screen, don't measure it.
+  update_frame(&frame, 0);
+
+  ops   = 0;
+  start = now_ms();
+  for (int i = 1; i <= ITERATIONS; i++) {
+    ops += update_frame(&frame, i);
+  }
+  uint32_t frame_ms = (now_ms() - start) / ITERATIONS;
+  printf("frame updates:    %lu ms (%lu operations)\n", frame_ms, ops / ITERATIONS);
+
+  return 0;
+}
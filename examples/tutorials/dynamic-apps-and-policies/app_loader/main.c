@@ -3,58 +3,53 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <libtock-sync/kernel/app_loader.h>
 #include <libtock-sync/services/alarm.h>
 #include <libtock/kernel/app_loader.h>
 #include <libtock/kernel/ipc.h>
 
 #include "loadable_binaries.h"
 
+// Size of each flash write. The kernel copies at most its own page buffer per
+// write, so keep this at or below that.
+#ifndef FLASH_BUFFER_SIZE
 #define FLASH_BUFFER_SIZE 512
+#endif
 #define RETURNCODE_SUCCESS 0
 
-static bool setup_done    = false;    // to check if setup is done
-static bool write_done    = false;    // to check if writing to flash is done
-static bool finalize_done = false;    // to check if the kernel is done finalizing the process binary
-static bool load_done     = false;    // to check if the process was loaded successfully
+static bool load_done = false;    // to check if the process was loaded successfully
 
 uint8_t app_id = 0;
 
+// While one buffer is written to flash the next chunk is copied into the other.
+static uint8_t flash_buffer_a[FLASH_BUFFER_SIZE];
+static uint8_t flash_buffer_b[FLASH_BUFFER_SIZE];
+static libtock_app_loader_stream_t stream;
+
+// Where the stream reads the app binary from. Here the binaries are embedded in
+// this app, but this could just as well read from the network or storage.
+struct binary_source {
+  const uint8_t* data;
+  uint32_t size;
+  uint32_t offset;
+};
+
 
 /********************************
  * Function prototypes
  *********************************/
 int install_binary(uint8_t id);
+int write_app(uint32_t size, const uint8_t* binary, const uint8_t* hash);
 
 
 /******************************************************************************************************
 * Callback functions
 *
-* 1. Callback to let us know when the capsule is done writing data to flash
-* 2. Set button callback to initiate the dynamic app load process on pressing button 1 (on nrf52840dk)
+* Callback to let us know when the kernel is done creating the new process. Setup, flash writes and
+* finalize are handled by the app loader stream.
 *
 ******************************************************************************************************/
 
-static void app_setup_done_callback(__attribute__((unused)) int   arg0,
-                                    __attribute__((unused)) int   arg1,
-                                    __attribute__((unused)) int   arg2,
-                                    __attribute__((unused)) void* ud) {
-  setup_done = true;
-}
-
-static void app_write_done_callback(__attribute__((unused)) int   arg0,
-                                    __attribute__((unused)) int   arg1,
-                                    __attribute__((unused)) int   arg2,
-                                    __attribute__((unused)) void* ud) {
-  write_done = true;
-}
-
-static void app_finalize_done_callback(__attribute__((unused)) int   arg0,
-                                       __attribute__((unused)) int   arg1,
-                                       __attribute__((unused)) int   arg2,
-                                       __attribute__((unused)) void* ud) {
-  finalize_done = true;
-}
-
 static void app_load_done_callback(int                           arg0,
                                    __attribute__((unused)) int   arg1,
                                    __attribute__((unused)) int   arg2,
@@ -75,28 +70,27 @@ int install_binary(uint8_t id) {
   }
 
   const char* app_name    = NULL;
-  unsigned char* app_data = NULL;
+  const uint8_t* app_data = NULL;
+  const uint8_t* app_hash = NULL;
   size_t app_size         = 0;
   size_t binary_size      = 0;
 
   app_name    = binary_names[id];
-  app_data    = (uint8_t*)(uintptr_t)binaries[id];
+  app_data    = binaries[id];
+  app_hash    = binary_hashes[id];
   app_size    = binary_sizes[id];
   binary_size = actual_sizes[id];
 
   printf("[AppLoader] Requested to load %s!\n", app_name);
 
-  int ret = libtock_app_loader_setup(app_size);
+  int ret = libtocksync_app_loader_stream_start(&stream, app_size);
   if (ret != RETURNCODE_SUCCESS) {
     printf("[Error] Setup Failed: %d.\n", ret);
     return -1;
   }
 
-  yield_for(&setup_done);
-  setup_done = false;
-
   printf("[Success] Setup successful. Writing app to flash.\n");
-  int ret1 = write_app(binary_size, app_data);
+  int ret1 = write_app(binary_size, app_data, app_hash);
   if (ret1 != RETURNCODE_SUCCESS) {
     printf("[Error] App flash write unsuccessful: %d.\n", ret1);
     return -1;
@@ -120,56 +114,44 @@ int install_binary(uint8_t id) {
 *
 * Function to write the app into the flash
 *
-* Takes app size and the app binary as arguments
+* Takes app size, the app binary and its SHA-256 hash as arguments
 ******************************************************************************************************/
 
-int write_app(double size, uint8_t binary[]) {
+static uint32_t read_binary(void* context, uint8_t* buffer, uint32_t length) {
+  struct binary_source* source = (struct binary_source*) context;
+  uint32_t remaining = source->size - source->offset;
+  if (length > remaining) length = remaining;
 
-  uint32_t write_count = 0;
-  uint8_t write_buffer[FLASH_BUFFER_SIZE];
-  uint32_t flash_offset = 0;
+  memcpy(buffer, &source->data[source->offset], length);
+  source->offset += length;
+  return length;
+}
 
-  // This value can be changed to different sizes
-  // to mimic different bus widths.
-  uint32_t write_buffer_size = FLASH_BUFFER_SIZE;
+int write_app(uint32_t size, const uint8_t* binary, const uint8_t* hash) {
+  struct binary_source source = {
+    .data   = binary,
+    .size   = size,
+    .offset = 0,
+  };
 
-  // set the write buffer
-  int ret = libtock_app_loader_set_buffer(write_buffer, FLASH_BUFFER_SIZE);
+  int ret = libtocksync_app_loader_stream_write(&stream, read_binary, &source);
   if (ret != RETURNCODE_SUCCESS) {
-    printf("[Error] Failed to set the write buffer: %d.\n", ret);
+    printf("[Error] Failed writing data to flash at offset: 0x%lx\n", stream.checkpoint.offset);
+    printf("[Error] Error nature: %d\n", ret);
     return -1;
   }
 
-  write_count = (size + write_buffer_size - 1) / write_buffer_size;
-
-  for (uint32_t offset = 0; offset < write_count; offset++) {
-
-    memset(write_buffer, 0, write_buffer_size);
-    // copy binary to write buffer
-    flash_offset = (offset * write_buffer_size);
-    size_t bytes_left = size - flash_offset;
-    size_t chunk      = bytes_left < write_buffer_size ? bytes_left : write_buffer_size;
-    memcpy(write_buffer, &binary[write_buffer_size * offset], chunk);
-    int ret1 = libtock_app_loader_write(flash_offset, write_buffer_size);
-    if (ret1 != 0) {
-      printf("[Error] Failed writing data to flash at address: 0x%lx\n", flash_offset);
-      printf("[Error] Error nature: %d\n", ret1);
-      return -1;
-    }
-    // wait on write done callback
-    yield_for(&write_done);
-    write_done = false;
-  }
-
   // Now that we are done writing the binary, we ask the kernel to finalize it.
-  printf("Done writing app, finalizing.\n");
-  int ret2 = libtock_app_loader_finalize();
-  if (ret2 != 0) {
+  printf("Done writing app (%lu chunks, %lu pipelined), finalizing.\n", stream.stats.chunks,
+         stream.stats.pipelined);
+  ret = libtocksync_app_loader_stream_finish(&stream, hash);
+  if (ret == RETURNCODE_FAIL) {
+    printf("[Error] App hash mismatch, aborted.\n");
+    return -1;
+  } else if (ret != RETURNCODE_SUCCESS) {
     printf("[Error] Failed to finalize new process binary.\n");
     return -1;
   }
-  yield_for(&finalize_done);
-  finalize_done = false;
 
   return 0;
 }
@@ -242,27 +224,13 @@ int main(void) {
     return -1;
   }
 
-  // set up the setup done callback
-  int err1 = libtock_app_loader_subscribe_setup(app_setup_done_callback, NULL);
+  // set up the setup, write and finalize callbacks
+  int err1 = libtock_app_loader_stream_init(&stream, flash_buffer_a, flash_buffer_b, FLASH_BUFFER_SIZE, NULL);
   if (err1 != 0) {
-    printf("[Error] Failed to set setup done callback: %d\n", err1);
+    printf("[Error] Failed to set up the app loader stream: %d\n", err1);
     return err1;
   }
 
-  // set up the write done callback
-  int err2 = libtock_app_loader_subscribe_write(app_write_done_callback, NULL);
-  if (err2 != 0) {
-    printf("[Error] Failed to set flash write done callback: %d\n", err2);
-    return err2;
-  }
-
-  // set up the finalize done callback
-  int err3 = libtock_app_loader_subscribe_finalize(app_finalize_done_callback, NULL);
-  if (err3 != 0) {
-    printf("[Error] Failed to set finalize done callback: %d\n", err3);
-    return err3;
-  }
-
   // set up the load done callback
   int err4 = libtock_app_loader_subscribe_load(app_load_done_callback, NULL);
   if (err4 != 0) {
@@ -1,4 +1,5 @@
 #!/usr/bin/env python3
+import hashlib
 import sys
 
 def trim_trailing_zeroes(b):
@@ -26,8 +27,10 @@ def main(input_path, output_path, array_name):
         f.write(f"const unsigned char {array_name}[] = {c_data};\n")
         f.write(f"const size_t {array_name}_size = {len(data)};\n")
         f.write(f"const size_t {array_name}_actual_size = {len(trimmed)};\n")
+        c_hash = format_data_strings(hashlib.sha256(trimmed).digest())
+        f.write(f"const unsigned char {array_name}_sha256[] = {c_hash};\n")
 
 if __name__ == "__main__":
     if len(sys.argv) != 4:
         sys.exit(1)
-    main(sys.argv[1], sys.argv[2], sys.argv[3])
\ No newline at end of file
+    main(sys.argv[1], sys.argv[2], sys.argv[3])
\ No newline at end of file
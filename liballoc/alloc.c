@@ -0,0 +1,417 @@
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "alloc.h"
+
+#define PAGE_SIZE LIBTOCK_ALLOC_PAGE_SIZE
+#define MAX_PAGES LIBTOCK_ALLOC_MAX_PAGES
+
+_Static_assert((PAGE_SIZE & (PAGE_SIZE - 1)) == 0, "LIBTOCK_ALLOC_PAGE_SIZE must be a power of two");
+_Static_assert(MAX_PAGES <= 0xffff, "LIBTOCK_ALLOC_MAX_PAGES is too large");
+
+#define ALIGNMENT 8
+
+// What each heap page is used for.
+#define PAGE_FREE 0
+// A run of pages for one large allocation: the first page, and the others.
+#define PAGE_SPAN 0xfe
+#define PAGE_SPAN_TAIL 0xff
+// Values from 1 up are slab pages, of size class `state - 1`.
+
+static const uint16_t class_size[] = {8, 16, 24, 32, 48, 64, 96, 128, 192, 256};
+#define NUM_CLASSES (sizeof(class_size) / sizeof(class_size[0]))
+
+_Static_assert(LIBTOCK_ALLOC_MAX_SMALL == 256, "size classes must end at LIBTOCK_ALLOC_MAX_SMALL");
+
+// Header at the start of every slab page.
+typedef struct slab {
+  // Slab pages of the same class with at least one free block.
+  struct slab* next;
+  struct slab* prev;
+  // Blocks that were freed, linked through their first word.
+  void* free;
+  // Blocks in use, and blocks handed out at least once. Blocks past `carved`
+  // have never been used and are not on `free`.
+  uint16_t used;
+  uint16_t carved;
+} slab_t;
+
+#define SLAB_HEADER ((sizeof(slab_t) + ALIGNMENT - 1) & ~(ALIGNMENT - 1))
+
+// Header at the start of every span.
+typedef struct {
+  uint32_t pages;
+  uint32_t unused;
+} span_t;
+
+#define SPAN_HEADER sizeof(span_t)
+
+static struct {
+  uint8_t* base;
+  // Pages below `brk`.
+  uint32_t pages;
+  uint8_t state[MAX_PAGES];
+  slab_t* partial[NUM_CLASSES];
+  libtock_alloc_stats_t stats;
+} heap;
+
+// Size class for each request size, in steps of 8 bytes.
+static const uint8_t size_to_class[LIBTOCK_ALLOC_MAX_SMALL / ALIGNMENT + 1] = {
+  0, 0, 1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7,
+  8, 8, 8, 8, 8, 8, 8, 8, 9, 9, 9, 9, 9, 9, 9, 9,
+};
+
+static inline uint8_t* page_address(uint32_t page) {
+  return heap.base + page * PAGE_SIZE;
+}
+
+static inline uint16_t slab_capacity(uint32_t size_class) {
+  return (PAGE_SIZE - SLAB_HEADER) / class_size[size_class];
+}
+
+// Set the heap up on first use. `brk` is rounded up to the allocation
+// alignment.
+static bool heap_init(void) {
+  uint8_t* brk = sbrk(0);
+  if (brk == (void*) -1) return false;
+
+  uint32_t pad = (ALIGNMENT - ((uintptr_t) brk & (ALIGNMENT - 1))) & (ALIGNMENT - 1);
+  if (pad != 0 && sbrk(pad) == (void*) -1) return false;
+
+  heap.base = brk + pad;
+  return true;
+}
+
+// Add `count` pages at the top of the heap.
+static bool heap_grow(uint32_t count) {
+  if (heap.base == NULL && !heap_init()) return false;
+  if (heap.pages + count > MAX_PAGES) return false;
+
+  uint8_t* old_brk = sbrk(count * PAGE_SIZE);
+  if (old_brk == (void*) -1) return false;
+  if (old_brk != page_address(heap.pages)) {
+    // Someone else moved `brk`, so the heap is no longer contiguous.
+    sbrk(-(int) (count * PAGE_SIZE));
+    return false;
+  }
+
+  memset(&heap.state[heap.pages], PAGE_FREE, count);
+  heap.pages += count;
+
+  heap.stats.heap_bytes = heap.pages * PAGE_SIZE;
+  if (heap.stats.heap_bytes > heap.stats.heap_high_water) {
+    heap.stats.heap_high_water = heap.stats.heap_bytes;
+  }
+  return true;
+}
+
+static void partial_remove(uint32_t size_class, slab_t* slab);
+
+// Give free pages at the top of the heap back to the kernel, once there are at
+// least `LIBTOCK_ALLOC_TRIM_PAGES`. Empty slabs kept for reuse count as free.
+static void heap_trim(void) {
+  uint32_t top = heap.pages;
+  while (top > 0) {
+    uint8_t state = heap.state[top - 1];
+    if (state == PAGE_SPAN || state == PAGE_SPAN_TAIL) break;
+    if (state != PAGE_FREE && ((slab_t*) page_address(top - 1))->used != 0) break;
+    top--;
+  }
+  uint32_t count = heap.pages - top;
+  if (count < LIBTOCK_ALLOC_TRIM_PAGES) return;
+
+  // Keep the lowest free page, so that a block allocated and freed over and
+  // over at the top of the heap does not move `brk` each time.
+  top++;
+  count--;
+
+  for (uint32_t page = top; page < heap.pages; page++) {
+    if (heap.state[page] != PAGE_FREE) {
+      partial_remove(heap.state[page] - 1, (slab_t*) page_address(page));
+      heap.state[page] = PAGE_FREE;
+    }
+  }
+  if (sbrk(-(int) (count * PAGE_SIZE)) != (void*) -1) {
+    heap.pages            = top;
+    heap.stats.heap_bytes = heap.pages * PAGE_SIZE;
+  }
+}
+
+// Find `count` free pages in a row, growing the heap if needed, and mark them
+// as used by `state`. Returns the first page, or -1.
+static int32_t pages_alloc(uint32_t count, uint8_t state) {
+  uint32_t run = 0;
+  uint32_t first;
+
+  for (first = 0; first + run < heap.pages; ) {
+    if (heap.state[first + run] != PAGE_FREE) {
+      first += run + 1;
+      run    = 0;
+    } else if (++run == count) {
+      break;
+    }
+  }
+
+  // `run` free pages at `first` ended at the top of the heap.
+  if (run < count && !heap_grow(count - run)) return -1;
+
+  heap.state[first] = state;
+  if (state == PAGE_SPAN) {
+    memset(&heap.state[first + 1], PAGE_SPAN_TAIL, count - 1);
+  }
+  return first;
+}
+
+static void pages_free(uint32_t first, uint32_t count) {
+  memset(&heap.state[first], PAGE_FREE, count);
+  heap_trim();
+}
+
+static void partial_push(uint32_t size_class, slab_t* slab) {
+  slab->prev = NULL;
+  slab->next = heap.partial[size_class];
+  if (slab->next != NULL) slab->next->prev = slab;
+  heap.partial[size_class] = slab;
+}
+
+static void partial_remove(uint32_t size_class, slab_t* slab) {
+  if (slab->prev != NULL) {
+    slab->prev->next = slab->next;
+  } else {
+    heap.partial[size_class] = slab->next;
+  }
+  if (slab->next != NULL) slab->next->prev = slab->prev;
+}
+
+static void* small_alloc(uint32_t size_class) {
+  slab_t* slab = heap.partial[size_class];
+  if (slab == NULL) {
+    int32_t page = pages_alloc(1, size_class + 1);
+    if (page < 0) return NULL;
+
+    slab         = (slab_t*) page_address(page);
+    slab->free   = NULL;
+    slab->used   = 0;
+    slab->carved = 0;
+    partial_push(size_class, slab);
+  }
+
+  void* block;
+  if (slab->free != NULL) {
+    block      = slab->free;
+    slab->free = *(void**) block;
+  } else {
+    block = (uint8_t*) slab + SLAB_HEADER + slab->carved * class_size[size_class];
+    slab->carved++;
+  }
+
+  if (++slab->used == slab_capacity(size_class)) {
+    partial_remove(size_class, slab);
+  }
+  heap.stats.allocated_bytes += class_size[size_class];
+  return block;
+}
+
+static void small_free(uint32_t page, uint32_t size_class, void* block) {
+  slab_t* slab = (slab_t*) page_address(page);
+
+  if (slab->used == slab_capacity(size_class)) {
+    partial_push(size_class, slab);
+  }
+  *(void**) block = slab->free;
+  slab->free      = block;
+  slab->used--;
+  heap.stats.allocated_bytes -= class_size[size_class];
+
+  // Keep one empty slab per class so that alternating malloc and free does
+  // not take a page from the kernel and give it back every time.
+  if (slab->used == 0) {
+    if (slab->next != NULL || slab->prev != NULL) {
+      partial_remove(size_class, slab);
+      pages_free(page, 1);
+    } else {
+      heap_trim();
+    }
+  }
+}
+
+static void* large_alloc(size_t size) {
+  if (size > MAX_PAGES * PAGE_SIZE) return NULL;
+
+  uint32_t count = (size + SPAN_HEADER + PAGE_SIZE - 1) / PAGE_SIZE;
+  int32_t page   = pages_alloc(count, PAGE_SPAN);
+  if (page < 0) return NULL;
+
+  span_t* span = (span_t*) page_address(page);
+  span->pages = count;
+  heap.stats.allocated_bytes += count * PAGE_SIZE;
+  return (uint8_t*) span + SPAN_HEADER;
+}
+
+// The page holding `ptr`, or -1 if it is not a live allocation.
+static int32_t page_of(const void* ptr) {
+  if (heap.base == NULL || (const uint8_t*) ptr < heap.base) return -1;
+
+  uint32_t page = ((const uint8_t*) ptr - heap.base) / PAGE_SIZE;
+  if (page >= heap.pages || heap.state[page] == PAGE_FREE) return -1;
+
+  // Aligned allocations may point past the first page of their span.
+  while (heap.state[page] == PAGE_SPAN_TAIL) {
+    page--;
+  }
+  return page;
+}
+
+void* libtock_alloc_malloc(size_t size) {
+  void* ptr;
+  if (size <= LIBTOCK_ALLOC_MAX_SMALL) {
+    ptr = small_alloc(size_to_class[(size + ALIGNMENT - 1) / ALIGNMENT]);
+  } else {
+    ptr = large_alloc(size);
+  }
+
+  if (ptr == NULL) {
+    heap.stats.failed_allocations++;
+    return NULL;
+  }
+  heap.stats.allocations++;
+  heap.stats.total_allocations++;
+  return ptr;
+}
+
+void libtock_alloc_free(void* ptr) {
+  int32_t page = page_of(ptr);
+  if (page < 0) return;
+
+  uint8_t state = heap.state[page];
+  if (state == PAGE_SPAN) {
+    span_t* span = (span_t*) page_address(page);
+    heap.stats.allocated_bytes -= span->pages * PAGE_SIZE;
+    pages_free(page, span->pages);
+  } else {
+    small_free(page, state - 1, ptr);
+  }
+
+  heap.stats.allocations--;
+  heap.stats.total_frees++;
+}
+
+size_t libtock_alloc_usable_size(void* ptr) {
+  int32_t page = page_of(ptr);
+  if (page < 0) return 0;
+
+  uint8_t state = heap.state[page];
+  if (state == PAGE_SPAN) {
+    span_t* span = (span_t*) page_address(page);
+    return page_address(page + span->pages) - (uint8_t*) ptr;
+  }
+  return class_size[state - 1];
+}
+
+void* libtock_alloc_calloc(size_t count, size_t size) {
+  size_t total;
+  if (__builtin_mul_overflow(count, size, &total)) return NULL;
+
+  void* ptr = libtock_alloc_malloc(total);
+  if (ptr != NULL) {
+    memset(ptr, 0, total);
+  }
+  return ptr;
+}
+
+// Grow or shrink a span in place. Only possible if the pages after it are free
+// or it is at the top of the heap.
+static bool span_resize(uint32_t page, size_t size) {
+  span_t* span   = (span_t*) page_address(page);
+  uint32_t count = (size + SPAN_HEADER + PAGE_SIZE - 1) / PAGE_SIZE;
+
+  if (count < span->pages) {
+    heap.stats.allocated_bytes -= (span->pages - count) * PAGE_SIZE;
+    pages_free(page + count, span->pages - count);
+    span->pages = count;
+    return true;
+  }
+
+  uint32_t end = page + span->pages;
+  uint32_t top = page + count;
+  if (top > MAX_PAGES) return false;
+  for (uint32_t p = end; p < top && p < heap.pages; p++) {
+    if (heap.state[p] != PAGE_FREE) return false;
+  }
+  if (top > heap.pages && !heap_grow(top - heap.pages)) return false;
+
+  memset(&heap.state[end], PAGE_SPAN_TAIL, top - end);
+  heap.stats.allocated_bytes += (count - span->pages) * PAGE_SIZE;
+  span->pages = count;
+  return true;
+}
+
+void* libtock_alloc_realloc(void* ptr, size_t size) {
+  if (ptr == NULL) return libtock_alloc_malloc(size);
+
+  int32_t page = page_of(ptr);
+  if (page < 0) return NULL;
+
+  size_t usable = libtock_alloc_usable_size(ptr);
+  if (heap.state[page] == PAGE_SPAN) {
+    // Only resize spans that are not aligned allocations.
+    if (size > LIBTOCK_ALLOC_MAX_SMALL &&
+        (uint8_t*) ptr == page_address(page) + SPAN_HEADER &&
+        span_resize(page, size)) {
+      return ptr;
+    }
+  } else if (size <= usable && size > usable / 2) {
+    // Same or neighbouring size class.
+    return ptr;
+  }
+
+  void* moved = libtock_alloc_malloc(size);
+  if (moved == NULL) return NULL;
+
+  memcpy(moved, ptr, size < usable ? size : usable);
+  libtock_alloc_free(ptr);
+  return moved;
+}
+
+void* libtock_alloc_memalign(size_t alignment, size_t size) {
+  if (alignment <= ALIGNMENT) return libtock_alloc_malloc(size);
+  if ((alignment & (alignment - 1)) != 0) return NULL;
+  // The fast path below depends on where the heap starts.
+  if (heap.base == NULL && !heap_init()) return NULL;
+
+  // Size classes that are powers of two are aligned to their size within a
+  // slab, as long as the slab's first block is.
+  if (size <= alignment && alignment <= LIBTOCK_ALLOC_MAX_SMALL &&
+      (SLAB_HEADER % alignment) == 0 && ((uintptr_t) heap.base % alignment) == 0 &&
+      (PAGE_SIZE % alignment) == 0) {
+    return libtock_alloc_malloc(alignment);
+  }
+
+  // Otherwise over-allocate a span and return an aligned pointer inside it.
+  uint8_t* ptr = libtock_alloc_malloc(size + alignment > LIBTOCK_ALLOC_MAX_SMALL ?
+                                      size + alignment : LIBTOCK_ALLOC_MAX_SMALL + 1);
+  if (ptr == NULL) return NULL;
+  return (void*) (((uintptr_t) ptr + alignment - 1) & ~(uintptr_t) (alignment - 1));
+}
+
+void libtock_alloc_get_stats(libtock_alloc_stats_t* stats) {
+  uint32_t free_pages = 0;
+  uint32_t largest    = 0;
+  uint32_t run        = 0;
+  for (uint32_t page = 0; page < heap.pages; page++) {
+    if (heap.state[page] == PAGE_FREE) {
+      free_pages++;
+      if (++run > largest) largest = run;
+    } else {
+      run = 0;
+    }
+  }
+
+  *stats                  = heap.stats;
+  stats->free_pages       = free_pages;
+  stats->largest_free_run = largest;
+  stats->fragmentation_percent = heap.stats.heap_bytes == 0 ? 0 :
+                                 (uint32_t) ((uint64_t) (heap.stats.heap_bytes - heap.stats.allocated_bytes) * 100 /
+                                             heap.stats.heap_bytes);
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+// Size-class allocator for Tock apps.
+//
+// Linking this library replaces newlib's `malloc`, `free`, `calloc`,
+// `realloc` and `memalign` (and the reentrant `_malloc_r` family newlib uses
+// internally), so existing code, including lwIP, Lua and libc++ containers,
+// uses it without changes.
+//
+// The heap is the app's `brk` region, managed in pages of
+// `LIBTOCK_ALLOC_PAGE_SIZE` bytes:
+//
+// - Requests up to `LIBTOCK_ALLOC_MAX_SMALL` bytes are rounded up to one of a
+//   few size classes and served from slab pages holding blocks of a single
+//   class. Allocating and freeing a block is a list push or pop.
+// - Larger requests get a run of whole pages.
+//
+// The heap grows only by the pages a request needs, when it needs them, as every
+// byte below `brk` is a byte the kernel can no longer use for grants. Once
+// there are `LIBTOCK_ALLOC_TRIM_PAGES` free pages at the top of the heap, all
+// but one of them are handed back to the kernel.
+//
+// Arenas (`libtock_arena_t`) serve many short-lived allocations from larger
+// chunks and free them all at once with `libtock_arena_reset`.
+//
+// The allocator expects to own `brk`: nothing else in the app may call `sbrk`
+// once it is in use.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Heap page size, a power of two.
+#ifndef LIBTOCK_ALLOC_PAGE_SIZE
+#define LIBTOCK_ALLOC_PAGE_SIZE 1024
+#endif
+
+// Largest heap, in pages.
+#ifndef LIBTOCK_ALLOC_MAX_PAGES
+#define LIBTOCK_ALLOC_MAX_PAGES 256
+#endif
+
+// Free pages at the top of the heap that trigger returning them to the kernel.
+#ifndef LIBTOCK_ALLOC_TRIM_PAGES
+#define LIBTOCK_ALLOC_TRIM_PAGES 2
+#endif
+
+// Largest request served from a size class.
+#define LIBTOCK_ALLOC_MAX_SMALL 256
+
+typedef struct {
+  // Bytes of `brk` owned by the allocator, now and at most.
+  uint32_t heap_bytes;
+  uint32_t heap_high_water;
+  // Bytes handed out in live allocations, after rounding up to the size
+  // class or page.
+  uint32_t allocated_bytes;
+  // Live allocations, and all allocations, frees and failed allocations.
+  uint32_t allocations;
+  uint32_t total_allocations;
+  uint32_t total_frees;
+  uint32_t failed_allocations;
+  // Free pages in the heap, and the longest run of them. A large request
+  // needing more pages than `largest_free_run` grows the heap.
+  uint32_t free_pages;
+  uint32_t largest_free_run;
+  // Percentage of the heap not handed out: free pages, unused blocks in slab
+  // pages and page headers.
+  uint32_t fragmentation_percent;
+} libtock_alloc_stats_t;
+
+void* libtock_alloc_malloc(size_t size);
+void libtock_alloc_free(void* ptr);
+void* libtock_alloc_calloc(size_t count, size_t size);
+void* libtock_alloc_realloc(void* ptr, size_t size);
+void* libtock_alloc_memalign(size_t alignment, size_t size);
+size_t libtock_alloc_usable_size(void* ptr);
+
+void libtock_alloc_get_stats(libtock_alloc_stats_t* stats);
+
+// Bump allocator over chunks taken from the heap. Allocations cannot be freed
+// individually; `libtock_arena_reset` frees all of them at once.
+typedef struct libtock_arena_chunk libtock_arena_chunk_t;
+
+typedef struct {
+  libtock_arena_chunk_t* chunks;
+  uint8_t* next;
+  uint8_t* end;
+  uint32_t chunk_size;
+  // Bytes allocated since the last reset, and the most ever.
+  uint32_t allocated;
+  uint32_t high_water;
+} libtock_arena_t;
+
+// Set up an arena that takes `chunk_size` bytes from the heap at a time. No
+// memory is taken until the first allocation.
+void libtock_arena_init(libtock_arena_t* arena, uint32_t chunk_size);
+
+// Allocate `size` bytes, aligned to 8 bytes. Returns NULL if the heap is
+// full.
+void* libtock_arena_alloc(libtock_arena_t* arena, size_t size);
+
+// Free everything allocated from the arena. The first chunk is kept for
+// reuse.
+void libtock_arena_reset(libtock_arena_t* arena);
+
+// Free everything allocated from the arena and return all of its chunks to
+// the heap.
+void libtock_arena_release(libtock_arena_t* arena);
+
+#ifdef __cplusplus
+}
+#endif
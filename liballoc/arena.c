@@ -0,0 +1,83 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "alloc.h"
+
+#define ALIGNMENT 8
+
+struct libtock_arena_chunk {
+  libtock_arena_chunk_t* next;
+  uint32_t size;
+};
+
+#define CHUNK_HEADER ((sizeof(libtock_arena_chunk_t) + ALIGNMENT - 1) & ~(ALIGNMENT - 1))
+
+void libtock_arena_init(libtock_arena_t* arena, uint32_t chunk_size) {
+  memset(arena, 0, sizeof(*arena));
+  arena->chunk_size = chunk_size;
+}
+
+// Start a new chunk with room for at least `size` bytes.
+static bool arena_grow(libtock_arena_t* arena, size_t size) {
+  size_t chunk_size = arena->chunk_size;
+  if (size > chunk_size - CHUNK_HEADER) {
+    chunk_size = size + CHUNK_HEADER;
+  }
+
+  libtock_arena_chunk_t* chunk = libtock_alloc_malloc(chunk_size);
+  if (chunk == NULL) return false;
+
+  chunk->size    = chunk_size;
+  chunk->next    = arena->chunks;
+  arena->chunks  = chunk;
+  arena->next    = (uint8_t*) chunk + CHUNK_HEADER;
+  arena->end     = (uint8_t*) chunk + chunk_size;
+  return true;
+}
+
+void* libtock_arena_alloc(libtock_arena_t* arena, size_t size) {
+  size = (size + ALIGNMENT - 1) & ~(size_t) (ALIGNMENT - 1);
+
+  if (arena->next == NULL || (size_t) (arena->end - arena->next) < size) {
+    if (!arena_grow(arena, size)) return NULL;
+  }
+
+  void* ptr = arena->next;
+  arena->next      += size;
+  arena->allocated += size;
+  if (arena->allocated > arena->high_water) {
+    arena->high_water = arena->allocated;
+  }
+  return ptr;
+}
+
+void libtock_arena_reset(libtock_arena_t* arena) {
+  libtock_arena_chunk_t* chunk = arena->chunks;
+  if (chunk == NULL) return;
+
+  // Keep the oldest chunk, which is the last one in the list.
+  while (chunk->next != NULL) {
+    libtock_arena_chunk_t* next = chunk->next;
+    libtock_alloc_free(chunk);
+    chunk = next;
+  }
+
+  arena->chunks    = chunk;
+  arena->next      = (uint8_t*) chunk + CHUNK_HEADER;
+  arena->end       = (uint8_t*) chunk + chunk->size;
+  arena->allocated = 0;
+}
+
+void libtock_arena_release(libtock_arena_t* arena) {
+  libtock_arena_chunk_t* chunk = arena->chunks;
+  while (chunk != NULL) {
+    libtock_arena_chunk_t* next = chunk->next;
+    libtock_alloc_free(chunk);
+    chunk = next;
+  }
+
+  arena->chunks    = NULL;
+  arena->next      = NULL;
+  arena->end       = NULL;
+  arena->allocated = 0;
+}
@@ -0,0 +1,67 @@
+#include <errno.h>
+#include <malloc.h>
+#include <reent.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+
+// Replacements for newlib's allocator. newlib calls the reentrant `_r`
+// versions internally (for example for stdio buffers), so both sets are
+// defined here; this keeps newlib's own allocator from being linked in.
+
+static void* check(void* ptr) {
+  if (ptr == NULL) errno = ENOMEM;
+  return ptr;
+}
+
+void* malloc(size_t size) {
+  return check(libtock_alloc_malloc(size));
+}
+
+void free(void* ptr) {
+  libtock_alloc_free(ptr);
+}
+
+void* calloc(size_t count, size_t size) {
+  return check(libtock_alloc_calloc(count, size));
+}
+
+void* realloc(void* ptr, size_t size) {
+  return check(libtock_alloc_realloc(ptr, size));
+}
+
+void* memalign(size_t alignment, size_t size) {
+  return check(libtock_alloc_memalign(alignment, size));
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+  return check(libtock_alloc_memalign(alignment, size));
+}
+
+size_t malloc_usable_size(void* ptr) {
+  return libtock_alloc_usable_size(ptr);
+}
+
+void* _malloc_r(__attribute__ ((unused)) struct _reent* r, size_t size) {
+  return malloc(size);
+}
+
+void _free_r(__attribute__ ((unused)) struct _reent* r, void* ptr) {
+  free(ptr);
+}
+
+void* _calloc_r(__attribute__ ((unused)) struct _reent* r, size_t count, size_t size) {
+  return calloc(count, size);
+}
+
+void* _realloc_r(__attribute__ ((unused)) struct _reent* r, void* ptr, size_t size) {
+  return realloc(ptr, size);
+}
+
+void* _memalign_r(__attribute__ ((unused)) struct _reent* r, size_t alignment, size_t size) {
+  return memalign(alignment, size);
+}
+
+size_t _malloc_usable_size_r(__attribute__ ((unused)) struct _reent* r, void* ptr) {
+  return malloc_usable_size(ptr);
+}
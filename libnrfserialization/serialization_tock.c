@@ -7,6 +7,7 @@
 #include <libtock-sync/services/alarm.h>
 #include <libtock/peripherals/gpio.h>
 #include <libtock/net/nrf51_serialization.h>
+#include <libtock/net/syscalls/nrf51_serialization_syscalls.h>
 
 #include "nrf.h"
 #include "ser_phy.h"
@@ -18,30 +19,57 @@
 #include "ble_serialization.h"
 #include "ser_sd_transport.h"
 
+#include "serialization_tock.h"
+
+// Receive buffers shared with the kernel. One buffer at a time is allowed to
+// the kernel. When the kernel reports received data, that buffer is swapped
+// out for a free one and event packets are queued in place, pointing into
+// the swapped-out buffer. A buffer becomes free again once every event in
+// it has been passed to the serialization library. Both sizes are set at
+// build time, see the Makefile.
+#ifndef SERIALIZATION_RX_BUFFERS
+#define SERIALIZATION_RX_BUFFERS 4
+#endif
+
+#ifndef SERIALIZATION_RX_QUEUE_DEPTH
+#define SERIALIZATION_RX_QUEUE_DEPTH 16
+#endif
+
+static uint8_t rx_buffers[SERIALIZATION_RX_BUFFERS][SER_HAL_TRANSPORT_RX_MAX_PKT_SIZE];
+// Number of queued events that point into each buffer.
+static uint16_t rx_buffer_events[SERIALIZATION_RX_BUFFERS];
+// Index of the buffer currently allowed to the kernel.
+static uint8_t _kernel_rx_buffer = 0;
+
 // Circular queue for event packets. Event packets are generated asynchronously
 // from the nRF (e.g. advertisement discovery or read requests).
-#define RX_BUFFER_SIZE 5
-static uint8_t rx_event_buffers[RX_BUFFER_SIZE][SER_HAL_TRANSPORT_RX_MAX_PKT_SIZE];
-static uint8_t _head_event = 0;
-static uint8_t _tail_event = 0;
+typedef struct {
+    uint8_t* packet;
+    uint8_t buffer;
+} rx_event_t;
+static rx_event_t rx_events[SERIALIZATION_RX_QUEUE_DEPTH];
+static uint16_t _head_event = 0;
+static uint16_t _tail_event = 0;
 
 // Single entry queue for receiving response packets after sending commands.
+// There is at most one outstanding response, so it is copied out of the
+// receive buffer rather than holding on to the whole buffer.
 static uint8_t rx_rsp_buffer[SER_HAL_TRANSPORT_RX_MAX_PKT_SIZE];
 static bool _have_rsp_packet = false;
 
-// Buffer to receive packets from the nrf51 in.
-// The upper layer also has a buffer, which we could use, but to make
-// the timing work out better we just keep a buffer around that the kernel
-// can keep a pointer to.
-static uint8_t rx[SER_HAL_TRANSPORT_RX_MAX_PKT_SIZE];
 // This is a pointer to the RX buffer passed in by the upper serialization
 // layer.
 static uint8_t* hal_rx_buf = NULL;
 
-// Buffer to create an outgoing packet into.
-static uint8_t tx[SER_HAL_TRANSPORT_TX_MAX_PKT_SIZE];
-// Length of the outgoing packet.
-static uint16_t tx_len = 0;
+// Buffers to create outgoing packets in. One is being written by the
+// kernel while packets sent in the meantime are appended to the other, and
+// go out together in a single write once the first write completes.
+static uint8_t tx_buffers[2][SER_HAL_TRANSPORT_TX_MAX_PKT_SIZE];
+// Buffer being written, and the buffer new packets are added to.
+static uint8_t _tx_writing = 0;
+// Length and number of packets in each buffer.
+static uint16_t tx_len[2]     = {0, 0};
+static uint16_t tx_packets[2] = {0, 0};
 
 // Callback that we pass TX done and RX events to
 static ser_phy_events_handler_t _ser_phy_event_handler;
@@ -58,10 +86,13 @@ static bool _need_wakeup = false;
 static bool _queued_packets = false;
 // Timer to detect when we fail to get a response message after sending a
 // command.
-static libtock_alarm_t* _timeout_timer = NULL;
+static libtock_alarm_t _timeout_timer;
+static bool _timeout_timer_running = false;
 // yield() variable.
 static bool nrf_serialization_done = false;
 
+static serialization_tock_stats_t _stats;
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
@@ -85,6 +116,109 @@ void ser_app_power_system_off_enter (void);
 void critical_region_enter (void);
 void critical_region_exit (void);
 
+/*******************************************************************************
+ * Receive and transmit buffer management
+ ******************************************************************************/
+
+static uint16_t rx_queue_depth (void) {
+    return (_tail_event + SERIALIZATION_RX_QUEUE_DEPTH - _head_event) % SERIALIZATION_RX_QUEUE_DEPTH;
+}
+
+// Find a buffer, other than the one the kernel has, with no queued events.
+static int find_free_rx_buffer (void) {
+    for (int i = 0; i < SERIALIZATION_RX_BUFFERS; i++) {
+        if (i != _kernel_rx_buffer && rx_buffer_events[i] == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Split the data the kernel received into packets. Responses are copied
+// out, events are queued in place. If events were queued, the kernel is
+// given a free buffer so it does not overwrite them.
+static void receive_packets (int rx_len) {
+    uint8_t buffer = _kernel_rx_buffer;
+    uint8_t* rx    = rx_buffers[buffer];
+
+    // Events can only be kept if there is another buffer to give the kernel.
+    bool can_keep_events = find_free_rx_buffer() >= 0;
+
+    int offset = 0;
+    while (rx_len - offset >= SER_PHY_HEADER_SIZE) {
+        int pktlen = (rx[offset] | rx[offset+1] << 8) + SER_PHY_HEADER_SIZE;
+        // Make sure that pktlen is reasonable
+        if (pktlen > (int) SER_HAL_TRANSPORT_RX_MAX_PKT_SIZE ||
+            pktlen+offset > (int) SER_HAL_TRANSPORT_RX_MAX_PKT_SIZE ||
+            pktlen > rx_len - offset) {
+            // Too big, something went wrong.
+            _stats.rx_dropped++;
+            break;
+        }
+        _stats.rx_packets++;
+
+        // Check which type of packet this is.
+        uint8_t packet_type = rx[offset+2];
+        switch (packet_type) {
+            case SER_PKT_TYPE_RESP:
+            case SER_PKT_TYPE_DTM_RESP:
+                if (_have_rsp_packet) {
+                    printf("Already have response packet?\n");
+                    _stats.rx_dropped++;
+                } else {
+                    _have_rsp_packet = true;
+                    memcpy(rx_rsp_buffer, rx+offset, pktlen);
+
+                    // Got a response, cancel any pending timer
+                    if (_timeout_timer_running) {
+                        libtock_alarm_ms_cancel(&_timeout_timer);
+                        _timeout_timer_running = false;
+                    }
+                }
+                break;
+
+            case SER_PKT_TYPE_EVT:
+                // Check if there is room
+                if (!can_keep_events || (_tail_event + 1) % SERIALIZATION_RX_QUEUE_DEPTH == _head_event) {
+                    _stats.rx_dropped++;
+                    break;
+                }
+                rx_events[_tail_event].packet = rx + offset;
+                rx_events[_tail_event].buffer = buffer;
+                rx_buffer_events[buffer]++;
+                _tail_event = (_tail_event + 1) % SERIALIZATION_RX_QUEUE_DEPTH;
+
+                uint16_t depth = rx_queue_depth();
+                if (depth > _stats.rx_queue_max) {
+                    _stats.rx_queue_max = depth;
+                }
+                break;
+        }
+
+        // Check for another packet in the buffer.
+        offset += pktlen;
+    }
+
+    if (rx_buffer_events[buffer] > 0) {
+        _kernel_rx_buffer = find_free_rx_buffer();
+        libtock_nrf51_serialization_set_readwrite_allow_receive_buffer(rx_buffers[_kernel_rx_buffer],
+                                                                       SER_HAL_TRANSPORT_RX_MAX_PKT_SIZE);
+        _stats.rx_swaps++;
+    }
+}
+
+// Start writing the buffer that packets have been added to.
+static int start_tx_write (void) {
+    _tx_writing = 1 - _tx_writing;
+    _stats.tx_writes++;
+    return libtock_nrf51_serialization_write(tx_buffers[_tx_writing], tx_len[_tx_writing]);
+}
+
+void serialization_tock_get_stats (serialization_tock_stats_t* stats) {
+    *stats = _stats;
+    stats->rx_queue_depth = rx_queue_depth();
+}
+
 /*******************************************************************************
  * Callback from the UART layer in the kernel
  ******************************************************************************/
@@ -94,6 +228,8 @@ void timeout_timer_cb (uint32_t a, uint32_t b, void* opaque) {
     UNUSED_PARAMETER(b);
     UNUSED_PARAMETER(opaque);
 
+    _timeout_timer_running = false;
+
     // Uh oh did not get a response to a command packet.
     // Send up an error.
     _ser_phy_rx_event.evt_type = SER_PHY_EVT_HW_ERROR;
@@ -110,68 +246,29 @@ void ble_serialization_callback (int callback_type, int rx_len, int c, void* oth
     if (callback_type == 1) {
         // TX DONE
 
-        // Reset that we are no longer sending a packet.
-        tx_len = 0;
+        // The packets in the finished write are sent.
+        uint16_t sent = tx_packets[_tx_writing];
+        tx_len[_tx_writing]     = 0;
+        tx_packets[_tx_writing] = 0;
+
+        // Send anything that was queued while the write was in progress.
+        if (tx_len[1 - _tx_writing] > 0) {
+            start_tx_write();
+        }
 
         // Notify the upper layer
         _ser_phy_tx_event.evt_type = SER_PHY_EVT_TX_PKT_SENT;
 
-        if (_ser_phy_event_handler) {
-            _ser_phy_event_handler(_ser_phy_tx_event);
+        for (uint16_t i = 0; i < sent; i++) {
+            if (_ser_phy_event_handler) {
+                _ser_phy_event_handler(_ser_phy_tx_event);
+            }
         }
 
     } else if (callback_type == 4) {
         // RX entire buffer
-
-        // Copy all received packets into our circular buffer
-        int offset = 0;
-        while (1 && (rx_len - offset >= SER_PHY_HEADER_SIZE)) {
-            int pktlen = (rx[offset] | rx[offset+1] << 8) + SER_PHY_HEADER_SIZE;
-            // Make sure that pktlen is reasonable
-            if (pktlen > (int) SER_HAL_TRANSPORT_RX_MAX_PKT_SIZE ||
-                pktlen+offset > (int) SER_HAL_TRANSPORT_RX_MAX_PKT_SIZE ||
-                pktlen > rx_len - offset) {
-                // Too big to copy, something went wrong.
-                break;
-            }
-
-            // Check which type of packet this is.
-            uint8_t packet_type = rx[offset+2];
-            switch (packet_type) {
-                case SER_PKT_TYPE_RESP:
-                case SER_PKT_TYPE_DTM_RESP:
-                    if (_have_rsp_packet) {
-                        printf("Already have response packet?\n");
-                    } else {
-                        _have_rsp_packet = true;
-                        memcpy(rx_rsp_buffer, rx+offset, pktlen);
-
-                        // Got a response, cancel any pending timer
-                        if (_timeout_timer != NULL) {
-                            libtock_alarm_ms_cancel(_timeout_timer);
-                            free(_timeout_timer);
-                            _timeout_timer = NULL;
-                        }
-                    }
-                    break;
-
-                case SER_PKT_TYPE_EVT:
-                    // Check if there is room
-                    if ((_tail_event + 1) % RX_BUFFER_SIZE == _head_event) {
-                        // No empty slots in the queue
-                        break;
-                    }
-                    // Copy into open slot and increment the pointer.
-                    memcpy(rx_event_buffers[_tail_event], rx+offset, pktlen);
-                    _tail_event = (_tail_event + 1) % RX_BUFFER_SIZE;
-                    break;
-            }
-
-            // Check for another packet in the buffer.
-            offset += pktlen;
-            if (rx_len <= offset) {
-                break;
-            }
+        if (rx_len > 0) {
+            receive_packets(rx_len);
         }
 
         // Only pass this buffer up if we don't have any others in flight. We
@@ -189,7 +286,8 @@ void ble_serialization_callback (int callback_type, int rx_len, int c, void* oth
                 // and things break. We use ser_sd_transport_is_busy() to do
                 // this check because it is essentially contingent on there
                 // being an outstanding response for a request.
-                buf_len = (rx_event_buffers[_head_event][0] | rx_event_buffers[_head_event][1] << 8);
+                uint8_t* packet = rx_events[_head_event].packet;
+                buf_len = (packet[0] | packet[1] << 8);
             }
 
             if (buf_len > 0) {
@@ -223,11 +321,14 @@ void ble_serialization_callback (int callback_type, int rx_len, int c, void* oth
                 memcpy(hal_rx_buf, rx_rsp_buffer+SER_PHY_HEADER_SIZE, buf_len);
 
             } else {
-                buf_len = rx_event_buffers[_head_event][0] | (((uint16_t) rx_event_buffers[_head_event][1]) << 8);
-                memcpy(hal_rx_buf, rx_event_buffers[_head_event]+SER_PHY_HEADER_SIZE, buf_len);
-
-                // Remove this packet from our queue.
-                _head_event = (_head_event + 1) % RX_BUFFER_SIZE;
+                rx_event_t* event = &rx_events[_head_event];
+                buf_len = event->packet[0] | (((uint16_t) event->packet[1]) << 8);
+                memcpy(hal_rx_buf, event->packet+SER_PHY_HEADER_SIZE, buf_len);
+
+                // Remove this packet from our queue, which frees its receive
+                // buffer once it holds no more queued events.
+                rx_buffer_events[event->buffer]--;
+                _head_event = (_head_event + 1) % SERIALIZATION_RX_QUEUE_DEPTH;
             }
 
             _ser_phy_rx_event.evt_type = SER_PHY_EVT_RX_PKT_RECEIVED;
@@ -248,6 +349,7 @@ void ble_serialization_callback (int callback_type, int rx_len, int c, void* oth
         } else {
             // Buffer is NULL. That means we have to drop this packet. We also
             // need to notify the serialization library that we did so.
+            _stats.rx_dropped++;
             _ser_phy_rx_event.evt_type = SER_PHY_EVT_RX_PKT_DROPPED;
             if (_ser_phy_event_handler) {
                 _receiving_packet = false;
@@ -329,7 +431,8 @@ uint32_t ser_phy_open (ser_phy_events_handler_t events_handler) {
     ret = libtock_nrf51_serialization_set_upcall(ble_serialization_callback, NULL);
     if (ret < 0) return NRF_ERROR_INTERNAL;
 
-    ret = libtock_nrf51_serialization_set_readwrite_allow_receive_buffer(rx, SER_HAL_TRANSPORT_RX_MAX_PKT_SIZE);
+    ret = libtock_nrf51_serialization_set_readwrite_allow_receive_buffer(rx_buffers[_kernel_rx_buffer],
+                                                                         SER_HAL_TRANSPORT_RX_MAX_PKT_SIZE);
     if (ret < 0) return NRF_ERROR_INTERNAL;
 
     ret = libtock_nrf51_serialization_read(SER_HAL_TRANSPORT_RX_MAX_PKT_SIZE, &bytes_read);
@@ -349,32 +452,45 @@ uint32_t ser_phy_tx_pkt_send (const uint8_t* p_buffer, uint16_t num_of_bytes) {
         return NRF_ERROR_INVALID_PARAM;
     }
 
-    // Check if there is no ongoing transmission at the moment
-    if (tx_len == 0) {
-        // We need to set a timer in case we never get the response packet.
-        if (ser_sd_transport_is_busy()) {
-            _timeout_timer = (libtock_alarm_t*)malloc(sizeof(libtock_alarm_t));
-            libtock_alarm_in_ms(100, timeout_timer_cb, NULL, _timeout_timer);
+    // Packets are added to the buffer that is not being written.
+    uint8_t next = 1 - _tx_writing;
+    if (tx_len[next] + SER_PHY_HEADER_SIZE + num_of_bytes > SER_HAL_TRANSPORT_TX_MAX_PKT_SIZE) {
+        _stats.tx_busy++;
+        return NRF_ERROR_BUSY;
+    }
+
+    // We need to set a timer in case we never get the response packet.
+    if (ser_sd_transport_is_busy()) {
+        if (_timeout_timer_running) {
+            libtock_alarm_ms_cancel(&_timeout_timer);
         }
+        libtock_alarm_in_ms(100, timeout_timer_cb, NULL, &_timeout_timer);
+        _timeout_timer_running = true;
+    }
 
-        // Encode the number of bytes as the first two bytes of the outgoing
-        // packet.
-        tx[0] = num_of_bytes & 0xFF;
-        tx[1] = (num_of_bytes >> 8) & 0xFF;
+    // Encode the number of bytes as the first two bytes of the outgoing
+    // packet.
+    uint8_t* tx = tx_buffers[next] + tx_len[next];
+    tx[0] = num_of_bytes & 0xFF;
+    tx[1] = (num_of_bytes >> 8) & 0xFF;
 
-        // Copy in the outgoing data
-        memcpy(tx+2, p_buffer, num_of_bytes);
+    // Copy in the outgoing data
+    memcpy(tx+2, p_buffer, num_of_bytes);
 
-        // Add in that we added the header (2 length bytes)
-        tx_len = num_of_bytes + SER_PHY_HEADER_SIZE;
+    // Add in that we added the header (2 length bytes)
+    tx_len[next] += num_of_bytes + SER_PHY_HEADER_SIZE;
+    tx_packets[next]++;
+    _stats.tx_packets++;
 
-        // Call tx procedure to start transmission of a packet
-        int ret = libtock_nrf51_serialization_write(tx, tx_len);
+    // Start the write now unless one is already in progress, in which case
+    // this packet goes out with the next write.
+    if (tx_len[_tx_writing] == 0) {
+        int ret = start_tx_write();
         if (ret < 0) {
+            tx_len[_tx_writing]     = 0;
+            tx_packets[_tx_writing] = 0;
             return NRF_ERROR_INTERNAL;
         }
-    } else {
-        return NRF_ERROR_BUSY;
     }
 
     return NRF_SUCCESS;
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Counters kept by the Tock serialization transport.
+typedef struct {
+    // Packets received from the nRF, and packets dropped because they were
+    // malformed, the event queue was full, or no receive buffer was free.
+    uint32_t rx_packets;
+    uint32_t rx_dropped;
+    // Times a receive buffer holding events was swapped out of the kernel.
+    uint32_t rx_swaps;
+    // Events currently queued, and the most ever queued at once.
+    uint32_t rx_queue_depth;
+    uint32_t rx_queue_max;
+    // Packets sent to the nRF, the writes they were sent in, and packets
+    // refused because the transmit buffer was full.
+    uint32_t tx_packets;
+    uint32_t tx_writes;
+    uint32_t tx_busy;
+} serialization_tock_stats_t;
+
+// Copy the current transport counters into `stats`.
+void serialization_tock_get_stats(serialization_tock_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,147 +1,186 @@
 #include <services/alarm.h>
 
+#include <openthread/platform/alarm-micro.h>
 #include <openthread/platform/alarm-milli.h>
+#include <openthread/platform/time.h>
 #include <plat.h>
 
-#include <stdio.h>
-#include <assert.h>
-
+#include "openthread-core-tock-config.h"
+
+// OpenThread keeps time as 32-bit millisecond (and microsecond) counters
+// that wrap, while the kernel alarm is a 32-bit tick counter that wraps at a
+// different point. Rather than converting between the two wrapping counters
+// directly, all time is kept on a 64-bit tick timeline that never wraps in
+// practice. OpenThread's timestamps are the low 32 bits of that timeline
+// converted to milli/microseconds, and alarm deadlines are stored as 64-bit
+// tick values.
+//
+// A single libtock alarm is shared by the millisecond alarm, the
+// microsecond alarm, and a guard that makes sure the 64-bit clock is read at
+// least once per half tick-counter period, so that no wrap is missed. The
+// alarm upcall only records that the alarm fired. The deadlines are checked
+// and OpenThread is notified from `otSysProcessDrivers`, so the main loop can
+// sleep in `yield()` until the next deadline instead of waking up to poll.
+
+// Longest time the hardware alarm is set for, so the 64-bit clock observes
+// every wrap of the 32-bit tick counter.
+#define GUARD_TICKS (1u << 31)
+
+#define NO_DEADLINE UINT64_MAX
 
 static libtock_alarm_ticks_t alarm;
-static libtock_alarm_t timer_wrap;
 static uint32_t frequency = 0;
 
-// maintain global variables to be used for timer wrapping logic
-uint32_t wrap_point = 0;
-uint32_t wrap_count;
-uint32_t prev_time_value;
+// 64-bit tick clock state.
+static uint32_t clock_high = 0;
+static uint32_t clock_last = 0;
+
+static uint64_t milli_deadline = NO_DEADLINE;
+static uint64_t micro_deadline = NO_DEADLINE;
 
-static bool pending_alarm_done_callback = false;
+static bool alarm_fired = false;
 
-static void alarm_done_callback(uint32_t __attribute__((unused)) now, 
-						   uint32_t __attribute__((unused)) scheduled, 
-						   void __attribute__((unused)) *aInstance) {
-	pending_alarm_done_callback = true;
+static uint32_t clock_frequency(void) {
+	if (frequency == 0) {
+		libtock_alarm_command_get_frequency(&frequency);
+	}
+	return frequency;
 }
 
-bool pending_alarm_done_callback_status(void) {
-	return pending_alarm_done_callback;
+// Extend the 32-bit tick counter to 64 bits. This must be called at least
+// once per 2^32 ticks, which the guard alarm ensures.
+static uint64_t now_ticks(void) {
+	uint32_t low;
+	libtock_alarm_command_read(&low);
+	if (low < clock_last) {
+		clock_high++;
+	}
+	clock_last = low;
+	return ((uint64_t) clock_high << 32) | low;
 }
 
-void reset_pending_alarm_done_callback(void) {
-	pending_alarm_done_callback = false;
+// Exact conversion of ticks to `units_per_second` units (rounded down).
+// Whole seconds and the remainder are converted separately so the
+// intermediate products cannot overflow.
+static uint64_t ticks_to_units(uint64_t ticks, uint32_t units_per_second) {
+	uint32_t freq = clock_frequency();
+	return (ticks / freq) * units_per_second +
+	       ((ticks % freq) * units_per_second) / freq;
 }
 
-// convert ms to physical clock ticks (this should be done using the timer_in method,
-// but this works in the meantime)
-static uint32_t milliToTicks(uint32_t ms) {
-  if (frequency == 0) {
-    libtock_alarm_command_get_frequency(&frequency);
-  }
-  return (ms / 1000) * frequency + (ms % 1000) * (frequency / 1000);
+// The first tick at which `ticks_to_units` reaches `units`.
+static uint64_t units_to_ticks(uint64_t units, uint32_t units_per_second) {
+	uint32_t freq = clock_frequency();
+	return (units / units_per_second) * freq +
+	       ((units % units_per_second) * freq + units_per_second - 1) / units_per_second;
 }
 
-void otPlatAlarmMilliStartAt(otInstance *aInstance, uint32_t aT0, uint32_t aDt){
-	// printf("Starting alarm at %d, with interval %d\n", aT0, aDt);
-	OT_UNUSED_VARIABLE(aInstance);
-	// TODO: this implementation for the alarm is temporary. Future implementation
-	// should use the `timer_in` functionality to set the alarm.
-
-	// check that aT0 and aDt are both less than max
-	// uint32_t. this is a temporary fix until we implement
-	// the wrap around functionality
-	if ((aT0 > UINT32_MAX) || (aDt > UINT32_MAX)) {
-		assert(false);
-		return;
+// Convert an OpenThread alarm (`t0 + dt`, both in wrapping 32-bit units)
+// into a deadline on the 64-bit tick timeline. `t0` may be in the past, and
+// `t0 + dt` may already have passed, in which case the deadline is now.
+static uint64_t deadline_ticks(uint64_t now, uint32_t t0, uint32_t dt, uint32_t units_per_second) {
+	uint64_t now_units = ticks_to_units(now, units_per_second);
+	uint32_t elapsed   = (uint32_t) now_units - t0;
+	if (elapsed >= dt) {
+		return now;
 	}
+	return units_to_ticks(now_units + (dt - elapsed), units_per_second);
+}
 
-	// inputs aT0, aDt are in ms, but libtock call must be in clock ticks
-	uint32_t ref = milliToTicks(aT0);
-	uint32_t dt  = milliToTicks(aDt);
-
-	// NOTE: This is a problem that will have to be fixed. Thread wants to
-	// be able to set a 2^32 millisecond timer. However, when converting
-	// milliseconds into clock ticks, the multiplication will overflow.
-	//
-	// OpenThread expects to be able to use the full 32 bit range in milliseconds.
-	libtock_alarm_at(ref, dt, alarm_done_callback, (void *)aInstance, &alarm);
+static void alarm_upcall(uint32_t __attribute__((unused)) now,
+						 uint32_t __attribute__((unused)) scheduled,
+						 void __attribute__((unused)) *ud) {
+	alarm_fired = true;
 }
 
-void otPlatAlarmMilliStop(otInstance *aInstance) {
-	OT_UNUSED_VARIABLE(aInstance);
+// Set the hardware alarm for the earliest deadline, or the wrap guard.
+// The alarm stays armed even when a deadline is already due, as cancelling
+// the only outstanding libtock alarm leaves the kernel alarm set.
+static void schedule_alarm(void) {
+	uint64_t now  = now_ticks();
+	uint64_t next = milli_deadline < micro_deadline ? milli_deadline : micro_deadline;
+	uint64_t dt   = GUARD_TICKS;
+
+	if (next <= now) {
+		// Already due, handle it on the next pass of the main loop without
+		// a round trip through the kernel.
+		alarm_fired = true;
+	} else if (next - now < GUARD_TICKS) {
+		dt = next - now;
+	}
+
 	libtock_alarm_cancel(&alarm);
+	libtock_alarm_at((uint32_t) now, (uint32_t) dt, alarm_upcall, NULL, &alarm);
+}
+
+void init_otPlatAlarm(void) {
+	clock_frequency();
+	now_ticks();
+	schedule_alarm();
 }
 
+bool pending_alarm_status(void) {
+	return alarm_fired;
+}
+
+void process_otPlatAlarm(otInstance *aInstance) {
+	if (!alarm_fired) {
+		return;
+	}
+	alarm_fired = false;
+
+	uint64_t now = now_ticks();
+
+	if (milli_deadline <= now) {
+		milli_deadline = NO_DEADLINE;
+		otPlatAlarmMilliFired(aInstance);
+	}
 
+#if OPENTHREAD_CONFIG_PLATFORM_USEC_TIMER_ENABLE
+	if (micro_deadline <= now) {
+		micro_deadline = NO_DEADLINE;
+		otPlatAlarmMicroFired(aInstance);
+	}
+#else
+	OT_UNUSED_VARIABLE(aInstance);
+#endif
 
-static void wrap_time_upcall(uint32_t __attribute__((unused)) now, uint32_t __attribute__((unused)) scheduled, void __attribute__((unused)) *_ud) {
-	// Timer for detecting wrapping event has fired. Call otPlatAlarmMilliGetNow()
-	// to check check if a wrap has occured.
-	otPlatAlarmMilliGetNow();
+	// Re-arm for the next deadline or the wrap guard.
+	schedule_alarm();
 }
 
-// OpenThread timing initializer to obtain the wrap point
-void init_otPlatAlarm(void) {
-	// libtock alarms overflow at 2^{32} ticks. We
-	// desire to find the time at which this overflow
-	// will occur to set an alarm. The reason for this
-	// alarm is elaborated upon in `otPlatAlarmMilliGetNow`.
+void otPlatAlarmMilliStartAt(otInstance *aInstance, uint32_t aT0, uint32_t aDt) {
+	OT_UNUSED_VARIABLE(aInstance);
+	milli_deadline = deadline_ticks(now_ticks(), aT0, aDt, 1000);
+	schedule_alarm();
+}
 
-	libtock_alarm_command_get_frequency(&frequency);
-	wrap_point = ((UINT32_MAX) / frequency) * 1000;
-	// account for leftover ticks
-	uint64_t left_over_ticks = ((UINT32_MAX % frequency) * 1000) / frequency;
-	wrap_point += (uint32_t) left_over_ticks;
-	libtock_alarm_repeating_every_ms(wrap_point >> 1, wrap_time_upcall, NULL, &timer_wrap);
-	prev_time_value = otPlatAlarmMilliGetNow();
+void otPlatAlarmMilliStop(otInstance *aInstance) {
+	OT_UNUSED_VARIABLE(aInstance);
+	milli_deadline = NO_DEADLINE;
+	schedule_alarm();
 }
 
 uint32_t otPlatAlarmMilliGetNow(void) {
-	// This method faces the unique challenge of handling
-	// libtock timers wrapping at 2^{32} bits. This creates
-	// challenges at the wrap point as `gettimeasticks` will
-	// wrap to be zero. We subsequently need `otPlatAlarmMilliGetNow`
-	// to account for this so that we can provide time values
-	// past 2^{32} ticks.
-	//
-	// We implement this logic by obtaining the timepoint at which
-	// timer wraps occur and counting the number of wrapping events
-	// that have occured. Together, these two values allow for the
-	// "getNow" time to be calculated. For this to work, we must
-	// ensure that we detect every wrapping event. We set a timer
-	// for this purpose to occur when the ticks value is halfway
-	// to wrapping. This is done to guard against the corner case
-	// of other latencies resulting in missed overflow events.
-	//
-	// This approach has the obvious drawback of "waking up"
-	// more often than otherwise necessary. This concern would
-	// be particularly pronounced for low power thread devices.
-	// However, the current Tock OpenThread port is not optimized
-	// for allowing sleep and this is subsequently not a major
-	// concern at this juncture.
-
-	// We will check for overflows here and subsequently cancel and
-	// reset the alarm.
-
-	struct timeval tv;
-	libtock_alarm_gettimeasticks(&tv);
-
-	uint32_t nowSeconds    = tv.tv_sec;
-	uint32_t nowMicro      = tv.tv_usec;
-	uint32_t nowMilli32bit = (nowSeconds * 1000) + (nowMicro / 1000);
-
-	nowMilli32bit += wrap_count * wrap_point;
-
-	// detect wrapping event
-	if (nowMilli32bit < prev_time_value) {
-		wrap_count++;
-		nowMilli32bit += wrap_count * wrap_point;
-	}
+	return (uint32_t) ticks_to_units(now_ticks(), 1000);
+}
+
+void otPlatAlarmMicroStartAt(otInstance *aInstance, uint32_t aT0, uint32_t aDt) {
+	OT_UNUSED_VARIABLE(aInstance);
+	micro_deadline = deadline_ticks(now_ticks(), aT0, aDt, 1000000);
+	schedule_alarm();
+}
 
-	prev_time_value = nowMilli32bit;
+void otPlatAlarmMicroStop(otInstance *aInstance) {
+	OT_UNUSED_VARIABLE(aInstance);
+	micro_deadline = NO_DEADLINE;
+	schedule_alarm();
+}
+
+uint32_t otPlatAlarmMicroGetNow(void) {
+	return (uint32_t) ticks_to_units(now_ticks(), 1000000);
+}
 
-	// Set timer to ensure we do not miss a wrapping event.
-	// (TODO: add more detailed comment and confirm this will guarad
-	// against missed wrapping event)
-	return nowMilli32bit;
+uint64_t otPlatTimeGet(void) {
+	return ticks_to_units(now_ticks(), 1000000);
 }
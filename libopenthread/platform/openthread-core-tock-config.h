@@ -199,7 +199,7 @@
  *
  */
 #ifndef OPENTHREAD_CONFIG_PLATFORM_USEC_TIMER_ENABLE
-#define OPENTHREAD_CONFIG_PLATFORM_USEC_TIMER_ENABLE 0
+#define OPENTHREAD_CONFIG_PLATFORM_USEC_TIMER_ENABLE 1
 #endif
 
 /**
@@ -95,6 +95,52 @@ extern void otSysEventSignalPending(void);
 
 otError otTockStartReceive(uint8_t aChannel, otInstance *aInstance);
 
+/**
+ * Counters for the radio receive path.
+ *
+ * Received frames are passed to OpenThread in place, from the kernel ring
+ * buffer they were received into, and are never copied.
+ *
+ */
+typedef struct otTockRxStats
+{
+    uint32_t frames;    ///< Frames passed to OpenThread.
+    uint32_t dropped;   ///< Frames discarded because their length was invalid.
+    uint32_t swaps;     ///< Kernel ring buffer swaps.
+    uint32_t deferred;  ///< Receive upcalls that arrived while OpenThread still held the other buffer.
+    uint32_t max_batch; ///< Most frames found in a buffer when it was swapped out.
+} otTockRxStats;
+
+/**
+ * Copies the receive path counters into @p aStats.
+ *
+ */
+void otTockGetRxStats(otTockRxStats *aStats);
+
+/**
+ * Counters for the radio transmit path.
+ *
+ * Every transmission OpenThread requests ends in exactly one of `delivered`,
+ * `no_ack`, `channel_access_failures` or `failed`. `retries` counts the
+ * retransmissions made while waiting for an ACK.
+ *
+ */
+typedef struct otTockTxStats
+{
+    uint32_t frames;                  ///< Transmissions requested by OpenThread.
+    uint32_t delivered;               ///< Frames acknowledged, or sent without requesting an ACK.
+    uint32_t retries;                 ///< Retransmissions after a missing ACK.
+    uint32_t no_ack;                  ///< Frames still unacknowledged after the last retry.
+    uint32_t channel_access_failures; ///< Frames dropped because CSMA-CA found the channel busy.
+    uint32_t failed;                  ///< Frames that could not be started, or the kernel failed to send for another reason.
+} otTockTxStats;
+
+/**
+ * Copies the transmit path counters into @p aStats.
+ *
+ */
+void otTockGetTxStats(otTockTxStats *aStats);
+
 #ifdef __cplusplus
 } // end of extern "C"
 #endif
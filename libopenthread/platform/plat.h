@@ -3,31 +3,23 @@
 #include <openthread/platform/radio.h>
 
 
-// Userspace ring buffer for handling async received upcalls 
-// from the kernel while performing potentially sync (yielding)
-// operations. The need for this is explained in more detail in
-// the comment at the top of `system.c`. The new field is used
-// to prevent `otSysProcessDrivers` from performing unnecessary
-// work if new data has not arrived. 
-typedef struct {
-    char *buffer;
-    int write_index;
-    int read_index;
-    bool new;
-} ring_buffer;
+// The kernel does not report the RSSI or LQI of received frames, so frames
+// and ACKs passed to OpenThread carry these fixed values. Together with the
+// receive sensitivity they give every link a good link margin.
+#define TOCK_RADIO_RSSI_ESTIMATE       (-50)
+#define TOCK_RADIO_LQI_ESTIMATE        0x7f
+#define TOCK_RADIO_RECEIVE_SENSITIVITY (-100)
 
-bool pending_alarm_done_callback_status(void);
+// True once a transmission, including any retransmissions, has finished
+// and `process_otPlatRadioTx` has a result to report.
+bool pending_tx_done_callback_status(void);
 
-void reset_pending_alarm_done_callback(void);
-
-bool pending_tx_done_callback_status(otRadioFrame *ackFrame, returncode_t *status, otRadioFrame* txFrame);
-
-void reset_pending_tx_done_callback(void);
+// Report a finished transmission to OpenThread. Called from
+// `otSysProcessDrivers`.
+void process_otPlatRadioTx(otInstance *aInstance);
 
 bool pending_rx_done_callback_status(void);
 
-void reset_pending_rx_done_callback(void);
-
 // Check if there are pending events that need to be handled before
 // calling yield(). These events can be generated if the application happens
 // to call yield() somewhere besides the main OpenThread loop.
@@ -35,3 +27,11 @@ bool openthread_platform_pending_work(void);
 
 // Initializer needed for alarm PAL methods.
 void init_otPlatAlarm(void);
+
+// True once the alarm backend's kernel alarm has fired (or an alarm was
+// started that is already due) and `process_otPlatAlarm` has work to do.
+bool pending_alarm_status(void);
+
+// Notify OpenThread of expired millisecond and microsecond alarms and
+// re-arm the kernel alarm. Called from `otSysProcessDrivers`.
+void process_otPlatAlarm(otInstance *aInstance);
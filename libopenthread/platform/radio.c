@@ -1,15 +1,28 @@
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <libtock-sync/net/ieee802154.h>
 #include <libtock/net/eui64.h>
 #include <libtock/net/ieee802154.h>
+#include <libtock/services/alarm.h>
 
 #include <openthread/platform/radio.h>
 
 #include "openthread-system.h"
 #include "plat.h"
 
-#define ACK_SIZE 3
+// Immediate ACK: frame control (2), sequence number (1) and FCS (2).
+#define ACK_SIZE 5
+
+// Frame control bits in the first byte of a frame.
+#define FCF_FRAME_TYPE_ACK 0x02
+#define FCF_ACK_REQUEST    0x20
+
+// The unit backoff period (20 symbols) and the range of the backoff exponent
+// used between retransmissions.
+#define UNIT_BACKOFF_US 320
+#define MIN_BE          3
+#define MAX_BE          5
 
 returncode_t ieee802154_set_channel_and_commit(uint8_t channel);
 
@@ -19,38 +32,154 @@ static otRadioFrame transmitFrame = {
   .mLength = OT_RADIO_FRAME_MAX_SIZE
 };
 
-// nrf52840 ACK on transmit is currently unimplemented. We fake this
-// for now by always saying the sent packet was ACKed by the receiver.
-static uint8_t ack_mPSdu[ACK_SIZE] = {0x02, 0x00, 0x00};
+// The kernel reports whether a transmitted frame was acknowledged, but not
+// the ACK itself. An immediate ACK carries nothing but the sequence number
+// and the frame pending bit, so it is rebuilt from the transmitted frame.
+// The kernel does not report the frame pending bit, so it is always clear.
+static uint8_t ack_mPSdu[ACK_SIZE];
 static otRadioFrame ackFrame_radio = {
   .mPsdu   = ack_mPSdu,
-  .mLength = 3
+  .mLength = ACK_SIZE
 };
 
+// The kernel performs CSMA-CA and waits for the ACK, but does not
+// retransmit. Retransmissions, separated by a random backoff, are done
+// here so that OpenThread sees a single transmission that either was
+// acknowledged or ran out of retries.
+static struct tx_state {
+  otRadioFrame* frame;
+  bool ack_requested;
+  uint8_t retries;
+  uint8_t max_retries;
+  libtock_alarm_ticks_t backoff;
+} tx_state;
+
 static struct pending_tx_done_callback {
   bool flag;
-  bool acked;
-  returncode_t ret;
-} pending_tx_done_callback = {false, false, RETURNCODE_FAIL};
+  otError error;
+  otRadioFrame* ack;
+} pending_tx_done_callback = {false, OT_ERROR_NONE, NULL};
+
+static otTockTxStats tx_stats;
+
+static void tx_done_callback(returncode_t ret, bool acked);
+
+static void finish_transmit(otError error, bool acked) {
+  switch (error) {
+    case OT_ERROR_NONE:
+      tx_stats.delivered++;
+      break;
+    case OT_ERROR_NO_ACK:
+      tx_stats.no_ack++;
+      break;
+    case OT_ERROR_CHANNEL_ACCESS_FAILURE:
+      tx_stats.channel_access_failures++;
+      break;
+    default:
+      tx_stats.failed++;
+      break;
+  }
 
-static void tx_done_callback(returncode_t ret, bool acked) {
-	pending_tx_done_callback.flag = true;
-  pending_tx_done_callback.acked = acked;
-  pending_tx_done_callback.ret = ret;
+  pending_tx_done_callback.error = error;
+  pending_tx_done_callback.ack   = NULL;
+  if (acked) {
+    ack_mPSdu[0] = FCF_FRAME_TYPE_ACK;
+    ack_mPSdu[1] = 0x00;
+    ack_mPSdu[2] = tx_state.frame->mPsdu[2];
+    ackFrame_radio.mChannel = tx_state.frame->mChannel;
+    ackFrame_radio.mInfo.mRxInfo.mRssi = TOCK_RADIO_RSSI_ESTIMATE;
+    ackFrame_radio.mInfo.mRxInfo.mLqi  = TOCK_RADIO_LQI_ESTIMATE;
+    pending_tx_done_callback.ack       = &ackFrame_radio;
+  }
+  pending_tx_done_callback.flag = true;
+}
+
+static returncode_t send_frame(void) {
+  // The Tock raw 15.4 driver expects frames that do not include the MFR (aka
+  // the CRC bytes). OpenThread gives us the full frame, so we just drop the
+  // final two bytes.
+  return libtock_ieee802154_send_raw(tx_state.frame->mPsdu, tx_state.frame->mLength - 2, tx_done_callback);
+}
+
+static void backoff_done_callback(uint32_t __attribute__((unused)) now,
+                                  uint32_t __attribute__((unused)) scheduled,
+                                  void __attribute__((unused)) *ud) {
+  if (send_frame() != RETURNCODE_SUCCESS) {
+    finish_transmit(OT_ERROR_ABORT, false);
+  }
+}
+
+// Wait a random number of unit backoff periods, with the backoff exponent
+// growing with each retry, before sending the frame again.
+static void schedule_retransmit(void) {
+  static bool seeded = false;
+  uint32_t now;
+  libtock_alarm_command_read(&now);
+
+  if (!seeded) {
+    uint64_t eui64 = 0;
+    libtock_eui64_get(&eui64);
+    srand((unsigned) (eui64 ^ (eui64 >> 32) ^ now));
+    seeded = true;
+  }
+
+  uint32_t be = MIN_BE + tx_state.retries - 1;
+  if (be > MAX_BE) {
+    be = MAX_BE;
+  }
+  uint32_t periods = (uint32_t) rand() & ((1u << be) - 1);
+
+  uint32_t frequency;
+  libtock_alarm_command_get_frequency(&frequency);
+  uint32_t ticks = (uint32_t) (((uint64_t) periods * UNIT_BACKOFF_US * frequency + 999999) / 1000000);
+
+  if (ticks == 0) {
+    backoff_done_callback(now, now, NULL);
+    return;
+  }
+  libtock_alarm_at(now, ticks, backoff_done_callback, NULL, &tx_state.backoff);
 }
 
-bool pending_tx_done_callback_status(otRadioFrame *ackFrame, returncode_t *ret, otRadioFrame *txFrame) {
-  if (pending_tx_done_callback.flag) {
-    *ackFrame = ackFrame_radio;
-    *ret = pending_tx_done_callback.ret;
-    *txFrame = transmitFrame;
+static void tx_done_callback(returncode_t ret, bool acked) {
+  if (ret == RETURNCODE_SUCCESS && (acked || !tx_state.ack_requested)) {
+    finish_transmit(OT_ERROR_NONE, acked);
+    return;
+  }
+
+  if (ret == RETURNCODE_EBUSY) {
+    // The kernel's CSMA-CA did not find the channel clear.
+    finish_transmit(OT_ERROR_CHANNEL_ACCESS_FAILURE, false);
+    return;
   }
 
+  if (ret != RETURNCODE_SUCCESS && ret != RETURNCODE_ENOACK) {
+    finish_transmit(OT_ERROR_ABORT, false);
+    return;
+  }
+
+  if (tx_state.retries < tx_state.max_retries) {
+    tx_state.retries++;
+    tx_stats.retries++;
+    schedule_retransmit();
+    return;
+  }
+  finish_transmit(OT_ERROR_NO_ACK, false);
+}
+
+bool pending_tx_done_callback_status(void) {
   return pending_tx_done_callback.flag;
 }
 
-void reset_pending_tx_done_callback(void) {
-	pending_tx_done_callback.flag = false;
+void process_otPlatRadioTx(otInstance *aInstance) {
+  if (!pending_tx_done_callback.flag) {
+    return;
+  }
+  pending_tx_done_callback.flag = false;
+  otPlatRadioTxDone(aInstance, tx_state.frame, pending_tx_done_callback.ack, pending_tx_done_callback.error);
+}
+
+void otTockGetTxStats(otTockTxStats *aStats) {
+  *aStats = tx_stats;
 }
 
 // Helper method for setting radio channel and calling config commit.
@@ -162,18 +291,24 @@ otError otPlatRadioTransmit(otInstance *aInstance, otRadioFrame *aFrame) {
     otPlatRadioEnable(aInstance);
   }
 
-  // The Tock raw 15.4 driver expects frames that do not include the MFR (aka
-  // the CRC bytes). OpenThread gives us the full frame, so we just drop the
-  // final two bytes.
-  aFrame->mLength = aFrame->mLength - 2;
+  // A transmission that cannot be started ends here, without a TxDone, so
+  // it is counted as failed.
+  tx_stats.frames++;
 
   int retCode = ieee802154_set_channel_and_commit(aFrame->mChannel);
   if (retCode != RETURNCODE_SUCCESS) {
+    tx_stats.failed++;
     return OT_ERROR_FAILED;
   }
 
-  returncode_t send_result =  libtock_ieee802154_send_raw((uint8_t*) aFrame->mPsdu, aFrame->mLength, tx_done_callback);
+  tx_state.frame         = aFrame;
+  tx_state.ack_requested = (aFrame->mPsdu[0] & FCF_ACK_REQUEST) != 0;
+  tx_state.retries       = 0;
+  tx_state.max_retries   = aFrame->mInfo.mTxInfo.mMaxFrameRetries;
+
+  returncode_t send_result = send_frame();
   if (send_result != RETURNCODE_SUCCESS) {
+    tx_stats.failed++;
     return OT_ERROR_FAILED;
   }
 
@@ -187,20 +322,18 @@ otRadioFrame *otPlatRadioGetTransmitBuffer(otInstance *aInstance) {
 }
 
 int8_t otPlatRadioGetRssi(otInstance *aInstance) {
-  // TODO this is hardcoded to be -50 dbm currently. This will
-  // result in the link quality indicator (LQI) to be excellent
+  // The kernel does not report RSSI, see `TOCK_RADIO_RSSI_ESTIMATE`.
   OT_UNUSED_VARIABLE(aInstance);
-  // printf("%s:%d in %s\n", __FILE__, __LINE__, __func__);
-  return -50;
+  return TOCK_RADIO_RSSI_ESTIMATE;
 }
 
 otRadioCaps otPlatRadioGetCaps(otInstance *aInstance) {
-  // TODO: Keeping this here as a placeholder to think
-  // more about what capabilites we want to define for openthread.
-  // Currently, we implement CSMA-CA backoff in the radio driver,
-  // but we may add the security capability.
+  // CSMA-CA backoff and the ACK timeout are implemented in the kernel radio
+  // driver, and retransmissions in `tx_done_callback`. We may add the
+  // security capability.
   OT_UNUSED_VARIABLE(aInstance);
-  return (otRadioCaps)(OT_RADIO_CAPS_CSMA_BACKOFF | OT_RADIO_CAPS_SLEEP_TO_TX);
+  return (otRadioCaps)(OT_RADIO_CAPS_ACK_TIMEOUT | OT_RADIO_CAPS_TRANSMIT_RETRIES |
+                       OT_RADIO_CAPS_CSMA_BACKOFF | OT_RADIO_CAPS_SLEEP_TO_TX);
 }
 
 bool otPlatRadioGetPromiscuous(otInstance *aInstance) {
@@ -312,9 +445,6 @@ otError otPlatRadioSetCcaEnergyDetectThreshold(otInstance *aInstance, int8_t aTh
 }
 
 int8_t otPlatRadioGetReceiveSensitivity(otInstance *aInstance) {
-  // TODO this is hardcoded to be -50 dbm currently. This will
-  // result in the link quality indicator (LQI) to be excellent
   OT_UNUSED_VARIABLE(aInstance);
-  // printf("%s:%d in %s\n", __FILE__, __LINE__, __func__);
-  return -50;
+  return TOCK_RADIO_RECEIVE_SENSITIVITY;
 }
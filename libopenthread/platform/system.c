@@ -21,62 +21,49 @@
 // challenging given the sync/async nature of the kernel upcalls.
 // Apps only receive upcalls when they have yielded. Conversely,
 // this means that an app will receive a pending upcall whenever
-// yield is called. This can lead to strange behavior and receiving
-// packets out of order if an app yields before completing copying
-// the packet from the buffer shared with the kernel to the buffer
-// passed to OpenThread. A ring buffer is used to handle receiving
-// and buffering multiple packets within the kernel (share ring buffer
-// with kernel). We also use a userspace ring buffer to hand the
-// aforementioned async issues. This allows the packet reception
-// for an OpenThread app to work as follows:
+// yield is called. OpenThread may call libtock functions that yield
+// while it is processing a received frame, so the frame must not be
+// overwritten until `otPlatRadioReceiveDone` returns.
+//
+// Two kernel ring buffers are used. One is always shared with the
+// kernel. When the kernel signals that frames have arrived, the
+// buffers are swapped: the other (empty) buffer is shared with the
+// kernel and the filled buffer is handed to OpenThread in place, with
+// each `otRadioFrame` pointing directly at the frame in the buffer.
+// Packet reception works as follows:
 //  1. App shares a kernel ring buffer with the kernel (read/write buffer).
 //  2. Kernel schedules an upcall to notify app.
 //  3. App yields allowing upcall to be handled.
-//  4. App copies data from kernel ring buffer to userspace ring buffer.
-//  5. App copies data from userspace ring buffer to OpenThread instance.
-//
-// Although the userspace ring buffer may appear redundant, it is necessary
-// as OpenThread may call libtock functions that yield while OpenThread
-// possess the buffer holding the receiving packet. The use of a ring buffer
-// allows for us to prevent the receive upcall from overwriting the buffer
-// OpenThread is currently copying to the OpenThread instance (leading to packets)
-// being receiving out of order or potentially overwritten.
+//  4. The upcall swaps buffers, unless OpenThread still holds the
+//     previously swapped-out buffer. In that case the kernel keeps
+//     filling its buffer and the swap happens once OpenThread is done.
+//  5. `otSysProcessDrivers` passes each frame in the swapped-out buffer
+//     to OpenThread, then releases the buffer for the next swap.
 
 static libtock_ieee802154_rxbuf rx_buf_a;
 static libtock_ieee802154_rxbuf rx_buf_b;
 
-#define USER_RX_BUF_FRAME_COUNT 3
-static char buf[libtock_ieee802154_FRAME_LEN * USER_RX_BUF_FRAME_COUNT];
-ring_buffer usr_rx_buffer = {
-  .buffer      = buf,
-  .write_index = 0,
-  .read_index  = 0,
-  .new         = false
-};
-
-static uint8_t rx_mPsdu[OT_RADIO_FRAME_MAX_SIZE];
-static otRadioFrame receiveFrame = {
-  .mPsdu   = rx_mPsdu,
-  .mLength = OT_RADIO_FRAME_MAX_SIZE
-};
+static otRadioFrame receiveFrame;
 
 typedef struct otTock {
-  ring_buffer* usr_rx_buffer;
+  // Buffer currently shared with the kernel.
   libtock_ieee802154_rxbuf* kernel_rx_buf;
+  // Buffer swapped out of the kernel whose frames OpenThread has not
+  // finished with yet, or NULL.
+  libtock_ieee802154_rxbuf* user_rx_buf;
+  // The kernel reported frames while `user_rx_buf` was still in use.
+  bool swap_deferred;
   otInstance* instance;
+  otTockRxStats stats;
 } otTock;
 
-typedef struct otTock otTock;
 otTock otTockInstance = {
-  .usr_rx_buffer = &usr_rx_buffer,
   .kernel_rx_buf = &rx_buf_a,
+  .user_rx_buf   = NULL,
+  .swap_deferred = false,
   .instance      = NULL,
 };
 
-// Helper utility to provide a new ring buffer to the kernel and
-// return the ring buffer previously held by the kernel
-static libtock_ieee802154_rxbuf* swap_shared_kernel_buf(otTock* instance);
-
 static void rx_callback(__attribute__ ((unused)) int   pans,
                         __attribute__ ((unused)) int   dst_addr,
                         __attribute__ ((unused)) int   src_addr);
@@ -88,19 +75,23 @@ static void ring_reset_cb(__attribute__ ((unused)) int   pans,
   rx_callback(pans, dst_addr, src_addr);
 }
 
-static libtock_ieee802154_rxbuf* swap_shared_kernel_buf(otTock* instance) {
-  libtock_ieee802154_rxbuf* rx_buf;
-
-  if (instance->kernel_rx_buf == &rx_buf_a) {
-    instance->kernel_rx_buf = &rx_buf_b;
-    rx_buf = &rx_buf_a;
-  } else {
-    instance->kernel_rx_buf = &rx_buf_a;
-    rx_buf = &rx_buf_b;
-  }
+// Share the idle buffer with the kernel and make the buffer the kernel
+// was filling available to OpenThread.
+static void swap_shared_kernel_buf(otTock* instance) {
+  libtock_ieee802154_rxbuf* filled = instance->kernel_rx_buf;
 
+  instance->kernel_rx_buf = (filled == &rx_buf_a) ? &rx_buf_b : &rx_buf_a;
   libtock_reset_ring_buf(instance->kernel_rx_buf, ring_reset_cb, NULL);
-  return rx_buf;
+
+  uint8_t* indices = *filled;
+  uint32_t queued  = (indices[1] + libtock_ieee802154_MAX_RING_BUF_FRAMES - indices[0]) %
+                     libtock_ieee802154_MAX_RING_BUF_FRAMES;
+
+  instance->user_rx_buf = filled;
+  instance->stats.swaps++;
+  if (queued > instance->stats.max_batch) {
+    instance->stats.max_batch = queued;
+  }
 }
 
 void otSysInit(int argc, char *argv[]){
@@ -114,72 +105,65 @@ bool otSysPseudoResetWasRequested(void) {
   return false;
 }
 
-void readRingBuf(otInstance *aInstance);
-
 bool pending_rx_done_callback_status(void) {
-  return usr_rx_buffer.new;
+  return otTockInstance.user_rx_buf != NULL;
 }
 
 bool openthread_platform_pending_work(void){
-    return (pending_alarm_done_callback_status() || 
-            pending_tx_done_callback_status(NULL, NULL, NULL) || 
+    return (pending_alarm_status() || 
+            pending_tx_done_callback_status() || 
             pending_rx_done_callback_status());
 }
 
-void readRingBuf(otInstance *aInstance) {
-    int offset;
-    if(usr_rx_buffer.new){
-    // loop through data until all new data is read
-    do {
-      offset = usr_rx_buffer.read_index * libtock_ieee802154_FRAME_LEN;
-      char* rx_buf       = usr_rx_buffer.buffer;
-      int header_len  = rx_buf[offset];
-      int payload_len = rx_buf[offset + 1];
-      int mic_len     = rx_buf[offset + 2];
-
-      // this does not seem necessary since we implement the csma backoff in the radio driver
-      // receiveFrame.mInfo.mRxInfo.mTimestamp = otPlatAlarmMilliGetNow() * 1000;
-      receiveFrame.mInfo.mRxInfo.mRssi      = 50;
-      receiveFrame.mLength = payload_len + header_len + mic_len + 2;
-      receiveFrame.mInfo.mRxInfo.mTimestamp = 0;
-      receiveFrame.mInfo.mRxInfo.mLqi       = 0x7f;
+void otTockGetRxStats(otTockRxStats *stats) {
+  *stats = otTockInstance.stats;
+}
 
-      // copy data
-      for (int i = 0; i < (receiveFrame.mLength + libtock_ieee802154_FRAME_META_LEN); i++) {
-        receiveFrame.mPsdu[i] = rx_buf[i + libtock_ieee802154_FRAME_META_LEN + offset];
+// Hand every frame in the swapped-out buffer to OpenThread. The frames are
+// not copied; `receiveFrame` points into the buffer, which is only given
+// back to the kernel after `otPlatRadioReceiveDone` has returned.
+static void process_received_frames(otInstance *aInstance) {
+  while (otTockInstance.user_rx_buf != NULL) {
+    uint8_t* frame;
+    while ((frame = libtock_ieee802154_read_next_frame(otTockInstance.user_rx_buf)) != NULL) {
+      int header_len  = frame[0];
+      int payload_len = frame[1];
+      int mic_len     = frame[2];
+      int length      = header_len + payload_len + mic_len + 2;
+
+      if (length > OT_RADIO_FRAME_MAX_SIZE) {
+        otTockInstance.stats.dropped++;
+        continue;
       }
 
+      receiveFrame.mPsdu   = &frame[libtock_ieee802154_FRAME_META_LEN];
+      receiveFrame.mLength = length;
+      receiveFrame.mInfo.mRxInfo.mRssi      = TOCK_RADIO_RSSI_ESTIMATE;
+      receiveFrame.mInfo.mRxInfo.mTimestamp = 0;
+      receiveFrame.mInfo.mRxInfo.mLqi       = TOCK_RADIO_LQI_ESTIMATE;
+
       // notify openthread instance that a frame has been received
       otPlatRadioReceiveDone(aInstance, &receiveFrame, OT_ERROR_NONE);
-      usr_rx_buffer.read_index++;
-      if (usr_rx_buffer.read_index == USER_RX_BUF_FRAME_COUNT) {
-        usr_rx_buffer.read_index = 0;
-      }
-    } while (usr_rx_buffer.read_index != usr_rx_buffer.write_index);
-    
-    usr_rx_buffer.new = false;  
-    } 
-}
-
-void otSysProcessDrivers(otInstance *aInstance){
+      otTockInstance.stats.frames++;
+    }
 
-  readRingBuf(aInstance);
+    otTockInstance.user_rx_buf = NULL;
 
-  if (pending_alarm_done_callback_status()) {
-    reset_pending_alarm_done_callback();
-    otPlatAlarmMilliFired(aInstance);
+    // Frames arrived while OpenThread held the buffer; pick them up now.
+    if (otTockInstance.swap_deferred) {
+      otTockInstance.swap_deferred = false;
+      swap_shared_kernel_buf(&otTockInstance);
+    }
   }
+}
 
-  otRadioFrame ackFrame;
-  otRadioFrame txFrame;
-  returncode_t status;
+void otSysProcessDrivers(otInstance *aInstance){
 
-  if (pending_tx_done_callback_status(&ackFrame, &status, &txFrame)) {
-    reset_pending_tx_done_callback();
+  process_received_frames(aInstance);
 
-    if (status == RETURNCODE_SUCCESS) otPlatRadioTxDone(aInstance, &txFrame, &ackFrame, OT_ERROR_NONE);
-    else otPlatRadioTxDone(aInstance, &txFrame, &ackFrame, OT_ERROR_ABORT);
-  }
+  process_otPlatAlarm(aInstance);
+
+  process_otPlatRadioTx(aInstance);
 
 }
 
@@ -188,46 +172,15 @@ static void rx_callback(__attribute__ ((unused)) int   pans,
                         __attribute__ ((unused)) int   dst_addr,
                         __attribute__ ((unused)) int   src_addr) {
 
-  /* It is important to avoid sync operations that yield (i.e. printf)
-     as this may cause a new upcall to be handled and data to be received
-     out of order and/or lost. */
-  uint8_t* rx_buf = swap_shared_kernel_buf(&otTockInstance)[0];
-
-  uint8_t* head_index = &rx_buf[0];
-  uint8_t* tail_index = &rx_buf[1];
-
-  int offset = 2 + *head_index * libtock_ieee802154_FRAME_LEN;
-
-  // | head active # | tail active # | frame 0 | frame 1 | ... | frame n |
-  while (*head_index != *tail_index) {
-    int header_len = rx_buf[offset];
-    int payload_len = rx_buf[offset + 1];
-    int mic_len        = rx_buf[offset + 2];
-
-    int receive_frame_length = payload_len + header_len + mic_len;
-    int ring_buffer_offset = usr_rx_buffer.write_index * libtock_ieee802154_FRAME_LEN;
-
-    for (int i = 0; i < (libtock_ieee802154_FRAME_META_LEN + receive_frame_length); i++) {
-      usr_rx_buffer.buffer[ring_buffer_offset + i] = rx_buf[i + offset];
-      rx_buf[i + offset] = 0;
-    }
-
-    usr_rx_buffer.new = true;
-    usr_rx_buffer.write_index++;
-    if (usr_rx_buffer.write_index == USER_RX_BUF_FRAME_COUNT) {
-      usr_rx_buffer.write_index = 0;
-    }
-
-    *head_index = (*head_index + 1) % libtock_ieee802154_MAX_RING_BUF_FRAMES;
-    offset     += libtock_ieee802154_FRAME_LEN;
-
-    if (*head_index == 0) {
-      offset = 2;
-    }
+  /* This only swaps buffers; the frames are read from the main loop. If
+     OpenThread is still reading the other buffer, leave the kernel's
+     buffer in place so it keeps collecting frames until the swap. */
+  if (otTockInstance.user_rx_buf != NULL) {
+    otTockInstance.swap_deferred = true;
+    otTockInstance.stats.deferred++;
+    return;
   }
-
-  assert(*head_index == *tail_index);
-
+  swap_shared_kernel_buf(&otTockInstance);
 }
 
 
@@ -0,0 +1,110 @@
+#include <string.h>
+
+#include <libtock/crypto/aes128_software.h>
+#include <libtock/crypto/syscalls/aes_syscalls.h>
+#include <libtock/defer.h>
+
+#include "aes.h"
+
+// Set by `LIBTOCKSYNC_SOFTWARE` in the libtock-sync Makefile.
+#ifndef LIBTOCKSYNC_AES_SOFTWARE
+#define LIBTOCKSYNC_AES_SOFTWARE 1
+#endif
+
+struct aes_data {
+  bool fired;
+  returncode_t ret;
+};
+
+static struct aes_data result = {.fired = false};
+
+static void aes_upcall(int                          status,
+                       __attribute__ ((unused)) int length,
+                       __attribute__ ((unused)) int verified,
+                       __attribute__ ((unused)) void* opaque) {
+  result.fired = true;
+  result.ret   = tock_status_to_returncode(status);
+}
+
+#if LIBTOCKSYNC_AES_SOFTWARE
+static returncode_t aes_software(libtock_aes_algorithm_t algorithm, bool encrypting,
+                                 const uint8_t* key, uint32_t key_length,
+                                 const uint8_t* iv, uint32_t iv_length,
+                                 const uint8_t* source, uint8_t* dest, uint32_t length) {
+  libtock_aes128_software_mode_t mode;
+  switch (algorithm) {
+    case LIBTOCK_AES128Ctr: mode = LIBTOCK_AES128_SOFTWARE_CTR; break;
+    case LIBTOCK_AES128CBC: mode = LIBTOCK_AES128_SOFTWARE_CBC; break;
+    case LIBTOCK_AES128ECB: mode = LIBTOCK_AES128_SOFTWARE_ECB; break;
+    default: return RETURNCODE_ENOSUPPORT;
+  }
+  if (key_length != LIBTOCK_AES128_SOFTWARE_KEY_LEN) return RETURNCODE_EINVAL;
+  if (mode != LIBTOCK_AES128_SOFTWARE_ECB && iv_length != LIBTOCK_AES128_SOFTWARE_BLOCK_LEN) return RETURNCODE_EINVAL;
+
+  libtock_aes128_software_t ctx;
+  libtock_aes128_software_init(&ctx, mode, encrypting, key, mode == LIBTOCK_AES128_SOFTWARE_ECB ? NULL : iv);
+  bool ok = libtock_aes128_software_crypt(&ctx, source, dest, length);
+  memset(&ctx, 0, sizeof(ctx));
+  return ok ? RETURNCODE_SUCCESS : RETURNCODE_ESIZE;
+}
+#endif
+
+bool libtocksync_aes_exists(void) {
+  return LIBTOCKSYNC_AES_SOFTWARE || libtock_aes_driver_exists();
+}
+
+returncode_t libtocksync_aes_crypt(libtock_aes_algorithm_t algorithm, bool encrypting,
+                                   const uint8_t* key, uint32_t key_length,
+                                   const uint8_t* iv, uint32_t iv_length,
+                                   const uint8_t* source, uint8_t* dest, uint32_t length) {
+  returncode_t ret;
+
+  if (algorithm == LIBTOCK_AES128CCM) return RETURNCODE_ENOSUPPORT;
+
+#if LIBTOCKSYNC_AES_SOFTWARE
+  static int driver = -1;
+  if (driver < 0) driver = libtock_aes_driver_exists();
+  if (!driver) {
+    return aes_software(algorithm, encrypting, key, key_length, iv, iv_length, source, dest, length);
+  }
+#endif
+
+  ret = libtock_aes_set_algorithm(algorithm, encrypting);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_aes_set_readonly_allow_key_buffer(key, key_length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+  defer { libtock_aes_set_readonly_allow_key_buffer(NULL, 0);
+  };
+
+  if (algorithm != LIBTOCK_AES128ECB) {
+    ret = libtock_aes_set_readonly_allow_iv_buffer(iv, iv_length);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+  }
+  defer { libtock_aes_set_readonly_allow_iv_buffer(NULL, 0);
+  };
+
+  ret = libtock_aes_set_readonly_allow_source_buffer(source, length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+  defer { libtock_aes_set_readonly_allow_source_buffer(NULL, 0);
+  };
+
+  ret = libtock_aes_set_readwrite_allow_dest_buffer(dest, length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+  defer { libtock_aes_set_readwrite_allow_dest_buffer(NULL, 0);
+  };
+
+  ret = libtock_aes_set_upcall(aes_upcall, NULL);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  result.fired = false;
+  ret = libtock_aes_setup();
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  // Wait for the operation.
+  yield_for(&result.fired);
+
+  ret = libtock_aes_finish();
+  if (result.ret != RETURNCODE_SUCCESS) return result.ret;
+  return ret;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <libtock/crypto/aes.h>
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Check if AES is available: true if there is an AES driver, or if
+// libtock-sync was built with the software AES-128. Use
+// `libtock_aes_driver_exists()` to check for the driver only.
+bool libtocksync_aes_exists(void);
+
+// Encrypt or decrypt `length` bytes from `source` into `dest` with AES-128 in
+// CTR, CBC or ECB mode. `source` and `dest` may be the same buffer.
+//
+// Uses the AES driver if there is one and otherwise a constant-time software
+// implementation. For CBC and ECB `length` must be a multiple of 16. `iv` is
+// ignored for ECB.
+returncode_t libtocksync_aes_crypt(libtock_aes_algorithm_t algorithm, bool encrypting,
+                                   const uint8_t* key, uint32_t key_length,
+                                   const uint8_t* iv, uint32_t iv_length,
+                                   const uint8_t* source, uint8_t* dest, uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,14 @@
+#include "aes_stream.h"
+
+void libtocksync_aes_stream_wait_slot(libtock_aes_stream_t* stream) {
+  // Batches complete from the AES upcall, so keep yielding until one does.
+  while (!libtock_aes_stream_can_submit(stream)) {
+    yield();
+  }
+}
+
+void libtocksync_aes_stream_wait(libtock_aes_stream_t* stream) {
+  while (libtock_aes_stream_busy(stream)) {
+    yield();
+  }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <libtock/crypto/aes_stream.h>
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Wait until another batch can be submitted to `stream`.
+void libtocksync_aes_stream_wait_slot(libtock_aes_stream_t* stream);
+
+// Wait until all batches submitted to `stream` have completed.
+void libtocksync_aes_stream_wait(libtock_aes_stream_t* stream);
+
+#ifdef __cplusplus
+}
+#endif
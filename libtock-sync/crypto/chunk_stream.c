@@ -0,0 +1,36 @@
+#include "chunk_stream.h"
+
+returncode_t libtocksync_chunk_stream(libtocksync_chunk_stream_read read, void* context,
+                                      uint8_t* buffer_a, uint8_t* buffer_b, uint32_t buffer_length,
+                                      libtocksync_chunk_stream_start start,
+                                      libtocksync_chunk_stream_wait wait) {
+  returncode_t ret;
+
+  uint8_t* current = buffer_a;
+  uint32_t length  = read(context, current, buffer_length);
+
+  while (length > 0) {
+    ret = start(current, length);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+
+    // Read the next chunk into the other buffer while this one is processed.
+    uint8_t* next = NULL;
+    uint32_t next_length = 0;
+    if (buffer_b != NULL) {
+      next        = (current == buffer_a) ? buffer_b : buffer_a;
+      next_length = read(context, next, buffer_length);
+    }
+
+    ret = wait();
+    if (ret != RETURNCODE_SUCCESS) return ret;
+
+    if (next == NULL) {
+      next        = buffer_a;
+      next_length = read(context, next, buffer_length);
+    }
+    current = next;
+    length  = next_length;
+  }
+
+  return RETURNCODE_SUCCESS;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Double-buffered chunk loop shared by `libtocksync_sha_stream()` and
+// `libtocksync_hmac_stream()`.
+
+// Reads the next chunk of input. Same contract as
+// `libtocksync_sha_read_chunk`.
+typedef uint32_t (*libtocksync_chunk_stream_read)(void* context, uint8_t* buffer, uint32_t length);
+
+// Hands one chunk to the kernel without waiting for it.
+typedef returncode_t (*libtocksync_chunk_stream_start)(const uint8_t* chunk, uint32_t length);
+
+// Waits for the chunk passed to the last `start` and returns its result.
+typedef returncode_t (*libtocksync_chunk_stream_wait)(void);
+
+// Pass all input returned by `read` to `start`, one chunk at a time.
+//
+// While the kernel works on a chunk in one buffer, the next chunk is read into
+// the other. If `buffer_b` is NULL, chunks are read and processed one after the
+// other using only `buffer_a`. Stops at the first chunk that fails.
+returncode_t libtocksync_chunk_stream(libtocksync_chunk_stream_read read, void* context,
+                                      uint8_t* buffer_a, uint8_t* buffer_b, uint32_t buffer_length,
+                                      libtocksync_chunk_stream_start start,
+                                      libtocksync_chunk_stream_wait wait);
+
+#ifdef __cplusplus
+}
+#endif
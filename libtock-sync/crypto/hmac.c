@@ -1,10 +1,55 @@
+#include <libtock/crypto/hmac_sha256_software.h>
 #include <libtock/crypto/syscalls/hmac_syscalls.h>
 #include <libtock/defer.h>
 
+#include "chunk_stream.h"
 #include "hmac.h"
 
+// Set by `LIBTOCKSYNC_SOFTWARE` in the libtock-sync Makefile.
+#ifndef LIBTOCKSYNC_HMAC_SOFTWARE
+#define LIBTOCKSYNC_HMAC_SOFTWARE 1
+#endif
+
+struct hmac_data {
+  bool fired;
+  returncode_t ret;
+};
+
+static struct hmac_data result = {.fired = false};
+
+static void hmac_cb(returncode_t ret) {
+  result.fired = true;
+  result.ret   = ret;
+}
+
+static returncode_t update_start(const uint8_t* input_buffer, uint32_t input_length) {
+  result.fired = false;
+  return libtock_hmac_update(input_buffer, input_length, hmac_cb);
+}
+
+static returncode_t update_wait(void) {
+  yield_for(&result.fired);
+  return result.ret;
+}
+
+#if LIBTOCKSYNC_HMAC_SOFTWARE
+// Streaming HMAC in progress in software, because there is no HMAC driver.
+static bool software_active = false;
+static libtock_hmac_sha256_software_t software_ctx;
+
+// Whether to compute `hmac_type` in software. Only HMAC-SHA256 is available.
+static returncode_t use_software(libtock_hmac_algorithm_t hmac_type, bool* software) {
+  static int driver = -1;
+  if (driver < 0) driver = libtock_hmac_driver_exists();
+
+  *software = !driver;
+  if (*software && hmac_type != LIBTOCK_HMAC_SHA256) return RETURNCODE_ENOSUPPORT;
+  return RETURNCODE_SUCCESS;
+}
+#endif
+
 bool libtocksync_hmac_exists(void) {
-  return libtock_hmac_driver_exists();
+  return LIBTOCKSYNC_HMAC_SOFTWARE || libtock_hmac_driver_exists();
 }
 
 returncode_t libtocksync_hmac_simple(libtock_hmac_algorithm_t hmac_type,
@@ -13,6 +58,17 @@ returncode_t libtocksync_hmac_simple(libtock_hmac_algorithm_t hmac_type,
                                      uint8_t* hmac_buffer, uint32_t hmac_length) {
   returncode_t ret;
 
+#if LIBTOCKSYNC_HMAC_SOFTWARE
+  bool software;
+  ret = use_software(hmac_type, &software);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+  if (software) {
+    if (hmac_length < LIBTOCK_SHA256_SOFTWARE_DIGEST_LEN) return RETURNCODE_ESIZE;
+    libtock_hmac_sha256_software(key_buffer, key_length, input_buffer, input_length, hmac_buffer);
+    return RETURNCODE_SUCCESS;
+  }
+#endif
+
   ret = libtock_hmac_command_set_algorithm((uint32_t) hmac_type);
   if (ret != RETURNCODE_SUCCESS) return ret;
 
@@ -39,3 +95,101 @@ returncode_t libtocksync_hmac_simple(libtock_hmac_algorithm_t hmac_type,
 
   return ret;
 }
+
+returncode_t libtocksync_hmac_init(libtock_hmac_algorithm_t hmac_type, const uint8_t* key_buffer, uint32_t key_length) {
+  returncode_t ret;
+
+#if LIBTOCKSYNC_HMAC_SOFTWARE
+  ret = use_software(hmac_type, &software_active);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+  if (software_active) {
+    libtock_hmac_sha256_software_init(&software_ctx, key_buffer, key_length);
+    return RETURNCODE_SUCCESS;
+  }
+#endif
+  ret = libtock_hmac_init(hmac_type, key_buffer, key_length);
+  if (ret != RETURNCODE_SUCCESS) libtock_hmac_set_readonly_allow_key_buffer(NULL, 0);
+  return ret;
+}
+
+returncode_t libtocksync_hmac_update(const uint8_t* input_buffer, uint32_t input_length) {
+  returncode_t ret;
+
+#if LIBTOCKSYNC_HMAC_SOFTWARE
+  if (software_active) {
+    libtock_hmac_sha256_software_update(&software_ctx, input_buffer, input_length);
+    return RETURNCODE_SUCCESS;
+  }
+#endif
+
+  ret = update_start(input_buffer, input_length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  // Wait for the callback.
+  return update_wait();
+}
+
+returncode_t libtocksync_hmac_finish(uint8_t* hmac_buffer, uint32_t hmac_length) {
+  returncode_t ret;
+
+#if LIBTOCKSYNC_HMAC_SOFTWARE
+  if (software_active) {
+    // The HMAC is over once this returns, whether or not it succeeded.
+    software_active = false;
+    if (hmac_length < LIBTOCK_SHA256_SOFTWARE_DIGEST_LEN) return RETURNCODE_ESIZE;
+    libtock_hmac_sha256_software_finish(&software_ctx, hmac_buffer);
+    return RETURNCODE_SUCCESS;
+  }
+#endif
+
+  result.fired = false;
+
+  // The HMAC is over once this returns, whether or not it succeeded.
+  defer { libtock_hmac_set_readonly_allow_key_buffer(NULL, 0);
+  };
+  defer { libtock_hmac_set_readonly_allow_data_buffer(NULL, 0);
+  };
+  defer { libtock_hmac_set_readwrite_allow_destination_buffer(NULL, 0);
+  };
+
+  ret = libtock_hmac_finish(hmac_buffer, hmac_length, hmac_cb);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  // Wait for the callback.
+  yield_for(&result.fired);
+  return result.ret;
+}
+
+returncode_t libtocksync_hmac_stream(libtock_hmac_algorithm_t hmac_type,
+                                     const uint8_t* key_buffer, uint32_t key_length,
+                                     libtocksync_hmac_read_chunk read, void* context,
+                                     uint8_t* buffer_a, uint8_t* buffer_b, uint32_t buffer_length,
+                                     uint8_t* hmac_buffer, uint32_t hmac_length) {
+  returncode_t ret;
+
+  ret = libtocksync_hmac_init(hmac_type, key_buffer, key_length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+#if LIBTOCKSYNC_HMAC_SOFTWARE
+  if (software_active) {
+    // Hashing runs on this core, so there is nothing to overlap reads with.
+    uint32_t length;
+    while ((length = read(context, buffer_a, buffer_length)) > 0) {
+      libtock_hmac_sha256_software_update(&software_ctx, buffer_a, length);
+    }
+    return libtocksync_hmac_finish(hmac_buffer, hmac_length);
+  }
+#endif
+
+  // The key stays allowed until the HMAC finishes; take it and the data back
+  // if streaming stops early.
+  defer { libtock_hmac_set_readonly_allow_key_buffer(NULL, 0);
+  };
+  defer { libtock_hmac_set_readonly_allow_data_buffer(NULL, 0);
+  };
+
+  ret = libtocksync_chunk_stream(read, context, buffer_a, buffer_b, buffer_length, update_start, update_wait);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  return libtocksync_hmac_finish(hmac_buffer, hmac_length);
+}
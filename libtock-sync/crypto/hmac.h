@@ -1,5 +1,6 @@
 #pragma once
 
+#include <libtock/crypto/hmac.h>
 #include <libtock/crypto/hmac_types.h>
 #include <libtock/tock.h>
 
@@ -9,15 +10,46 @@
 extern "C" {
 #endif
 
-
+// Check if HMACs can be computed: true if there is an HMAC driver, or if
+// libtock-sync was built with the software HMAC-SHA256. Use
+// `libtock_hmac_driver_exists()` to check for the driver only.
 bool libtocksync_hmac_exists(void);
 
 // Compute an HMAC on the given buffer.
+//
+// All functions below use the HMAC driver if there is one. Otherwise
+// HMAC-SHA256 is computed in software, and other algorithms return
+// `RETURNCODE_ENOSUPPORT`.
 returncode_t libtocksync_hmac_simple(libtock_hmac_algorithm_t hmac_type,
                                      uint8_t* key_buffer, uint32_t key_length,
                                      uint8_t* input_buffer, uint32_t input_length,
                                      uint8_t* hmac_buffer, uint32_t hmac_length);
 
+// Start a streaming HMAC. See `libtock_hmac_init()`.
+returncode_t libtocksync_hmac_init(libtock_hmac_algorithm_t hmac_type, const uint8_t* key_buffer, uint32_t key_length);
+
+// Add a chunk to the streaming HMAC and wait until the kernel is done with it.
+returncode_t libtocksync_hmac_update(const uint8_t* input_buffer, uint32_t input_length);
+
+// Finish the streaming HMAC and store it in `hmac_buffer`.
+returncode_t libtocksync_hmac_finish(uint8_t* hmac_buffer, uint32_t hmac_length);
+
+// Function that reads the next chunk of input for `libtocksync_hmac_stream()`.
+//
+// Fill `buffer` with up to `length` bytes and return how many bytes were
+// written. Returning 0 ends the input.
+typedef uint32_t (*libtocksync_hmac_read_chunk)(void* context, uint8_t* buffer, uint32_t length);
+
+// Compute an HMAC over all input returned by `read`.
+//
+// Chunks are double buffered the same way as `libtocksync_sha_stream()`. If
+// `buffer_b` is NULL, chunks are read and hashed one after the other.
+returncode_t libtocksync_hmac_stream(libtock_hmac_algorithm_t hmac_type,
+                                     const uint8_t* key_buffer, uint32_t key_length,
+                                     libtocksync_hmac_read_chunk read, void* context,
+                                     uint8_t* buffer_a, uint8_t* buffer_b, uint32_t buffer_length,
+                                     uint8_t* hmac_buffer, uint32_t hmac_length);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,7 +1,15 @@
+#include <libtock/crypto/sha256_software.h>
 #include <libtock/crypto/syscalls/sha_syscalls.h>
+#include <libtock/defer.h>
 
+#include "chunk_stream.h"
 #include "sha.h"
 
+// Set by `LIBTOCKSYNC_SOFTWARE` in the libtock-sync Makefile.
+#ifndef LIBTOCKSYNC_SHA_SOFTWARE
+#define LIBTOCKSYNC_SHA_SOFTWARE 1
+#endif
+
 struct sha_data {
   bool fired;
   returncode_t ret;
@@ -14,8 +22,34 @@ static void sha_cb_hash(returncode_t ret) {
   result.ret   = ret;
 }
 
+static returncode_t update_start(const uint8_t* input_buffer, uint32_t input_length) {
+  result.fired = false;
+  return libtock_sha_update(input_buffer, input_length, sha_cb_hash);
+}
+
+static returncode_t update_wait(void) {
+  yield_for(&result.fired);
+  return result.ret;
+}
+
+#if LIBTOCKSYNC_SHA_SOFTWARE
+// Streaming hash in progress in software, because there is no SHA driver.
+static bool software_active = false;
+static libtock_sha256_software_t software_ctx;
+
+// Whether to hash `hash_type` in software. Only SHA-256 is available.
+static returncode_t use_software(libtock_sha_algorithm_t hash_type, bool* software) {
+  static int driver = -1;
+  if (driver < 0) driver = libtock_sha_driver_exists();
+
+  *software = !driver;
+  if (*software && hash_type != LIBTOCK_SHA256) return RETURNCODE_ENOSUPPORT;
+  return RETURNCODE_SUCCESS;
+}
+#endif
+
 bool libtocksync_sha_exists(void) {
-  return libtock_sha_driver_exists();
+  return LIBTOCKSYNC_SHA_SOFTWARE || libtock_sha_driver_exists();
 }
 
 returncode_t libtocksync_sha_simple_hash(libtock_sha_algorithm_t hash_type,
@@ -23,20 +57,116 @@ returncode_t libtocksync_sha_simple_hash(libtock_sha_algorithm_t hash_type,
                                          uint8_t* hash_buffer, uint32_t hash_length) {
   returncode_t ret;
 
+#if LIBTOCKSYNC_SHA_SOFTWARE
+  bool software;
+  ret = use_software(hash_type, &software);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+  if (software) {
+    if (hash_length < LIBTOCK_SHA256_SOFTWARE_DIGEST_LEN) return RETURNCODE_ESIZE;
+    libtock_sha256_software(input_buffer, input_length, hash_buffer);
+    return RETURNCODE_SUCCESS;
+  }
+#endif
+
   result.fired = false;
 
+  defer { libtock_sha_set_readonly_allow_data_buffer(NULL, 0);
+  };
+  defer { libtock_sha_set_readwrite_allow_destination_buffer(NULL, 0);
+  };
+
   ret = libtock_sha_simple_hash(hash_type, input_buffer, input_length, hash_buffer, hash_length, sha_cb_hash);
   if (ret != RETURNCODE_SUCCESS) return ret;
 
   // Wait for the callback.
   yield_for(&result.fired);
-  if (result.ret != RETURNCODE_SUCCESS) return result.ret;
+  return result.ret;
+}
 
-  ret = libtock_sha_set_readonly_allow_data_buffer(NULL, 0);
+returncode_t libtocksync_sha_init(libtock_sha_algorithm_t hash_type) {
+#if LIBTOCKSYNC_SHA_SOFTWARE
+  returncode_t ret = use_software(hash_type, &software_active);
   if (ret != RETURNCODE_SUCCESS) return ret;
+  if (software_active) {
+    libtock_sha256_software_init(&software_ctx);
+    return RETURNCODE_SUCCESS;
+  }
+#endif
+  return libtock_sha_init(hash_type);
+}
 
-  ret = libtock_sha_set_readwrite_allow_destination_buffer(NULL, 0);
+returncode_t libtocksync_sha_update(const uint8_t* input_buffer, uint32_t input_length) {
+  returncode_t ret;
+
+#if LIBTOCKSYNC_SHA_SOFTWARE
+  if (software_active) {
+    libtock_sha256_software_update(&software_ctx, input_buffer, input_length);
+    return RETURNCODE_SUCCESS;
+  }
+#endif
+
+  ret = update_start(input_buffer, input_length);
   if (ret != RETURNCODE_SUCCESS) return ret;
 
-  return RETURNCODE_SUCCESS;
+  // Wait for the callback.
+  return update_wait();
+}
+
+returncode_t libtocksync_sha_finish(uint8_t* hash_buffer, uint32_t hash_length) {
+  returncode_t ret;
+
+#if LIBTOCKSYNC_SHA_SOFTWARE
+  if (software_active) {
+    // The hash is over once this returns, whether or not it succeeded.
+    software_active = false;
+    if (hash_length < LIBTOCK_SHA256_SOFTWARE_DIGEST_LEN) return RETURNCODE_ESIZE;
+    libtock_sha256_software_finish(&software_ctx, hash_buffer);
+    return RETURNCODE_SUCCESS;
+  }
+#endif
+
+  result.fired = false;
+
+  // The hash is over once this returns, whether or not it succeeded.
+  defer { libtock_sha_set_readonly_allow_data_buffer(NULL, 0);
+  };
+  defer { libtock_sha_set_readwrite_allow_destination_buffer(NULL, 0);
+  };
+
+  ret = libtock_sha_finish(hash_buffer, hash_length, sha_cb_hash);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  // Wait for the callback.
+  yield_for(&result.fired);
+  return result.ret;
+}
+
+returncode_t libtocksync_sha_stream(libtock_sha_algorithm_t hash_type,
+                                    libtocksync_sha_read_chunk read, void* context,
+                                    uint8_t* buffer_a, uint8_t* buffer_b, uint32_t buffer_length,
+                                    uint8_t* hash_buffer, uint32_t hash_length) {
+  returncode_t ret;
+
+  ret = libtocksync_sha_init(hash_type);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+#if LIBTOCKSYNC_SHA_SOFTWARE
+  if (software_active) {
+    // Hashing runs on this core, so there is nothing to overlap reads with.
+    uint32_t length;
+    while ((length = read(context, buffer_a, buffer_length)) > 0) {
+      libtock_sha256_software_update(&software_ctx, buffer_a, length);
+    }
+    return libtocksync_sha_finish(hash_buffer, hash_length);
+  }
+#endif
+
+  // Take the data back if streaming stops early.
+  defer { libtock_sha_set_readonly_allow_data_buffer(NULL, 0);
+  };
+
+  ret = libtocksync_chunk_stream(read, context, buffer_a, buffer_b, buffer_length, update_start, update_wait);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  return libtocksync_sha_finish(hash_buffer, hash_length);
 }
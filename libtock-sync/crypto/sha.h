@@ -7,14 +7,46 @@
 extern "C" {
 #endif
 
-
+// Check if hashes can be computed: true if there is a SHA driver, or if
+// libtock-sync was built with the software SHA-256 (`LIBTOCKSYNC_SOFTWARE` in
+// libtock-sync/Makefile). `libtock_sha_driver_exists()` checks for the driver
+// alone.
 bool libtocksync_sha_exists(void);
 
 // Compute a SHA hash on the given buffer.
+//
+// All functions below use the SHA driver if there is one. Otherwise SHA-256 is
+// computed in software, and other algorithms return `RETURNCODE_ENOSUPPORT`.
 returncode_t libtocksync_sha_simple_hash(libtock_sha_algorithm_t hash_type,
                                          uint8_t* input_buffer, uint32_t input_length,
                                          uint8_t* hash_buffer, uint32_t hash_length);
 
+// Start a streaming hash. See `libtock_sha_init()`.
+returncode_t libtocksync_sha_init(libtock_sha_algorithm_t hash_type);
+
+// Add a chunk to the streaming hash and wait until the kernel is done with it.
+returncode_t libtocksync_sha_update(const uint8_t* input_buffer, uint32_t input_length);
+
+// Finish the streaming hash and store it in `hash_buffer`.
+returncode_t libtocksync_sha_finish(uint8_t* hash_buffer, uint32_t hash_length);
+
+// Function that reads the next chunk of input for `libtocksync_sha_stream()`.
+//
+// Fill `buffer` with up to `length` bytes and return how many bytes were
+// written. Returning 0 ends the input.
+typedef uint32_t (*libtocksync_sha_read_chunk)(void* context, uint8_t* buffer, uint32_t length);
+
+// Hash all input returned by `read` and store the hash in `hash_buffer`.
+//
+// `buffer_a` and `buffer_b` are both `buffer_length` bytes. While the kernel
+// hashes a chunk in one buffer, the next chunk is read into the other, so
+// reading and hashing overlap. If `buffer_b` is NULL, chunks are read and
+// hashed one after the other using only `buffer_a`.
+returncode_t libtocksync_sha_stream(libtock_sha_algorithm_t hash_type,
+                                    libtocksync_sha_read_chunk read, void* context,
+                                    uint8_t* buffer_a, uint8_t* buffer_b, uint32_t buffer_length,
+                                    uint8_t* hash_buffer, uint32_t hash_length);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,140 @@
+#include <string.h>
+
+#include "console_buffered.h"
+
+static struct {
+  bool enabled;
+  libtocksync_console_full_policy_t policy;
+  uint8_t* buffer;
+  uint32_t size;
+  // Oldest unsent byte, and bytes waiting (including those being sent).
+  uint32_t tail;
+  uint32_t count;
+  // Bytes handed to the kernel by the current transfer, 0 if idle.
+  uint32_t in_flight;
+  // Set each time a transfer completes.
+  bool transfer_done;
+  libtocksync_console_buffered_stats_t stats;
+} console;
+
+static void start_transfer(void);
+
+static void write_done(returncode_t ret, __attribute__ ((unused)) uint32_t length) {
+  if (ret != RETURNCODE_SUCCESS) {
+    console.stats.bytes_dropped += console.in_flight;
+  }
+
+  console.tail          = (console.tail + console.in_flight) % console.size;
+  console.count        -= console.in_flight;
+  console.in_flight     = 0;
+  console.transfer_done = true;
+
+  start_transfer();
+}
+
+// Send as much of the buffered text as is contiguous, if the console is idle.
+static void start_transfer(void) {
+  while (console.in_flight == 0 && console.count > 0) {
+    uint32_t len = console.count;
+    if (len > console.size - console.tail) {
+      len = console.size - console.tail;
+    }
+
+    returncode_t ret = libtock_console_write(console.buffer + console.tail, len, write_done);
+    if (ret == RETURNCODE_SUCCESS) {
+      console.in_flight = len;
+      console.stats.transfers++;
+      return;
+    }
+
+    // The kernel refused the transfer; discard it rather than retrying forever.
+    console.stats.bytes_dropped += len;
+    console.tail   = (console.tail + len) % console.size;
+    console.count -= len;
+  }
+}
+
+// Copy as much of `data` as fits into the buffer.
+static uint32_t buffer_put(const uint8_t* data, uint32_t len) {
+  uint32_t space = console.size - console.count;
+  if (len > space) {
+    len = space;
+  }
+
+  uint32_t head  = (console.tail + console.count) % console.size;
+  uint32_t first = console.size - head;
+  if (first > len) {
+    first = len;
+  }
+  memcpy(console.buffer + head, data, first);
+  memcpy(console.buffer, data + first, len - first);
+
+  console.count += len;
+  if (console.count > console.stats.high_water) {
+    console.stats.high_water = console.count;
+  }
+  console.stats.bytes_buffered += len;
+  return len;
+}
+
+returncode_t libtocksync_console_buffered_enable(uint8_t* buffer, uint32_t size,
+                                                 libtocksync_console_full_policy_t policy) {
+  if (buffer == NULL || size == 0) return RETURNCODE_EINVAL;
+  if (console.enabled) return RETURNCODE_EALREADY;
+
+  console.buffer    = buffer;
+  console.size      = size;
+  console.policy    = policy;
+  console.tail      = 0;
+  console.count     = 0;
+  console.in_flight = 0;
+  console.enabled   = true;
+  return RETURNCODE_SUCCESS;
+}
+
+void libtocksync_console_buffered_disable(void) {
+  if (!console.enabled) return;
+
+  libtocksync_console_buffered_flush();
+  console.enabled = false;
+}
+
+bool libtocksync_console_buffered_is_enabled(void) {
+  return console.enabled;
+}
+
+int libtocksync_console_buffered_write(const uint8_t* data, uint32_t len) {
+  uint32_t remaining = len;
+
+  while (remaining > 0) {
+    uint32_t put = buffer_put(data, remaining);
+    data      += put;
+    remaining -= put;
+
+    start_transfer();
+    if (remaining == 0) break;
+
+    // The buffer is full. Waiting only helps if a transfer will free space.
+    if (console.policy == LIBTOCKSYNC_CONSOLE_DROP || console.in_flight == 0) {
+      console.stats.bytes_dropped += remaining;
+      break;
+    }
+
+    console.stats.blocked++;
+    console.transfer_done = false;
+    yield_for(&console.transfer_done);
+  }
+
+  return len;
+}
+
+void libtocksync_console_buffered_flush(void) {
+  while (console.in_flight > 0) {
+    console.transfer_done = false;
+    yield_for(&console.transfer_done);
+  }
+}
+
+void libtocksync_console_buffered_get_stats(libtocksync_console_buffered_stats_t* stats) {
+  *stats = console.stats;
+}
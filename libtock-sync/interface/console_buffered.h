@@ -0,0 +1,70 @@
+#pragma once
+
+#include <libtock/interface/console.h>
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Buffered console output.
+//
+// By default every `printf` flush is a blocking console write: the process
+// waits in `yield` until the kernel has sent the text. Once buffered output
+// is enabled, `printf` (and anything else using `_write`) copies the text
+// into a ring buffer supplied by the app and returns immediately. The
+// buffer is sent in the background. Text written while a transfer is in
+// progress is merged and sent in one transfer when the current one
+// completes.
+//
+// Transfers only complete while the process yields. Apps that never yield
+// will fill the buffer.
+//
+// While buffered output is enabled, all console output should go through
+// `_write` (e.g. `printf`, `puts`). Other calls to `libtock_console_write`
+// replace the upcall that drains the buffer.
+
+// What to do with text that does not fit in the buffer.
+typedef enum {
+  // Discard the text that does not fit and count it in `bytes_dropped`.
+  LIBTOCKSYNC_CONSOLE_DROP,
+  // Wait for the buffer to drain until everything fits.
+  LIBTOCKSYNC_CONSOLE_BLOCK,
+} libtocksync_console_full_policy_t;
+
+typedef struct {
+  // Bytes accepted into the buffer.
+  uint32_t bytes_buffered;
+  // Bytes discarded because the buffer was full, or a transfer failed.
+  uint32_t bytes_dropped;
+  // Console transfers issued to the kernel.
+  uint32_t transfers;
+  // Writes that had to wait for space.
+  uint32_t blocked;
+  // Most bytes waiting in the buffer at once.
+  uint32_t high_water;
+} libtocksync_console_buffered_stats_t;
+
+// Start buffering console output in `buffer`, which must remain valid until
+// buffered output is disabled.
+returncode_t libtocksync_console_buffered_enable(uint8_t* buffer, uint32_t size,
+                                                 libtocksync_console_full_policy_t policy);
+
+// Wait for the buffer to drain and go back to blocking writes.
+void libtocksync_console_buffered_disable(void);
+
+bool libtocksync_console_buffered_is_enabled(void);
+
+// Add `len` bytes to the buffer and start sending them if the console is
+// idle. Returns the number of bytes consumed, which is always `len`; with the
+// drop policy some of them may have been discarded.
+int libtocksync_console_buffered_write(const uint8_t* data, uint32_t len);
+
+// Wait until everything written so far has been sent.
+void libtocksync_console_buffered_flush(void);
+
+void libtocksync_console_buffered_get_stats(libtocksync_console_buffered_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,64 @@
+#include "app_loader.h"
+
+struct app_loader_result {
+  bool fired;
+  returncode_t ret;
+};
+
+static struct app_loader_result result;
+
+static void app_loader_cb(returncode_t ret) {
+  result.fired = true;
+  result.ret   = ret;
+}
+
+returncode_t libtocksync_app_loader_stream_start(libtock_app_loader_stream_t* stream, uint32_t app_length) {
+  result.fired = false;
+  returncode_t ret = libtock_app_loader_stream_start(stream, app_length, app_loader_cb);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  yield_for(&result.fired);
+  return result.ret;
+}
+
+returncode_t libtocksync_app_loader_stream_resume(libtock_app_loader_stream_t* stream,
+                                                  const libtock_app_loader_checkpoint_t* checkpoint) {
+  result.fired = false;
+  returncode_t ret = libtock_app_loader_stream_resume(stream, checkpoint, app_loader_cb);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  yield_for(&result.fired);
+  return result.ret;
+}
+
+returncode_t libtocksync_app_loader_stream_write(libtock_app_loader_stream_t* stream,
+                                                 libtocksync_app_loader_read_chunk read, void* context) {
+  if (!stream->set_up) return RETURNCODE_EINVAL;
+
+  while (libtock_app_loader_stream_offset(stream) < stream->app_length) {
+    uint32_t space;
+    uint8_t* buffer = libtock_app_loader_stream_reserve(stream, &space);
+    if (buffer == NULL) {
+      if (stream->error != RETURNCODE_SUCCESS) return stream->error;
+      // Both buffers are full, wait for the write in flight to finish.
+      yield();
+      continue;
+    }
+
+    uint32_t len = read(context, buffer, space);
+    if (len == 0) break;
+
+    returncode_t ret = libtock_app_loader_stream_commit(stream, len);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+  }
+  return stream->error;
+}
+
+returncode_t libtocksync_app_loader_stream_finish(libtock_app_loader_stream_t* stream, const uint8_t* expected_hash) {
+  result.fired = false;
+  returncode_t ret = libtock_app_loader_stream_finish(stream, expected_hash, app_loader_cb);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  yield_for(&result.fired);
+  return result.ret;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <libtock/kernel/app_loader.h>
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Function that reads the next chunk of the app for
+// `libtocksync_app_loader_stream_write()`.
+//
+// Fill `buffer` with up to `length` bytes and return how many bytes were
+// written. Returning 0 ends the input.
+typedef uint32_t (*libtocksync_app_loader_read_chunk)(void* context, uint8_t* buffer, uint32_t length);
+
+// Start writing an app of `app_length` bytes and wait for the kernel to be
+// ready. `stream` must have been set up with `libtock_app_loader_stream_init()`.
+returncode_t libtocksync_app_loader_stream_start(libtock_app_loader_stream_t* stream, uint32_t app_length);
+
+// Continue an interrupted app write from `checkpoint`.
+returncode_t libtocksync_app_loader_stream_resume(libtock_app_loader_stream_t* stream,
+                                                  const libtock_app_loader_checkpoint_t* checkpoint);
+
+// Read the app from `read` straight into the staging buffers until it returns
+// 0 or the whole app has been read. Chunks are read while the previous chunk
+// is written to flash.
+//
+// Can be called again after `read` ran dry to continue where it stopped.
+returncode_t libtocksync_app_loader_stream_write(libtock_app_loader_stream_t* stream,
+                                                 libtocksync_app_loader_read_chunk read, void* context);
+
+// Write out the rest of the app, check it against `expected_hash` (or NULL)
+// and finalize it.
+//
+// Returns `RETURNCODE_FAIL` if the hash did not match, in which case the app
+// has been aborted.
+returncode_t libtocksync_app_loader_stream_finish(libtock_app_loader_stream_t* stream, const uint8_t* expected_hash);
+
+#ifdef __cplusplus
+}
+#endif
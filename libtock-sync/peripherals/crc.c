@@ -1,7 +1,13 @@
+#include <libtock/peripherals/crc_software.h>
 #include <libtock/peripherals/syscalls/crc_syscalls.h>
 
 #include "crc.h"
 
+// Set by `LIBTOCKSYNC_SOFTWARE` in the libtock-sync Makefile.
+#ifndef LIBTOCKSYNC_CRC_SOFTWARE
+#define LIBTOCKSYNC_CRC_SOFTWARE 1
+#endif
+
 struct crc_data {
   bool fired;
   int status;
@@ -17,17 +23,42 @@ static void crc_callback(returncode_t ret, uint32_t crc) {
 }
 
 bool libtocksync_crc_exists(void) {
-  return libtock_crc_driver_exists();
+  return LIBTOCKSYNC_CRC_SOFTWARE || libtock_crc_driver_exists();
 }
 
 returncode_t libtocksync_crc_compute(const uint8_t* buf, size_t buflen, libtock_crc_alg_t algorithm, uint32_t* crc) {
   returncode_t ret;
+
+#if LIBTOCKSYNC_CRC_SOFTWARE
+  // Look up the driver once, it cannot appear later.
+  static int driver = -1;
+  if (driver < 0) driver = libtock_crc_driver_exists();
+  if (!driver) {
+    *crc = libtock_crc_software_compute(buf, buflen, algorithm);
+    return RETURNCODE_SUCCESS;
+  }
+#endif
+
   result.fired = false;
 
   ret = libtock_crc_compute(buf, buflen, algorithm, crc_callback);
+#if LIBTOCKSYNC_CRC_SOFTWARE
+  if (ret == RETURNCODE_ESIZE) {
+    libtock_crc_set_readonly_allow(NULL, 0);
+    *crc = libtock_crc_software_compute(buf, buflen, algorithm);
+    return RETURNCODE_SUCCESS;
+  }
+#endif
   if (ret != RETURNCODE_SUCCESS) return ret;
 
   yield_for(&result.fired);
+#if LIBTOCKSYNC_CRC_SOFTWARE
+  if (result.status == RETURNCODE_ESIZE) {
+    libtock_crc_set_readonly_allow(NULL, 0);
+    *crc = libtock_crc_software_compute(buf, buflen, algorithm);
+    return RETURNCODE_SUCCESS;
+  }
+#endif
   if (result.status != RETURNCODE_SUCCESS) return result.status;
 
   ret = libtock_crc_set_readonly_allow(NULL, 0);
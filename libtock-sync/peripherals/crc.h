@@ -7,13 +7,22 @@
 extern "C" {
 #endif
 
+// Check if CRCs can be computed: true if there is a CRC driver, or if
+// libtock-sync was built with the software CRC. Use
+// `libtock_crc_driver_exists()` to check for the driver only.
 bool libtocksync_crc_exists(void);
 
 // Compute a CRC.
 //
+// Uses the CRC driver if there is one, and otherwise (or if the buffer is too
+// big for the unit) computes the CRC in software, if libtock-sync was built
+// with it.
+//
 // Returns `SUCCESS` and sets `result` on success.
 // Returns `EBUSY` if a computation is already in progress.
-// Returns `ESIZE` if the buffer is too big for the unit.
+// Returns `ESIZE` if the buffer is too big for the unit and libtock-sync was
+// built without the software CRC.
+// Returns `ENODEVICE` if there is no CRC driver and no software CRC.
 returncode_t libtocksync_crc_compute(const uint8_t* buf, size_t buflen, libtock_crc_alg_t algorithm, uint32_t* result);
 
 #ifdef __cplusplus
@@ -0,0 +1,33 @@
+#include <libtock/tock.h>
+
+#include "../storage/nonvolatile_storage.h"
+#include "log.h"
+
+void libtocksync_log_flush(void) {
+  // Each completed console write starts the next one from its upcall.
+  while (libtock_log_sending()) {
+    yield();
+  }
+}
+
+returncode_t libtocksync_log_save(uint32_t offset, uint32_t length, uint32_t* saved) {
+  *saved = 0;
+
+  while (*saved < length) {
+    const uint8_t* data;
+    uint32_t len = libtock_log_peek(&data);
+    if (len == 0) break;
+    if (len > length - *saved) {
+      len = length - *saved;
+    }
+
+    int written;
+    returncode_t ret = libtocksync_nonvolatile_storage_write(offset + *saved, len, (uint8_t*) data, len, &written);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+    if (written <= 0) break;
+
+    libtock_log_consume(written);
+    *saved += written;
+  }
+  return RETURNCODE_SUCCESS;
+}
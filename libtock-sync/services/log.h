@@ -0,0 +1,24 @@
+#pragma once
+
+#include <libtock/services/log.h>
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Block until all buffered log records have been sent to the console.
+void libtocksync_log_flush(void);
+
+// Move buffered log records to nonvolatile storage, starting at `offset`.
+// At most `length` bytes are written; whatever does not fit stays in the log
+// buffer. `saved` is set to the number of bytes written. Only for
+// `LIBTOCK_LOG_OUTPUT_MANUAL`.
+//
+// The stored bytes are the same COBS stream that is sent to the console, so
+// a dump of the region can be passed to `tools/tock_log/tock_log_decode.py`.
+returncode_t libtocksync_log_save(uint32_t offset, uint32_t length, uint32_t* saved);
+
+#ifdef __cplusplus
+}
+#endif
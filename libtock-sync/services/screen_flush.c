@@ -0,0 +1,15 @@
+#include "screen_flush.h"
+
+void libtocksync_screen_flush_wait_buffer(const uint8_t* buffer) {
+  // The flush engine calls back from the screen upcalls, so keep yielding
+  // until it releases the buffer.
+  while (libtock_screen_flush_buffer_busy(buffer)) {
+    yield();
+  }
+}
+
+void libtocksync_screen_flush_wait(void) {
+  while (libtock_screen_flush_busy()) {
+    yield();
+  }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <libtock/services/screen_flush.h>
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Block until `buffer` has been transferred to the screen and may be rendered
+// into again.
+void libtocksync_screen_flush_wait_buffer(const uint8_t* buffer);
+
+// Block until all submitted regions have been transferred to the screen.
+void libtocksync_screen_flush_wait(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,25 @@
+#include "text_screen_frame.h"
+
+struct text_screen_frame_data {
+  bool fired;
+  returncode_t ret;
+};
+
+static struct text_screen_frame_data result = {.fired = false};
+
+static void text_screen_frame_cb(returncode_t ret) {
+  result.fired = true;
+  result.ret   = ret;
+}
+
+returncode_t libtocksync_text_screen_frame_commit(libtock_text_screen_frame_t* frame) {
+  returncode_t ret;
+  result.fired = false;
+
+  ret = libtock_text_screen_frame_commit(frame, text_screen_frame_cb);
+  if (ret == RETURNCODE_EALREADY) return RETURNCODE_SUCCESS;
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  yield_for(&result.fired);
+  return result.ret;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <libtock/services/text_screen_frame.h>
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Send the changes in `frame` to the screen and wait for them to complete.
+//
+// Returns `RETURNCODE_SUCCESS` if nothing changed.
+returncode_t libtocksync_text_screen_frame_commit(libtock_text_screen_frame_t* frame);
+
+#ifdef __cplusplus
+}
+#endif
@@ -12,6 +12,8 @@
 #include <string.h>
 
 #include <libtock/kernel/ipc.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/services/memory_profile.h>
 
 #include "alarm.h"
 #include "unit_test.h"
@@ -92,6 +94,19 @@ struct unit_test_t {
   // The reason a test has failed;
   char reason[72];
 
+  // Alarm ticks the most recent test function ran for, measured by the runner.
+  uint32_t ticks;
+
+  // Bytes of stack the most recent test used below the runner's own frame.
+  uint32_t stack_bytes;
+
+  // How far the heap has grown since the runner started, up to the end of the
+  // most recent test.
+  uint32_t heap_bytes;
+
+  // Alarm counter when the supervisor started the current test.
+  uint32_t start_ticks;
+
   // Interior linked list element, points to the next test runner in the
   // queue.
   unit_test_t* next;
@@ -155,6 +170,8 @@ static bool list_contains(linked_list_t* list, unit_test_t* test) {
 #define TEST_BUF_SZ 256
 static char test_buf[TEST_BUF_SZ] __attribute__((aligned(TEST_BUF_SZ)));
 
+_Static_assert(sizeof(unit_test_t) <= TEST_BUF_SZ, "unit_test_t must fit in the shared buffer");
+
 /**
  * Test runner's condition variable which allows the test runner to
  * cooperatively multiprogram with the test supervisor.
@@ -162,10 +179,22 @@ static char test_buf[TEST_BUF_SZ] __attribute__((aligned(TEST_BUF_SZ)));
 static bool done = false;
 
 /**
- * Test supervisor's linked list of pending test runners.
+ * Test supervisor's linked list of test runners waiting for a free slot.
  */
 static linked_list_t pending_pids;
 
+/**
+ * Test supervisor's number of test runners currently running tests, and how
+ * many may run at once.
+ */
+static uint32_t running_count = 0;
+static uint32_t max_running   = 1;
+
+/**
+ * Test supervisor's output format.
+ */
+static unit_test_output_t output_format = UnitTestText;
+
 
 /*******************************************************************************
  * TEST RUNNER FUNCTIONS
@@ -201,6 +230,20 @@ static void sync_with_supervisor(int svc) {
   yield_for(&done);
 }
 
+/*
+ * Stack and heap measurement.
+ *
+ * Before each test the unused stack below the runner is painted again (see
+ * libtock/services/memory_profile.h), and afterwards the lowest overwritten
+ * word gives the deepest point the test reached.
+ */
+static uintptr_t heap_base = 0;
+
+static uintptr_t heap_top(void) {
+  // memop 1 is sbrk, so an increment of 0 returns the current break.
+  return (uintptr_t) memop(1, 0).data;
+}
+
 static char failure_reason[sizeof(((unit_test_t*) 0)->reason)];
 void set_failure_reason(const char* reason) {
   strncpy(failure_reason, reason, sizeof(failure_reason));
@@ -228,6 +271,7 @@ void unit_test_runner(unit_test_fun* tests, uint32_t test_count,
   unit_test_t* test = (unit_test_t*)(&test_buf[0]);
   test->count      = test_count;
   test->timeout_ms = timeout_ms;
+  heap_base        = heap_top();
 
   // Establish communication with the test supervisor service. First delay 10 ms
   // to ensure the supervisor service has time to register.
@@ -255,11 +299,19 @@ void unit_test_runner(unit_test_fun* tests, uint32_t test_count,
     sync_with_supervisor(test_svc);
 
     // Run the test.
+    libtock_memory_profile_reset_stack();
     test_setup();
     failure_reason[0] = '\0';
+    uint32_t start, end;
+    libtock_alarm_command_read(&start);
     bool passed = tests[i].fun();
+    libtock_alarm_command_read(&end);
     test_teardown();
 
+    test->ticks       = end - start;
+    test->stack_bytes = libtock_memory_profile_stack_used_since_reset();
+    test->heap_bytes  = heap_top() - heap_base;
+
     // Record the result. If the test timed out, the supervisor will have
     // marked the result already.
     if (test->result != Timeout) {
@@ -284,6 +336,43 @@ void unit_test_runner(unit_test_fun* tests, uint32_t test_count,
  * TEST SUPERVISOR FUNCTIONS
  ******************************************************************************/
 
+/** \brief Print a string as a JSON string literal.
+ */
+static void print_json_string(const char* str) {
+  putchar('"');
+  for ( ; *str != '\0'; str++) {
+    if (*str == '"' || *str == '\\') {
+      printf("\\%c", *str);
+    } else if ((unsigned char) *str < 0x20) {
+      printf("\\u%04x", *str);
+    } else {
+      putchar(*str);
+    }
+  }
+  putchar('"');
+}
+
+/** \brief Print the individual test result as one JSON line.
+ */
+static void print_test_result_json(unit_test_t* test, const char* name, const char* reason) {
+  static const char* result_names[] = { "pass", "fail", "timeout" };
+
+  printf("{\"pid\":%d,\"test\":%lu,\"name\":", test->pid, test->current);
+  print_json_string(name);
+  printf(",\"result\":\"%s\",\"ticks\":%lu,\"ms\":%lu", result_names[test->result], test->ticks,
+         libtock_alarm_ticks_to_ms(test->ticks));
+  if (test->result == Timeout) {
+    puts("}");
+    return;
+  }
+  printf(",\"stack\":%lu,\"heap\":%lu", test->stack_bytes, test->heap_bytes);
+  if (test->result == Failed) {
+    printf(",\"reason\":");
+    print_json_string(reason);
+  }
+  puts("}");
+}
+
 /** \brief Print the individual test result to the console.
  */
 static void print_test_result(unit_test_t* test) {
@@ -291,6 +380,10 @@ static void print_test_result(unit_test_t* test) {
   char reason_buf[sizeof(test->reason) + 1] = {0};
   memcpy(name_buf, test->name, sizeof(test->name));
   memcpy(reason_buf, test->reason, sizeof(test->reason));
+  if (output_format == UnitTestJsonLines) {
+    print_test_result_json(test, name_buf, reason_buf);
+    return;
+  }
   printf("%d.%03lu: %-24s ", test->pid, test->current, name_buf);
   switch (test->result) {
     case Passed:
@@ -315,29 +408,46 @@ static void print_test_summary(unit_test_t* test) {
 
   uint32_t incomplete = total - (test->pass_count + test->fail_count);
 
+  if (output_format == UnitTestJsonLines) {
+    printf("{\"pid\":%d,\"summary\":true,\"passed\":%lu,\"failed\":%lu,\"incomplete\":%lu,\"total\":%lu}\n",
+           test->pid, test->pass_count, test->fail_count, incomplete, total);
+    return;
+  }
+
   printf("Summary %d: [%lu/%lu] Passed, [%lu/%lu] Failed, [%lu/%lu] Incomplete\n",
          test->pid, test->pass_count, total,
          test->fail_count, total,
          incomplete, total);
 }
 
-struct alarm_cb_data {
-  unit_test_t* test;
-};
-
-static struct alarm_cb_data data = { .test = NULL };
+/** \brief Start the next test runner waiting for a slot, if there is one.
+ */
+static void start_next_runner(linked_list_t* pending) {
+  if (pending->head && running_count < max_running) {
+    unit_test_t* next = pending->head;
+    list_pop(pending);
+    running_count++;
+    ipc_notify_client(next->pid);
+  }
+}
 
 /** \brief Timer callback for handling a test timeout.
  *
  * When a test times out, there's no guarantee about the test runner's state, so
- * we just stop the tests here and print the results.
+ * we stop that runner's tests here, print its results and give its slot to
+ * the next runner.
  */
-static void timeout_callback(__attribute__ ((unused)) uint32_t now,
+static void timeout_callback(uint32_t                          now,
                              __attribute__ ((unused)) uint32_t scheduled,
-                             __attribute__ ((unused)) void*    opqaue) {
-  data.test->result = Timeout;
-  print_test_result(data.test);
-  print_test_summary(data.test);
+                             void*                             opaque) {
+  unit_test_t* test = (unit_test_t*) opaque;
+  test->result = Timeout;
+  test->ticks  = now - test->start_ticks;
+  print_test_result(test);
+  print_test_summary(test);
+
+  running_count--;
+  start_next_runner(&pending_pids);
 }
 
 /** \brief IPC service callback for coordinating test runners.
@@ -365,21 +475,17 @@ static void unit_test_service_callback(int                            pid,
       // Initialize the relevant fields in the test descriptor.
       test->pid = pid;
 
-      // Queue the test
+      // Queue the test runner, and start it if there is a free slot.
       if (!list_contains(pending, test)) {
         list_append(pending, test);
       }
-
-      // If there is no other test in progress, start this test.
-      if (pending->head->pid == pid) {
-        ipc_notify_client(pid);
-      }
+      start_next_runner(pending);
       break;
 
     case TestStart:
       // Start the alarm and start the test.
-      data.test = test;
-      libtock_alarm_in_ms(test->timeout_ms, timeout_callback, NULL, &test->alarm);
+      libtock_alarm_command_read(&test->start_ticks);
+      libtock_alarm_in_ms(test->timeout_ms, timeout_callback, test, &test->alarm);
       ipc_notify_client(test->pid);
       break;
 
@@ -408,15 +514,15 @@ static void unit_test_service_callback(int                            pid,
         print_test_summary(test);
       }
 
-      // Remove the completed test runner from the queue and allow it to
-      // exit.
-      list_pop(pending);
+      // Allow the completed test runner to exit. A runner that timed out
+      // already gave up its slot.
       ipc_notify_client(test->pid);
+      if (test->result != Timeout) {
+        running_count--;
+      }
 
       // Continue with the next enqueued test runner, if there is one.
-      if (pending->head) {
-        ipc_notify_client(pending->head->pid);
-      }
+      start_next_runner(pending);
       break;
     default:
       break;
@@ -428,8 +534,18 @@ static void unit_test_service_callback(int                            pid,
  * Sets up the IPC service and returns.
  */
 void unit_test_service(void) {
+  unit_test_service_with_options(1, UnitTestText);
+}
+
+/** \brief Test supervisor entry point with a number of test runners to run at
+ * once and an output format.
+ */
+void unit_test_service_with_options(uint32_t max_parallel, unit_test_output_t output) {
   pending_pids.head = NULL;
   pending_pids.tail = NULL;
+  running_count     = 0;
+  max_running       = max_parallel > 0 ? max_parallel : 1;
+  output_format     = output;
   ipc_register_service_callback("org.tockos.unit_test",
                                 unit_test_service_callback, &pending_pids);
 }
@@ -67,6 +67,24 @@
  *    2.001: fail             [FAILED]
  *    2.002: timeout          [ERROR: Timeout]
  *
+ * ## Parallel runners and machine-readable output
+ *
+ * `unit_test_service_with_options` lets the supervisor run several test
+ * runners at once, each test still with its own timeout, and print one JSON
+ * object per line instead:
+ *
+ *    unit_test_service_with_options(4, UnitTestJsonLines);
+ *
+ *    {"pid":2,"test":0,"name":"pass","result":"pass","ticks":41,"ms":1,"stack":96,"heap":0}
+ *    {"pid":2,"test":1,"name":"fail","result":"fail","ticks":38,"ms":1,"stack":96,"heap":0,"reason":"x == 1"}
+ *    {"pid":2,"test":2,"name":"timeout","result":"timeout","ticks":9830,"ms":300}
+ *    {"pid":2,"summary":true,"passed":1,"failed":1,"incomplete":1,"total":3}
+ *
+ * `ticks` is how long the test function ran in alarm ticks. `stack` is the
+ * stack the test used below the runner's own frame, and `heap` is how far the
+ * runner's heap has grown since it started. Runners that use the same
+ * peripherals should not be run in parallel.
+ *
  * Author: Shane Leonard <shanel@stanford.edu>
  * Modified: 8/13/2017
  */
@@ -101,6 +119,15 @@ void set_failure_reason(const char* reason);
 
 #define CHECK(x) if (!(x)) { set_failure_reason(#x); return false; }
 
+/** \brief Test supervisor output formats. */
+typedef enum {
+  // One human-readable line per test.
+  UnitTestText,
+
+  // One JSON object per line, with timing and memory use.
+  UnitTestJsonLines,
+} unit_test_output_t;
+
 /** \brief A test setup function */
 bool test_setup(void);
 
@@ -164,6 +191,14 @@ void unit_test_runner(unit_test_fun* tests, uint32_t test_count,
  */
 void unit_test_service(void);
 
+/** \brief Test supervisor entry point with options.
+ *
+ * \param max_parallel The number of test runners which may run tests at the
+ *                     same time. `unit_test_service` uses 1.
+ * \param output The format test results are printed in.
+ */
+void unit_test_service_with_options(uint32_t max_parallel, unit_test_output_t output);
+
 #ifdef __cplusplus
 }
 #endif
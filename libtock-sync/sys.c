@@ -1,4 +1,5 @@
 #include "interface/console.h"
+#include "interface/console_buffered.h"
 
 // XXX Suppress missing prototype warnings for this file as the headers should
 // be in newlib internals, but first stab at including things didn't quite work
@@ -12,6 +13,10 @@
 // ------------------------------
 
 int _write(__attribute__ ((unused)) int fd, const void* buf, uint32_t count) {
+  if (libtocksync_console_buffered_is_enabled()) {
+    return libtocksync_console_buffered_write((const uint8_t*) buf, count);
+  }
+
   int written;
   libtocksync_console_write((const uint8_t*) buf, count, &written);
   return written;
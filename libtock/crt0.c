@@ -1,6 +1,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "peripherals/syscalls/alarm_syscalls.h"
+#include "stack_pointer.h"
 #include "tock.h"
 
 #if defined(STACK_SIZE)
@@ -249,6 +251,85 @@ void _start(void* app_start __attribute__((unused)),
 #endif
 }
 
+// Set by an app that runs on a kernel which zeroes process memory before
+// starting or restarting a process, to skip zeroing BSS in crt0. See
+// `tock.h`.
+__attribute__ ((weak))
+const bool libtock_crt0_kernel_zeroes_bss = false;
+
+// Alarm ticks from the start of C startup to `main`. Written just before
+// `main` is called, so it is not cleared with BSS.
+static uint32_t startup_ticks;
+
+uint32_t libtock_startup_ticks(void) {
+  return startup_ticks;
+}
+
+// Set by an app that wants its stack use profiled, to have the stack painted
+// before `main`. See `tock.h`.
+__attribute__ ((weak))
+const bool libtock_crt0_paint_stack = false;
+
+// Written just before `main` is called, like `startup_ticks`.
+static libtock_memory_layout_t memory_layout;
+
+void libtock_memory_layout(libtock_memory_layout_t* layout) {
+  *layout = memory_layout;
+}
+
+// Bytes below the stack pointer left unpainted, for the frames of the calls
+// made on the way to `main`.
+#define PAINT_MARGIN 64
+
+// Record where the stack and heap are, and paint the unused stack if the app
+// asked for it. Stack addresses are computed the same way as in `_start`.
+static void record_layout(struct hdr* myhdr, uint32_t mem_start) {
+  memory_layout.stack_bottom = (uint32_t*)mem_start;
+  memory_layout.stack_top    = (uint32_t*)((mem_start + myhdr->stack_size + 7) & 0xfffffff8);
+  memory_layout.heap_start   = (void*)(mem_start + myhdr->bss_start + myhdr->bss_size);
+
+  if (libtock_crt0_paint_stack) {
+    uint32_t* limit = libtock_stack_pointer() - PAINT_MARGIN / sizeof(uint32_t);
+    for (uint32_t* p = memory_layout.stack_bottom; p < limit; p++) {
+      *p = LIBTOCK_STACK_PAINT;
+    }
+  }
+}
+
+// Read the alarm counter without going through any globals, as this runs
+// before the GOT and data sections are set up.
+static inline uint32_t startup_clock(void) {
+  syscall_return_t rval = command(DRIVER_NUM_ALARM, 2, 0, 0);
+  return rval.type == TOCK_SYSCALL_SUCCESS_U32 ? rval.data[0] : 0;
+}
+
+// Relocate one address. Addresses with the MSB set point into flash and have
+// the sentinel removed and `app_start` added; all others point into RAM and
+// have `mem_start` added. Written without branches: `flash_mask` is all ones
+// for flash addresses, and `flash_adjust` is the difference between the two
+// cases.
+static inline uint32_t relocate(uint32_t addr, uint32_t mem_start, uint32_t flash_adjust) {
+  uint32_t flash_mask = (uint32_t) ((int32_t) addr >> 31);
+  return addr + mem_start + (flash_adjust & flash_mask);
+}
+
+// Copy the data section into RAM and zero BSS.
+static void load_sections(struct hdr* myhdr, uint32_t app_start, uint32_t mem_start) {
+  // Load the data section from flash into RAM. We use the offsets from our
+  // crt0 header so we know where this starts and where it should go.
+  void* data_start     = (void*)(myhdr->data_start + mem_start);
+  void* data_sym_start = (void*)(myhdr->data_sym_start + app_start);
+  memcpy(data_start, data_sym_start, myhdr->data_size);
+
+  // Zero BSS segment. Again, we know where this should be in the process RAM
+  // based on the crt0 header. The flag is read after the data section is
+  // loaded in case an app defines it as a non-const variable.
+  if (!libtock_crt0_kernel_zeroes_bss) {
+    char* bss_start = (char*)(myhdr->bss_start + mem_start);
+    memset(bss_start, 0, myhdr->bss_size);
+  }
+}
+
 // C startup routine that configures memory for the process. This also handles
 // PIC fixups that are required for the application.
 //
@@ -259,75 +340,69 @@ void _start(void* app_start __attribute__((unused)),
 //   app.
 __attribute__((noreturn))
 void _c_start_pic(uint32_t app_start, uint32_t mem_start) {
+  uint32_t start = startup_clock();
   struct hdr* myhdr = (struct hdr*)app_start;
 
+  // Addresses are either offsets from 0x0 (RAM) or from 0x80000000 (flash),
+  // since the app was linked with those as the start of RAM and flash. Adding
+  // `mem_start` fixes RAM addresses. For flash addresses we also need to
+  // remove the sentinel and replace `mem_start` with `app_start`:
+  //
+  //     got_entry = (got_stored_entry - original_RAM_start_address) + actual_RAM_start_address
+  //     got_entry = (got_stored_entry ^ 0x80000000) + app_start
+  //
+  // Both are done by `relocate` using this adjustment.
+  uint32_t flash_adjust = app_start - mem_start - 0x80000000;
+
   // Fix up the Global Offset Table (GOT).
 
   // Get the address in memory of where the table should go.
   uint32_t* got_start = (uint32_t*)(myhdr->got_start + mem_start);
   // Get the address in flash of where the table currently is.
   uint32_t* got_sym_start = (uint32_t*)(myhdr->got_sym_start + app_start);
-  // Iterate all entries in the table and correct the addresses.
-  for (uint32_t i = 0; i < (myhdr->got_size / (uint32_t)sizeof(uint32_t)); i++) {
-    // Use the sentinel here. If the most significant bit is 0, then we know
-    // this offset is pointing to an address in memory. If the MSB is 1, then
-    // the offset refers to a value in flash.
-    if ((got_sym_start[i] & 0x80000000) == 0) {
-      // This is an address for something in memory, and we need to correct the
-      // address now that we know where this app is actually running in memory.
-      // This equation is really:
-      //
-      //     got_entry = (got_stored_entry - original_RAM_start_address) + actual_RAM_start_address
-      //
-      // However, we compiled the app where `original_RAM_start_address` is 0x0,
-      // so we can omit that.
-      got_start[i] = got_sym_start[i] + mem_start;
-    } else {
-      // Otherwise, this address refers to something in flash. Now that we know
-      // where the app has actually been loaded, we can reference from the
-      // actual `app_start` address. We also have to remove our fake flash
-      // address sentinel (by ORing with 0x80000000).
-      got_start[i] = (got_sym_start[i] ^ 0x80000000) + app_start;
-    }
+  // Iterate all entries in the table and correct the addresses, four at a
+  // time. Large apps have thousands of entries.
+  uint32_t got_len = myhdr->got_size / (uint32_t)sizeof(uint32_t);
+  uint32_t i       = 0;
+  for (; i + 4 <= got_len; i += 4) {
+    uint32_t a = got_sym_start[i];
+    uint32_t b = got_sym_start[i + 1];
+    uint32_t c = got_sym_start[i + 2];
+    uint32_t d = got_sym_start[i + 3];
+    got_start[i]     = relocate(a, mem_start, flash_adjust);
+    got_start[i + 1] = relocate(b, mem_start, flash_adjust);
+    got_start[i + 2] = relocate(c, mem_start, flash_adjust);
+    got_start[i + 3] = relocate(d, mem_start, flash_adjust);
+  }
+  for (; i < got_len; i++) {
+    got_start[i] = relocate(got_sym_start[i], mem_start, flash_adjust);
   }
 
-  // Load the data section from flash into RAM. We use the offsets from our
-  // crt0 header so we know where this starts and where it should go.
-  void* data_start     = (void*)(myhdr->data_start + mem_start);
-  void* data_sym_start = (void*)(myhdr->data_sym_start + app_start);
-  memcpy(data_start, data_sym_start, myhdr->data_size);
-
-  // Zero BSS segment. Again, we know where this should be in the process RAM
-  // based on the crt0 header.
-  char* bss_start = (char*)(myhdr->bss_start + mem_start);
-  memset(bss_start, 0, myhdr->bss_size);
+  load_sections(myhdr, app_start, mem_start);
 
   // Do relative data address fixups. We know these entries are stored at the end
   // of flash and can be located using the crt0 header.
   //
   // The data structure used for these is `struct reldata`, where a 32 bit
-  // length field is followed by that many entries. We iterate each entry and
-  // correct addresses.
+  // length field is followed by that many entries. Entries come in pairs: the
+  // offset of the address to fix, relative to the beginning of the app's
+  // memory region, and relocation info that we do not need. The addresses use
+  // the same sentinel as the GOT.
   struct reldata* rd = (struct reldata*)(myhdr->reldata_start + (uint32_t)app_start);
-  for (uint32_t i = 0; i < (rd->len / (int)sizeof(uint32_t)); i += 2) {
-    // The entries are offsets from the beginning of the app's memory region.
-    // First, we get a pointer to the location of the address we need to fix.
+  uint32_t rd_len = rd->len / (uint32_t)sizeof(uint32_t);
+  for (i = 0; i + 4 <= rd_len; i += 4) {
+    uint32_t* a = (uint32_t*)(rd->data[i] + mem_start);
+    uint32_t* b = (uint32_t*)(rd->data[i + 2] + mem_start);
+    *a = relocate(*a, mem_start, flash_adjust);
+    *b = relocate(*b, mem_start, flash_adjust);
+  }
+  for (; i < rd_len; i += 2) {
     uint32_t* target = (uint32_t*)(rd->data[i] + mem_start);
-    if ((*target & 0x80000000) == 0) {
-      // Again, we use our sentinel. If the address at that location has a MSB
-      // of 0, then we know this is an address in RAM. We need to fix the
-      // address by including the offset where the app actual ended up in
-      // memory. This is a simple addition since the app was compiled with a
-      // memory address of zero.
-      *target += mem_start;
-    } else {
-      // When the MSB is 1, the address is in flash. We clear our sentinel, and
-      // then make the address an offset from the start of where the app is
-      // located in flash.
-      *target = (*target ^ 0x80000000) + app_start;
-    }
+    *target = relocate(*target, mem_start, flash_adjust);
   }
 
+  startup_ticks = startup_clock() - start;
+  record_layout(myhdr, mem_start);
   exit(main(0, NULL));
 }
 
@@ -340,6 +415,7 @@ void _c_start_pic(uint32_t app_start, uint32_t mem_start) {
 //   app.
 __attribute__((noreturn))
 void _c_start_nopic(uint32_t app_start, uint32_t mem_start) {
+  uint32_t start = startup_clock();
   struct hdr* myhdr = (struct hdr*)app_start;
 
   // Copy over the Global Offset Table (GOT). The GOT seems to still get created
@@ -351,16 +427,9 @@ void _c_start_nopic(uint32_t app_start, uint32_t mem_start) {
   void* got_sym_start = (void*)(myhdr->got_sym_start + app_start);
   memcpy(got_start, got_sym_start, myhdr->got_size);
 
-  // Load the data section from flash into RAM. We use the offsets from our
-  // crt0 header so we know where this starts and where it should go.
-  void* data_start     = (void*)(myhdr->data_start + mem_start);
-  void* data_sym_start = (void*)(myhdr->data_sym_start + app_start);
-  memcpy(data_start, data_sym_start, myhdr->data_size);
-
-  // Zero BSS segment. Again, we know where this should be in the process RAM
-  // based on the crt0 header.
-  char* bss_start = (char*)(myhdr->bss_start + mem_start);
-  memset(bss_start, 0, myhdr->bss_size);
+  load_sections(myhdr, app_start, mem_start);
 
+  startup_ticks = startup_clock() - start;
+  record_layout(myhdr, mem_start);
   exit(main(0, NULL));
 }
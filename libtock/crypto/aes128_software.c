@@ -0,0 +1,532 @@
+#include <string.h>
+
+#include "aes128_software.h"
+
+#define BLOCK LIBTOCK_AES128_SOFTWARE_BLOCK_LEN
+
+// Bitsliced AES S-box (Boyar and Peralta's circuit). `q[i]` holds bit `i` of
+// every byte being substituted, one byte per bit lane.
+static void sbox(uint32_t* q) {
+  uint32_t x0, x1, x2, x3, x4, x5, x6, x7;
+  uint32_t y1, y2, y3, y4, y5, y6, y7, y8, y9;
+  uint32_t y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+  uint32_t y20, y21;
+  uint32_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+  uint32_t z10, z11, z12, z13, z14, z15, z16, z17;
+  uint32_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+  uint32_t t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+  uint32_t t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+  uint32_t t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+  uint32_t t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+  uint32_t t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+  uint32_t t60, t61, t62, t63, t64, t65, t66, t67;
+  uint32_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+  x0 = q[7];
+  x1 = q[6];
+  x2 = q[5];
+  x3 = q[4];
+  x4 = q[3];
+  x5 = q[2];
+  x6 = q[1];
+  x7 = q[0];
+
+  // Top linear transformation.
+  y14 = x3 ^ x5;
+  y13 = x0 ^ x6;
+  y9  = x0 ^ x3;
+  y8  = x0 ^ x5;
+  t0  = x1 ^ x2;
+  y1  = t0 ^ x7;
+  y4  = y1 ^ x3;
+  y12 = y13 ^ y14;
+  y2  = y1 ^ x0;
+  y5  = y1 ^ x6;
+  y3  = y5 ^ y8;
+  t1  = x4 ^ y12;
+  y15 = t1 ^ x5;
+  y20 = t1 ^ x1;
+  y6  = y15 ^ x7;
+  y10 = y15 ^ t0;
+  y11 = y20 ^ y9;
+  y7  = x7 ^ y11;
+  y17 = y10 ^ y11;
+  y19 = y10 ^ y8;
+  y16 = t0 ^ y11;
+  y21 = y13 ^ y16;
+  y18 = x0 ^ y16;
+
+  // Non-linear section.
+  t2  = y12 & y15;
+  t3  = y3 & y6;
+  t4  = t3 ^ t2;
+  t5  = y4 & x7;
+  t6  = t5 ^ t2;
+  t7  = y13 & y16;
+  t8  = y5 & y1;
+  t9  = t8 ^ t7;
+  t10 = y2 & y7;
+  t11 = t10 ^ t7;
+  t12 = y9 & y11;
+  t13 = y14 & y17;
+  t14 = t13 ^ t12;
+  t15 = y8 & y10;
+  t16 = t15 ^ t12;
+  t17 = t4 ^ t14;
+  t18 = t6 ^ t16;
+  t19 = t9 ^ t14;
+  t20 = t11 ^ t16;
+  t21 = t17 ^ y20;
+  t22 = t18 ^ y19;
+  t23 = t19 ^ y21;
+  t24 = t20 ^ y18;
+
+  t25 = t21 ^ t22;
+  t26 = t21 & t23;
+  t27 = t24 ^ t26;
+  t28 = t25 & t27;
+  t29 = t28 ^ t22;
+  t30 = t23 ^ t24;
+  t31 = t22 ^ t26;
+  t32 = t31 & t30;
+  t33 = t32 ^ t24;
+  t34 = t23 ^ t33;
+  t35 = t27 ^ t33;
+  t36 = t24 & t35;
+  t37 = t36 ^ t34;
+  t38 = t27 ^ t36;
+  t39 = t29 & t38;
+  t40 = t25 ^ t39;
+
+  t41 = t40 ^ t37;
+  t42 = t29 ^ t33;
+  t43 = t29 ^ t40;
+  t44 = t33 ^ t37;
+  t45 = t42 ^ t41;
+  z0  = t44 & y15;
+  z1  = t37 & y6;
+  z2  = t33 & x7;
+  z3  = t43 & y16;
+  z4  = t40 & y1;
+  z5  = t29 & y7;
+  z6  = t42 & y11;
+  z7  = t45 & y17;
+  z8  = t41 & y10;
+  z9  = t44 & y12;
+  z10 = t37 & y3;
+  z11 = t33 & y4;
+  z12 = t43 & y13;
+  z13 = t40 & y5;
+  z14 = t29 & y2;
+  z15 = t42 & y9;
+  z16 = t45 & y14;
+  z17 = t41 & y8;
+
+  // Bottom linear transformation.
+  t46 = z15 ^ z16;
+  t47 = z10 ^ z11;
+  t48 = z5 ^ z13;
+  t49 = z9 ^ z10;
+  t50 = z2 ^ z12;
+  t51 = z2 ^ z5;
+  t52 = z7 ^ z8;
+  t53 = z0 ^ z3;
+  t54 = z6 ^ z7;
+  t55 = z16 ^ z17;
+  t56 = z12 ^ t48;
+  t57 = t50 ^ t53;
+  t58 = z4 ^ t46;
+  t59 = z3 ^ t54;
+  t60 = t46 ^ t57;
+  t61 = z14 ^ t57;
+  t62 = t52 ^ t58;
+  t63 = t49 ^ t58;
+  t64 = z4 ^ t59;
+  t65 = t61 ^ t62;
+  t66 = z1 ^ t63;
+  s0  = t59 ^ t63;
+  s6  = t56 ^ ~t62;
+  s7  = t48 ^ ~t60;
+  t67 = t64 ^ t65;
+  s3  = t53 ^ t66;
+  s4  = t51 ^ t66;
+  s5  = t47 ^ t65;
+  s1  = t64 ^ ~s3;
+  s2  = t55 ^ ~t67;
+
+  q[7] = s0;
+  q[6] = s1;
+  q[5] = s2;
+  q[4] = s3;
+  q[3] = s4;
+  q[2] = s5;
+  q[1] = s6;
+  q[0] = s7;
+}
+
+// The inverse S-box is the inverse affine transform, the forward S-box (which
+// inverts in GF(2^8) and applies the affine transform), then the inverse
+// affine transform again.
+static void inv_affine(uint32_t* q) {
+  uint32_t q0 = ~q[0], q1 = ~q[1], q2 = q[2], q3 = q[3];
+  uint32_t q4 = q[4], q5 = ~q[5], q6 = ~q[6], q7 = q[7];
+
+  q[7] = q1 ^ q4 ^ q6;
+  q[6] = q0 ^ q3 ^ q5;
+  q[5] = q7 ^ q2 ^ q4;
+  q[4] = q6 ^ q1 ^ q3;
+  q[3] = q5 ^ q0 ^ q2;
+  q[2] = q4 ^ q7 ^ q1;
+  q[1] = q3 ^ q6 ^ q0;
+  q[0] = q2 ^ q5 ^ q7;
+}
+
+static void inv_sbox(uint32_t* q) {
+  inv_affine(q);
+  sbox(q);
+  inv_affine(q);
+}
+
+// Transpose an 8x8 bit matrix, one byte per row. Row `r` of the output holds
+// bit `7 - r` of every input byte. The transpose is its own inverse.
+static void transpose8(const uint8_t* in, uint8_t* out) {
+  uint32_t x = ((uint32_t) in[0] << 24) | ((uint32_t) in[1] << 16) | ((uint32_t) in[2] << 8) | in[3];
+  uint32_t y = ((uint32_t) in[4] << 24) | ((uint32_t) in[5] << 16) | ((uint32_t) in[6] << 8) | in[7];
+  uint32_t t;
+
+  t = (x ^ (x >> 7)) & 0x00AA00AA;
+  x = x ^ t ^ (t << 7);
+  t = (y ^ (y >> 7)) & 0x00AA00AA;
+  y = y ^ t ^ (t << 7);
+  t = (x ^ (x >> 14)) & 0x0000CCCC;
+  x = x ^ t ^ (t << 14);
+  t = (y ^ (y >> 14)) & 0x0000CCCC;
+  y = y ^ t ^ (t << 14);
+  t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+  y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+  x = t;
+
+  out[0] = x >> 24;
+  out[1] = x >> 16;
+  out[2] = x >> 8;
+  out[3] = x;
+  out[4] = y >> 24;
+  out[5] = y >> 16;
+  out[6] = y >> 8;
+  out[7] = y;
+}
+
+// Substitute every byte of `blocks` (one or two) consecutive 16 byte blocks.
+static void sub_bytes(uint8_t* state, int blocks, bool inverse) {
+  uint8_t rows[4][8];
+  uint32_t q[8] = {0};
+  int groups = blocks * 2;
+
+  for (int g = 0; g < groups; g++) {
+    transpose8(&state[g * 8], rows[g]);
+    for (int r = 0; r < 8; r++) {
+      q[7 - r] |= (uint32_t) rows[g][r] << (g * 8);
+    }
+  }
+
+  if (inverse) {
+    inv_sbox(q);
+  } else {
+    sbox(q);
+  }
+
+  for (int g = 0; g < groups; g++) {
+    for (int r = 0; r < 8; r++) {
+      rows[g][r] = q[7 - r] >> (g * 8);
+    }
+    transpose8(rows[g], &state[g * 8]);
+  }
+}
+
+static inline uint8_t xtime(uint8_t x) {
+  return (x << 1) ^ (0x1b & -(x >> 7));
+}
+
+// xtime on four bytes at once.
+static inline uint32_t xtime4(uint32_t x) {
+  return ((x & 0x7f7f7f7f) << 1) ^ (((x >> 7) & 0x01010101) * 0x1b);
+}
+
+static inline uint32_t rotr32(uint32_t x, int n) {
+  return (x >> n) | (x << (32 - n));
+}
+
+static inline uint32_t load_le32(const uint8_t* p) {
+  return p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static inline void store_le32(uint8_t* p, uint32_t v) {
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+}
+
+static void shift_rows(uint8_t* s) {
+  uint8_t t;
+  // Row 1: rotate left by one.
+  t     = s[1];
+  s[1]  = s[5];
+  s[5]  = s[9];
+  s[9]  = s[13];
+  s[13] = t;
+  // Row 2: rotate by two.
+  t     = s[2];
+  s[2]  = s[10];
+  s[10] = t;
+  t     = s[6];
+  s[6]  = s[14];
+  s[14] = t;
+  // Row 3: rotate left by three.
+  t     = s[15];
+  s[15] = s[11];
+  s[11] = s[7];
+  s[7]  = s[3];
+  s[3]  = t;
+}
+
+static void inv_shift_rows(uint8_t* s) {
+  uint8_t t;
+  t     = s[13];
+  s[13] = s[9];
+  s[9]  = s[5];
+  s[5]  = s[1];
+  s[1]  = t;
+  t     = s[2];
+  s[2]  = s[10];
+  s[10] = t;
+  t     = s[6];
+  s[6]  = s[14];
+  s[14] = t;
+  t     = s[3];
+  s[3]  = s[7];
+  s[7]  = s[11];
+  s[11] = s[15];
+  s[15] = t;
+}
+
+// Each column is handled as one word with byte `i` of the column in bits
+// 8i..8i+7, so rotating the word right by 8 lines up byte `i + 1` with byte `i`.
+static inline uint32_t mix_column(uint32_t w) {
+  uint32_t r8 = rotr32(w, 8);
+  return xtime4(w ^ r8) ^ r8 ^ rotr32(w, 16) ^ rotr32(w, 24);
+}
+
+static void mix_columns(uint8_t* s) {
+  for (int c = 0; c < 16; c += 4) {
+    store_le32(&s[c], mix_column(load_le32(&s[c])));
+  }
+}
+
+static void inv_mix_columns(uint8_t* s) {
+  // InvMixColumns is MixColumns after multiplying opposite bytes by x^2.
+  for (int c = 0; c < 16; c += 4) {
+    uint32_t w = load_le32(&s[c]);
+    w ^= xtime4(xtime4(w ^ rotr32(w, 16)));
+    store_le32(&s[c], mix_column(w));
+  }
+}
+
+static inline void add_round_key(uint8_t* s, const uint8_t* key) {
+  for (int i = 0; i < BLOCK; i++) {
+    s[i] ^= key[i];
+  }
+}
+
+// Encrypt one or two consecutive blocks in place.
+static void encrypt_blocks(const uint8_t* round_keys, uint8_t* state, int blocks) {
+  for (int b = 0; b < blocks; b++) {
+    add_round_key(&state[b * BLOCK], round_keys);
+  }
+  for (int round = 1; round <= 10; round++) {
+    sub_bytes(state, blocks, false);
+    for (int b = 0; b < blocks; b++) {
+      uint8_t* s = &state[b * BLOCK];
+      shift_rows(s);
+      if (round != 10) mix_columns(s);
+      add_round_key(s, &round_keys[round * BLOCK]);
+    }
+  }
+}
+
+// Decrypt one or two consecutive blocks in place.
+static void decrypt_blocks(const uint8_t* round_keys, uint8_t* state, int blocks) {
+  for (int b = 0; b < blocks; b++) {
+    add_round_key(&state[b * BLOCK], &round_keys[10 * BLOCK]);
+  }
+  for (int round = 9; round >= 0; round--) {
+    for (int b = 0; b < blocks; b++) {
+      inv_shift_rows(&state[b * BLOCK]);
+    }
+    sub_bytes(state, blocks, true);
+    for (int b = 0; b < blocks; b++) {
+      uint8_t* s = &state[b * BLOCK];
+      add_round_key(s, &round_keys[round * BLOCK]);
+      if (round != 0) inv_mix_columns(s);
+    }
+  }
+}
+
+static void expand_key(uint8_t* round_keys, const uint8_t* key) {
+  uint8_t rcon = 1;
+
+  memcpy(round_keys, key, BLOCK);
+  for (int i = BLOCK; i < 11 * BLOCK; i += 4) {
+    uint8_t word[BLOCK] = {0};
+    memcpy(word, &round_keys[i - 4], 4);
+
+    if (i % BLOCK == 0) {
+      // RotWord and SubWord, then Rcon.
+      uint8_t t = word[0];
+      word[0] = word[1];
+      word[1] = word[2];
+      word[2] = word[3];
+      word[3] = t;
+      sub_bytes(word, 1, false);
+      word[0] ^= rcon;
+      rcon     = xtime(rcon);
+    }
+
+    for (int j = 0; j < 4; j++) {
+      round_keys[i + j] = round_keys[i - BLOCK + j] ^ word[j];
+    }
+  }
+}
+
+void libtock_aes128_software_init(libtock_aes128_software_t* ctx, libtock_aes128_software_mode_t mode,
+                                  bool encrypting, const uint8_t* key, const uint8_t* iv) {
+  expand_key(ctx->round_keys, key);
+  ctx->mode       = mode;
+  ctx->encrypting = encrypting;
+  if (iv != NULL) {
+    memcpy(ctx->iv, iv, BLOCK);
+  } else {
+    memset(ctx->iv, 0, BLOCK);
+  }
+}
+
+void libtock_aes128_software_encrypt_block(const libtock_aes128_software_t* ctx, const uint8_t* in, uint8_t* out) {
+  uint8_t state[BLOCK];
+  memcpy(state, in, BLOCK);
+  encrypt_blocks(ctx->round_keys, state, 1);
+  memcpy(out, state, BLOCK);
+}
+
+static void ctr_increment(uint8_t* counter) {
+  // Big-endian increment without a data-dependent early exit.
+  uint32_t carry = 1;
+  for (int i = BLOCK - 1; i >= 0; i--) {
+    carry     += counter[i];
+    counter[i] = carry;
+    carry    >>= 8;
+  }
+}
+
+static void crypt_ctr(libtock_aes128_software_t* ctx, const uint8_t* source, uint8_t* dest, size_t length) {
+  uint8_t keystream[2 * BLOCK];
+
+  while (length > 0) {
+    // Two counter blocks per pass share the S-box work.
+    memcpy(keystream, ctx->iv, BLOCK);
+    ctr_increment(ctx->iv);
+    int blocks = length > BLOCK ? 2 : 1;
+    if (blocks == 2) {
+      memcpy(&keystream[BLOCK], ctx->iv, BLOCK);
+      ctr_increment(ctx->iv);
+    }
+    encrypt_blocks(ctx->round_keys, keystream, blocks);
+
+    size_t n = (size_t) blocks * BLOCK;
+    if (n > length) n = length;
+    for (size_t i = 0; i < n; i++) {
+      dest[i] = source[i] ^ keystream[i];
+    }
+    source += n;
+    dest   += n;
+    length -= n;
+  }
+}
+
+static void crypt_ecb(libtock_aes128_software_t* ctx, const uint8_t* source, uint8_t* dest, size_t length) {
+  uint8_t state[2 * BLOCK];
+
+  while (length > 0) {
+    int blocks = length >= 2 * BLOCK ? 2 : 1;
+    size_t n   = (size_t) blocks * BLOCK;
+    memcpy(state, source, n);
+    if (ctx->encrypting) {
+      encrypt_blocks(ctx->round_keys, state, blocks);
+    } else {
+      decrypt_blocks(ctx->round_keys, state, blocks);
+    }
+    memcpy(dest, state, n);
+    source += n;
+    dest   += n;
+    length -= n;
+  }
+}
+
+static void crypt_cbc(libtock_aes128_software_t* ctx, const uint8_t* source, uint8_t* dest, size_t length) {
+  uint8_t state[2 * BLOCK];
+
+  if (ctx->encrypting) {
+    // Each block depends on the previous ciphertext, so one at a time.
+    while (length > 0) {
+      for (int i = 0; i < BLOCK; i++) {
+        state[i] = source[i] ^ ctx->iv[i];
+      }
+      encrypt_blocks(ctx->round_keys, state, 1);
+      memcpy(ctx->iv, state, BLOCK);
+      memcpy(dest, state, BLOCK);
+      source += BLOCK;
+      dest   += BLOCK;
+      length -= BLOCK;
+    }
+    return;
+  }
+
+  uint8_t cipher[2 * BLOCK];
+  while (length > 0) {
+    int blocks = length >= 2 * BLOCK ? 2 : 1;
+    size_t n   = (size_t) blocks * BLOCK;
+    memcpy(cipher, source, n);
+    memcpy(state, source, n);
+    decrypt_blocks(ctx->round_keys, state, blocks);
+    for (int i = 0; i < BLOCK; i++) {
+      state[i] ^= ctx->iv[i];
+    }
+    if (blocks == 2) {
+      for (int i = 0; i < BLOCK; i++) {
+        state[BLOCK + i] ^= cipher[i];
+      }
+    }
+    memcpy(ctx->iv, &cipher[n - BLOCK], BLOCK);
+    memcpy(dest, state, n);
+    source += n;
+    dest   += n;
+    length -= n;
+  }
+}
+
+bool libtock_aes128_software_crypt(libtock_aes128_software_t* ctx, const uint8_t* source, uint8_t* dest,
+                                   size_t length) {
+  switch (ctx->mode) {
+    case LIBTOCK_AES128_SOFTWARE_CTR:
+      crypt_ctr(ctx, source, dest, length);
+      return true;
+    case LIBTOCK_AES128_SOFTWARE_ECB:
+      if (length % BLOCK != 0) return false;
+      crypt_ecb(ctx, source, dest, length);
+      return true;
+    case LIBTOCK_AES128_SOFTWARE_CBC:
+      if (length % BLOCK != 0) return false;
+      crypt_cbc(ctx, source, dest, length);
+      return true;
+  }
+  return false;
+}
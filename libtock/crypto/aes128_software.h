@@ -0,0 +1,56 @@
+#pragma once
+
+// Constant-time software AES-128.
+//
+// Used by libtock-sync when the board has no AES driver. The S-box is
+// computed with a bitsliced boolean circuit rather than looked up in a table,
+// and MixColumns uses masks instead of branches, so the running time and
+// memory access pattern do not depend on the key or data. Two blocks are
+// processed together where the mode allows it (ECB, CTR, CBC decryption).
+//
+// It has no dependencies on the kernel so it can also be built for the host.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LIBTOCK_AES128_SOFTWARE_BLOCK_LEN 16
+#define LIBTOCK_AES128_SOFTWARE_KEY_LEN   16
+
+typedef enum {
+  LIBTOCK_AES128_SOFTWARE_ECB,
+  LIBTOCK_AES128_SOFTWARE_CBC,
+  LIBTOCK_AES128_SOFTWARE_CTR,
+} libtock_aes128_software_mode_t;
+
+typedef struct {
+  uint8_t round_keys[11 * LIBTOCK_AES128_SOFTWARE_BLOCK_LEN];
+  // CBC chaining value or CTR counter block.
+  uint8_t iv[LIBTOCK_AES128_SOFTWARE_BLOCK_LEN];
+  libtock_aes128_software_mode_t mode;
+  bool encrypting;
+} libtock_aes128_software_t;
+
+// Set up `ctx` with a 16 byte `key`. `iv` is the 16 byte CBC IV or initial CTR
+// counter block, and is ignored for ECB.
+void libtock_aes128_software_init(libtock_aes128_software_t* ctx, libtock_aes128_software_mode_t mode,
+                                  bool encrypting, const uint8_t* key, const uint8_t* iv);
+
+// Encrypt or decrypt `length` bytes from `source` into `dest`. `source` and
+// `dest` may be the same buffer.
+//
+// Calls continue the same stream. `length` must be a multiple of 16, except
+// for the final call in CTR mode. Returns false if `length` is invalid.
+bool libtock_aes128_software_crypt(libtock_aes128_software_t* ctx, const uint8_t* source, uint8_t* dest,
+                                   size_t length);
+
+// Encrypt a single 16 byte block.
+void libtock_aes128_software_encrypt_block(const libtock_aes128_software_t* ctx, const uint8_t* in, uint8_t* out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,191 @@
+#include <string.h>
+
+#include "../peripherals/syscalls/alarm_syscalls.h"
+#include "../services/alarm.h"
+#include "aes_stream.h"
+#include "syscalls/aes_syscalls.h"
+
+static returncode_t stream_start(libtock_aes_stream_t* stream) {
+  libtock_aes_stream_batch_t* batch = &stream->batches[stream->head];
+  returncode_t ret;
+
+  ret = libtock_aes_set_readonly_allow_source_buffer(batch->source, batch->length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_aes_set_readwrite_allow_dest_buffer(batch->dest, batch->length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  if (stream->algorithm == LIBTOCK_AES128CCM) {
+    // Every CCM message is a separate operation with its own nonce.
+    ret = libtock_aes_set_algorithm(stream->algorithm, stream->encrypting);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+    ret = libtock_aes_ccm_set_a_off(stream->ccm_a_off);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+    ret = libtock_aes_ccm_set_m_off(stream->ccm_m_off);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+    ret = libtock_aes_ccm_set_mic_len(stream->ccm_mic_len);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+    ret = libtock_aes_ccm_set_confidential(stream->ccm_confidential);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+    ret = libtock_aes_set_readonly_allow_nonce_buffer(batch->nonce, batch->nonce_length);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+    ret = libtock_aes_setup();
+  } else if (!stream->started) {
+    ret = libtock_aes_setup();
+  } else {
+    ret = libtock_aes_crypt();
+  }
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  stream->started   = true;
+  stream->in_flight = true;
+  return RETURNCODE_SUCCESS;
+}
+
+static void aes_stream_upcall(int status,
+                              __attribute__ ((unused)) int length,
+                              int verified, void* opaque) {
+  libtock_aes_stream_t* stream      = (libtock_aes_stream_t*) opaque;
+  libtock_aes_stream_batch_t* batch = &stream->batches[stream->head];
+  uint8_t* dest  = batch->dest;
+  uint32_t len   = batch->length;
+  returncode_t ret = tock_status_to_returncode(status);
+
+  if (stream->algorithm == LIBTOCK_AES128CCM) {
+    if (ret == RETURNCODE_SUCCESS && !stream->encrypting && !verified) {
+      ret = RETURNCODE_FAIL;
+    }
+    libtock_aes_finish();
+    stream->started = false;
+  }
+
+  libtock_alarm_command_read(&stream->stats.last_ticks);
+  stream->stats.bytes += len;
+  stream->stats.batches++;
+
+  stream->in_flight = false;
+  stream->head      = (stream->head + 1) % LIBTOCK_AES_STREAM_DEPTH;
+  stream->count--;
+
+  // Keep the engine busy before handing the output to the app.
+  returncode_t start_ret = RETURNCODE_SUCCESS;
+  libtock_aes_stream_batch_t failed = {0};
+  if (stream->count > 0) {
+    start_ret = stream_start(stream);
+    if (start_ret == RETURNCODE_SUCCESS) {
+      stream->stats.pipelined++;
+    } else {
+      failed       = stream->batches[stream->head];
+      stream->head = (stream->head + 1) % LIBTOCK_AES_STREAM_DEPTH;
+      stream->count--;
+    }
+  }
+
+  stream->cb(ret, dest, len);
+  if (start_ret != RETURNCODE_SUCCESS) {
+    stream->cb(start_ret, failed.dest, failed.length);
+  }
+}
+
+returncode_t libtock_aes_stream_init(libtock_aes_stream_t* stream, libtock_aes_algorithm_t algorithm, bool encrypting,
+                                     const uint8_t* key, uint32_t key_length,
+                                     const uint8_t* iv, uint32_t iv_length,
+                                     libtock_aes_stream_callback cb) {
+  returncode_t ret;
+
+  memset(stream, 0, sizeof(libtock_aes_stream_t));
+  stream->algorithm  = algorithm;
+  stream->encrypting = encrypting;
+  stream->cb         = cb;
+
+  ret = libtock_aes_set_algorithm(algorithm, encrypting);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_aes_set_readonly_allow_key_buffer(key, key_length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  if (algorithm != LIBTOCK_AES128CCM && iv != NULL) {
+    ret = libtock_aes_set_readonly_allow_iv_buffer(iv, iv_length);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+  }
+
+  return libtock_aes_set_upcall(aes_stream_upcall, stream);
+}
+
+void libtock_aes_stream_set_ccm(libtock_aes_stream_t* stream, uint32_t a_off, uint32_t m_off, uint32_t mic_len,
+                                bool confidential) {
+  stream->ccm_a_off        = a_off;
+  stream->ccm_m_off        = m_off;
+  stream->ccm_mic_len      = mic_len;
+  stream->ccm_confidential = confidential;
+}
+
+static returncode_t stream_submit(libtock_aes_stream_t* stream, const uint8_t* nonce, uint32_t nonce_length,
+                                  const uint8_t* source, uint8_t* dest, uint32_t length) {
+  if (stream->count == LIBTOCK_AES_STREAM_DEPTH) return RETURNCODE_EBUSY;
+
+  libtock_aes_stream_batch_t* batch =
+    &stream->batches[(stream->head + stream->count) % LIBTOCK_AES_STREAM_DEPTH];
+  batch->source       = source;
+  batch->dest         = dest;
+  batch->length       = length;
+  batch->nonce        = nonce;
+  batch->nonce_length = nonce_length;
+  stream->count++;
+
+  if (stream->stats.batches == 0 && !stream->in_flight) {
+    libtock_alarm_command_read(&stream->stats.first_ticks);
+  }
+
+  if (!stream->in_flight) {
+    returncode_t ret = stream_start(stream);
+    if (ret != RETURNCODE_SUCCESS) {
+      stream->count--;
+      return ret;
+    }
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_aes_stream_submit(libtock_aes_stream_t* stream, const uint8_t* source, uint8_t* dest,
+                                       uint32_t length) {
+  if (stream->algorithm == LIBTOCK_AES128CCM) return RETURNCODE_EINVAL;
+  return stream_submit(stream, NULL, 0, source, dest, length);
+}
+
+returncode_t libtock_aes_stream_submit_ccm(libtock_aes_stream_t* stream, const uint8_t* nonce, uint32_t nonce_length,
+                                           const uint8_t* source, uint8_t* dest, uint32_t length) {
+  if (stream->algorithm != LIBTOCK_AES128CCM) return RETURNCODE_EINVAL;
+  return stream_submit(stream, nonce, nonce_length, source, dest, length);
+}
+
+bool libtock_aes_stream_can_submit(libtock_aes_stream_t* stream) {
+  return stream->count < LIBTOCK_AES_STREAM_DEPTH;
+}
+
+bool libtock_aes_stream_busy(libtock_aes_stream_t* stream) {
+  return stream->count > 0;
+}
+
+returncode_t libtock_aes_stream_finish(libtock_aes_stream_t* stream) {
+  if (stream->count > 0) return RETURNCODE_EBUSY;
+
+  returncode_t ret = RETURNCODE_SUCCESS;
+  if (stream->started) {
+    ret = libtock_aes_finish();
+    stream->started = false;
+  }
+
+  libtock_aes_set_readonly_allow_source_buffer(NULL, 0);
+  libtock_aes_set_readwrite_allow_dest_buffer(NULL, 0);
+  libtock_aes_set_readonly_allow_key_buffer(NULL, 0);
+  libtock_aes_set_readonly_allow_iv_buffer(NULL, 0);
+  libtock_aes_set_readonly_allow_nonce_buffer(NULL, 0);
+  return ret;
+}
+
+uint32_t libtock_aes_stream_bytes_per_second(libtock_aes_stream_t* stream) {
+  uint32_t ms = libtock_alarm_ticks_to_ms(stream->stats.last_ticks - stream->stats.first_ticks);
+  if (ms == 0) return 0;
+  return (uint32_t) ((uint64_t) stream->stats.bytes * 1000 / ms);
+}
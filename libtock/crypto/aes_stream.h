@@ -0,0 +1,125 @@
+#pragma once
+
+// Pipelined bulk AES.
+//
+// With `libtock_aes_crypt()` the app waits for each operation's upcall before
+// it can move the source and destination allows to the next block of data.
+// A `libtock_aes_stream_t` queues up to two batches. As soon as one batch
+// completes, the next batch is allowed and started from the upcall, before the
+// app's callback runs, so the engine is kept busy while the app consumes the
+// finished output and prepares the batch after that.
+//
+// CTR, CBC and ECB batches continue one stream: the kernel carries the counter
+// or chaining value from one batch to the next. CCM batches are independent
+// messages, each with its own nonce.
+//
+// Batches may be in place (`source == dest`).
+//
+// Typical use:
+//
+//   libtock_aes_stream_init(&stream, LIBTOCK_AES128Ctr, true, key, 16, iv, 16, batch_done);
+//   libtock_aes_stream_submit(&stream, records_a, out_a, len);
+//   libtock_aes_stream_submit(&stream, records_b, out_b, len);
+//   // In `batch_done`, send the output and submit the next batch.
+//
+// There is only one AES engine, so only one stream can be used at a time.
+
+#include "../tock.h"
+#include "aes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of batches that can be queued, including the one in flight.
+#define LIBTOCK_AES_STREAM_DEPTH 2
+
+// Function signature for completed batches.
+//
+// - `arg1` (`returncode_t`): Status of the batch. For CCM decryption,
+//   `RETURNCODE_FAIL` if the MIC did not verify.
+// - `arg2` (`uint8_t*`): The batch's destination buffer.
+// - `arg3` (`uint32_t`): Length of the batch.
+typedef void (*libtock_aes_stream_callback)(returncode_t, uint8_t*, uint32_t);
+
+typedef struct {
+  const uint8_t* source;
+  uint8_t* dest;
+  uint32_t length;
+  const uint8_t* nonce;
+  uint32_t nonce_length;
+} libtock_aes_stream_batch_t;
+
+typedef struct {
+  // Bytes and batches completed.
+  uint32_t bytes;
+  uint32_t batches;
+  // Alarm ticks from the first submitted batch to the last completed batch.
+  uint32_t first_ticks;
+  uint32_t last_ticks;
+  // Batches that were started straight from the previous batch's upcall.
+  uint32_t pipelined;
+} libtock_aes_stream_stats_t;
+
+typedef struct {
+  libtock_aes_algorithm_t algorithm;
+  bool encrypting;
+  libtock_aes_stream_callback cb;
+
+  // CCM parameters, applied before each CCM batch.
+  uint32_t ccm_a_off;
+  uint32_t ccm_m_off;
+  uint32_t ccm_mic_len;
+  bool ccm_confidential;
+
+  libtock_aes_stream_batch_t batches[LIBTOCK_AES_STREAM_DEPTH];
+  uint8_t head;
+  uint8_t count;
+  bool in_flight;
+  // Whether `libtock_aes_setup()` has loaded the key and IV.
+  bool started;
+
+  libtock_aes_stream_stats_t stats;
+} libtock_aes_stream_t;
+
+// Set up a stream using `algorithm`.
+//
+// `key` and `iv` must stay valid until `libtock_aes_stream_finish()`. For CCM,
+// `iv` is ignored and a nonce is passed with every batch instead. `cb` is
+// called for each completed batch.
+returncode_t libtock_aes_stream_init(libtock_aes_stream_t* stream, libtock_aes_algorithm_t algorithm, bool encrypting,
+                                     const uint8_t* key, uint32_t key_length,
+                                     const uint8_t* iv, uint32_t iv_length,
+                                     libtock_aes_stream_callback cb);
+
+// Set the CCM parameters used for every batch.
+void libtock_aes_stream_set_ccm(libtock_aes_stream_t* stream, uint32_t a_off, uint32_t m_off, uint32_t mic_len,
+                                bool confidential);
+
+// Queue `length` bytes from `source` to be written to `dest`.
+//
+// Neither buffer may be touched until the batch's callback. Returns
+// `RETURNCODE_EBUSY` if `LIBTOCK_AES_STREAM_DEPTH` batches are already queued.
+returncode_t libtock_aes_stream_submit(libtock_aes_stream_t* stream, const uint8_t* source, uint8_t* dest,
+                                       uint32_t length);
+
+// Queue a CCM message with its own `nonce`.
+returncode_t libtock_aes_stream_submit_ccm(libtock_aes_stream_t* stream, const uint8_t* nonce, uint32_t nonce_length,
+                                           const uint8_t* source, uint8_t* dest, uint32_t length);
+
+// Whether another batch can be submitted.
+bool libtock_aes_stream_can_submit(libtock_aes_stream_t* stream);
+
+// Whether any batches are queued or in flight.
+bool libtock_aes_stream_busy(libtock_aes_stream_t* stream);
+
+// End the stream and clear the key and IV. Returns `RETURNCODE_EBUSY` if
+// batches are still queued.
+returncode_t libtock_aes_stream_finish(libtock_aes_stream_t* stream);
+
+// Throughput of the completed batches in bytes per second.
+uint32_t libtock_aes_stream_bytes_per_second(libtock_aes_stream_t* stream);
+
+#ifdef __cplusplus
+}
+#endif
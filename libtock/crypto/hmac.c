@@ -9,6 +9,21 @@ static void hmac_upcall(int ret,
   cb(tock_status_to_returncode(ret));
 }
 
+// Callback for the streaming operation in progress. The upcall is subscribed
+// once per HMAC so each chunk only costs an allow and a command.
+static libtock_hmac_callback_hmac stream_cb = NULL;
+
+static void hmac_stream_upcall(int ret,
+                               __attribute__ ((unused)) int unused1,
+                               __attribute__ ((unused)) int unused2,
+                               __attribute__ ((unused)) void* opaque) {
+  libtock_hmac_callback_hmac cb = stream_cb;
+  stream_cb = NULL;
+  if (cb != NULL) {
+    cb(tock_status_to_returncode(ret));
+  }
+}
+
 bool libtock_hmac_exists(void) {
   return libtock_hmac_driver_exists();
 }
@@ -39,3 +54,45 @@ returncode_t libtock_hmac_simple(libtock_hmac_algorithm_t hmac_type,
   ret = libtock_hmac_command_run();
   return ret;
 }
+
+returncode_t libtock_hmac_init(libtock_hmac_algorithm_t hmac_type, const uint8_t* key_buffer, uint32_t key_length) {
+  returncode_t ret;
+
+  ret = libtock_hmac_command_set_algorithm((uint32_t) hmac_type);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_hmac_set_readonly_allow_key_buffer(key_buffer, key_length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  stream_cb = NULL;
+  ret       = libtock_hmac_set_upcall(hmac_stream_upcall, NULL);
+  return ret;
+}
+
+returncode_t libtock_hmac_update(const uint8_t* input_buffer, uint32_t input_length, libtock_hmac_callback_hmac cb) {
+  returncode_t ret;
+
+  if (stream_cb != NULL) return RETURNCODE_EBUSY;
+
+  ret = libtock_hmac_set_readonly_allow_data_buffer(input_buffer, input_length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  stream_cb = cb;
+  ret       = libtock_hmac_command_update();
+  if (ret != RETURNCODE_SUCCESS) stream_cb = NULL;
+  return ret;
+}
+
+returncode_t libtock_hmac_finish(uint8_t* hmac_buffer, uint32_t hmac_length, libtock_hmac_callback_hmac cb) {
+  returncode_t ret;
+
+  if (stream_cb != NULL) return RETURNCODE_EBUSY;
+
+  ret = libtock_hmac_set_readwrite_allow_destination_buffer(hmac_buffer, hmac_length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  stream_cb = cb;
+  ret       = libtock_hmac_command_finish();
+  if (ret != RETURNCODE_SUCCESS) stream_cb = NULL;
+  return ret;
+}
@@ -24,6 +24,27 @@ returncode_t libtock_hmac_simple(libtock_hmac_algorithm_t hmac_type,
                                  uint8_t* hmac_buffer, uint32_t hmac_length,
                                  libtock_hmac_callback_hmac cb);
 
+// Streaming interface.
+//
+// Works like the SHA streaming interface: `libtock_hmac_init()`, then
+// `libtock_hmac_update()` for each chunk, waiting for its callback before the
+// next update, then `libtock_hmac_finish()`. The key and each chunk must not
+// be modified until the matching callback has been called.
+
+// Start a new streaming HMAC with the key in `key_buffer`. The key stays
+// shared with the kernel until `libtock_hmac_finish()` completes.
+returncode_t libtock_hmac_init(libtock_hmac_algorithm_t hmac_type, const uint8_t* key_buffer, uint32_t key_length);
+
+// Add `input_length` bytes from `input_buffer` to the HMAC.
+//
+// The callback will be called when the kernel is done with the buffer.
+returncode_t libtock_hmac_update(const uint8_t* input_buffer, uint32_t input_length, libtock_hmac_callback_hmac cb);
+
+// Finish the HMAC and store it in `hmac_buffer`.
+//
+// The callback will be called when the HMAC is available.
+returncode_t libtock_hmac_finish(uint8_t* hmac_buffer, uint32_t hmac_length, libtock_hmac_callback_hmac cb);
+
 #ifdef __cplusplus
 }
 #endif
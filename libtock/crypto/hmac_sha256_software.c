@@ -0,0 +1,48 @@
+#include <string.h>
+
+#include "hmac_sha256_software.h"
+
+void libtock_hmac_sha256_software_init(libtock_hmac_sha256_software_t* ctx, const uint8_t* key, size_t key_length) {
+  uint8_t block[LIBTOCK_SHA256_SOFTWARE_BLOCK_LEN] = {0};
+
+  // Keys longer than a block are hashed first.
+  if (key_length > LIBTOCK_SHA256_SOFTWARE_BLOCK_LEN) {
+    libtock_sha256_software(key, key_length, block);
+  } else {
+    memcpy(block, key, key_length);
+  }
+
+  for (int i = 0; i < LIBTOCK_SHA256_SOFTWARE_BLOCK_LEN; i++) {
+    ctx->outer_key[i] = block[i] ^ 0x5c;
+    block[i]         ^= 0x36;
+  }
+
+  libtock_sha256_software_init(&ctx->inner);
+  libtock_sha256_software_update(&ctx->inner, block, sizeof(block));
+  memset(block, 0, sizeof(block));
+}
+
+void libtock_hmac_sha256_software_update(libtock_hmac_sha256_software_t* ctx, const uint8_t* data, size_t length) {
+  libtock_sha256_software_update(&ctx->inner, data, length);
+}
+
+void libtock_hmac_sha256_software_finish(libtock_hmac_sha256_software_t* ctx, uint8_t* mac) {
+  uint8_t inner_digest[LIBTOCK_SHA256_SOFTWARE_DIGEST_LEN];
+  libtock_sha256_software_finish(&ctx->inner, inner_digest);
+
+  libtock_sha256_software_t outer;
+  libtock_sha256_software_init(&outer);
+  libtock_sha256_software_update(&outer, ctx->outer_key, sizeof(ctx->outer_key));
+  libtock_sha256_software_update(&outer, inner_digest, sizeof(inner_digest));
+  libtock_sha256_software_finish(&outer, mac);
+
+  memset(ctx->outer_key, 0, sizeof(ctx->outer_key));
+}
+
+void libtock_hmac_sha256_software(const uint8_t* key, size_t key_length, const uint8_t* data, size_t length,
+                                  uint8_t* mac) {
+  libtock_hmac_sha256_software_t ctx;
+  libtock_hmac_sha256_software_init(&ctx, key, key_length);
+  libtock_hmac_sha256_software_update(&ctx, data, length);
+  libtock_hmac_sha256_software_finish(&ctx, mac);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+// Software HMAC-SHA256, built on the software SHA-256.
+
+#include "sha256_software.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  libtock_sha256_software_t inner;
+  // Key XOR opad, kept for the outer hash.
+  uint8_t outer_key[LIBTOCK_SHA256_SOFTWARE_BLOCK_LEN];
+} libtock_hmac_sha256_software_t;
+
+// Start a new HMAC with `key`.
+void libtock_hmac_sha256_software_init(libtock_hmac_sha256_software_t* ctx, const uint8_t* key, size_t key_length);
+
+// Add `length` bytes from `data` to the HMAC.
+void libtock_hmac_sha256_software_update(libtock_hmac_sha256_software_t* ctx, const uint8_t* data, size_t length);
+
+// Finish the HMAC and write the 32 byte result to `mac`.
+void libtock_hmac_sha256_software_finish(libtock_hmac_sha256_software_t* ctx, uint8_t* mac);
+
+// Compute an HMAC over `length` bytes from `data` in one call.
+void libtock_hmac_sha256_software(const uint8_t* key, size_t key_length, const uint8_t* data, size_t length,
+                                  uint8_t* mac);
+
+#ifdef __cplusplus
+}
+#endif
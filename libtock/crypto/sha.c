@@ -9,6 +9,21 @@ static void sha_upcall(int status,
   cb(tock_status_to_returncode(status));
 }
 
+// Callback for the streaming operation in progress. The upcall is subscribed
+// once per hash so each chunk only costs an allow and a command.
+static libtock_sha_callback_hash stream_cb = NULL;
+
+static void sha_stream_upcall(int status,
+                              __attribute__ ((unused)) int unused1,
+                              __attribute__ ((unused)) int unused2,
+                              __attribute__ ((unused)) void* opaque) {
+  libtock_sha_callback_hash cb = stream_cb;
+  stream_cb = NULL;
+  if (cb != NULL) {
+    cb(tock_status_to_returncode(status));
+  }
+}
+
 bool libtock_sha_exists(void) {
   return libtock_sha_driver_exists();
 }
@@ -35,3 +50,42 @@ returncode_t libtock_sha_simple_hash(libtock_sha_algorithm_t hash_type,
   ret = libtock_sha_command_run();
   return ret;
 }
+
+returncode_t libtock_sha_init(libtock_sha_algorithm_t hash_type) {
+  returncode_t ret;
+
+  ret = libtock_sha_command_set_algorithm((uint8_t) hash_type);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  stream_cb = NULL;
+  ret       = libtock_sha_set_upcall(sha_stream_upcall, NULL);
+  return ret;
+}
+
+returncode_t libtock_sha_update(const uint8_t* input_buffer, uint32_t input_length, libtock_sha_callback_hash cb) {
+  returncode_t ret;
+
+  if (stream_cb != NULL) return RETURNCODE_EBUSY;
+
+  ret = libtock_sha_set_readonly_allow_data_buffer((uint8_t*) input_buffer, input_length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  stream_cb = cb;
+  ret       = libtock_sha_command_update();
+  if (ret != RETURNCODE_SUCCESS) stream_cb = NULL;
+  return ret;
+}
+
+returncode_t libtock_sha_finish(uint8_t* hash_buffer, uint32_t hash_length, libtock_sha_callback_hash cb) {
+  returncode_t ret;
+
+  if (stream_cb != NULL) return RETURNCODE_EBUSY;
+
+  ret = libtock_sha_set_readwrite_allow_destination_buffer(hash_buffer, hash_length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  stream_cb = cb;
+  ret       = libtock_sha_command_finish();
+  if (ret != RETURNCODE_SUCCESS) stream_cb = NULL;
+  return ret;
+}
@@ -28,6 +28,30 @@ returncode_t libtock_sha_simple_hash(libtock_sha_algorithm_t hash_type,
                                      uint8_t* hash_buffer, uint32_t hash_length,
                                      libtock_sha_callback_hash cb);
 
+// Streaming interface.
+//
+// Hash input that is not available in one buffer, such as data read from
+// flash in chunks. Call `libtock_sha_init()`, then `libtock_sha_update()` for
+// each chunk, waiting for its callback before the next update, and finally
+// `libtock_sha_finish()` to get the hash.
+//
+// The chunk passed to `libtock_sha_update()` must not be modified until its
+// callback has been called. Reading the next chunk into a second buffer while
+// the current one is hashed overlaps I/O and hashing.
+
+// Start a new streaming hash.
+returncode_t libtock_sha_init(libtock_sha_algorithm_t hash_type);
+
+// Add `input_length` bytes from `input_buffer` to the hash.
+//
+// The callback will be called when the kernel is done with the buffer.
+returncode_t libtock_sha_update(const uint8_t* input_buffer, uint32_t input_length, libtock_sha_callback_hash cb);
+
+// Finish the hash and store it in `hash_buffer`.
+//
+// The callback will be called when the hash is available.
+returncode_t libtock_sha_finish(uint8_t* hash_buffer, uint32_t hash_length, libtock_sha_callback_hash cb);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,138 @@
+#include <string.h>
+
+#include "sha256_software.h"
+
+static const uint32_t k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x, y, z)  (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define BSIG0(x) (ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define BSIG1(x) (ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define SSIG0(x) (ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define SSIG1(x) (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+
+static inline uint32_t load_be32(const uint8_t* p) {
+  return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+static inline void store_be32(uint8_t* p, uint32_t v) {
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+
+// Process `blocks` consecutive 64 byte blocks. The message schedule is kept
+// as a rolling 16 word window instead of the full 64 words to save stack.
+static void sha256_compress(uint32_t state[8], const uint8_t* data, size_t blocks) {
+  uint32_t w[16];
+
+  while (blocks--) {
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int i = 0; i < 64; i++) {
+      uint32_t wi;
+      if (i < 16) {
+        wi = load_be32(&data[i * 4]);
+      } else {
+        wi = SSIG1(w[(i - 2) & 15]) + w[(i - 7) & 15] + SSIG0(w[(i - 15) & 15]) + w[i & 15];
+      }
+      w[i & 15] = wi;
+
+      uint32_t t1 = h + BSIG1(e) + CH(e, f, g) + k[i] + wi;
+      uint32_t t2 = BSIG0(a) + MAJ(a, b, c);
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+    data     += LIBTOCK_SHA256_SOFTWARE_BLOCK_LEN;
+  }
+}
+
+void libtock_sha256_software_init(libtock_sha256_software_t* ctx) {
+  static const uint32_t initial[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+  };
+  memcpy(ctx->state, initial, sizeof(initial));
+  ctx->length    = 0;
+  ctx->block_len = 0;
+}
+
+void libtock_sha256_software_update(libtock_sha256_software_t* ctx, const uint8_t* data, size_t length) {
+  ctx->length += length;
+
+  // Top up a partial block first.
+  if (ctx->block_len > 0) {
+    size_t take = LIBTOCK_SHA256_SOFTWARE_BLOCK_LEN - ctx->block_len;
+    if (take > length) take = length;
+    memcpy(&ctx->block[ctx->block_len], data, take);
+    ctx->block_len += take;
+    data   += take;
+    length -= take;
+    if (ctx->block_len < LIBTOCK_SHA256_SOFTWARE_BLOCK_LEN) return;
+    sha256_compress(ctx->state, ctx->block, 1);
+    ctx->block_len = 0;
+  }
+
+  // Hash whole blocks straight from the input.
+  size_t blocks = length / LIBTOCK_SHA256_SOFTWARE_BLOCK_LEN;
+  if (blocks > 0) {
+    sha256_compress(ctx->state, data, blocks);
+    data   += blocks * LIBTOCK_SHA256_SOFTWARE_BLOCK_LEN;
+    length -= blocks * LIBTOCK_SHA256_SOFTWARE_BLOCK_LEN;
+  }
+
+  memcpy(ctx->block, data, length);
+  ctx->block_len = length;
+}
+
+void libtock_sha256_software_finish(libtock_sha256_software_t* ctx, uint8_t* digest) {
+  uint64_t bits = ctx->length * 8;
+
+  ctx->block[ctx->block_len++] = 0x80;
+  if (ctx->block_len > LIBTOCK_SHA256_SOFTWARE_BLOCK_LEN - 8) {
+    memset(&ctx->block[ctx->block_len], 0, LIBTOCK_SHA256_SOFTWARE_BLOCK_LEN - ctx->block_len);
+    sha256_compress(ctx->state, ctx->block, 1);
+    ctx->block_len = 0;
+  }
+  memset(&ctx->block[ctx->block_len], 0, LIBTOCK_SHA256_SOFTWARE_BLOCK_LEN - 8 - ctx->block_len);
+  store_be32(&ctx->block[56], bits >> 32);
+  store_be32(&ctx->block[60], bits);
+  sha256_compress(ctx->state, ctx->block, 1);
+
+  for (int i = 0; i < 8; i++) {
+    store_be32(&digest[i * 4], ctx->state[i]);
+  }
+}
+
+void libtock_sha256_software(const uint8_t* data, size_t length, uint8_t* digest) {
+  libtock_sha256_software_t ctx;
+  libtock_sha256_software_init(&ctx);
+  libtock_sha256_software_update(&ctx, data, length);
+  libtock_sha256_software_finish(&ctx, digest);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+// Software SHA-256.
+//
+// Used by libtock-sync when the board has no SHA driver, and usable directly
+// by apps that want a hash without a system call round trip. It has no
+// dependencies on the kernel so it can also be built for the host.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LIBTOCK_SHA256_SOFTWARE_BLOCK_LEN  64
+#define LIBTOCK_SHA256_SOFTWARE_DIGEST_LEN 32
+
+typedef struct {
+  uint32_t state[8];
+  uint64_t length;
+  uint8_t block[LIBTOCK_SHA256_SOFTWARE_BLOCK_LEN];
+  uint32_t block_len;
+} libtock_sha256_software_t;
+
+// Start a new hash.
+void libtock_sha256_software_init(libtock_sha256_software_t* ctx);
+
+// Add `length` bytes from `data` to the hash.
+void libtock_sha256_software_update(libtock_sha256_software_t* ctx, const uint8_t* data, size_t length);
+
+// Finish the hash and write the 32 byte digest to `digest`.
+void libtock_sha256_software_finish(libtock_sha256_software_t* ctx, uint8_t* digest);
+
+// Hash `length` bytes from `data` in one call.
+void libtock_sha256_software(const uint8_t* data, size_t length, uint8_t* digest);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,603 @@
+#include <string.h>
+
+#include "screen_blit.h"
+
+// The kernels below are generated per pixel format, so the pixel size and the
+// load/store/convert functions are compile-time constants in every inner loop.
+// `MONO` uses a page layout rather than rows of pixels and has its own
+// implementation of every operation.
+
+////////////////////////////////////////////////////////////////////////////////
+// Pixel access
+////////////////////////////////////////////////////////////////////////////////
+
+static inline uint32_t expand2(uint32_t v) {
+  return v * 0x55;
+}
+
+static inline uint32_t expand3(uint32_t v) {
+  return (v << 5) | (v << 2) | (v >> 1);
+}
+
+static inline uint32_t expand5(uint32_t v) {
+  return (v << 3) | (v >> 2);
+}
+
+static inline uint32_t expand6(uint32_t v) {
+  return (v << 2) | (v >> 4);
+}
+
+static inline uint32_t argb(uint32_t a, uint32_t r, uint32_t g, uint32_t b) {
+  return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+// RGB_233
+static inline uint32_t load_rgb233(const uint8_t* p) {
+  return *p;
+}
+
+static inline void store_rgb233(uint8_t* p, uint32_t v) {
+  *p = (uint8_t) v;
+}
+
+static inline uint32_t to_argb_rgb233(uint32_t v) {
+  return argb(0xFF, expand2((v >> 6) & 0x3), expand3((v >> 3) & 0x7), expand3(v & 0x7));
+}
+
+static inline uint32_t from_argb_rgb233(uint32_t c) {
+  return ((c >> 16) & 0xC0) | ((c >> 10) & 0x38) | ((c >> 5) & 0x07);
+}
+
+// RGB_565
+static inline uint32_t load_rgb565(const uint8_t* p) {
+  return *(const uint16_t*) p;
+}
+
+static inline void store_rgb565(uint8_t* p, uint32_t v) {
+  *(uint16_t*) p = (uint16_t) v;
+}
+
+static inline uint32_t to_argb_rgb565(uint32_t v) {
+  return argb(0xFF, expand5((v >> 11) & 0x1F), expand6((v >> 5) & 0x3F), expand5(v & 0x1F));
+}
+
+static inline uint32_t from_argb_rgb565(uint32_t c) {
+  return ((c >> 8) & 0xF800) | ((c >> 5) & 0x07E0) | ((c >> 3) & 0x001F);
+}
+
+// RGB_888
+static inline uint32_t load_rgb888(const uint8_t* p) {
+  uint32_t v = 0;
+  memcpy(&v, p, 3);
+  return v;
+}
+
+static inline void store_rgb888(uint8_t* p, uint32_t v) {
+  memcpy(p, &v, 3);
+}
+
+static inline uint32_t to_argb_rgb888(uint32_t v) {
+  return 0xFF000000 | v;
+}
+
+static inline uint32_t from_argb_rgb888(uint32_t c) {
+  return c & 0x00FFFFFF;
+}
+
+// ARGB_8888
+static inline uint32_t load_argb8888(const uint8_t* p) {
+  return *(const uint32_t*) p;
+}
+
+static inline void store_argb8888(uint8_t* p, uint32_t v) {
+  *(uint32_t*) p = v;
+}
+
+static inline uint32_t to_argb_argb8888(uint32_t v) {
+  return v;
+}
+
+static inline uint32_t from_argb_argb8888(uint32_t c) {
+  return c;
+}
+
+// MONO
+static inline bool mono_get(const libtock_screen_blit_surface_t* s, uint32_t x, uint32_t y) {
+  return (s->buffer[x + (y / 8) * s->width] >> (y % 8)) & 0x1;
+}
+
+static inline void mono_set(libtock_screen_blit_surface_t* s, uint32_t x, uint32_t y, bool on) {
+  uint8_t* byte = &s->buffer[x + (y / 8) * s->width];
+  uint8_t mask  = 1 << (y % 8);
+  *byte = on ? (*byte | mask) : (*byte & ~mask);
+}
+
+static inline uint32_t mono_to_argb(bool on) {
+  return on ? 0xFFFFFFFF : 0xFF000000;
+}
+
+static inline bool mono_from_argb(uint32_t c) {
+  // Threshold on luma.
+  uint32_t luma = (((c >> 16) & 0xFF) * 77 + ((c >> 8) & 0xFF) * 150 + (c & 0xFF) * 29) >> 8;
+  return luma >= 128;
+}
+
+// Format list used to generate kernels: name, bytes per pixel.
+#define BLIT_FORMATS(X) \
+        X(rgb233, 1)    \
+        X(rgb565, 2)    \
+        X(rgb888, 3)    \
+        X(argb8888, 4)
+
+// Map a format to its index in the kernel tables. `MONO` is not in the tables.
+static int format_index(libtock_screen_format_t format) {
+  switch (format) {
+    case RGB_233:   return 0;
+    case RGB_565:   return 1;
+    case RGB_888:   return 2;
+    case ARGB_8888: return 3;
+    default:        return -1;
+  }
+}
+
+static uint32_t bytes_per_pixel(libtock_screen_format_t format) {
+  switch (format) {
+    case RGB_233:   return 1;
+    case RGB_565:   return 2;
+    case RGB_888:   return 3;
+    case ARGB_8888: return 4;
+    default:        return 0;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Clipping
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  int dst_x, dst_y;
+  int src_x, src_y;
+  int width, height;
+} blit_rect_t;
+
+static void clip_axis(int* dst, int* src, int* len, int dst_limit, int src_limit) {
+  if (*dst < 0) {
+    *src -= *dst;
+    *len += *dst;
+    *dst  = 0;
+  }
+  if (*src < 0) {
+    *dst -= *src;
+    *len += *src;
+    *src  = 0;
+  }
+  if (*dst + *len > dst_limit) *len = dst_limit - *dst;
+  if (*src + *len > src_limit) *len = src_limit - *src;
+}
+
+// Clip `r` to `dst` and, if not NULL, `src`. Returns false if nothing is left.
+static bool clip(const libtock_screen_blit_surface_t* dst, const libtock_screen_blit_surface_t* src,
+                 blit_rect_t* r) {
+  int src_w = src != NULL ? (int) src->width : r->src_x + r->width;
+  int src_h = src != NULL ? (int) src->height : r->src_y + r->height;
+
+  clip_axis(&r->dst_x, &r->src_x, &r->width, (int) dst->width, src_w);
+  clip_axis(&r->dst_y, &r->src_y, &r->height, (int) dst->height, src_h);
+  return r->width > 0 && r->height > 0;
+}
+
+static inline uint8_t* pixel_ptr(const libtock_screen_blit_surface_t* s, int x, int y, uint32_t bpp) {
+  return s->buffer + ((size_t) y * s->width + (size_t) x) * bpp;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Fill
+////////////////////////////////////////////////////////////////////////////////
+
+// Fill `count` pixels of a row with a 32-bit replicated `pattern`, using
+// word stores for the aligned middle of the row.
+#define BLIT_FILL_ROW(NAME, BPP)                                                        \
+        static void fill_row_ ## NAME(uint8_t* p, uint32_t count, uint32_t color,       \
+                                      uint32_t pattern) {                               \
+          while (count > 0 && ((uintptr_t) p & 0x3) != 0) {                             \
+            store_ ## NAME(p, color);                                                   \
+            p += BPP;                                                                   \
+            count--;                                                                    \
+          }                                                                             \
+          uint32_t* w    = (uint32_t*) p;                                               \
+          uint32_t words = (count * BPP) / 4;                                           \
+          while (words >= 4) {                                                          \
+            w[0]   = pattern;                                                           \
+            w[1]   = pattern;                                                           \
+            w[2]   = pattern;                                                           \
+            w[3]   = pattern;                                                           \
+            w     += 4;                                                                 \
+            words -= 4;                                                                 \
+          }                                                                             \
+          while (words > 0) {                                                           \
+            *w++ = pattern;                                                             \
+            words--;                                                                    \
+          }                                                                             \
+          p     = (uint8_t*) w;                                                         \
+          count = count % (4 / BPP);                                                    \
+          while (count > 0) {                                                           \
+            store_ ## NAME(p, color);                                                   \
+            p += BPP;                                                                   \
+            count--;                                                                    \
+          }                                                                             \
+        }
+
+BLIT_FILL_ROW(rgb233, 1)
+BLIT_FILL_ROW(rgb565, 2)
+BLIT_FILL_ROW(argb8888, 4)
+
+// 24-bit pixels repeat every three words; fill four pixels per iteration.
+static void fill_row_rgb888(uint8_t* p, uint32_t count, uint32_t color,
+                            __attribute__ ((unused)) uint32_t pattern) {
+  while (count > 0 && ((uintptr_t) p & 0x3) != 0) {
+    store_rgb888(p, color);
+    p += 3;
+    count--;
+  }
+
+  uint32_t block[3];
+  uint8_t* b = (uint8_t*) block;
+  for (int i = 0; i < 4; i++) {
+    store_rgb888(b + i * 3, color);
+  }
+
+  uint32_t* w = (uint32_t*) p;
+  while (count >= 4) {
+    w[0]   = block[0];
+    w[1]   = block[1];
+    w[2]   = block[2];
+    w     += 3;
+    count -= 4;
+  }
+  p = (uint8_t*) w;
+  while (count > 0) {
+    store_rgb888(p, color);
+    p += 3;
+    count--;
+  }
+}
+
+static uint32_t fill_pattern(libtock_screen_format_t format, uint32_t color) {
+  switch (format) {
+    case RGB_233:   return (color & 0xFF) * 0x01010101;
+    case RGB_565:   return (color & 0xFFFF) * 0x00010001;
+    case ARGB_8888: return color;
+    default:        return 0;
+  }
+}
+
+typedef void (*fill_row_fn)(uint8_t*, uint32_t, uint32_t, uint32_t);
+
+#define BLIT_FILL_ENTRY(NAME, BPP) fill_row_ ## NAME,
+static const fill_row_fn fill_row_kernels[] = { BLIT_FORMATS(BLIT_FILL_ENTRY) };
+
+static void fill_mono(libtock_screen_blit_surface_t* dst, const blit_rect_t* r, bool on) {
+  int y_end = r->dst_y + r->height;
+
+  for (int page = r->dst_y / 8; page * 8 < y_end; page++) {
+    // Mask of the rows of this page inside the rectangle.
+    int first   = r->dst_y > page * 8 ? r->dst_y - page * 8 : 0;
+    int last    = y_end < (page + 1) * 8 ? y_end - page * 8 : 8;
+    uint8_t mask = (uint8_t) (((1u << last) - 1) & ~((1u << first) - 1));
+
+    uint8_t* row = dst->buffer + page * dst->width + r->dst_x;
+    if (mask == 0xFF) {
+      memset(row, on ? 0xFF : 0x00, r->width);
+    } else {
+      for (int x = 0; x < r->width; x++) {
+        row[x] = on ? (row[x] | mask) : (row[x] & ~mask);
+      }
+    }
+  }
+}
+
+size_t libtock_screen_blit_buffer_size(uint32_t width, uint32_t height, libtock_screen_format_t format) {
+  if (format == MONO) {
+    return width * ((height + 7) / 8);
+  }
+  return (size_t) width * height * bytes_per_pixel(format);
+}
+
+uint32_t libtock_screen_blit_color(libtock_screen_format_t format, uint8_t r, uint8_t g, uint8_t b) {
+  uint32_t c = argb(0xFF, r, g, b);
+  switch (format) {
+    case MONO:      return mono_from_argb(c);
+    case RGB_233:   return from_argb_rgb233(c);
+    case RGB_565:   return from_argb_rgb565(c);
+    case RGB_888:   return from_argb_rgb888(c);
+    case ARGB_8888: return from_argb_argb8888(c);
+    default:        return 0;
+  }
+}
+
+returncode_t libtock_screen_blit_fill_rect(libtock_screen_blit_surface_t* dst, int x, int y, int width, int height,
+                                           uint32_t color) {
+  blit_rect_t r = { .dst_x = x, .dst_y = y, .src_x = 0, .src_y = 0, .width = width, .height = height };
+
+  if (dst->format == MONO) {
+    if (clip(dst, NULL, &r)) fill_mono(dst, &r, color != 0);
+    return RETURNCODE_SUCCESS;
+  }
+
+  int index = format_index(dst->format);
+  if (index < 0) return RETURNCODE_EINVAL;
+  if (!clip(dst, NULL, &r)) return RETURNCODE_SUCCESS;
+
+  fill_row_fn fill_row = fill_row_kernels[index];
+  uint32_t bpp         = bytes_per_pixel(dst->format);
+  uint32_t pattern     = fill_pattern(dst->format, color);
+  for (int row = 0; row < r.height; row++) {
+    fill_row(pixel_ptr(dst, r.dst_x, r.dst_y + row, bpp), r.width, color, pattern);
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Copy and format conversion
+////////////////////////////////////////////////////////////////////////////////
+
+typedef void (*convert_row_fn)(uint8_t*, const uint8_t*, uint32_t);
+
+#define BLIT_CONVERT_ROW(SRC, SRC_BPP, DST, DST_BPP)                                       \
+        static void convert_row_ ## SRC ## _to_ ## DST(uint8_t* d, const uint8_t* s,       \
+                                                       uint32_t count) {                   \
+          for (uint32_t i = 0; i < count; i++) {                                           \
+            store_ ## DST(d, from_argb_ ## DST(to_argb_ ## SRC(load_ ## SRC(s))));         \
+            d += DST_BPP;                                                                  \
+            s += SRC_BPP;                                                                  \
+          }                                                                                \
+        }
+
+#define BLIT_CONVERT_FROM(SRC, SRC_BPP)                      \
+        BLIT_CONVERT_ROW(SRC, SRC_BPP, rgb233, 1)            \
+        BLIT_CONVERT_ROW(SRC, SRC_BPP, rgb565, 2)            \
+        BLIT_CONVERT_ROW(SRC, SRC_BPP, rgb888, 3)            \
+        BLIT_CONVERT_ROW(SRC, SRC_BPP, argb8888, 4)
+
+BLIT_FORMATS(BLIT_CONVERT_FROM)
+
+#define BLIT_CONVERT_ENTRY(SRC, SRC_BPP)                                                \
+        { convert_row_ ## SRC ## _to_rgb233, convert_row_ ## SRC ## _to_rgb565,         \
+          convert_row_ ## SRC ## _to_rgb888, convert_row_ ## SRC ## _to_argb8888 },
+static const convert_row_fn convert_row_kernels[4][4] = { BLIT_FORMATS(BLIT_CONVERT_ENTRY) };
+
+// Convert a single pixel through ARGB_8888, for conversions involving MONO.
+static uint32_t get_argb(const libtock_screen_blit_surface_t* s, int x, int y) {
+  switch (s->format) {
+    case MONO:      return mono_to_argb(mono_get(s, x, y));
+    case RGB_233:   return to_argb_rgb233(load_rgb233(pixel_ptr(s, x, y, 1)));
+    case RGB_565:   return to_argb_rgb565(load_rgb565(pixel_ptr(s, x, y, 2)));
+    case RGB_888:   return to_argb_rgb888(load_rgb888(pixel_ptr(s, x, y, 3)));
+    case ARGB_8888: return load_argb8888(pixel_ptr(s, x, y, 4));
+    default:        return 0;
+  }
+}
+
+static void set_argb(libtock_screen_blit_surface_t* s, int x, int y, uint32_t c) {
+  switch (s->format) {
+    case MONO:      mono_set(s, x, y, mono_from_argb(c)); break;
+    case RGB_233:   store_rgb233(pixel_ptr(s, x, y, 1), from_argb_rgb233(c)); break;
+    case RGB_565:   store_rgb565(pixel_ptr(s, x, y, 2), from_argb_rgb565(c)); break;
+    case RGB_888:   store_rgb888(pixel_ptr(s, x, y, 3), from_argb_rgb888(c)); break;
+    case ARGB_8888: store_argb8888(pixel_ptr(s, x, y, 4), c); break;
+    default:        break;
+  }
+}
+
+static void copy_mono(libtock_screen_blit_surface_t* dst, const libtock_screen_blit_surface_t* src,
+                      const blit_rect_t* r) {
+  bool same  = dst->buffer == src->buffer;
+  bool up    = same && r->dst_y > r->src_y;
+  bool right = same && r->dst_x > r->src_x;
+
+  for (int j = 0; j < r->height; j++) {
+    int row = up ? r->height - 1 - j : j;
+    for (int i = 0; i < r->width; i++) {
+      int col = right ? r->width - 1 - i : i;
+      mono_set(dst, r->dst_x + col, r->dst_y + row, mono_get(src, r->src_x + col, r->src_y + row));
+    }
+  }
+}
+
+returncode_t libtock_screen_blit_copy_rect(libtock_screen_blit_surface_t* dst, int dst_x, int dst_y,
+                                           const libtock_screen_blit_surface_t* src, int src_x, int src_y,
+                                           int width, int height) {
+  blit_rect_t r = { .dst_x = dst_x, .dst_y = dst_y, .src_x = src_x, .src_y = src_y, .width = width,
+                    .height = height };
+
+  int dst_index = format_index(dst->format);
+  int src_index = format_index(src->format);
+  if ((dst_index < 0 && dst->format != MONO) || (src_index < 0 && src->format != MONO)) {
+    return RETURNCODE_EINVAL;
+  }
+  if (!clip(dst, src, &r)) return RETURNCODE_SUCCESS;
+
+  if (dst->format == MONO && src->format == MONO) {
+    copy_mono(dst, src, &r);
+    return RETURNCODE_SUCCESS;
+  }
+
+  if (dst_index < 0 || src_index < 0) {
+    // Conversion to or from MONO.
+    for (int j = 0; j < r.height; j++) {
+      for (int i = 0; i < r.width; i++) {
+        set_argb(dst, r.dst_x + i, r.dst_y + j, get_argb(src, r.src_x + i, r.src_y + j));
+      }
+    }
+    return RETURNCODE_SUCCESS;
+  }
+
+  uint32_t dst_bpp = bytes_per_pixel(dst->format);
+  uint32_t src_bpp = bytes_per_pixel(src->format);
+
+  if (dst->format == src->format) {
+    // Plain row copies. Walk rows bottom-up if they overlap that way.
+    bool up = dst->buffer == src->buffer && r.dst_y > r.src_y;
+    for (int j = 0; j < r.height; j++) {
+      int row = up ? r.height - 1 - j : j;
+      memmove(pixel_ptr(dst, r.dst_x, r.dst_y + row, dst_bpp), pixel_ptr(src, r.src_x, r.src_y + row, src_bpp),
+              (size_t) r.width * dst_bpp);
+    }
+    return RETURNCODE_SUCCESS;
+  }
+
+  convert_row_fn convert_row = convert_row_kernels[src_index][dst_index];
+  for (int j = 0; j < r.height; j++) {
+    convert_row(pixel_ptr(dst, r.dst_x, r.dst_y + j, dst_bpp), pixel_ptr(src, r.src_x, r.src_y + j, src_bpp),
+                r.width);
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Alpha blending
+////////////////////////////////////////////////////////////////////////////////
+
+// Blend two ARGB colors with `a` in 0-256, two channels per multiply.
+static inline uint32_t blend_rgb(uint32_t s, uint32_t d, uint32_t a) {
+  uint32_t rb = (((s & 0x00FF00FF) * a + (d & 0x00FF00FF) * (256 - a)) >> 8) & 0x00FF00FF;
+  uint32_t g  = (((s & 0x0000FF00) * a + (d & 0x0000FF00) * (256 - a)) >> 8) & 0x0000FF00;
+  return rb | g;
+}
+
+#define BLIT_BLEND_ROW(NAME, BPP)                                                              \
+        static void blend_row_ ## NAME(uint8_t* d, const uint8_t* s, uint32_t count) {         \
+          for (uint32_t i = 0; i < count; i++, d += BPP, s += 4) {                             \
+            uint32_t c = load_argb8888(s);                                                     \
+            uint32_t a = c >> 24;                                                              \
+            if (a == 0) continue;                                                              \
+            if (a == 0xFF) {                                                                   \
+              store_ ## NAME(d, from_argb_ ## NAME(c | 0xFF000000));                           \
+              continue;                                                                        \
+            }                                                                                  \
+            uint32_t dc = to_argb_ ## NAME(load_ ## NAME(d));                                  \
+            uint32_t a256 = a + (a >> 7);                                                      \
+            uint32_t da   = dc >> 24;                                                          \
+            uint32_t out_a = a + ((da * (256 - a256)) >> 8);                                   \
+            store_ ## NAME(d, from_argb_ ## NAME((out_a << 24) | blend_rgb(c, dc, a256)));     \
+          }                                                                                    \
+        }
+
+BLIT_BLEND_ROW(rgb233, 1)
+BLIT_BLEND_ROW(rgb888, 3)
+BLIT_BLEND_ROW(argb8888, 4)
+
+// RGB_565 blends in 16-bit space: spreading the pixel over a 32-bit word as
+// `-GGGGGG-----RRRRR------BBBBB` leaves room to blend all three channels with
+// a single multiply.
+static void blend_row_rgb565(uint8_t* d, const uint8_t* s, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++, d += 2, s += 4) {
+    uint32_t c = load_argb8888(s);
+    uint32_t a = (c >> 24) >> 3;
+    if (a == 0) continue;
+
+    uint32_t fg = from_argb_rgb565(c);
+    if (a == 31) {
+      store_rgb565(d, fg);
+      continue;
+    }
+
+    uint32_t bg = load_rgb565(d);
+    fg = (fg | (fg << 16)) & 0x07E0F81F;
+    bg = (bg | (bg << 16)) & 0x07E0F81F;
+    uint32_t result = ((((fg - bg) * a) >> 5) + bg) & 0x07E0F81F;
+    store_rgb565(d, (result >> 16) | result);
+  }
+}
+
+#define BLIT_BLEND_ENTRY(NAME, BPP) blend_row_ ## NAME,
+static const convert_row_fn blend_row_kernels[] = { BLIT_FORMATS(BLIT_BLEND_ENTRY) };
+
+returncode_t libtock_screen_blit_blend_rect(libtock_screen_blit_surface_t* dst, int dst_x, int dst_y,
+                                            const libtock_screen_blit_surface_t* src, int src_x, int src_y,
+                                            int width, int height) {
+  blit_rect_t r = { .dst_x = dst_x, .dst_y = dst_y, .src_x = src_x, .src_y = src_y, .width = width,
+                    .height = height };
+
+  if (src->format != ARGB_8888) return RETURNCODE_EINVAL;
+  int dst_index = format_index(dst->format);
+  if (dst_index < 0 && dst->format != MONO) return RETURNCODE_EINVAL;
+  if (!clip(dst, src, &r)) return RETURNCODE_SUCCESS;
+
+  if (dst->format == MONO) {
+    // No intermediate levels; a pixel is drawn if it is mostly opaque.
+    for (int j = 0; j < r.height; j++) {
+      for (int i = 0; i < r.width; i++) {
+        uint32_t c = load_argb8888(pixel_ptr(src, r.src_x + i, r.src_y + j, 4));
+        if ((c >> 24) >= 0x80) mono_set(dst, r.dst_x + i, r.dst_y + j, mono_from_argb(c));
+      }
+    }
+    return RETURNCODE_SUCCESS;
+  }
+
+  convert_row_fn blend_row = blend_row_kernels[dst_index];
+  uint32_t dst_bpp         = bytes_per_pixel(dst->format);
+  for (int j = 0; j < r.height; j++) {
+    blend_row(pixel_ptr(dst, r.dst_x, r.dst_y + j, dst_bpp), pixel_ptr(src, r.src_x, r.src_y + j, 4), r.width);
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Glyphs
+////////////////////////////////////////////////////////////////////////////////
+
+typedef void (*glyph_row_fn)(uint8_t*, const uint8_t*, uint32_t, uint32_t, uint32_t);
+
+// Draw `count` pixels of a glyph row starting at bit `bit`. Whole zero bytes
+// of the glyph are skipped at once.
+#define BLIT_GLYPH_ROW(NAME, BPP)                                                             \
+        static void glyph_row_ ## NAME(uint8_t* d, const uint8_t* bits, uint32_t bit,         \
+                                       uint32_t count, uint32_t color) {                      \
+          uint32_t i = 0;                                                                     \
+          while (i < count) {                                                                 \
+            uint32_t b = bit + i;                                                             \
+            uint8_t byte = bits[b / 8] << (b % 8);                                            \
+            uint32_t n   = 8 - (b % 8);                                                       \
+            if (n > count - i) n = count - i;                                                 \
+            for (uint32_t k = 0; byte != 0 && k < n; k++, byte <<= 1) {                       \
+              if (byte & 0x80) store_ ## NAME(d + (i + k) * BPP, color);                      \
+            }                                                                                 \
+            i += n;                                                                           \
+          }                                                                                   \
+        }
+
+BLIT_FORMATS(BLIT_GLYPH_ROW)
+
+#define BLIT_GLYPH_ENTRY(NAME, BPP) glyph_row_ ## NAME,
+static const glyph_row_fn glyph_row_kernels[] = { BLIT_FORMATS(BLIT_GLYPH_ENTRY) };
+
+returncode_t libtock_screen_blit_glyph(libtock_screen_blit_surface_t* dst, int x, int y, const uint8_t* glyph,
+                                       int width, int height, uint32_t color) {
+  blit_rect_t r = { .dst_x = x, .dst_y = y, .src_x = 0, .src_y = 0, .width = width, .height = height };
+
+  int dst_index = format_index(dst->format);
+  if (dst_index < 0 && dst->format != MONO) return RETURNCODE_EINVAL;
+  if (!clip(dst, NULL, &r)) return RETURNCODE_SUCCESS;
+
+  uint32_t row_bytes = (width + 7) / 8;
+
+  if (dst->format == MONO) {
+    for (int j = 0; j < r.height; j++) {
+      const uint8_t* bits = glyph + (r.src_y + j) * row_bytes;
+      for (int i = 0; i < r.width; i++) {
+        uint32_t b = r.src_x + i;
+        if (bits[b / 8] & (0x80 >> (b % 8))) mono_set(dst, r.dst_x + i, r.dst_y + j, color != 0);
+      }
+    }
+    return RETURNCODE_SUCCESS;
+  }
+
+  glyph_row_fn glyph_row = glyph_row_kernels[dst_index];
+  uint32_t bpp           = bytes_per_pixel(dst->format);
+  for (int j = 0; j < r.height; j++) {
+    glyph_row(pixel_ptr(dst, r.dst_x, r.dst_y + j, bpp), glyph + (r.src_y + j) * row_bytes, r.src_x, r.width,
+              color);
+  }
+  return RETURNCODE_SUCCESS;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+// Software 2D drawing into screen buffers.
+//
+// These functions draw into a buffer in one of the screen pixel formats
+// (`libtock_screen_format_t`) that can then be sent with
+// `libtock_screen_write()`. They do not make any system calls.
+//
+// Pixel layout in memory:
+//
+// - `MONO`: 1 bit per pixel in 8-pixel-high pages, as used by SSD1306-style
+//   displays and u8g2. Pixel (x, y) is bit `y % 8` of byte
+//   `x + (y / 8) * width`. A set bit is a lit pixel.
+// - `RGB_233`: 1 byte per pixel, `RRGGGBBB`.
+// - `RGB_565`: 2 bytes per pixel, stored as a native `uint16_t`.
+// - `RGB_888`: 3 bytes per pixel, stored as the three low bytes of a native
+//   `0xRRGGBB` value (blue first on little-endian targets).
+// - `ARGB_8888`: 4 bytes per pixel, stored as a native `uint32_t` `0xAARRGGBB`.
+//
+// Colors passed to these functions are in the surface's native format, see
+// `libtock_screen_blit_color()`. Surface buffers must be 4-byte aligned.
+//
+// All operations clip to the destination (and source) surface.
+
+#include "../tock.h"
+#include "screen.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  uint8_t* buffer;
+  uint32_t width;
+  uint32_t height;
+  libtock_screen_format_t format;
+} libtock_screen_blit_surface_t;
+
+// Number of bytes needed for a `width`x`height` buffer in `format`.
+size_t libtock_screen_blit_buffer_size(uint32_t width, uint32_t height, libtock_screen_format_t format);
+
+// Convert an 8-bit-per-channel color to the native value for `format`.
+uint32_t libtock_screen_blit_color(libtock_screen_format_t format, uint8_t r, uint8_t g, uint8_t b);
+
+// Fill a rectangle with `color`.
+returncode_t libtock_screen_blit_fill_rect(libtock_screen_blit_surface_t* dst, int x, int y, int width, int height,
+                                           uint32_t color);
+
+// Copy a `width`x`height` rectangle from (`src_x`, `src_y`) in `src` to
+// (`dst_x`, `dst_y`) in `dst`.
+//
+// If the surfaces have different pixel formats the pixels are converted.
+// Copies within the same buffer may overlap.
+returncode_t libtock_screen_blit_copy_rect(libtock_screen_blit_surface_t* dst, int dst_x, int dst_y,
+                                           const libtock_screen_blit_surface_t* src, int src_x, int src_y,
+                                           int width, int height);
+
+// Alpha blend a rectangle of an `ARGB_8888` surface onto `dst`.
+//
+// `dst` may be in any format. For `ARGB_8888` destinations the alpha channel
+// is composited as well.
+returncode_t libtock_screen_blit_blend_rect(libtock_screen_blit_surface_t* dst, int dst_x, int dst_y,
+                                            const libtock_screen_blit_surface_t* src, int src_x, int src_y,
+                                            int width, int height);
+
+// Draw a 1-bit-per-pixel glyph at (`x`, `y`) in `color`.
+//
+// `glyph` is `height` rows of `(width + 7) / 8` bytes each, most significant
+// bit first. Set bits are drawn, clear bits are left untouched.
+returncode_t libtock_screen_blit_glyph(libtock_screen_blit_surface_t* dst, int x, int y, const uint8_t* glyph,
+                                       int width, int height, uint32_t color);
+
+#ifdef __cplusplus
+}
+#endif
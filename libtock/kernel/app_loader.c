@@ -1,5 +1,6 @@
-#include "app_loader.h"
+#include <string.h>
 
+#include "app_loader.h"
 #include "syscalls/app_loader_syscalls.h"
 
 bool libtock_app_loader_exists(void) {
@@ -100,3 +101,307 @@ returncode_t libtock_app_loader_load(void) {
 returncode_t libtock_app_loader_abort(void) {
   return libtock_app_loader_command_abort();
 }
+
+/*
+ * Streaming app loader.
+ */
+
+// Whether the buffer being filled should be written now.
+static bool stream_chunk_ready(libtock_app_loader_stream_t* stream) {
+  if (stream->fill_len == 0) return false;
+  if (stream->fill_len == stream->buffer_len) return true;
+  if (stream->fill_offset + stream->fill_len == stream->app_length) return true;
+  return stream->finishing;
+}
+
+static void stream_report_write(libtock_app_loader_stream_t* stream, returncode_t ret) {
+  if (stream->write_cb != NULL) {
+    stream->write_cb(ret, &stream->checkpoint);
+  }
+}
+
+static returncode_t stream_write(libtock_app_loader_stream_t* stream) {
+  uint8_t* buffer = stream->buffers[stream->fill];
+  uint32_t len    = stream->fill_len;
+  returncode_t ret;
+
+  // Only the last chunk can be short. Pad it up to the app length.
+  if (len < stream->buffer_len) {
+    uint32_t remaining = stream->app_length - stream->fill_offset;
+    uint32_t padded    = remaining < stream->buffer_len ? remaining : stream->buffer_len;
+    memset(&buffer[len], 0, padded - len);
+    len = padded;
+  }
+
+  ret = libtock_app_loader_set_buffer(buffer, len);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_app_loader_write(stream->fill_offset, len);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  stream->writing      = true;
+  stream->write_offset = stream->fill_offset;
+  stream->write_len    = len;
+  memcpy(&stream->write_hash, &stream->hash, sizeof(libtock_sha256_software_t));
+
+  // Start filling the other buffer.
+  stream->fill        ^= 1;
+  stream->fill_offset += len;
+  stream->fill_len     = 0;
+  return RETURNCODE_SUCCESS;
+}
+
+// Everything is in flash: check the hash and finalize, or abort on a mismatch.
+static returncode_t stream_complete(libtock_app_loader_stream_t* stream) {
+  if (stream->expected_hash != NULL) {
+    uint8_t digest[LIBTOCK_SHA256_SOFTWARE_DIGEST_LEN];
+    libtock_sha256_software_finish(&stream->hash, digest);
+    if (memcmp(digest, stream->expected_hash, sizeof(digest)) != 0) {
+      return libtock_app_loader_abort();
+    }
+  }
+  return libtock_app_loader_finalize();
+}
+
+static void stream_setup_upcall(int                          status,
+                                __attribute__ ((unused)) int arg1,
+                                __attribute__ ((unused)) int arg2,
+                                void*                        opaque) {
+  libtock_app_loader_stream_t* stream = (libtock_app_loader_stream_t*) opaque;
+  returncode_t ret = tock_status_to_returncode(status);
+
+  stream->set_up = ret == RETURNCODE_SUCCESS;
+  stream->done_cb(ret);
+}
+
+static void stream_write_upcall(int                          status,
+                                __attribute__ ((unused)) int arg1,
+                                __attribute__ ((unused)) int arg2,
+                                void*                        opaque) {
+  libtock_app_loader_stream_t* stream = (libtock_app_loader_stream_t*) opaque;
+  returncode_t ret = tock_status_to_returncode(status);
+
+  stream->writing = false;
+  if (ret != RETURNCODE_SUCCESS) {
+    stream->error = ret;
+    stream_report_write(stream, ret);
+    if (stream->finishing) {
+      stream->finishing = false;
+      stream->done_cb(ret);
+    }
+    return;
+  }
+
+  stream->checkpoint.offset = stream->write_offset + stream->write_len;
+  memcpy(&stream->checkpoint.hash, &stream->write_hash, sizeof(libtock_sha256_software_t));
+  stream->stats.chunks++;
+  stream->stats.bytes += stream->write_len;
+
+  // Keep the flash busy before handing control back to the app.
+  returncode_t start_ret = RETURNCODE_SUCCESS;
+  if (stream_chunk_ready(stream)) {
+    start_ret = stream_write(stream);
+    if (start_ret == RETURNCODE_SUCCESS) {
+      stream->stats.pipelined++;
+    } else {
+      stream->error = start_ret;
+    }
+  }
+
+  stream_report_write(stream, RETURNCODE_SUCCESS);
+  if (start_ret != RETURNCODE_SUCCESS) {
+    stream_report_write(stream, start_ret);
+  }
+
+  if (stream->finishing && !stream->writing) {
+    ret = stream->error;
+    if (ret == RETURNCODE_SUCCESS) ret = stream_complete(stream);
+    if (ret != RETURNCODE_SUCCESS) {
+      stream->finishing = false;
+      stream->done_cb(ret);
+    }
+  }
+}
+
+static void stream_finalize_upcall(int                          status,
+                                   __attribute__ ((unused)) int arg1,
+                                   __attribute__ ((unused)) int arg2,
+                                   void*                        opaque) {
+  libtock_app_loader_stream_t* stream = (libtock_app_loader_stream_t*) opaque;
+
+  stream->set_up    = false;
+  stream->finishing = false;
+  stream->done_cb(tock_status_to_returncode(status));
+}
+
+static void stream_abort_upcall(int                          status,
+                                __attribute__ ((unused)) int arg1,
+                                __attribute__ ((unused)) int arg2,
+                                void*                        opaque) {
+  libtock_app_loader_stream_t* stream = (libtock_app_loader_stream_t*) opaque;
+  returncode_t ret = tock_status_to_returncode(status);
+
+  // An abort while finishing means the hash did not match.
+  if (stream->finishing) ret = RETURNCODE_FAIL;
+
+  stream->set_up    = false;
+  stream->finishing = false;
+  stream->done_cb(ret);
+}
+
+returncode_t libtock_app_loader_stream_init(libtock_app_loader_stream_t* stream, uint8_t* buffer_a, uint8_t* buffer_b,
+                                            uint32_t buffer_len, libtock_app_loader_write_callback write_cb) {
+  returncode_t ret;
+
+  memset(stream, 0, sizeof(libtock_app_loader_stream_t));
+  stream->buffers[0] = buffer_a;
+  stream->buffers[1] = buffer_b;
+  stream->buffer_len = buffer_len;
+  stream->write_cb   = write_cb;
+
+  ret = libtock_app_loader_subscribe_setup(stream_setup_upcall, stream);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+  ret = libtock_app_loader_subscribe_write(stream_write_upcall, stream);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+  ret = libtock_app_loader_subscribe_finalize(stream_finalize_upcall, stream);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+  return libtock_app_loader_subscribe_abort(stream_abort_upcall, stream);
+}
+
+static returncode_t stream_setup(libtock_app_loader_stream_t* stream, uint32_t app_length,
+                                 libtock_app_loader_callback cb) {
+  if (stream->set_up || stream->writing) return RETURNCODE_EBUSY;
+
+  returncode_t ret = libtock_app_loader_setup(app_length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  stream->app_length = app_length;
+  stream->fill       = 0;
+  stream->fill_len   = 0;
+  stream->finishing  = false;
+  stream->error      = RETURNCODE_SUCCESS;
+  stream->done_cb    = cb;
+  memset(&stream->stats, 0, sizeof(libtock_app_loader_stream_stats_t));
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_app_loader_stream_start(libtock_app_loader_stream_t* stream, uint32_t app_length,
+                                             libtock_app_loader_callback cb) {
+  returncode_t ret = stream_setup(stream, app_length, cb);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  stream->fill_offset = 0;
+  libtock_sha256_software_init(&stream->hash);
+
+  stream->checkpoint.magic      = LIBTOCK_APP_LOADER_CHECKPOINT_MAGIC;
+  stream->checkpoint.app_length = app_length;
+  stream->checkpoint.offset     = 0;
+  memcpy(&stream->checkpoint.hash, &stream->hash, sizeof(libtock_sha256_software_t));
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_app_loader_stream_resume(libtock_app_loader_stream_t* stream,
+                                              const libtock_app_loader_checkpoint_t* checkpoint,
+                                              libtock_app_loader_callback cb) {
+  if (checkpoint->magic != LIBTOCK_APP_LOADER_CHECKPOINT_MAGIC ||
+      checkpoint->offset > checkpoint->app_length) {
+    return RETURNCODE_EINVAL;
+  }
+
+  returncode_t ret = stream_setup(stream, checkpoint->app_length, cb);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  stream->fill_offset = checkpoint->offset;
+  memcpy(&stream->hash, &checkpoint->hash, sizeof(libtock_sha256_software_t));
+  memcpy(&stream->checkpoint, checkpoint, sizeof(libtock_app_loader_checkpoint_t));
+  return RETURNCODE_SUCCESS;
+}
+
+uint8_t* libtock_app_loader_stream_reserve(libtock_app_loader_stream_t* stream, uint32_t* len) {
+  *len = 0;
+  if (!stream->set_up || stream->finishing || stream->error != RETURNCODE_SUCCESS) return NULL;
+  // The buffer being filled is full and waiting for the write in flight.
+  if (stream_chunk_ready(stream)) return NULL;
+
+  uint32_t space     = stream->buffer_len - stream->fill_len;
+  uint32_t remaining = stream->app_length - stream->fill_offset - stream->fill_len;
+  *len = space < remaining ? space : remaining;
+  return &stream->buffers[stream->fill][stream->fill_len];
+}
+
+returncode_t libtock_app_loader_stream_commit(libtock_app_loader_stream_t* stream, uint32_t len) {
+  uint32_t space;
+  uint8_t* data = libtock_app_loader_stream_reserve(stream, &space);
+  if (data == NULL) return stream->error != RETURNCODE_SUCCESS ? stream->error : RETURNCODE_EBUSY;
+  if (len > space) return RETURNCODE_ESIZE;
+
+  // Hash while the previous chunk is being written.
+  libtock_sha256_software_update(&stream->hash, data, len);
+  stream->fill_len += len;
+
+  if (!stream->writing && stream_chunk_ready(stream)) {
+    returncode_t ret = stream_write(stream);
+    if (ret != RETURNCODE_SUCCESS) {
+      stream->error = ret;
+      return ret;
+    }
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+uint32_t libtock_app_loader_stream_push(libtock_app_loader_stream_t* stream, const uint8_t* data, uint32_t len) {
+  uint32_t pushed = 0;
+
+  while (pushed < len) {
+    uint32_t space;
+    uint8_t* dest = libtock_app_loader_stream_reserve(stream, &space);
+    if (dest == NULL || space == 0) break;
+
+    uint32_t n = len - pushed < space ? len - pushed : space;
+    memcpy(dest, &data[pushed], n);
+    if (libtock_app_loader_stream_commit(stream, n) != RETURNCODE_SUCCESS) break;
+    pushed += n;
+  }
+
+  if (pushed < len) stream->stats.stalls++;
+  return pushed;
+}
+
+uint32_t libtock_app_loader_stream_offset(libtock_app_loader_stream_t* stream) {
+  return stream->fill_offset + stream->fill_len;
+}
+
+returncode_t libtock_app_loader_stream_finish(libtock_app_loader_stream_t* stream, const uint8_t* expected_hash,
+                                              libtock_app_loader_callback cb) {
+  if (!stream->set_up || stream->finishing) return RETURNCODE_EBUSY;
+  if (stream->error != RETURNCODE_SUCCESS) return stream->error;
+
+  stream->expected_hash = expected_hash;
+  stream->done_cb       = cb;
+  stream->finishing     = true;
+
+  // Either the last chunk is in flight and the write upcall completes the
+  // stream, or we write out what is left here.
+  returncode_t ret = RETURNCODE_SUCCESS;
+  if (!stream->writing) {
+    if (stream->fill_len > 0) {
+      ret = stream_write(stream);
+    } else {
+      ret = stream_complete(stream);
+    }
+  }
+  if (ret != RETURNCODE_SUCCESS) {
+    stream->finishing = false;
+  }
+  return ret;
+}
+
+returncode_t libtock_app_loader_stream_abort(libtock_app_loader_stream_t* stream, libtock_app_loader_callback cb) {
+  if (stream->finishing) return RETURNCODE_EBUSY;
+
+  returncode_t ret = libtock_app_loader_abort();
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  stream->done_cb = cb;
+  return RETURNCODE_SUCCESS;
+}
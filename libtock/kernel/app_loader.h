@@ -5,6 +5,7 @@ extern "C"
 {
 #endif
 
+#include "../crypto/sha256_software.h"
 #include "../tock.h"
 
 #define BUTTON1 0
@@ -89,11 +90,166 @@ returncode_t libtock_app_loader_abort(void);
 
 
 /*
- * Internal function to write new app to flash. Takes app size as argument.
+ * Streaming app loader.
+ *
+ * Writes a new app to flash as it arrives, so the image never has to be held
+ * in memory and can come from any source (network, IPC, storage). Two staging
+ * buffers are used: while one is being written to flash, the app fills the
+ * other. A SHA-256 hash of the image is computed as it is staged and checked
+ * before the app is finalized.
+ *
+ * After every chunk is written, the write callback gets a checkpoint with the
+ * number of bytes in flash and the hash state up to that point. If the
+ * transfer is interrupted, the checkpoint can be passed to
+ * `libtock_app_loader_stream_resume()` to continue from there, for example
+ * after a reset. The kernel must give the app the same region in flash again,
+ * which it does as long as no other app was loaded in between. If only the
+ * source was interrupted and the stream is still set up, keep pushing from
+ * `libtock_app_loader_stream_offset()` instead.
+ *
+ * Typical use:
+ *
+ *   libtock_app_loader_stream_init(&stream, buf_a, buf_b, sizeof(buf_a), on_write);
+ *   libtock_app_loader_stream_start(&stream, app_length, on_setup);
+ *   // As data arrives:
+ *   libtock_app_loader_stream_push(&stream, data, len);
+ *   // Once all data has been pushed:
+ *   libtock_app_loader_stream_finish(&stream, expected_hash, on_done);
+ */
+
+#define LIBTOCK_APP_LOADER_CHECKPOINT_MAGIC 0x4b504341 // "ACPK"
+
+typedef struct {
+  uint32_t magic;
+  // Length passed to setup.
+  uint32_t app_length;
+  // Bytes of the app written to flash.
+  uint32_t offset;
+  // Hash of the first `offset` bytes.
+  libtock_sha256_software_t hash;
+} libtock_app_loader_checkpoint_t;
+
+typedef struct {
+  // Chunks and bytes written to flash.
+  uint32_t chunks;
+  uint32_t bytes;
+  // Chunks started straight from the previous chunk's write upcall.
+  uint32_t pipelined;
+  // Pushes that could not be fully accepted because both buffers were full.
+  uint32_t stalls;
+} libtock_app_loader_stream_stats_t;
+
+/*
+ * Function signature for setup, finish and abort completion.
+ */
+typedef void (*libtock_app_loader_callback)(returncode_t);
+
+/*
+ * Function signature for completed chunk writes.
+ *
+ * Called after every chunk is written with the status of the write and the
+ * new checkpoint. Buffer space is free again when this is called.
+ */
+typedef void (*libtock_app_loader_write_callback)(returncode_t, const libtock_app_loader_checkpoint_t*);
+
+typedef struct {
+  uint8_t* buffers[2];
+  uint32_t buffer_len;
+  libtock_app_loader_write_callback write_cb;
+  libtock_app_loader_callback done_cb;
+
+  uint32_t app_length;
+  // Buffer being filled, how much of it is filled, and where it goes in flash.
+  uint8_t fill;
+  uint32_t fill_len;
+  uint32_t fill_offset;
+
+  bool set_up;
+  bool writing;
+  bool finishing;
+  uint32_t write_offset;
+  uint32_t write_len;
+  returncode_t error;
+
+  // Hash of everything staged, and the hash at the end of the chunk being
+  // written.
+  libtock_sha256_software_t hash;
+  libtock_sha256_software_t write_hash;
+  const uint8_t* expected_hash;
+
+  libtock_app_loader_checkpoint_t checkpoint;
+  libtock_app_loader_stream_stats_t stats;
+} libtock_app_loader_stream_t;
+
+/*
+ * Set up a stream using the two staging buffers of `buffer_len` bytes each.
+ * Larger buffers mean fewer, larger flash writes. `write_cb` may be NULL.
+ *
+ * This subscribes to the setup, write, finalize and abort upcalls.
+ */
+returncode_t libtock_app_loader_stream_init(libtock_app_loader_stream_t* stream, uint8_t* buffer_a, uint8_t* buffer_b,
+                                            uint32_t buffer_len, libtock_app_loader_write_callback write_cb);
+
+/*
+ * Ask the kernel for space for an app of `app_length` bytes. `cb` is called
+ * once the kernel is ready to accept data.
+ */
+returncode_t libtock_app_loader_stream_start(libtock_app_loader_stream_t* stream, uint32_t app_length,
+                                             libtock_app_loader_callback cb);
+
+/*
+ * Like `libtock_app_loader_stream_start()`, but continue an interrupted
+ * transfer from `checkpoint`. The next byte pushed is the byte at
+ * `checkpoint->offset`.
+ */
+returncode_t libtock_app_loader_stream_resume(libtock_app_loader_stream_t* stream,
+                                              const libtock_app_loader_checkpoint_t* checkpoint,
+                                              libtock_app_loader_callback cb);
+
+/*
+ * Get space in the staging buffer to read data into directly.
+ *
+ * Returns a pointer to the free space and sets `len` to its size, or returns
+ * NULL if both buffers are full. Follow with `libtock_app_loader_stream_commit()`.
+ */
+uint8_t* libtock_app_loader_stream_reserve(libtock_app_loader_stream_t* stream, uint32_t* len);
+
+/*
+ * Add `len` bytes written into the space from `libtock_app_loader_stream_reserve()`
+ * to the image.
  */
-int write_app(double size, uint8_t binary[]);
+returncode_t libtock_app_loader_stream_commit(libtock_app_loader_stream_t* stream, uint32_t len);
 
+/*
+ * Copy `len` bytes from `data` into the image.
+ *
+ * Returns the number of bytes accepted, which is less than `len` if both
+ * buffers are full. Push the rest after the next write callback.
+ */
+uint32_t libtock_app_loader_stream_push(libtock_app_loader_stream_t* stream, const uint8_t* data, uint32_t len);
+
+/*
+ * Bytes of the image pushed so far.
+ */
+uint32_t libtock_app_loader_stream_offset(libtock_app_loader_stream_t* stream);
 
+/*
+ * Write out the remaining data, check the image hash against `expected_hash`
+ * (32 bytes, or NULL to skip the check) and finalize the app. The last chunk
+ * is padded with zeros up to the app length.
+ *
+ * `cb` is called with `RETURNCODE_SUCCESS` once the app is finalized, or with
+ * `RETURNCODE_FAIL` if the hash did not match, in which case the app has been
+ * aborted.
+ */
+returncode_t libtock_app_loader_stream_finish(libtock_app_loader_stream_t* stream, const uint8_t* expected_hash,
+                                              libtock_app_loader_callback cb);
+
+/*
+ * Abort the app being written. `cb` is called when the kernel has released the
+ * space.
+ */
+returncode_t libtock_app_loader_stream_abort(libtock_app_loader_stream_t* stream, libtock_app_loader_callback cb);
 
 #ifdef __cplusplus
 }
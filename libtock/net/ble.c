@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "../peripherals/syscalls/alarm_syscalls.h"
 #include "ble.h"
 
 #include "tock.h"
@@ -50,6 +51,212 @@ int ble_stop_passive_scan(void) {
   return tock_command_return_novalue_to_returncode(res);
 }
 
+// AdvData types (Bluetooth Assigned Numbers, Common Data Types).
+#define AD_UUID16_INCOMPLETE    0x02
+#define AD_UUID16_COMPLETE      0x03
+#define AD_UUID128_INCOMPLETE   0x06
+#define AD_UUID128_COMPLETE     0x07
+#define AD_SERVICE_DATA_UUID16  0x16
+#define AD_SERVICE_DATA_UUID128 0x21
+#define AD_MANUFACTURER_DATA    0xff
+
+#define ADV_PDU_MIN_SIZE (2 + LIBTOCK_BLE_ADDRESS_SIZE)
+
+// The PDU header's length field covers the advertiser address and AdvData.
+#define ADV_PDU_LENGTH_MASK 0x3f
+
+// `free_packets` has one bit per packet.
+_Static_assert(LIBTOCK_BLE_SCAN_MAX_PACKETS == 32, "free_packets is a 32-bit mask");
+
+// Length of an advertising PDU from its header, or 0 if it cannot be one.
+static int adv_pdu_length(const uint8_t* pdu) {
+  int len = 2 + (pdu[1] & ADV_PDU_LENGTH_MASK);
+  return (len < ADV_PDU_MIN_SIZE || len > LIBTOCK_BLE_ADV_PDU_MAX_SIZE) ? 0 : len;
+}
+
+static uint16_t read_le16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+static bool has_uuid16(const libtock_ble_scan_filter_t* filter, const uint8_t* uuid) {
+  for (size_t i = 0; i < filter->num_uuids16; i++) {
+    if (filter->uuids16[i] == read_le16(uuid)) return true;
+  }
+  return false;
+}
+
+static bool has_uuid128(const libtock_ble_scan_filter_t* filter, const uint8_t* uuid) {
+  for (size_t i = 0; i < filter->num_uuids128; i++) {
+    if (memcmp(filter->uuids128[i], uuid, 16) == 0) return true;
+  }
+  return false;
+}
+
+static bool has_company_id(const libtock_ble_scan_filter_t* filter, const uint8_t* id) {
+  for (size_t i = 0; i < filter->num_company_ids; i++) {
+    if (filter->company_ids[i] == read_le16(id)) return true;
+  }
+  return false;
+}
+
+bool libtock_ble_scan_filter_match(const libtock_ble_scan_filter_t* filter, const uint8_t* pdu, int len) {
+  if (pdu == NULL || len < ADV_PDU_MIN_SIZE || len > LIBTOCK_BLE_ADV_PDU_MAX_SIZE) return false;
+  if (filter == NULL) return true;
+
+  if (filter->num_addresses > 0) {
+    bool found = false;
+    for (size_t i = 0; i < filter->num_addresses && !found; i++) {
+      found = memcmp(filter->addresses[i], &pdu[2], LIBTOCK_BLE_ADDRESS_SIZE) == 0;
+    }
+    if (!found) return false;
+  }
+
+  bool uuid16_ok  = filter->num_uuids16 == 0;
+  bool uuid128_ok = filter->num_uuids128 == 0;
+  bool company_ok = filter->num_company_ids == 0;
+
+  // AdvData is a sequence of structures of a length byte, a type byte and
+  // `length - 1` bytes of data.
+  const uint8_t* p   = &pdu[ADV_PDU_MIN_SIZE];
+  const uint8_t* end = &pdu[len];
+  while (!(uuid16_ok && uuid128_ok && company_ok) && p + 2 <= end && p[0] != 0 && p + 1 + p[0] <= end) {
+    uint8_t type        = p[1];
+    const uint8_t* data = &p[2];
+    int data_len        = p[0] - 1;
+    p += 1 + p[0];
+
+    switch (type) {
+      case AD_UUID16_INCOMPLETE:
+      case AD_UUID16_COMPLETE:
+        for (int i = 0; i + 2 <= data_len && !uuid16_ok; i += 2) {
+          uuid16_ok = has_uuid16(filter, &data[i]);
+        }
+        break;
+      case AD_SERVICE_DATA_UUID16:
+        uuid16_ok = uuid16_ok || (data_len >= 2 && has_uuid16(filter, data));
+        break;
+      case AD_UUID128_INCOMPLETE:
+      case AD_UUID128_COMPLETE:
+        for (int i = 0; i + 16 <= data_len && !uuid128_ok; i += 16) {
+          uuid128_ok = has_uuid128(filter, &data[i]);
+        }
+        break;
+      case AD_SERVICE_DATA_UUID128:
+        uuid128_ok = uuid128_ok || (data_len >= 16 && has_uuid128(filter, data));
+        break;
+      case AD_MANUFACTURER_DATA:
+        company_ok = company_ok || (data_len >= 2 && has_company_id(filter, data));
+        break;
+    }
+  }
+  return uuid16_ok && uuid128_ok && company_ok;
+}
+
+static void ble_scan_upcall(int result, int len, __attribute__ ((unused)) int unused, void* opaque) {
+  libtock_ble_scanner_t* scanner      = (libtock_ble_scanner_t*) opaque;
+  libtock_ble_scan_packet_t* captured = &scanner->packets[scanner->kernel_packet];
+
+  if (result != RETURNCODE_SUCCESS || len < ADV_PDU_MIN_SIZE || len > LIBTOCK_BLE_ADV_PDU_MAX_SIZE) {
+    scanner->counters.errors++;
+    return;
+  }
+  scanner->counters.received++;
+
+  // Filter while the driver still holds the buffer, so that advertisements
+  // the app does not want cost no system calls.
+  if (!libtock_ble_scan_filter_match(scanner->filter, captured->pdu, len)) {
+    scanner->counters.filtered++;
+    return;
+  }
+  if (scanner->free_packets == 0) {
+    scanner->counters.dropped++;
+    return;
+  }
+
+  // Give the driver a free buffer in exchange for this one.
+  int next = __builtin_ctz(scanner->free_packets);
+  allow_rw_return_t allow_res = allow_readwrite(BLE_DRIVER_NUMBER, BLE_CFG_SCAN_BUF_ALLOWRW,
+                                                scanner->packets[next].pdu, LIBTOCK_BLE_ADV_PDU_MAX_SIZE);
+  if (!allow_res.success) {
+    scanner->counters.dropped++;
+    return;
+  }
+  scanner->free_packets &= ~(1u << next);
+  scanner->kernel_packet = next;
+
+  // The driver may have written another advertisement into the buffer since
+  // it was checked, so check again now that the app owns it, taking the
+  // length from the PDU as `len` may be for the earlier one. The advertisement
+  // was already counted as received, so if the buffer no longer holds a valid
+  // one it counts as dropped, not as an error.
+  int captured_len = adv_pdu_length(captured->pdu);
+  if (captured_len == 0) {
+    scanner->counters.dropped++;
+    libtock_ble_scan_release(scanner, captured);
+    return;
+  }
+  if (!libtock_ble_scan_filter_match(scanner->filter, captured->pdu, captured_len)) {
+    scanner->counters.filtered++;
+    libtock_ble_scan_release(scanner, captured);
+    return;
+  }
+
+  captured->len  = captured_len;
+  captured->rssi = LIBTOCK_BLE_RSSI_UNKNOWN;
+  if (libtock_alarm_command_read(&captured->timestamp) != RETURNCODE_SUCCESS) {
+    captured->timestamp = 0;
+  }
+  scanner->counters.matched++;
+  scanner->callback(captured, scanner->opaque);
+}
+
+returncode_t libtock_ble_scan_start(libtock_ble_scanner_t* scanner,
+                                    libtock_ble_scan_packet_t* packets, int num_packets,
+                                    const libtock_ble_scan_filter_t* filter,
+                                    libtock_ble_scan_callback callback, void* opaque) {
+  if (scanner == NULL || packets == NULL || callback == NULL) return RETURNCODE_EINVAL;
+  if (num_packets < 2 || num_packets > LIBTOCK_BLE_SCAN_MAX_PACKETS) return RETURNCODE_EINVAL;
+
+  memset(scanner, 0, sizeof(libtock_ble_scanner_t));
+  scanner->packets     = packets;
+  scanner->num_packets = num_packets;
+  scanner->filter      = filter;
+  scanner->callback    = callback;
+  scanner->opaque      = opaque;
+  // The first buffer goes to the driver.
+  scanner->kernel_packet = 0;
+  scanner->free_packets  = (num_packets == LIBTOCK_BLE_SCAN_MAX_PACKETS ? UINT32_MAX : (1u << num_packets) - 1) & ~1u;
+
+  subscribe_return_t sub_res = subscribe(BLE_DRIVER_NUMBER, BLE_SCAN_SUB, ble_scan_upcall, scanner);
+  if (!sub_res.success) return tock_status_to_returncode(sub_res.status);
+
+  allow_rw_return_t allow_res =
+    allow_readwrite(BLE_DRIVER_NUMBER, BLE_CFG_SCAN_BUF_ALLOWRW, packets[0].pdu, LIBTOCK_BLE_ADV_PDU_MAX_SIZE);
+  if (!allow_res.success) return tock_status_to_returncode(allow_res.status);
+
+  syscall_return_t res = command(BLE_DRIVER_NUMBER, BLE_SCAN_CMD, 1, 0);
+  return tock_command_return_novalue_to_returncode(res);
+}
+
+void libtock_ble_scan_release(libtock_ble_scanner_t* scanner, libtock_ble_scan_packet_t* packet) {
+  scanner->free_packets |= 1u << (packet - scanner->packets);
+}
+
+returncode_t libtock_ble_scan_stop(libtock_ble_scanner_t* scanner) {
+  syscall_return_t res = command(BLE_DRIVER_NUMBER, BLE_ADV_STOP_CMD, 1, 0);
+  int ret = tock_command_return_novalue_to_returncode(res);
+
+  // Take back the driver's buffer and stop upcalls.
+  allow_rw_return_t allow_res = allow_readwrite(BLE_DRIVER_NUMBER, BLE_CFG_SCAN_BUF_ALLOWRW, NULL, 0);
+  if (allow_res.success) {
+    scanner->free_packets |= 1u << scanner->kernel_packet;
+  }
+  subscribe_return_t sub_res = subscribe(BLE_DRIVER_NUMBER, BLE_SCAN_SUB, NULL, NULL);
+  if (ret == RETURNCODE_SUCCESS && !allow_res.success) ret = tock_status_to_returncode(allow_res.status);
+  if (ret == RETURNCODE_SUCCESS && !sub_res.success) ret = tock_status_to_returncode(sub_res.status);
+  return ret;
+}
+
 int ble_set_tx_power(TxPower_t power_level) {
   syscall_return_t res = command(BLE_DRIVER_NUMBER, BLE_CFG_TX_POWER_CMD, power_level, 0);
   return tock_command_return_novalue_to_returncode(res);
@@ -32,6 +32,16 @@ extern "C" {
 #define ADV_NONCONN_IND  0x02
 #define ADV_SCAN_IND  0x06
 
+#define LIBTOCK_BLE_ADDRESS_SIZE 6
+#define LIBTOCK_BLE_ADV_DATA_MAX_SIZE 31
+
+// Largest advertising PDU delivered by a scan: the 2-byte header, advertiser
+// address and AdvData.
+#define LIBTOCK_BLE_ADV_PDU_MAX_SIZE (2 + LIBTOCK_BLE_ADDRESS_SIZE + LIBTOCK_BLE_ADV_DATA_MAX_SIZE)
+
+// Signal strength of an advertisement that is not known.
+#define LIBTOCK_BLE_RSSI_UNKNOWN 127
+
 typedef enum {
   POSITIVE_10_DBM = 10,
   POSITIVE_9_DBM  = 9,
@@ -106,6 +116,108 @@ int ble_start_passive_scan(uint8_t* data, uint8_t len, subscribe_upcall callback
 // stop passive scanning
 int ble_stop_passive_scan(void);
 
+// Continuous scanning
+//
+// `libtock_ble_scan_start()` rotates several capture buffers so that
+// advertisements can be held and processed after the upcall that delivered
+// them. When an advertisement arrives, the library swaps a free buffer in for
+// the one the driver wrote to. It then checks the advertisement against a
+// filter and calls the app only for those that match. Matching buffers
+// belong to the app until it returns them with `libtock_ble_scan_release()`.
+// Buffers that do not match are reused at once. If the app holds every
+// buffer, new advertisements are dropped and counted.
+
+// A received advertisement.
+typedef struct {
+  // The advertising PDU: 2-byte header, advertiser address and AdvData.
+  uint8_t pdu[LIBTOCK_BLE_ADV_PDU_MAX_SIZE];
+  uint8_t len;
+  // Signal strength in dBm. The BLE driver does not report it yet, so this
+  // is `LIBTOCK_BLE_RSSI_UNKNOWN`.
+  int8_t rssi;
+  // Alarm counter when the library received the advertisement's upcall.
+  uint32_t timestamp;
+} libtock_ble_scan_packet_t;
+
+// Which advertisements to deliver. Each kind of criterion that has values
+// must match one of them; a filter with no values accepts everything.
+typedef struct {
+  // Advertiser addresses, in the byte order they are sent (least
+  // significant byte first).
+  const uint8_t (*addresses)[LIBTOCK_BLE_ADDRESS_SIZE];
+  size_t num_addresses;
+  // 16-bit service UUIDs, found in the service UUID lists and 16-bit service
+  // data of the AdvData.
+  const uint16_t* uuids16;
+  size_t num_uuids16;
+  // 128-bit service UUIDs, least significant byte first as sent, found in
+  // the service UUID lists and 128-bit service data.
+  const uint8_t (*uuids128)[16];
+  size_t num_uuids128;
+  // Company identifiers of manufacturer specific data.
+  const uint16_t* company_ids;
+  size_t num_company_ids;
+} libtock_ble_scan_filter_t;
+
+// Every received advertisement is counted exactly once as matched, filtered or
+// dropped, so `matched + filtered + dropped == received`. Errors are not
+// counted as received.
+typedef struct {
+  // Well-formed advertisements delivered by the driver.
+  uint32_t received;
+  // Of those, the ones passed to the app, and the ones rejected by the
+  // filter.
+  uint32_t matched;
+  uint32_t filtered;
+  // Matching advertisements lost because the app held every buffer, or
+  // because the driver overwrote them before the app could take the buffer.
+  uint32_t dropped;
+  // Failed receptions and malformed advertisements.
+  uint32_t errors;
+} libtock_ble_scan_counters_t;
+
+// Function signature for scan callbacks.
+//
+// - `packet`: A matching advertisement. The app owns it until it passes it
+//   to `libtock_ble_scan_release()`, and can do so after returning.
+// - `opaque`: The pointer passed to `libtock_ble_scan_start()`.
+typedef void (*libtock_ble_scan_callback)(libtock_ble_scan_packet_t* packet, void* opaque);
+
+#define LIBTOCK_BLE_SCAN_MAX_PACKETS 32
+
+typedef struct {
+  libtock_ble_scan_packet_t* packets;
+  int num_packets;
+  // Buffer the driver writes to, and a bit for each buffer free for it.
+  int kernel_packet;
+  uint32_t free_packets;
+  const libtock_ble_scan_filter_t* filter;
+  libtock_ble_scan_callback callback;
+  void* opaque;
+  libtock_ble_scan_counters_t counters;
+} libtock_ble_scanner_t;
+
+// Start passive scanning into `num_packets` buffers (2 to
+// `LIBTOCK_BLE_SCAN_MAX_PACKETS`). One buffer is always with the driver, so
+// the app can hold up to `num_packets - 1` advertisements at a time.
+//
+// `filter` may be NULL to deliver every advertisement. The scanner, packets
+// and filter must stay valid until `libtock_ble_scan_stop()`.
+returncode_t libtock_ble_scan_start(libtock_ble_scanner_t* scanner,
+                                    libtock_ble_scan_packet_t* packets, int num_packets,
+                                    const libtock_ble_scan_filter_t* filter,
+                                    libtock_ble_scan_callback callback, void* opaque);
+
+// Return a packet passed to the scan callback to the scanner.
+void libtock_ble_scan_release(libtock_ble_scanner_t* scanner, libtock_ble_scan_packet_t* packet);
+
+// Stop scanning and take back the buffer held by the driver.
+returncode_t libtock_ble_scan_stop(libtock_ble_scanner_t* scanner);
+
+// Whether an advertising PDU of `len` bytes passes `filter`. Does not make any
+// system calls.
+bool libtock_ble_scan_filter_match(const libtock_ble_scan_filter_t* filter, const uint8_t* pdu, int len);
+
 // configure tx_power
 //
 // power_level          - transmitting power in dBM of the radio
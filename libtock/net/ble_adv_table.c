@@ -0,0 +1,230 @@
+#include <string.h>
+
+#include "ble_adv_table.h"
+
+// Layout of an advertising PDU (Bluetooth Core Specification, Vol 6, Part B,
+// 2.3): a 2-byte header, the advertiser address, then AdvData.
+#define PDU_HEADER_SIZE 2
+#define PDU_TYPE_MASK   0x0f
+#define PDU_TXADD_MASK  0x40
+#define PDU_MIN_SIZE    (PDU_HEADER_SIZE + LIBTOCK_BLE_ADDRESS_SIZE)
+
+// Marks an empty slot and the ends of the device lists.
+#define NONE 0xffffu
+
+static uint32_t hash(const uint8_t* address, bool random_address) {
+  uint32_t lo = address[0] | (address[1] << 8) | (address[2] << 16) | ((uint32_t) address[3] << 24);
+  uint32_t hi = address[4] | (address[5] << 8) | ((uint32_t) random_address << 16);
+  uint32_t h  = (lo ^ (hi * 0x9e3779b1u)) * 0x85ebca6bu;
+  return h ^ (h >> 16);
+}
+
+static bool matches(const libtock_ble_adv_device_t* device, const uint8_t* address, bool random_address) {
+  return device->random_address == random_address &&
+         memcmp(device->address, address, LIBTOCK_BLE_ADDRESS_SIZE) == 0;
+}
+
+// Slot holding the device, or the empty slot where it would go.
+static uint16_t probe(const libtock_ble_adv_table_t* table, const uint8_t* address, bool random_address) {
+  uint16_t i = hash(address, random_address) & table->slot_mask;
+  while (table->slots[i] != NONE && !matches(&table->devices[table->slots[i]], address, random_address)) {
+    i = (i + 1) & table->slot_mask;
+  }
+  return i;
+}
+
+static void lru_unlink(libtock_ble_adv_table_t* table, libtock_ble_adv_device_t* device) {
+  if (device->older != NONE) {
+    table->devices[device->older].newer = device->newer;
+  } else {
+    table->oldest = device->newer;
+  }
+  if (device->newer != NONE) {
+    table->devices[device->newer].older = device->older;
+  } else {
+    table->newest = device->older;
+  }
+}
+
+static void lru_push_newest(libtock_ble_adv_table_t* table, uint16_t index) {
+  libtock_ble_adv_device_t* device = &table->devices[index];
+  device->older = table->newest;
+  device->newer = NONE;
+  if (table->newest != NONE) {
+    table->devices[table->newest].newer = index;
+  } else {
+    table->oldest = index;
+  }
+  table->newest = index;
+}
+
+// Empty a slot, moving later entries of its probe sequence back so that
+// lookups never need to skip deleted slots.
+static void slot_delete(libtock_ble_adv_table_t* table, uint16_t hole) {
+  uint16_t mask = table->slot_mask;
+  uint16_t i    = (hole + 1) & mask;
+  while (table->slots[i] != NONE) {
+    libtock_ble_adv_device_t* device = &table->devices[table->slots[i]];
+    uint16_t home = hash(device->address, device->random_address) & mask;
+    // Move the entry if its home slot is not between the hole and here.
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      table->slots[hole] = table->slots[i];
+      device->slot       = hole;
+      hole = i;
+    }
+    i = (i + 1) & mask;
+  }
+  table->slots[hole] = NONE;
+}
+
+returncode_t libtock_ble_adv_table_init(libtock_ble_adv_table_t* table,
+                                        libtock_ble_adv_device_t* devices, uint16_t capacity,
+                                        uint16_t* slots, uint16_t slot_count) {
+  if (capacity == 0 || capacity == NONE) return RETURNCODE_EINVAL;
+  if ((slot_count & (slot_count - 1)) != 0) return RETURNCODE_EINVAL;
+  if (slot_count < (uint32_t) capacity + capacity / 2) return RETURNCODE_EINVAL;
+
+  table->devices   = devices;
+  table->slots     = slots;
+  table->capacity  = capacity;
+  table->slot_mask = slot_count - 1;
+  libtock_ble_adv_table_clear(table);
+  return RETURNCODE_SUCCESS;
+}
+
+void libtock_ble_adv_table_clear(libtock_ble_adv_table_t* table) {
+  memset(table->slots, 0xff, ((size_t) table->slot_mask + 1) * sizeof(uint16_t));
+  // Unused entries are chained through `newer`.
+  for (uint16_t i = 0; i < table->capacity; i++) {
+    table->devices[i].newer = i + 1 < table->capacity ? (uint16_t) (i + 1) : NONE;
+  }
+  table->free      = 0;
+  table->count     = 0;
+  table->oldest    = NONE;
+  table->newest    = NONE;
+  table->updates   = 0;
+  table->invalid   = 0;
+  table->evictions = 0;
+}
+
+libtock_ble_adv_update_t libtock_ble_adv_table_update(libtock_ble_adv_table_t* table,
+                                                      const uint8_t* pdu, int len,
+                                                      int8_t rssi, uint32_t now,
+                                                      libtock_ble_adv_device_t** device_out) {
+  if (device_out != NULL) *device_out = NULL;
+
+  if (pdu == NULL || len < PDU_MIN_SIZE || len > LIBTOCK_BLE_ADV_PDU_MAX_SIZE) {
+    table->invalid++;
+    return LIBTOCK_BLE_ADV_INVALID;
+  }
+  const uint8_t* address = pdu + PDU_HEADER_SIZE;
+  const uint8_t* data    = address + LIBTOCK_BLE_ADDRESS_SIZE;
+  uint8_t data_len       = len - PDU_MIN_SIZE;
+  uint8_t pdu_type       = pdu[0] & PDU_TYPE_MASK;
+  bool random_address    = (pdu[0] & PDU_TXADD_MASK) != 0;
+
+  table->updates++;
+
+  libtock_ble_adv_update_t result;
+  libtock_ble_adv_device_t* device;
+  uint16_t slot = probe(table, address, random_address);
+  if (table->slots[slot] != NONE) {
+    uint16_t index = table->slots[slot];
+    device = &table->devices[index];
+    if (device->pdu_type == pdu_type && device->data_len == data_len &&
+        memcmp(device->data, data, data_len) == 0) {
+      result = LIBTOCK_BLE_ADV_SEEN;
+    } else {
+      result = LIBTOCK_BLE_ADV_CHANGED;
+    }
+    if (table->newest != index) {
+      lru_unlink(table, device);
+      lru_push_newest(table, index);
+    }
+  } else {
+    if (table->free == NONE) {
+      // Full: drop the device heard least recently.
+      libtock_ble_adv_table_remove(table, &table->devices[table->oldest]);
+      table->evictions++;
+      // Removing may have moved entries into the slot found above.
+      slot = probe(table, address, random_address);
+    }
+    uint16_t index = table->free;
+    device      = &table->devices[index];
+    table->free = device->newer;
+    table->count++;
+
+    table->slots[slot] = index;
+    device->slot       = slot;
+    memcpy(device->address, address, LIBTOCK_BLE_ADDRESS_SIZE);
+    device->random_address = random_address;
+    device->seen           = 0;
+    device->first_seen     = now;
+    device->rssi_count     = 0;
+    device->rssi_sum       = 0;
+    lru_push_newest(table, index);
+    result = LIBTOCK_BLE_ADV_NEW;
+  }
+
+  if (result != LIBTOCK_BLE_ADV_SEEN) {
+    device->pdu_type = pdu_type;
+    device->data_len = data_len;
+    memcpy(device->data, data, data_len);
+  }
+  device->seen++;
+  device->last_seen = now;
+  device->rssi_last = rssi;
+  if (rssi != LIBTOCK_BLE_RSSI_UNKNOWN) {
+    if (device->rssi_count == 0 || rssi < device->rssi_min) device->rssi_min = rssi;
+    if (device->rssi_count == 0 || rssi > device->rssi_max) device->rssi_max = rssi;
+    device->rssi_count++;
+    device->rssi_sum += rssi;
+  }
+
+  if (device_out != NULL) *device_out = device;
+  return result;
+}
+
+libtock_ble_adv_device_t* libtock_ble_adv_table_find(libtock_ble_adv_table_t* table,
+                                                     const uint8_t address[LIBTOCK_BLE_ADDRESS_SIZE],
+                                                     bool random_address) {
+  uint16_t slot = probe(table, address, random_address);
+  return table->slots[slot] != NONE ? &table->devices[table->slots[slot]] : NULL;
+}
+
+void libtock_ble_adv_table_remove(libtock_ble_adv_table_t* table, libtock_ble_adv_device_t* device) {
+  uint16_t index = device - table->devices;
+  slot_delete(table, device->slot);
+  lru_unlink(table, device);
+  device->newer = table->free;
+  table->free   = index;
+  table->count--;
+}
+
+int libtock_ble_adv_table_expire(libtock_ble_adv_table_t* table, uint32_t before) {
+  int removed = 0;
+  while (table->oldest != NONE) {
+    libtock_ble_adv_device_t* device = &table->devices[table->oldest];
+    if ((int32_t) (device->last_seen - before) >= 0) break;
+    libtock_ble_adv_table_remove(table, device);
+    removed++;
+  }
+  return removed;
+}
+
+libtock_ble_adv_device_t* libtock_ble_adv_table_newest(libtock_ble_adv_table_t* table) {
+  return table->newest != NONE ? &table->devices[table->newest] : NULL;
+}
+
+libtock_ble_adv_device_t* libtock_ble_adv_table_older(libtock_ble_adv_table_t* table,
+                                                      const libtock_ble_adv_device_t* device) {
+  return device->older != NONE ? &table->devices[device->older] : NULL;
+}
+
+int libtock_ble_adv_device_rssi_mean(const libtock_ble_adv_device_t* device) {
+  if (device->rssi_count == 0) return LIBTOCK_BLE_RSSI_UNKNOWN;
+  int64_t count = device->rssi_count;
+  int64_t sum   = device->rssi_sum;
+  // Round to nearest; the sum is negative for any realistic signal.
+  return (int) (sum >= 0 ? (sum + count / 2) / count : -((-sum + count / 2) / count));
+}
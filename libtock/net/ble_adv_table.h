@@ -0,0 +1,133 @@
+#pragma once
+
+// Table of the BLE devices heard by a scanner.
+//
+// Devices are keyed by advertiser address (and whether it is public or
+// random) in an open-addressing hash table, so recording an advertisement is
+// a hash lookup rather than a scan of every known device. For each device the
+// table keeps its latest advertisement and how often, when and how strongly
+// it was heard.
+//
+// All storage is provided by the caller and nothing is allocated, so
+// `libtock_ble_adv_table_update()` can be called directly from a scan upcall.
+// When the table is full, the device heard least recently is dropped to make
+// room for a new one.
+//
+// These functions do not make any system calls.
+
+#include "../tock.h"
+#include "ble.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  uint8_t address[LIBTOCK_BLE_ADDRESS_SIZE];
+  // True if the address is random (the TxAdd bit), false if public.
+  bool random_address;
+
+  // Latest advertisement: PDU type (`ADV_IND`, ...) and AdvData.
+  uint8_t pdu_type;
+  uint8_t data_len;
+  uint8_t data[LIBTOCK_BLE_ADV_DATA_MAX_SIZE];
+
+  // Advertisements received, and the times of the first and latest, as
+  // passed to `libtock_ble_adv_table_update()`.
+  uint32_t seen;
+  uint32_t first_seen;
+  uint32_t last_seen;
+
+  // Signal strength in dBm of the latest advertisement and over all of them,
+  // leaving out those with `LIBTOCK_BLE_RSSI_UNKNOWN`. `rssi_count` is 0 if
+  // none was known.
+  int8_t rssi_last;
+  int8_t rssi_min;
+  int8_t rssi_max;
+  uint32_t rssi_count;
+  int64_t rssi_sum;
+
+  // Used by the table.
+  uint16_t slot;
+  uint16_t older;
+  uint16_t newer;
+} libtock_ble_adv_device_t;
+
+typedef enum {
+  // The advertisement was malformed and was not recorded.
+  LIBTOCK_BLE_ADV_INVALID = 0,
+  // First advertisement from this device.
+  LIBTOCK_BLE_ADV_NEW,
+  // Known device with a different PDU type or AdvData than last time.
+  LIBTOCK_BLE_ADV_CHANGED,
+  // Known device repeating its last advertisement.
+  LIBTOCK_BLE_ADV_SEEN,
+} libtock_ble_adv_update_t;
+
+typedef struct {
+  libtock_ble_adv_device_t* devices;
+  uint16_t* slots;
+  uint16_t capacity;
+  uint16_t slot_mask;
+  uint16_t count;
+  uint16_t oldest;
+  uint16_t newest;
+  uint16_t free;
+
+  // Advertisements recorded, malformed ones rejected, and devices dropped to
+  // make room for new ones.
+  uint32_t updates;
+  uint32_t invalid;
+  uint32_t evictions;
+} libtock_ble_adv_table_t;
+
+// Set up an empty table for up to `capacity` devices.
+//
+// `devices` holds `capacity` entries. `slots` holds `slot_count` entries,
+// which must be a power of two and at least `capacity + capacity / 2`; twice
+// `capacity` keeps lookups short.
+returncode_t libtock_ble_adv_table_init(libtock_ble_adv_table_t* table,
+                                        libtock_ble_adv_device_t* devices, uint16_t capacity,
+                                        uint16_t* slots, uint16_t slot_count);
+
+// Remove all devices.
+void libtock_ble_adv_table_clear(libtock_ble_adv_table_t* table);
+
+// Record an advertising PDU as received by `ble_start_passive_scan()` or
+// `libtock_ble_scan_start()`: the 2-byte header, advertiser address and
+// AdvData, `len` bytes in total. `rssi` may be `LIBTOCK_BLE_RSSI_UNKNOWN`.
+// `now` is any timestamp the app uses, for example alarm ticks.
+//
+// If `device` is not NULL it is set to the device's entry, or NULL if the
+// advertisement was invalid. The entry stays valid until the device is
+// removed or evicted.
+libtock_ble_adv_update_t libtock_ble_adv_table_update(libtock_ble_adv_table_t* table,
+                                                      const uint8_t* pdu, int len,
+                                                      int8_t rssi, uint32_t now,
+                                                      libtock_ble_adv_device_t** device);
+
+// Find a device, or NULL.
+libtock_ble_adv_device_t* libtock_ble_adv_table_find(libtock_ble_adv_table_t* table,
+                                                     const uint8_t address[LIBTOCK_BLE_ADDRESS_SIZE],
+                                                     bool random_address);
+
+// Remove a device from the table.
+void libtock_ble_adv_table_remove(libtock_ble_adv_table_t* table, libtock_ble_adv_device_t* device);
+
+// Remove all devices last heard before `before`, comparing times as wrapping
+// 32-bit counters. Returns how many were removed.
+int libtock_ble_adv_table_expire(libtock_ble_adv_table_t* table, uint32_t before);
+
+// Devices from the most to the least recently heard: start with
+// `libtock_ble_adv_table_newest()` and call `libtock_ble_adv_table_older()`
+// until it returns NULL. The table must not be changed while iterating.
+libtock_ble_adv_device_t* libtock_ble_adv_table_newest(libtock_ble_adv_table_t* table);
+libtock_ble_adv_device_t* libtock_ble_adv_table_older(libtock_ble_adv_table_t* table,
+                                                      const libtock_ble_adv_device_t* device);
+
+// Mean signal strength in dBm, or `LIBTOCK_BLE_RSSI_UNKNOWN`.
+int libtock_ble_adv_device_rssi_mean(const libtock_ble_adv_device_t* device);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+// Table-driven software CRC.
+//
+// Computes the same algorithms as the CRC driver, for boards without one or
+// for buffers larger than the hardware unit accepts.
+//
+// By default each algorithm uses a 256 entry table (1 KiB for the CRC-32
+// variants, 512 bytes for CRC-16), and all three tables are linked whenever
+// the software CRC is used. Building libtock with
+// `LIBTOCK_CRC_SOFTWARE_TABLE_BITS` defined as 4 uses 16 entry tables instead,
+// which are about half as fast but only take 64 or 32 bytes.
+
+#include "crc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef LIBTOCK_CRC_SOFTWARE_TABLE_BITS
+#define LIBTOCK_CRC_SOFTWARE_TABLE_BITS 8
+#endif
+
+// Compute a CRC over `buflen` bytes of `buf` with `algorithm`, giving the
+// same result as `libtock_crc_compute()`.
+uint32_t libtock_crc_software_compute(const uint8_t* buf, size_t buflen, libtock_crc_alg_t algorithm);
+
+#ifdef __cplusplus
+}
+#endif
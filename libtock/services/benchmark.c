@@ -0,0 +1,142 @@
+#include <stdio.h>
+
+#include "../peripherals/syscalls/alarm_syscalls.h"
+#include "benchmark.h"
+
+static uint32_t alarm_clock_read(void) {
+  uint32_t ticks;
+  libtock_alarm_command_read(&ticks);
+  return ticks;
+}
+
+// The frequency is filled in on first use.
+static libtock_benchmark_clock_t alarm_clock = {
+  .name      = "alarm",
+  .read      = alarm_clock_read,
+  .frequency = 0,
+};
+
+#if defined(__riscv)
+static uint32_t rdcycle_read(void) {
+  uint32_t cycles;
+  __asm__ volatile ("rdcycle %0" : "=r" (cycles));
+  return cycles;
+}
+
+const libtock_benchmark_clock_t libtock_benchmark_clock_rdcycle = {
+  .name      = "rdcycle",
+  .read      = rdcycle_read,
+  .frequency = 0,
+};
+#endif
+
+static const libtock_benchmark_clock_t* active_clock = &alarm_clock;
+
+static uint32_t samples[LIBTOCK_BENCHMARK_MAX_SAMPLES];
+
+void libtock_benchmark_set_clock(const libtock_benchmark_clock_t* new_clock) {
+  active_clock = new_clock;
+}
+
+static const libtock_benchmark_clock_t* benchmark_clock(void) {
+  if (active_clock == &alarm_clock && alarm_clock.frequency == 0) {
+    libtock_alarm_command_get_frequency(&alarm_clock.frequency);
+  }
+  return active_clock;
+}
+
+// Time `inner` calls of the benchmark body, in clock ticks.
+static uint32_t time_sample(const libtock_benchmark_t* benchmark, uint32_t inner) {
+  libtock_benchmark_fn body = benchmark->body;
+  void* context = benchmark->context;
+
+  uint32_t start = active_clock->read();
+  for (uint32_t i = 0; i < inner; i++) {
+    body(context);
+  }
+  return active_clock->read() - start;
+}
+
+// Convert a sample to time per call.
+static uint32_t per_call(uint32_t ticks, uint32_t inner, uint32_t frequency) {
+  uint64_t value;
+  if (frequency != 0) {
+    value = ((uint64_t) ticks * 1000000000u / frequency + inner / 2) / inner;
+  } else {
+    value = ((uint64_t) ticks + inner / 2) / inner;
+  }
+  return value > UINT32_MAX ? UINT32_MAX : (uint32_t) value;
+}
+
+static void sort_samples(uint32_t* values, uint32_t count) {
+  for (uint32_t i = 1; i < count; i++) {
+    uint32_t value = values[i];
+    uint32_t j     = i;
+    while (j > 0 && values[j - 1] > value) {
+      values[j] = values[j - 1];
+      j--;
+    }
+    values[j] = value;
+  }
+}
+
+returncode_t libtock_benchmark_run(const libtock_benchmark_t* benchmark, libtock_benchmark_result_t* result) {
+  if (benchmark->body == NULL) return RETURNCODE_EINVAL;
+
+  const libtock_benchmark_clock_t* c = benchmark_clock();
+  uint32_t warmup = benchmark->warmup != 0 ? benchmark->warmup : LIBTOCK_BENCHMARK_DEFAULT_WARMUP;
+  uint32_t repeat = benchmark->repeat != 0 ? benchmark->repeat : LIBTOCK_BENCHMARK_DEFAULT_REPEAT;
+  if (repeat > LIBTOCK_BENCHMARK_MAX_SAMPLES) repeat = LIBTOCK_BENCHMARK_MAX_SAMPLES;
+
+  if (benchmark->setup != NULL) benchmark->setup(benchmark->context);
+
+  // Calibration doubles as warmup.
+  uint32_t inner = benchmark->inner;
+  if (inner == 0) {
+    inner = 1;
+    while (inner < LIBTOCK_BENCHMARK_MAX_INNER &&
+           time_sample(benchmark, inner) < LIBTOCK_BENCHMARK_MIN_SAMPLE_TICKS) {
+      inner *= 2;
+    }
+  }
+
+  for (uint32_t i = 0; i < warmup; i++) {
+    time_sample(benchmark, inner);
+  }
+  for (uint32_t i = 0; i < repeat; i++) {
+    samples[i] = time_sample(benchmark, inner);
+  }
+
+  if (benchmark->teardown != NULL) benchmark->teardown(benchmark->context);
+
+  sort_samples(samples, repeat);
+  uint32_t p99 = (repeat * 99 + 99) / 100 - 1;
+
+  result->samples = repeat;
+  result->inner   = inner;
+  result->min     = per_call(samples[0], inner, c->frequency);
+  result->median  = per_call(samples[repeat / 2], inner, c->frequency);
+  result->p99     = per_call(samples[p99], inner, c->frequency);
+  result->max     = per_call(samples[repeat - 1], inner, c->frequency);
+  return RETURNCODE_SUCCESS;
+}
+
+void libtock_benchmark_run_all(const libtock_benchmark_t* benchmarks, uint32_t count) {
+  const libtock_benchmark_clock_t* c = benchmark_clock();
+  const char* unit = c->frequency != 0 ? "ns" : "ticks";
+
+  printf("{\"clock\":\"%s\",\"hz\":%lu}\n", c->name, (unsigned long) c->frequency);
+
+  for (uint32_t i = 0; i < count; i++) {
+    libtock_benchmark_result_t result;
+    returncode_t ret = libtock_benchmark_run(&benchmarks[i], &result);
+    if (ret != RETURNCODE_SUCCESS) {
+      printf("{\"bench\":\"%s\",\"error\":\"%s\"}\n", benchmarks[i].name, tock_strrcode(ret));
+      continue;
+    }
+    printf("{\"bench\":\"%s\",\"n\":%lu,\"inner\":%lu,\"min\":%lu,\"median\":%lu,\"p99\":%lu,\"max\":%lu,\"unit\":\"%s\"}\n",
+           benchmarks[i].name, (unsigned long) result.samples, (unsigned long) result.inner,
+           (unsigned long) result.min, (unsigned long) result.median, (unsigned long) result.p99,
+           (unsigned long) result.max, unit);
+  }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+// Microbenchmark harness.
+//
+// A benchmark is a function run many times in a loop. Each sample times
+// `inner` calls of the function, so that even a coarse clock such as a 32 kHz
+// alarm counter measures operations that take a few microseconds. The first
+// `warmup` samples are thrown away, the next `repeat` samples are kept, and the
+// minimum, median, 99th percentile and maximum time per call are reported.
+//
+// Results are printed as one JSON object per line:
+//
+//   {"clock":"alarm","hz":32768}
+//   {"bench":"command_noop","n":32,"inner":512,"min":3576,"median":3633,"p99":4012,"max":4012,"unit":"ns"}
+//
+// Typical use:
+//
+//   static void bench_yield_no_wait(void* ctx) {
+//     yield_no_wait();
+//   }
+//
+//   libtock_benchmark_t benchmarks[] = {
+//     LIBTOCK_BENCHMARK(yield_no_wait, bench_yield_no_wait, NULL),
+//   };
+//   libtock_benchmark_run_all(benchmarks, 1);
+//
+// Benchmark functions may block (for example by calling libtock-sync
+// drivers), in which case the time includes waiting for the kernel.
+
+#include "../tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Most samples kept per benchmark.
+#ifndef LIBTOCK_BENCHMARK_MAX_SAMPLES
+#define LIBTOCK_BENCHMARK_MAX_SAMPLES 64
+#endif
+
+// Defaults used when a benchmark leaves `warmup` or `repeat` at 0.
+#define LIBTOCK_BENCHMARK_DEFAULT_WARMUP 2
+#define LIBTOCK_BENCHMARK_DEFAULT_REPEAT 32
+
+// When calibrating `inner`, keep doubling it until a sample takes at least
+// this many clock ticks.
+#define LIBTOCK_BENCHMARK_MIN_SAMPLE_TICKS 256
+
+// Upper limit for a calibrated `inner`.
+#define LIBTOCK_BENCHMARK_MAX_INNER 65536
+
+// Function being benchmarked.
+typedef void (*libtock_benchmark_fn)(void* context);
+
+typedef struct {
+  const char* name;
+  // Called once before the benchmark runs, and once after. Either may be NULL.
+  libtock_benchmark_fn setup;
+  libtock_benchmark_fn teardown;
+  libtock_benchmark_fn body;
+  void* context;
+  // Samples discarded before measuring, and samples kept.
+  uint32_t warmup;
+  uint32_t repeat;
+  // Calls to `body` per sample, or 0 to pick one automatically.
+  uint32_t inner;
+} libtock_benchmark_t;
+
+#define LIBTOCK_BENCHMARK(NAME, BODY, CONTEXT) { \
+          .name    = #NAME,                       \
+          .body    = BODY,                        \
+          .context = CONTEXT,                     \
+}
+
+typedef struct {
+  // Samples kept and calls per sample.
+  uint32_t samples;
+  uint32_t inner;
+  // Time per call, in nanoseconds, or in clock ticks if the clock frequency
+  // is unknown.
+  uint32_t min;
+  uint32_t median;
+  uint32_t p99;
+  uint32_t max;
+} libtock_benchmark_result_t;
+
+// A time source. `frequency` is in Hz, or 0 if unknown (results are then in
+// ticks).
+typedef struct {
+  const char* name;
+  uint32_t (*read)(void);
+  uint32_t frequency;
+} libtock_benchmark_clock_t;
+
+// Use `clock` for all following benchmarks. The default is the alarm counter.
+void libtock_benchmark_set_clock(const libtock_benchmark_clock_t* clock);
+
+#if defined(__riscv)
+// The RISC-V `cycle` CSR. Only usable if the kernel lets userspace read it,
+// otherwise reading it faults.
+extern const libtock_benchmark_clock_t libtock_benchmark_clock_rdcycle;
+#endif
+
+// Run one benchmark and store its statistics in `result`.
+returncode_t libtock_benchmark_run(const libtock_benchmark_t* benchmark, libtock_benchmark_result_t* result);
+
+// Run `count` benchmarks and print each result as it completes.
+void libtock_benchmark_run_all(const libtock_benchmark_t* benchmarks, uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,268 @@
+#include <string.h>
+
+#include "ipc_channel.h"
+
+#define IPC_CHANNEL_MAGIC 0x43435049 // "IPCC"
+
+// Per-message length header.
+#define IPC_CHANNEL_FRAME_HEADER 4
+
+// Channels with clients, indexed by the order clients first notify us.
+static libtock_ipc_channel_t service_channels[LIBTOCK_IPC_CHANNEL_MAX_CLIENTS];
+static libtock_ipc_channel_callback service_cb = NULL;
+
+// The two processes only share memory, and either can be preempted at any
+// point. Indices are read and written with atomics so the compiler neither
+// caches nor reorders them around the ring contents.
+static inline uint32_t index_load(uint32_t* index) {
+  return __atomic_load_n(index, __ATOMIC_SEQ_CST);
+}
+
+static inline void index_store(uint32_t* index, uint32_t value) {
+  __atomic_store_n(index, value, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t frame_len(size_t len) {
+  return IPC_CHANNEL_FRAME_HEADER + ((len + 3) & ~3u);
+}
+
+static void ring_write(uint8_t* ring, uint32_t size, uint32_t pos, const void* data, size_t len) {
+  uint32_t offset = pos & (size - 1);
+  size_t first    = size - offset;
+  if (first > len) first = len;
+
+  memcpy(&ring[offset], data, first);
+  memcpy(ring, (const uint8_t*) data + first, len - first);
+}
+
+static void ring_read(const uint8_t* ring, uint32_t size, uint32_t pos, void* data, size_t len) {
+  uint32_t offset = pos & (size - 1);
+  size_t first    = size - offset;
+  if (first > len) first = len;
+
+  memcpy(data, &ring[offset], first);
+  memcpy((uint8_t*) data + first, ring, len - first);
+}
+
+static returncode_t channel_notify(libtock_ipc_channel_t* channel) {
+  int ret = channel->is_service ? ipc_notify_client(channel->peer) : ipc_notify_service(channel->peer);
+  if (ret == RETURNCODE_SUCCESS) {
+    channel->stats.notifications++;
+  }
+  return ret;
+}
+
+// Find the ring this side writes to, or reads from.
+static void channel_tx(libtock_ipc_channel_t* channel, uint8_t** ring, uint32_t** head, uint32_t** tail) {
+  libtock_ipc_channel_header_t* header = channel->header;
+  if (channel->is_service) {
+    *ring = channel->s2c_ring;
+    *head = &header->s2c_head;
+    *tail = &header->s2c_tail;
+  } else {
+    *ring = channel->c2s_ring;
+    *head = &header->c2s_head;
+    *tail = &header->c2s_tail;
+  }
+}
+
+static void channel_rx(libtock_ipc_channel_t* channel, uint8_t** ring, uint32_t** head, uint32_t** tail) {
+  libtock_ipc_channel_header_t* header = channel->header;
+  if (channel->is_service) {
+    *ring = channel->c2s_ring;
+    *head = &header->c2s_head;
+    *tail = &header->c2s_tail;
+  } else {
+    *ring = channel->s2c_ring;
+    *head = &header->s2c_head;
+    *tail = &header->s2c_tail;
+  }
+}
+
+static void channel_attach(libtock_ipc_channel_t* channel, void* buffer, uint32_t ring_size) {
+  channel->header   = (libtock_ipc_channel_header_t*) buffer;
+  channel->c2s_ring = (uint8_t*) buffer + LIBTOCK_IPC_CHANNEL_HEADER_LEN;
+  channel->s2c_ring = channel->c2s_ring + ring_size;
+}
+
+static void channel_client_upcall(__attribute__ ((unused)) int pid,
+                                  __attribute__ ((unused)) int len,
+                                  __attribute__ ((unused)) int buf,
+                                  void*                        ud) {
+  libtock_ipc_channel_t* channel = (libtock_ipc_channel_t*) ud;
+  if (channel->cb != NULL) {
+    channel->cb(channel);
+  }
+}
+
+static void channel_service_upcall(int pid, int len, int buf, __attribute__ ((unused)) void* ud) {
+  if (buf == 0 || len < LIBTOCK_IPC_CHANNEL_HEADER_LEN) return;
+
+  libtock_ipc_channel_header_t* header = (libtock_ipc_channel_header_t*) buf;
+  uint32_t ring_size = header->ring_size;
+  if (header->magic != IPC_CHANNEL_MAGIC ||
+      ring_size == 0 || (ring_size & (ring_size - 1)) != 0 ||
+      LIBTOCK_IPC_CHANNEL_HEADER_LEN + 2 * ring_size > (uint32_t) len) {
+    return;
+  }
+
+  libtock_ipc_channel_t* channel = NULL;
+  libtock_ipc_channel_t* unused  = NULL;
+  for (int i = 0; i < LIBTOCK_IPC_CHANNEL_MAX_CLIENTS; i++) {
+    // A restarted client gets a new process id but may share the same buffer,
+    // so it takes over the slot of its earlier instance.
+    if (service_channels[i].header != NULL &&
+        (service_channels[i].peer == (size_t) pid || service_channels[i].header == header)) {
+      channel = &service_channels[i];
+      if (channel->peer != (size_t) pid) {
+        channel->peer = pid;
+        memset(&channel->stats, 0, sizeof(channel->stats));
+      }
+      break;
+    }
+    if (service_channels[i].header == NULL && unused == NULL) {
+      unused = &service_channels[i];
+    }
+  }
+
+  if (channel == NULL) {
+    if (unused == NULL) return;
+    channel = unused;
+    memset(channel, 0, sizeof(libtock_ipc_channel_t));
+    channel->peer       = pid;
+    channel->is_service = true;
+    channel->cb         = service_cb;
+  }
+  // A restarted client may share a different buffer.
+  channel_attach(channel, header, ring_size);
+
+  if (channel->cb != NULL) {
+    channel->cb(channel);
+  }
+}
+
+returncode_t libtock_ipc_channel_client_init(libtock_ipc_channel_t* channel, const char* pkg_name, void* buffer,
+                                             size_t len, libtock_ipc_channel_callback cb) {
+  if (len < 2 * LIBTOCK_IPC_CHANNEL_HEADER_LEN || (len & (len - 1)) != 0) return RETURNCODE_ESIZE;
+  if (((uintptr_t) buffer & (len - 1)) != 0) return RETURNCODE_EINVAL;
+
+  size_t svc_id;
+  int ret = ipc_discover(pkg_name, &svc_id);
+  if (ret < 0) return ret;
+
+  // Rings are powers of two, and two rings of `len / 2` leave no room for the
+  // header, so each ring is `len / 4`.
+  uint32_t ring_size = len / 4;
+
+  memset(channel, 0, sizeof(libtock_ipc_channel_t));
+  channel->peer       = svc_id;
+  channel->is_service = false;
+  channel->cb         = cb;
+  channel_attach(channel, buffer, ring_size);
+
+  libtock_ipc_channel_header_t* header = channel->header;
+  memset(header, 0, LIBTOCK_IPC_CHANNEL_HEADER_LEN);
+  header->ring_size = ring_size;
+  // Write the magic last so the service never sees a partial header.
+  index_store(&header->magic, IPC_CHANNEL_MAGIC);
+
+  ret = ipc_register_client_callback(svc_id, channel_client_upcall, channel);
+  if (ret < 0) return ret;
+
+  ret = ipc_share(svc_id, buffer, len);
+  return ret;
+}
+
+returncode_t libtock_ipc_channel_service_init(const char* pkg_name, libtock_ipc_channel_callback cb) {
+  memset(service_channels, 0, sizeof(service_channels));
+  service_cb = cb;
+
+  int ret = ipc_register_service_callback(pkg_name, channel_service_upcall, NULL);
+  return ret;
+}
+
+void libtock_ipc_channel_service_close(libtock_ipc_channel_t* channel) {
+  memset(channel, 0, sizeof(libtock_ipc_channel_t));
+}
+
+returncode_t libtock_ipc_channel_send(libtock_ipc_channel_t* channel, const void* data, size_t len) {
+  uint32_t ring_size = channel->header->ring_size;
+  uint32_t needed    = frame_len(len);
+  if (needed > ring_size) return RETURNCODE_ESIZE;
+
+  uint8_t* ring;
+  uint32_t* head_p;
+  uint32_t* tail_p;
+  channel_tx(channel, &ring, &head_p, &tail_p);
+
+  // Only this side writes `head`, so it can be read without racing.
+  uint32_t head = *head_p;
+  if (head - index_load(tail_p) + needed > ring_size) {
+    channel->stats.full++;
+    return RETURNCODE_ENOMEM;
+  }
+
+  uint32_t frame = len;
+  ring_write(ring, ring_size, head, &frame, IPC_CHANNEL_FRAME_HEADER);
+  ring_write(ring, ring_size, head + IPC_CHANNEL_FRAME_HEADER, data, len);
+  index_store(head_p, head + needed);
+  channel->stats.sent++;
+
+  // Check for empty only after publishing the message. The receiver stores
+  // `tail` before checking `head` for more messages, so either it sees this
+  // message or we see that it caught up with `head` and went to sleep.
+  if (index_load(tail_p) == head) {
+    return channel_notify(channel);
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_ipc_channel_peek_size(libtock_ipc_channel_t* channel, size_t* len) {
+  uint8_t* ring;
+  uint32_t* head_p;
+  uint32_t* tail_p;
+  channel_rx(channel, &ring, &head_p, &tail_p);
+
+  uint32_t tail = *tail_p;
+  if (index_load(head_p) == tail) return RETURNCODE_EALREADY;
+
+  uint32_t frame;
+  ring_read(ring, channel->header->ring_size, tail, &frame, IPC_CHANNEL_FRAME_HEADER);
+  *len = frame;
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_ipc_channel_receive(libtock_ipc_channel_t* channel, void* data, size_t max_len, size_t* len) {
+  size_t frame;
+  returncode_t ret = libtock_ipc_channel_peek_size(channel, &frame);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  uint32_t ring_size = channel->header->ring_size;
+  if (frame_len(frame) > ring_size) {
+    // The peer corrupted the ring. Drop everything queued.
+    uint8_t* ring;
+    uint32_t* head_p;
+    uint32_t* tail_p;
+    channel_rx(channel, &ring, &head_p, &tail_p);
+    index_store(tail_p, index_load(head_p));
+    return RETURNCODE_FAIL;
+  }
+  if (frame > max_len) return RETURNCODE_ESIZE;
+
+  uint8_t* ring;
+  uint32_t* head_p;
+  uint32_t* tail_p;
+  channel_rx(channel, &ring, &head_p, &tail_p);
+
+  uint32_t tail = *tail_p;
+  ring_read(ring, ring_size, tail + IPC_CHANNEL_FRAME_HEADER, data, frame);
+  index_store(tail_p, tail + frame_len(frame));
+  channel->stats.received++;
+
+  *len = frame;
+  return RETURNCODE_SUCCESS;
+}
+
+size_t libtock_ipc_channel_max_message(libtock_ipc_channel_t* channel) {
+  return channel->header->ring_size - IPC_CHANNEL_FRAME_HEADER;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+// Message channels over IPC shared memory.
+//
+// `ipc_share` lets a client share one buffer with a service, and
+// `ipc_notify_service`/`ipc_notify_client` act as doorbells. This library lays
+// out two single-producer, single-consumer ring buffers in the shared buffer,
+// one in each direction, and frames messages in them. Many messages can be
+// queued per doorbell: the sender only notifies the receiver when a ring goes
+// from empty to non-empty, and the receiver drains all queued messages when it
+// is notified.
+//
+// Shared buffer layout:
+//
+//   +--------+---------------------------+---------------------------+
+//   | header | client -> service ring    | service -> client ring    |
+//   +--------+---------------------------+---------------------------+
+//
+// Each ring holds `ring_size` bytes, a quarter of the buffer: the buffer and
+// the rings are powers of two, and two rings of half the buffer would leave no
+// room for the header. Every message uses a 4 byte length header and is padded
+// to a multiple of 4 bytes.
+//
+// Client:
+//
+//   static uint8_t buf[512] __attribute__((aligned(512)));
+//   static libtock_ipc_channel_t channel;
+//
+//   libtock_ipc_channel_client_init(&channel, "org.tockos.example", buf, sizeof(buf), on_reply);
+//   libtock_ipc_channel_send(&channel, msg, msg_len);
+//
+// Service:
+//
+//   static void on_message(libtock_ipc_channel_t* channel) {
+//     while (libtock_ipc_channel_receive(channel, msg, sizeof(msg), &len) == RETURNCODE_SUCCESS) {
+//       ...
+//     }
+//   }
+//
+//   libtock_ipc_channel_service_init("org.tockos.example", on_message);
+
+#include "../kernel/ipc.h"
+#include "../tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of clients a service can have channels with.
+#ifndef LIBTOCK_IPC_CHANNEL_MAX_CLIENTS
+#define LIBTOCK_IPC_CHANNEL_MAX_CLIENTS 4
+#endif
+
+// Size of the header at the start of the shared buffer.
+#define LIBTOCK_IPC_CHANNEL_HEADER_LEN 32
+
+typedef struct {
+  uint32_t magic;
+  uint32_t ring_size;
+  // Free-running byte counters. `head` is written by the producer and `tail`
+  // by the consumer of each ring.
+  uint32_t c2s_head;
+  uint32_t c2s_tail;
+  uint32_t s2c_head;
+  uint32_t s2c_tail;
+  uint32_t reserved[2];
+} libtock_ipc_channel_header_t;
+
+typedef struct {
+  // Messages sent and received on this channel.
+  uint32_t sent;
+  uint32_t received;
+  // Notifications sent to the peer. Ideally much smaller than `sent`.
+  uint32_t notifications;
+  // Messages that could not be sent because the ring was full.
+  uint32_t full;
+} libtock_ipc_channel_stats_t;
+
+struct libtock_ipc_channel;
+
+// Function signature for message notifications.
+//
+// Called when the peer notifies that new messages are available. The callback
+// should receive all queued messages, as the peer will not notify again until
+// the ring has been drained.
+typedef void (*libtock_ipc_channel_callback)(struct libtock_ipc_channel*);
+
+typedef struct libtock_ipc_channel {
+  libtock_ipc_channel_header_t* header;
+  uint8_t* c2s_ring;
+  uint8_t* s2c_ring;
+  // Process id of the peer.
+  size_t peer;
+  bool is_service;
+  libtock_ipc_channel_callback cb;
+  libtock_ipc_channel_stats_t stats;
+} libtock_ipc_channel_t;
+
+// Set up a channel to the service named `pkg_name` using `buffer` as shared
+// memory.
+//
+// `buffer` must meet the requirements of `ipc_share`: `len` a power of two and
+// `buffer` aligned to `len`. `cb` is called when the service sends messages.
+returncode_t libtock_ipc_channel_client_init(libtock_ipc_channel_t* channel, const char* pkg_name, void* buffer,
+                                             size_t len, libtock_ipc_channel_callback cb);
+
+// Register this process as the service `pkg_name` and accept channels from
+// clients. `cb` is called with the client's channel whenever a client sends
+// messages.
+returncode_t libtock_ipc_channel_service_init(const char* pkg_name, libtock_ipc_channel_callback cb);
+
+// Forget a client's channel, so that its slot can be used by another client.
+//
+// Call from the service when the client has exited or misbehaves. There are
+// `LIBTOCK_IPC_CHANNEL_MAX_CLIENTS` slots, and a client keeps its slot until
+// it is closed or a restarted instance of it shares the same buffer again.
+void libtock_ipc_channel_service_close(libtock_ipc_channel_t* channel);
+
+// Queue a message for the peer.
+//
+// Returns `RETURNCODE_ENOMEM` if the ring does not currently have space for
+// the message, and `RETURNCODE_ESIZE` if the message can never fit.
+returncode_t libtock_ipc_channel_send(libtock_ipc_channel_t* channel, const void* data, size_t len);
+
+// Receive the next message from the peer into `data`.
+//
+// Returns `RETURNCODE_EALREADY` if there are no more messages, and
+// `RETURNCODE_ESIZE` if the next message is larger than `max_len` (the message
+// stays queued, see `libtock_ipc_channel_peek_size`).
+returncode_t libtock_ipc_channel_receive(libtock_ipc_channel_t* channel, void* data, size_t max_len, size_t* len);
+
+// Get the size of the next message without receiving it.
+//
+// Returns `RETURNCODE_EALREADY` if there are no messages.
+returncode_t libtock_ipc_channel_peek_size(libtock_ipc_channel_t* channel, size_t* len);
+
+// Largest message that can be sent on this channel.
+size_t libtock_ipc_channel_max_message(libtock_ipc_channel_t* channel);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,248 @@
+#include <stdarg.h>
+#include <string.h>
+
+#include "../interface/console.h"
+#include "log.h"
+
+// Start of the `.tock_log` section, defined by the linker script. Only used to
+// turn entry addresses into indices; the section is never read on the device.
+extern const uint8_t _tock_log[];
+
+// Record ID 0 reports dropped records; call site IDs start at 1.
+#define DROPPED_ID 0
+
+// A COBS-encoded record is at most one byte longer per 254 bytes, plus the
+// zero delimiter.
+#define MAX_FRAME (LIBTOCK_LOG_MAX_RECORD + LIBTOCK_LOG_MAX_RECORD / 254 + 2)
+
+static struct {
+  uint8_t* buffer;
+  uint32_t size;
+  libtock_log_output_t output;
+  uint32_t level;
+  // Oldest buffered byte, and bytes buffered (including those being sent).
+  uint32_t tail;
+  uint32_t count;
+  // Bytes handed to the console by the current transfer, 0 if idle.
+  uint32_t in_flight;
+  // Records dropped since the last dropped-records record was written.
+  uint32_t unreported;
+  libtock_log_stats_t stats;
+} logger;
+
+static void start_transfer(void);
+
+static void write_done(__attribute__ ((unused)) returncode_t ret, __attribute__ ((unused)) uint32_t length) {
+  logger.tail      = (logger.tail + logger.in_flight) % logger.size;
+  logger.count    -= logger.in_flight;
+  logger.in_flight = 0;
+  start_transfer();
+}
+
+// Send as much of the buffer as is contiguous, if the console is idle.
+static void start_transfer(void) {
+  if (logger.output != LIBTOCK_LOG_OUTPUT_CONSOLE || logger.in_flight != 0 || logger.count == 0) return;
+
+  uint32_t len = logger.count;
+  if (len > logger.size - logger.tail) {
+    len = logger.size - logger.tail;
+  }
+
+  if (libtock_console_write(logger.buffer + logger.tail, len, write_done) == RETURNCODE_SUCCESS) {
+    logger.in_flight = len;
+  }
+}
+
+static uint8_t* put_varint(uint8_t* p, uint64_t value) {
+  while (value >= 0x80) {
+    *p++    = (uint8_t) value | 0x80;
+    value >>= 7;
+  }
+  *p++ = (uint8_t) value;
+  return p;
+}
+
+static uint64_t zigzag(int64_t value) {
+  return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+// Encode the arguments described by `types` after `p`. Returns NULL if the
+// record would not fit in `end`.
+static uint8_t* put_args(uint8_t* p, uint8_t* end, uint32_t types, va_list args) {
+  for (; types != 0; types >>= 4) {
+    // Every fixed-size value fits in 10 bytes.
+    if (end - p < 10) return NULL;
+
+    switch (types & 0xf) {
+      case LIBTOCK_LOG_ARG_I32:
+        p = put_varint(p, zigzag(va_arg(args, int)));
+        break;
+      case LIBTOCK_LOG_ARG_U32:
+        p = put_varint(p, va_arg(args, unsigned int));
+        break;
+      case LIBTOCK_LOG_ARG_I64:
+        p = put_varint(p, zigzag(va_arg(args, long long)));
+        break;
+      case LIBTOCK_LOG_ARG_U64:
+        p = put_varint(p, va_arg(args, unsigned long long));
+        break;
+      case LIBTOCK_LOG_ARG_F32: {
+        float value = (float) va_arg(args, double);
+        memcpy(p, &value, sizeof(value));
+        p += sizeof(value);
+        break;
+      }
+      case LIBTOCK_LOG_ARG_F64: {
+        double value = va_arg(args, double);
+        memcpy(p, &value, sizeof(value));
+        p += sizeof(value);
+        break;
+      }
+      case LIBTOCK_LOG_ARG_STR: {
+        const char* str = va_arg(args, const char*);
+        if (str == NULL) str = "(null)";
+        // Truncate to whatever space is left after the length.
+        size_t len = strnlen(str, (size_t) (end - p) - 2);
+        p = put_varint(p, len);
+        memcpy(p, str, len);
+        p += len;
+        break;
+      }
+      case LIBTOCK_LOG_ARG_PTR:
+        p = put_varint(p, (uintptr_t) va_arg(args, void*));
+        break;
+      default:
+        return NULL;
+    }
+  }
+  return p;
+}
+
+static void ring_put(const uint8_t* data, uint32_t len) {
+  uint32_t head  = (logger.tail + logger.count) % logger.size;
+  uint32_t first = logger.size - head;
+  if (first > len) {
+    first = len;
+  }
+  memcpy(logger.buffer + head, data, first);
+  memcpy(logger.buffer, data + first, len - first);
+  logger.count += len;
+}
+
+// COBS-encode `record` and append it to the buffer, followed by a zero byte.
+// Returns false, and writes nothing, if it does not fit.
+static bool put_frame(const uint8_t* record, uint32_t len) {
+  uint8_t frame[MAX_FRAME];
+  uint8_t* code_at = frame;
+  uint8_t* out     = frame + 1;
+  uint8_t code     = 1;
+
+  for (uint32_t i = 0; i < len; i++) {
+    if (record[i] == 0) {
+      *code_at = code;
+      code_at  = out++;
+      code     = 1;
+      continue;
+    }
+    *out++ = record[i];
+    if (++code == 0xff) {
+      *code_at = code;
+      code_at  = out++;
+      code     = 1;
+    }
+  }
+  *code_at = code;
+  *out++   = 0;
+
+  uint32_t frame_len = out - frame;
+  if (frame_len > logger.size - logger.count) return false;
+
+  ring_put(frame, frame_len);
+  logger.stats.bytes += frame_len;
+  if (logger.count > logger.stats.high_water) {
+    logger.stats.high_water = logger.count;
+  }
+  return true;
+}
+
+returncode_t libtock_log_init(uint8_t* buffer, uint32_t size, libtock_log_output_t output) {
+  if (buffer == NULL || size < MAX_FRAME) return RETURNCODE_EINVAL;
+  if (logger.in_flight != 0) return RETURNCODE_EBUSY;
+
+  logger.buffer     = buffer;
+  logger.size       = size;
+  logger.output     = output;
+  logger.tail       = 0;
+  logger.count      = 0;
+  logger.unreported = 0;
+  return RETURNCODE_SUCCESS;
+}
+
+void libtock_log_set_level(uint32_t level) {
+  logger.level = level;
+}
+
+void libtock_log_write(const void* entry, uint32_t level, uint32_t types, ...) {
+  if (logger.buffer == NULL || level < logger.level) return;
+
+  uint8_t record[LIBTOCK_LOG_MAX_RECORD];
+  uint8_t* end = record + sizeof(record);
+  uint8_t* p;
+
+  if (logger.unreported != 0) {
+    p = put_varint(record, DROPPED_ID);
+    p = put_varint(p, logger.unreported);
+    if (!put_frame(record, p - record)) {
+      logger.unreported++;
+      logger.stats.dropped++;
+      return;
+    }
+    logger.unreported = 0;
+  }
+
+  uint32_t id = ((const uint8_t*) entry - _tock_log) / 4 + 1;
+  p = put_varint(record, id);
+
+  va_list args;
+  va_start(args, types);
+  p = put_args(p, end, types, args);
+  va_end(args);
+
+  if (p == NULL || !put_frame(record, p - record)) {
+    logger.unreported++;
+    logger.stats.dropped++;
+    return;
+  }
+  logger.stats.records++;
+
+  start_transfer();
+}
+
+uint32_t libtock_log_pending(void) {
+  return logger.count;
+}
+
+bool libtock_log_sending(void) {
+  return logger.in_flight != 0;
+}
+
+uint32_t libtock_log_peek(const uint8_t** data) {
+  uint32_t len = logger.count;
+  if (len > logger.size - logger.tail) {
+    len = logger.size - logger.tail;
+  }
+  *data = logger.buffer + logger.tail;
+  return len;
+}
+
+void libtock_log_consume(uint32_t length) {
+  if (length > logger.count) {
+    length = logger.count;
+  }
+  logger.tail   = (logger.tail + length) % logger.size;
+  logger.count -= length;
+}
+
+void libtock_log_get_stats(libtock_log_stats_t* stats) {
+  *stats = logger.stats;
+}
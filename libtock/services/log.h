@@ -0,0 +1,196 @@
+#pragma once
+
+// Binary logging with deferred formatting.
+//
+// `printf` spends most of its time formatting text, and most of the bytes it
+// sends are the fixed parts of the format string. This logger does neither on
+// the device. Each `libtock_log_*` call site stores its format string, level
+// and source location in the `.tock_log` section of the app's ELF file, which
+// is not part of the TBF and takes no flash. At run time only the index of
+// that entry and the raw argument values are written, as a compact binary
+// record, into a ring buffer supplied by the app. The host tool
+// `tools/tock_log/tock_log_decode.py` reads the strings back out of the ELF and
+// turns records into text.
+//
+// Typical use:
+//
+//   static uint8_t log_buffer[512];
+//
+//   libtock_log_init(log_buffer, sizeof(log_buffer), LIBTOCK_LOG_OUTPUT_CONSOLE);
+//   libtock_log_info("sample %d from sensor %s: %u mV", i, name, mv);
+//
+// The format string must be a string literal. Supported argument types are
+// integers up to 64 bits, `float`/`double`, C strings and pointers, with at
+// most `LIBTOCK_LOG_MAX_ARGS` arguments. Argument types are taken from the C
+// types of the arguments, not from the format string, and the host formats
+// each one with the matching conversion from the format string.
+//
+// Records are COBS-encoded and terminated by a zero byte, so the decoder can
+// find record boundaries in a stream that was joined mid-record or interleaved
+// with other console output. When the ring buffer is full new records are
+// dropped, and the number dropped is reported in a record of its own once
+// there is space again.
+//
+// With `LIBTOCK_LOG_OUTPUT_CONSOLE` the buffer is sent with asynchronous
+// console writes that complete while the app yields. Apps should not also
+// write to the console with `printf` while a log transfer is in progress, as
+// the console only has one write in flight per process. With
+// `LIBTOCK_LOG_OUTPUT_MANUAL` nothing is sent automatically and the app drains
+// the buffer with `libtock_log_peek` and `libtock_log_consume`, for example to
+// store it in flash (see `libtock-sync/services/log.h`).
+//
+// The logging macros are only available from C.
+
+#include "../tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LIBTOCK_LOG_LEVEL_TRACE 0
+#define LIBTOCK_LOG_LEVEL_DEBUG 1
+#define LIBTOCK_LOG_LEVEL_INFO  2
+#define LIBTOCK_LOG_LEVEL_WARN  3
+#define LIBTOCK_LOG_LEVEL_ERROR 4
+
+// Call sites below this level are removed at compile time.
+#ifndef LIBTOCK_LOG_MIN_LEVEL
+#define LIBTOCK_LOG_MIN_LEVEL LIBTOCK_LOG_LEVEL_TRACE
+#endif
+
+// Largest record before COBS encoding. Longer string arguments are truncated.
+#ifndef LIBTOCK_LOG_MAX_RECORD
+#define LIBTOCK_LOG_MAX_RECORD 64
+#endif
+
+#define LIBTOCK_LOG_MAX_ARGS 7
+
+typedef enum {
+  // Send records to the console as they are written.
+  LIBTOCK_LOG_OUTPUT_CONSOLE,
+  // Keep records in the buffer until the app consumes them.
+  LIBTOCK_LOG_OUTPUT_MANUAL,
+} libtock_log_output_t;
+
+typedef struct {
+  // Records written to the buffer.
+  uint32_t records;
+  // Records dropped because the buffer was full.
+  uint32_t dropped;
+  // Encoded bytes written to the buffer.
+  uint32_t bytes;
+  // Most bytes waiting in the buffer at once.
+  uint32_t high_water;
+} libtock_log_stats_t;
+
+// Start logging into `buffer`, which must remain valid while logging is used.
+returncode_t libtock_log_init(uint8_t* buffer, uint32_t size, libtock_log_output_t output);
+
+// Ignore records below `level` at run time.
+void libtock_log_set_level(uint32_t level);
+
+// Bytes waiting in the buffer, including any being sent to the console.
+uint32_t libtock_log_pending(void);
+
+// Whether a console transfer is in progress.
+bool libtock_log_sending(void);
+
+// Point `data` at the oldest buffered bytes that are contiguous in memory and
+// return how many there are. Only for `LIBTOCK_LOG_OUTPUT_MANUAL`.
+uint32_t libtock_log_peek(const uint8_t** data);
+
+// Remove `length` bytes returned by `libtock_log_peek` from the buffer.
+void libtock_log_consume(uint32_t length);
+
+void libtock_log_get_stats(libtock_log_stats_t* stats);
+
+// Argument type tags, packed four bits per argument by the logging macros.
+#define LIBTOCK_LOG_ARG_I32 1
+#define LIBTOCK_LOG_ARG_U32 2
+#define LIBTOCK_LOG_ARG_I64 3
+#define LIBTOCK_LOG_ARG_U64 4
+#define LIBTOCK_LOG_ARG_F32 5
+#define LIBTOCK_LOG_ARG_F64 6
+#define LIBTOCK_LOG_ARG_STR 7
+#define LIBTOCK_LOG_ARG_PTR 8
+
+// Entry stored in `.tock_log` for each call site. `text` holds the source
+// location and the format string, each terminated by a NUL.
+#define LIBTOCK_LOG_ENTRY(TEXT) \
+        struct {                \
+          uint32_t types;       \
+          uint32_t level;       \
+          char text[sizeof(TEXT)]; \
+        }
+
+// Write one record. Called by the logging macros.
+void libtock_log_write(const void* entry, uint32_t level, uint32_t types, ...);
+
+#ifndef __cplusplus
+
+#define LIBTOCK_LOG_ARG_TYPE(X) _Generic((X),                                         \
+                                         _Bool: LIBTOCK_LOG_ARG_U32,                  \
+                                         char: LIBTOCK_LOG_ARG_I32,                   \
+                                         signed char: LIBTOCK_LOG_ARG_I32,            \
+                                         unsigned char: LIBTOCK_LOG_ARG_U32,          \
+                                         short: LIBTOCK_LOG_ARG_I32,                  \
+                                         unsigned short: LIBTOCK_LOG_ARG_U32,         \
+                                         int: LIBTOCK_LOG_ARG_I32,                    \
+                                         unsigned int: LIBTOCK_LOG_ARG_U32,           \
+                                         long: sizeof(long) == 8 ? LIBTOCK_LOG_ARG_I64 \
+                                                                 : LIBTOCK_LOG_ARG_I32, \
+                                         unsigned long: sizeof(long) == 8 ? LIBTOCK_LOG_ARG_U64 \
+                                                                          : LIBTOCK_LOG_ARG_U32, \
+                                         long long: LIBTOCK_LOG_ARG_I64,              \
+                                         unsigned long long: LIBTOCK_LOG_ARG_U64,     \
+                                         float: LIBTOCK_LOG_ARG_F32,                  \
+                                         double: LIBTOCK_LOG_ARG_F64,                 \
+                                         char*: LIBTOCK_LOG_ARG_STR,                  \
+                                         const char*: LIBTOCK_LOG_ARG_STR,            \
+                                         default: LIBTOCK_LOG_ARG_PTR)
+
+#define _LIBTOCK_LOG_T(I, X) ((uint32_t) LIBTOCK_LOG_ARG_TYPE(X) << (4 * (I)))
+#define _LIBTOCK_LOG_TYPES_0() 0
+#define _LIBTOCK_LOG_TYPES_1(A) _LIBTOCK_LOG_T(0, A)
+#define _LIBTOCK_LOG_TYPES_2(A, B) _LIBTOCK_LOG_TYPES_1(A) | _LIBTOCK_LOG_T(1, B)
+#define _LIBTOCK_LOG_TYPES_3(A, B, C) _LIBTOCK_LOG_TYPES_2(A, B) | _LIBTOCK_LOG_T(2, C)
+#define _LIBTOCK_LOG_TYPES_4(A, B, C, D) _LIBTOCK_LOG_TYPES_3(A, B, C) | _LIBTOCK_LOG_T(3, D)
+#define _LIBTOCK_LOG_TYPES_5(A, B, C, D, E) _LIBTOCK_LOG_TYPES_4(A, B, C, D) | _LIBTOCK_LOG_T(4, E)
+#define _LIBTOCK_LOG_TYPES_6(A, B, C, D, E, F) _LIBTOCK_LOG_TYPES_5(A, B, C, D, E) | _LIBTOCK_LOG_T(5, F)
+#define _LIBTOCK_LOG_TYPES_7(A, B, C, D, E, F, G) _LIBTOCK_LOG_TYPES_6(A, B, C, D, E, F) | _LIBTOCK_LOG_T(6, G)
+
+#define _LIBTOCK_LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, N, ...) N
+#define _LIBTOCK_LOG_NARGS(...) _LIBTOCK_LOG_NARGS_(_, ## __VA_ARGS__, 7, 6, 5, 4, 3, 2, 1, 0)
+#define _LIBTOCK_LOG_CAT_(A, B) A ## B
+#define _LIBTOCK_LOG_CAT(A, B) _LIBTOCK_LOG_CAT_(A, B)
+
+// Packed type tags of the arguments. Arguments are not evaluated.
+#define LIBTOCK_LOG_TYPES(...) \
+        (_LIBTOCK_LOG_CAT(_LIBTOCK_LOG_TYPES_, _LIBTOCK_LOG_NARGS(__VA_ARGS__))(__VA_ARGS__))
+
+#define _LIBTOCK_LOG_STR_(X) #X
+#define _LIBTOCK_LOG_STR(X) _LIBTOCK_LOG_STR_(X)
+#define _LIBTOCK_LOG_TEXT(FMT) __FILE__ ":" _LIBTOCK_LOG_STR(__LINE__) "\0" FMT
+
+#define libtock_log(LEVEL, FMT, ...) do {                                                           \
+          if ((LEVEL) >= LIBTOCK_LOG_MIN_LEVEL) {                                                   \
+            static const LIBTOCK_LOG_ENTRY(_LIBTOCK_LOG_TEXT(FMT)) _libtock_log_entry         \
+            __attribute__ ((section(".tock_log"), aligned(4), used)) = {                            \
+              LIBTOCK_LOG_TYPES(__VA_ARGS__), (LEVEL), _LIBTOCK_LOG_TEXT(FMT)                       \
+            };                                                                                      \
+            _Static_assert(_LIBTOCK_LOG_NARGS(__VA_ARGS__) <= LIBTOCK_LOG_MAX_ARGS, "too many log arguments"); \
+            libtock_log_write(&_libtock_log_entry, (LEVEL), LIBTOCK_LOG_TYPES(__VA_ARGS__), ## __VA_ARGS__);  \
+          }                                                                                         \
+} while (0)
+
+#define libtock_log_trace(FMT, ...) libtock_log(LIBTOCK_LOG_LEVEL_TRACE, FMT, ## __VA_ARGS__)
+#define libtock_log_debug(FMT, ...) libtock_log(LIBTOCK_LOG_LEVEL_DEBUG, FMT, ## __VA_ARGS__)
+#define libtock_log_info(FMT, ...)  libtock_log(LIBTOCK_LOG_LEVEL_INFO, FMT, ## __VA_ARGS__)
+#define libtock_log_warn(FMT, ...)  libtock_log(LIBTOCK_LOG_LEVEL_WARN, FMT, ## __VA_ARGS__)
+#define libtock_log_error(FMT, ...) libtock_log(LIBTOCK_LOG_LEVEL_ERROR, FMT, ## __VA_ARGS__)
+
+#endif // __cplusplus
+
+#ifdef __cplusplus
+}
+#endif
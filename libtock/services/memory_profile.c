@@ -0,0 +1,91 @@
+#include <stdio.h>
+
+#include "../stack_pointer.h"
+
+#include "memory_profile.h"
+
+// Bytes below the stack pointer left unpainted by
+// `libtock_memory_profile_reset_stack`, for the frames of the calls it makes.
+#define PAINT_MARGIN 64
+
+// Deepest stack pointer seen by `libtock_memory_profile_sample`.
+static uint32_t* lowest_sample;
+
+// Top of the stack painted by `libtock_memory_profile_reset_stack`, or NULL.
+static uint32_t* paint_limit;
+
+// First word from the bottom of the stack up to `limit` that lost its paint.
+static uint32_t* lowest_unpainted(uint32_t* bottom, uint32_t* limit) {
+  uint32_t* p = bottom;
+  while (p < limit && *p == LIBTOCK_STACK_PAINT) {
+    p++;
+  }
+  return p;
+}
+
+void libtock_memory_profile_sample(void) {
+  uint32_t* sp = libtock_stack_pointer();
+  if (lowest_sample == NULL || sp < lowest_sample) {
+    lowest_sample = sp;
+  }
+}
+
+void libtock_memory_profile_get(libtock_memory_profile_t* profile) {
+  libtock_memory_layout_t layout;
+  libtock_memory_layout(&layout);
+
+  libtock_memory_profile_sample();
+  bool painted = libtock_crt0_paint_stack || paint_limit != NULL;
+
+  profile->stack_size         = (uint32_t) (layout.stack_top - layout.stack_bottom) * sizeof(uint32_t);
+  profile->stack_sampled_only = !painted;
+
+  uint32_t* lowest = lowest_sample;
+  if (painted) {
+    // Everything below the first word that lost its paint was never used.
+    lowest = lowest_unpainted(layout.stack_bottom, lowest);
+  }
+  profile->stack_used = (uint32_t) (layout.stack_top - lowest) * sizeof(uint32_t);
+
+  uintptr_t heap_start = (uintptr_t) layout.heap_start;
+  uintptr_t brk        = (uintptr_t) memop(1, 0).data;
+  uintptr_t high_water = (uintptr_t) libtock_heap_high_water();
+  if (high_water < brk) {
+    high_water = brk;
+  }
+  profile->heap_used       = brk - heap_start;
+  profile->heap_high_water = high_water - heap_start;
+
+  uintptr_t grant_start = (uintptr_t) tock_app_grant_begins_at();
+  profile->unused = grant_start > brk ? grant_start - brk : 0;
+}
+
+void libtock_memory_profile_reset_stack(void) {
+  libtock_memory_layout_t layout;
+  libtock_memory_layout(&layout);
+
+  uint32_t* limit = libtock_stack_pointer() - PAINT_MARGIN / sizeof(uint32_t);
+  for (uint32_t* p = layout.stack_bottom; p < limit; p++) {
+    *p = LIBTOCK_STACK_PAINT;
+  }
+  paint_limit   = limit;
+  lowest_sample = NULL;
+}
+
+uint32_t libtock_memory_profile_stack_used_since_reset(void) {
+  if (paint_limit == NULL) return 0;
+
+  libtock_memory_layout_t layout;
+  libtock_memory_layout(&layout);
+  return (uint32_t) (paint_limit - lowest_unpainted(layout.stack_bottom, paint_limit)) * sizeof(uint32_t);
+}
+
+void libtock_memory_profile_print(void) {
+  libtock_memory_profile_t profile;
+  libtock_memory_profile_get(&profile);
+  printf("{\"stack_size\":%lu,\"stack_used\":%lu%s,\"heap_used\":%lu,\"heap_high_water\":%lu,\"unused\":%lu}\n",
+         (unsigned long) profile.stack_size, (unsigned long) profile.stack_used,
+         profile.stack_sampled_only ? ",\"stack_sampled_only\":true" : "",
+         (unsigned long) profile.heap_used, (unsigned long) profile.heap_high_water,
+         (unsigned long) profile.unused);
+}
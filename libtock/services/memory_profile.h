@@ -0,0 +1,64 @@
+#pragma once
+
+// Stack and heap high-water marks.
+//
+// To measure the stack, the app asks crt0 to paint it before `main`:
+//
+//   const bool libtock_crt0_paint_stack = true;
+//
+// The deepest stack use is then found by looking for the lowest word that no
+// longer holds the paint. Without painting, only the depths seen by
+// `libtock_memory_profile_sample` are known.
+//
+// The heap high-water mark is the highest break set through `sbrk`, which is
+// what `malloc` uses to grow the heap.
+//
+// The results tell how far `STACK_SIZE` and `APP_HEAP_SIZE` can be reduced.
+// They only cover the code paths the app has run so far, so measure after
+// exercising it fully and leave some margin.
+
+#include "../tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  // Bytes reserved for the stack, and the most used.
+  uint32_t stack_size;
+  uint32_t stack_used;
+  // True if the stack was not painted, so `stack_used` is only the deepest
+  // sampled use.
+  bool stack_sampled_only;
+  // Bytes between the start of the heap and the break, now and at most.
+  uint32_t heap_used;
+  uint32_t heap_high_water;
+  // Bytes between the break and the kernel's grant region, which the heap can
+  // still grow into.
+  uint32_t unused;
+} libtock_memory_profile_t;
+
+// Record the current stack depth. Useful without stack painting, for example
+// at the start of deeply nested upcalls.
+void libtock_memory_profile_sample(void);
+
+// Measure the stack and heap.
+void libtock_memory_profile_get(libtock_memory_profile_t* profile);
+
+// Paint the unused stack below the caller again, whether or not crt0 painted
+// it, and forget the depths seen so far. Later measurements then only cover
+// what runs from here on, for example a single test.
+void libtock_memory_profile_reset_stack(void);
+
+// Bytes of stack used below the caller of the last
+// `libtock_memory_profile_reset_stack`, or 0 if it was never called.
+uint32_t libtock_memory_profile_stack_used_since_reset(void);
+
+// Measure the stack and heap and print the results as a JSON object:
+//
+//   {"stack_size":2048,"stack_used":612,"heap_used":1024,"heap_high_water":3072,"unused":10240}
+void libtock_memory_profile_print(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,199 @@
+#include <string.h>
+
+#include "../display/syscalls/screen_syscalls.h"
+#include "alarm.h"
+#include "screen_flush.h"
+
+typedef struct {
+  uint8_t* buffer;
+  uint16_t x;
+  uint16_t y;
+  uint16_t width;
+  uint16_t height;
+  size_t length;
+  bool end_of_frame;
+} flush_region_t;
+
+static struct {
+  uint8_t* buffers[2];
+  size_t len;
+  libtock_screen_flush_callback cb;
+
+  // The region currently being transferred, and the one queued behind it.
+  flush_region_t current;
+  bool current_valid;
+  flush_region_t pending;
+  bool pending_valid;
+
+  // Buffer that was submitted last.
+  uint8_t* last_submitted;
+
+  libtock_screen_flush_stats_t stats;
+  uint32_t stats_start;
+} flush;
+
+static void flush_start_next(void);
+
+static void flush_finish(returncode_t ret) {
+  uint8_t* buffer = flush.current.buffer;
+
+  if (ret == RETURNCODE_SUCCESS) {
+    flush.stats.regions++;
+    flush.stats.bytes += flush.current.length;
+    if (flush.current.end_of_frame) {
+      flush.stats.frames++;
+    }
+  }
+  flush.current_valid = false;
+
+  // Every transfer ends here, whether the write finished or failed, so take
+  // the buffer back from the kernel.
+  libtock_screen_set_readonly_allow(NULL, 0);
+
+  // Start the queued transfer before handing the buffer back, so the screen
+  // is kept busy while the caller renders.
+  flush_start_next();
+
+  if (flush.cb != NULL) {
+    flush.cb(ret, buffer);
+  }
+}
+
+static void flush_write_done(returncode_t ret) {
+  flush_finish(ret);
+}
+
+static void flush_set_frame_done(returncode_t ret) {
+  if (ret == RETURNCODE_SUCCESS) {
+    ret = libtock_screen_write(flush.current.buffer, flush.len, flush.current.length, flush_write_done);
+  }
+  if (ret != RETURNCODE_SUCCESS) {
+    flush_finish(ret);
+  }
+}
+
+static returncode_t flush_start_current(void) {
+  return libtock_screen_set_frame(flush.current.x, flush.current.y, flush.current.width, flush.current.height,
+                                  flush_set_frame_done);
+}
+
+static void flush_start_next(void) {
+  if (flush.current_valid || !flush.pending_valid) return;
+
+  flush.current       = flush.pending;
+  flush.current_valid = true;
+  flush.pending_valid = false;
+
+  returncode_t ret = flush_start_current();
+  if (ret != RETURNCODE_SUCCESS) {
+    flush_finish(ret);
+  }
+}
+
+returncode_t libtock_screen_flush_init(uint8_t* buffer_a, uint8_t* buffer_b, size_t len,
+                                       libtock_screen_flush_callback cb) {
+  if (buffer_a == NULL || len == 0) return RETURNCODE_EINVAL;
+  if (libtock_screen_flush_busy()) return RETURNCODE_EBUSY;
+
+  memset(&flush, 0, sizeof(flush));
+  flush.buffers[0] = buffer_a;
+  flush.buffers[1] = buffer_b;
+  flush.len        = len;
+  flush.cb         = cb;
+
+  libtock_screen_flush_reset_stats();
+  return RETURNCODE_SUCCESS;
+}
+
+uint8_t* libtock_screen_flush_back_buffer(void) {
+  if (flush.buffers[1] == NULL || flush.last_submitted == flush.buffers[1]) {
+    return flush.buffers[0];
+  }
+  return flush.buffers[1];
+}
+
+bool libtock_screen_flush_buffer_busy(const uint8_t* buffer) {
+  return (flush.current_valid && flush.current.buffer == buffer) ||
+         (flush.pending_valid && flush.pending.buffer == buffer);
+}
+
+bool libtock_screen_flush_busy(void) {
+  return flush.current_valid || flush.pending_valid;
+}
+
+returncode_t libtock_screen_flush_submit(uint8_t* buffer, uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+                                         size_t length, bool end_of_frame) {
+  if (length > flush.len) return RETURNCODE_ESIZE;
+  if (libtock_screen_flush_buffer_busy(buffer) || flush.pending_valid) return RETURNCODE_EBUSY;
+
+  flush_region_t region = {
+    .buffer       = buffer,
+    .x            = x,
+    .y            = y,
+    .width        = width,
+    .height       = height,
+    .length       = length,
+    .end_of_frame = end_of_frame,
+  };
+  flush.last_submitted = buffer;
+
+  if (flush.current_valid) {
+    // Queue behind the transfer in progress.
+    flush.pending       = region;
+    flush.pending_valid = true;
+    flush.stats.overlapped++;
+    return RETURNCODE_SUCCESS;
+  }
+
+  flush.current       = region;
+  flush.current_valid = true;
+
+  returncode_t ret = flush_start_current();
+  if (ret != RETURNCODE_SUCCESS) {
+    flush.current_valid = false;
+  }
+  return ret;
+}
+
+void libtock_screen_flush_dirty_rows(const uint8_t* previous, const uint8_t* next, size_t row_bytes, size_t rows,
+                                     size_t* first, size_t* count) {
+  size_t start = 0;
+  size_t end   = rows;
+
+  while (start < end && memcmp(previous + start * row_bytes, next + start * row_bytes, row_bytes) == 0) {
+    start++;
+  }
+  while (end > start && memcmp(previous + (end - 1) * row_bytes, next + (end - 1) * row_bytes, row_bytes) == 0) {
+    end--;
+  }
+
+  *first = start;
+  *count = end - start;
+}
+
+void libtock_screen_flush_get_stats(libtock_screen_flush_stats_t* stats) {
+  uint32_t now;
+  libtock_alarm_command_read(&now);
+
+  *stats = flush.stats;
+  stats->elapsed_ticks = now - flush.stats_start;
+}
+
+void libtock_screen_flush_reset_stats(void) {
+  memset(&flush.stats, 0, sizeof(flush.stats));
+  libtock_alarm_command_read(&flush.stats_start);
+}
+
+uint32_t libtock_screen_flush_fps_x100(void) {
+  libtock_screen_flush_stats_t stats;
+  libtock_screen_flush_get_stats(&stats);
+
+  uint32_t ms = libtock_alarm_ticks_to_ms(stats.elapsed_ticks);
+  if (ms == 0) return 0;
+  return (uint32_t) ((uint64_t) stats.frames * 100 * 1000 / ms);
+}
+
+uint32_t libtock_screen_flush_bytes_per_frame(void) {
+  if (flush.stats.frames == 0) return 0;
+  return flush.stats.bytes / flush.stats.frames;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+// Double-buffered screen flushing.
+//
+// The screen driver can only transfer one buffer at a time, and a synchronous
+// `libtocksync_screen_write()` stalls the app until the transfer completes.
+// This service lets a renderer (e.g. LVGL or u8g2) draw into one buffer while
+// the other is being sent to the screen.
+//
+// The expected use looks something like:
+//
+//   libtock_screen_flush_init(buffer_a, buffer_b, len, flush_done);
+//
+//   for (;;) {
+//     uint8_t* buf = libtock_screen_flush_back_buffer();
+//     // Wait until `buf` is no longer being transferred, then render into it.
+//     libtocksync_screen_flush_wait_buffer(buf);
+//     render(buf);
+//     libtock_screen_flush_submit(buf, x, y, w, h, bytes, true);
+//   }
+//
+// At most one region per buffer can be outstanding: one being transferred and
+// one queued behind it. There is only one screen driver, so there is only one
+// flush engine per app. The engine owns the screen upcall while a transfer is
+// outstanding; wait for it to finish before calling other screen functions.
+
+#include "../display/screen.h"
+#include "../tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Function signature for a completed transfer.
+//
+// - `arg1` (`returncode_t`): Status of the transfer.
+// - `arg2` (`uint8_t*`): The buffer that was transferred, which the caller now
+//   owns again.
+typedef void (*libtock_screen_flush_callback)(returncode_t, uint8_t*);
+
+typedef struct {
+  // Number of regions transferred.
+  uint32_t regions;
+  // Number of complete frames transferred (regions submitted with
+  // `end_of_frame` set).
+  uint32_t frames;
+  // Number of pixel data bytes transferred.
+  uint32_t bytes;
+  // Number of regions submitted while the other buffer was still transferring,
+  // i.e. where rendering overlapped a transfer.
+  uint32_t overlapped;
+  // Alarm ticks since the statistics were last reset.
+  uint32_t elapsed_ticks;
+} libtock_screen_flush_stats_t;
+
+// Set up the flush engine with two buffers of `len` bytes each.
+//
+// `buffer_b` may be NULL, in which case the engine works single-buffered.
+// `cb` is called every time a submitted region has been written to the screen.
+returncode_t libtock_screen_flush_init(uint8_t* buffer_a, uint8_t* buffer_b, size_t len,
+                                       libtock_screen_flush_callback cb);
+
+// Get the buffer that should be rendered into next.
+//
+// This is the buffer that was not submitted last. It may still be in flight;
+// callers must wait for it to be released before writing to it.
+uint8_t* libtock_screen_flush_back_buffer(void);
+
+// Check if `buffer` is owned by the flush engine (being transferred or queued).
+bool libtock_screen_flush_buffer_busy(const uint8_t* buffer);
+
+// Check if any transfer is in progress or queued.
+bool libtock_screen_flush_busy(void);
+
+// Queue the region of `buffer` covering `width`x`height` pixels at (`x`, `y`)
+// for transfer to the screen. `length` is the number of bytes of pixel data.
+//
+// If no transfer is in progress the transfer starts immediately, otherwise it
+// starts when the previous one finishes. Set `end_of_frame` on the last region
+// of a frame so the frame rate can be measured.
+//
+// Returns `RETURNCODE_EBUSY` if `buffer` is already owned by the engine.
+returncode_t libtock_screen_flush_submit(uint8_t* buffer, uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+                                         size_t length, bool end_of_frame);
+
+// Find the range of rows that differ between `previous` and `next`.
+//
+// Both buffers hold `rows` rows of `row_bytes` bytes each. On return `first` is
+// the index of the first row that differs and `count` is the number of rows up
+// to and including the last row that differs. `count` is 0 if the buffers are
+// identical.
+void libtock_screen_flush_dirty_rows(const uint8_t* previous, const uint8_t* next, size_t row_bytes, size_t rows,
+                                     size_t* first, size_t* count);
+
+// Get the flush statistics.
+void libtock_screen_flush_get_stats(libtock_screen_flush_stats_t* stats);
+
+// Reset the flush statistics and start a new measurement interval.
+void libtock_screen_flush_reset_stats(void);
+
+// Frames per second since the statistics were reset, times 100.
+uint32_t libtock_screen_flush_fps_x100(void);
+
+// Average number of bytes transferred per frame.
+uint32_t libtock_screen_flush_bytes_per_frame(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,197 @@
+#include <string.h>
+
+#include "../display/syscalls/text_screen_syscalls.h"
+#include "alarm.h"
+#include "text_screen_frame.h"
+
+// The text screen driver has a single upcall, so only one frame can be
+// committing at a time.
+static libtock_text_screen_frame_t* active_frame = NULL;
+
+static returncode_t frame_run_next(libtock_text_screen_frame_t* frame);
+
+static bool frame_add_op(libtock_text_screen_frame_t* frame, uint8_t type, uint8_t col, uint8_t row, uint8_t len) {
+  if (frame->num_ops >= LIBTOCK_TEXT_SCREEN_FRAME_MAX_OPS) return false;
+
+  libtock_text_screen_frame_op_t* op = &frame->ops[frame->num_ops++];
+  op->type = type;
+  op->col  = col;
+  op->row  = row;
+  op->len  = len;
+  return true;
+}
+
+// Build the operation list turning `shown` into `desired`. Returns false if it
+// does not fit in the operation list.
+static bool frame_build_ops(libtock_text_screen_frame_t* frame, uint8_t merge_gap) {
+  frame->num_ops = 0;
+
+  // Until the screen has been cleared once we don't know what is on it.
+  if (!frame->shown_valid) {
+    if (!frame_add_op(frame, LIBTOCK_TEXT_SCREEN_FRAME_OP_CLEAR, 0, 0, 0)) return false;
+  }
+
+  for (uint8_t row = 0; row < frame->height; row++) {
+    const char* want = &frame->desired[row * frame->width];
+    const char* have = &frame->shown[row * frame->width];
+
+    uint8_t col = 0;
+    while (col < frame->width) {
+      char current = frame->shown_valid ? have[col] : ' ';
+      if (want[col] == current) {
+        col++;
+        continue;
+      }
+
+      // Extend the run while the next difference is within `merge_gap`.
+      uint8_t start = col;
+      uint8_t end   = col + 1;
+      for (uint8_t next = end; next < frame->width && next - end <= merge_gap; next++) {
+        char next_current = frame->shown_valid ? have[next] : ' ';
+        if (want[next] != next_current) end = next + 1;
+      }
+
+      if (!frame_add_op(frame, LIBTOCK_TEXT_SCREEN_FRAME_OP_CURSOR, start, row, 0)) return false;
+      if (!frame_add_op(frame, LIBTOCK_TEXT_SCREEN_FRAME_OP_WRITE, start, row, end - start)) return false;
+      col = end;
+    }
+  }
+  return true;
+}
+
+static void frame_finish(libtock_text_screen_frame_t* frame, returncode_t ret) {
+  uint32_t now;
+  libtock_alarm_command_read(&now);
+
+  frame->last_update_ticks = now - frame->start_ticks;
+  frame->last_update_ops   = frame->next_op;
+  frame->busy = false;
+  active_frame = NULL;
+
+  // Take back the text of the last write, whether or not the commit finished.
+  libtock_text_screen_set_readonly_allow(NULL, 0);
+
+  if (ret != RETURNCODE_SUCCESS) {
+    // The screen is in an unknown state, redraw it all next time.
+    frame->shown_valid = false;
+  }
+
+  if (frame->cb != NULL) {
+    frame->cb(ret);
+  }
+}
+
+static void frame_op_done(returncode_t ret) {
+  libtock_text_screen_frame_t* frame = active_frame;
+  if (frame == NULL) return;
+
+  if (ret != RETURNCODE_SUCCESS) {
+    frame_finish(frame, ret);
+    return;
+  }
+
+  // Record what is now on the screen.
+  libtock_text_screen_frame_op_t* op = &frame->ops[frame->next_op];
+  if (op->type == LIBTOCK_TEXT_SCREEN_FRAME_OP_CLEAR) {
+    memset(frame->shown, ' ', sizeof(frame->shown));
+    frame->shown_valid = true;
+  } else if (op->type == LIBTOCK_TEXT_SCREEN_FRAME_OP_WRITE) {
+    size_t offset = op->row * frame->width + op->col;
+    memcpy(&frame->shown[offset], &frame->sending[offset], op->len);
+  }
+
+  frame->next_op++;
+  if (frame->next_op == frame->num_ops) {
+    frame_finish(frame, RETURNCODE_SUCCESS);
+  } else {
+    ret = frame_run_next(frame);
+    if (ret != RETURNCODE_SUCCESS) {
+      frame_finish(frame, ret);
+    }
+  }
+}
+
+static returncode_t frame_run_next(libtock_text_screen_frame_t* frame) {
+  libtock_text_screen_frame_op_t* op = &frame->ops[frame->next_op];
+  returncode_t ret;
+
+  switch (op->type) {
+    case LIBTOCK_TEXT_SCREEN_FRAME_OP_CLEAR:
+      ret = libtock_text_screen_clear(frame_op_done);
+      break;
+    case LIBTOCK_TEXT_SCREEN_FRAME_OP_CURSOR:
+      ret = libtock_text_screen_set_cursor(op->col, op->row, frame_op_done);
+      break;
+    case LIBTOCK_TEXT_SCREEN_FRAME_OP_WRITE: {
+      uint8_t* text = (uint8_t*) &frame->sending[op->row * frame->width + op->col];
+      ret = libtock_text_screen_write(text, op->len, op->len, frame_op_done);
+      break;
+    }
+    default:
+      ret = RETURNCODE_EINVAL;
+      break;
+  }
+  return ret;
+}
+
+returncode_t libtock_text_screen_frame_init(libtock_text_screen_frame_t* frame, uint8_t width, uint8_t height) {
+  if (width == 0 || height == 0 || width * height > LIBTOCK_TEXT_SCREEN_FRAME_MAX_CELLS) {
+    return RETURNCODE_ESIZE;
+  }
+
+  memset(frame, 0, sizeof(libtock_text_screen_frame_t));
+  frame->width  = width;
+  frame->height = height;
+  libtock_text_screen_frame_clear(frame);
+  return RETURNCODE_SUCCESS;
+}
+
+void libtock_text_screen_frame_clear(libtock_text_screen_frame_t* frame) {
+  memset(frame->desired, ' ', sizeof(frame->desired));
+}
+
+void libtock_text_screen_frame_print(libtock_text_screen_frame_t* frame, uint8_t col, uint8_t row, const char* str) {
+  if (row >= frame->height) return;
+
+  char* line = &frame->desired[row * frame->width];
+  for ( ; col < frame->width && *str != '\0'; col++, str++) {
+    line[col] = *str;
+  }
+}
+
+void libtock_text_screen_frame_set_line(libtock_text_screen_frame_t* frame, uint8_t row, const char* str) {
+  if (row >= frame->height) return;
+
+  memset(&frame->desired[row * frame->width], ' ', frame->width);
+  libtock_text_screen_frame_print(frame, 0, row, str);
+}
+
+void libtock_text_screen_frame_invalidate(libtock_text_screen_frame_t* frame) {
+  frame->shown_valid = false;
+}
+
+returncode_t libtock_text_screen_frame_commit(libtock_text_screen_frame_t* frame,
+                                              libtock_text_screen_callback_done cb) {
+  if (frame->busy || active_frame != NULL) return RETURNCODE_EBUSY;
+
+  // If there are too many scattered changes, fall back to one write per
+  // changed row.
+  if (!frame_build_ops(frame, LIBTOCK_TEXT_SCREEN_FRAME_MERGE_GAP)) {
+    if (!frame_build_ops(frame, frame->width)) return RETURNCODE_ESIZE;
+  }
+  if (frame->num_ops == 0) return RETURNCODE_EALREADY;
+
+  memcpy(frame->sending, frame->desired, sizeof(frame->sending));
+  frame->next_op = 0;
+  frame->cb      = cb;
+  frame->busy    = true;
+  active_frame   = frame;
+  libtock_alarm_command_read(&frame->start_ticks);
+
+  returncode_t ret = frame_run_next(frame);
+  if (ret != RETURNCODE_SUCCESS) {
+    frame->busy  = false;
+    active_frame = NULL;
+  }
+  return ret;
+}
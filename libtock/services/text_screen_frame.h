@@ -0,0 +1,116 @@
+#pragma once
+
+// Frame-based text screen updates.
+//
+// Every text screen operation (`set_cursor`, `write`, `clear`, ...) is a
+// separate system call round-trip. Redrawing a multi-line display line by line
+// costs many of them even when most of the text did not change.
+//
+// A `libtock_text_screen_frame_t` holds the desired screen contents and a
+// shadow copy of what is currently shown. Apps draw into the frame, and
+// `libtock_text_screen_frame_commit()` sends only the changed characters as a
+// single queued pipeline of cursor moves and writes.
+//
+// The expected use looks something like:
+//
+//   libtock_text_screen_frame_t frame;
+//   libtock_text_screen_frame_init(&frame, 16, 2);
+//
+//   libtock_text_screen_frame_set_line(&frame, 0, "Temp: 21.5C");
+//   libtock_text_screen_frame_set_line(&frame, 1, "Hum:  40%");
+//   libtock_text_screen_frame_commit(&frame, done_callback);
+//
+// There is only one text screen driver, so only one frame can be committing at
+// a time.
+
+#include "../display/text_screen.h"
+#include "../tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Largest supported screen, in characters (e.g. 4x20).
+#ifndef LIBTOCK_TEXT_SCREEN_FRAME_MAX_CELLS
+#define LIBTOCK_TEXT_SCREEN_FRAME_MAX_CELLS 80
+#endif
+
+// Maximum number of operations in one update.
+#ifndef LIBTOCK_TEXT_SCREEN_FRAME_MAX_OPS
+#define LIBTOCK_TEXT_SCREEN_FRAME_MAX_OPS 32
+#endif
+
+// Changed runs on a row that are separated by at most this many unchanged
+// characters are sent as one write, as rewriting a few characters is cheaper
+// than another cursor move.
+#ifndef LIBTOCK_TEXT_SCREEN_FRAME_MERGE_GAP
+#define LIBTOCK_TEXT_SCREEN_FRAME_MERGE_GAP 4
+#endif
+
+typedef enum {
+  LIBTOCK_TEXT_SCREEN_FRAME_OP_CLEAR,
+  LIBTOCK_TEXT_SCREEN_FRAME_OP_CURSOR,
+  LIBTOCK_TEXT_SCREEN_FRAME_OP_WRITE,
+} libtock_text_screen_frame_op_type_t;
+
+typedef struct {
+  uint8_t type;
+  uint8_t col;
+  uint8_t row;
+  uint8_t len;
+} libtock_text_screen_frame_op_t;
+
+typedef struct {
+  uint8_t width;
+  uint8_t height;
+
+  // What the app wants shown, and what is currently shown.
+  char desired[LIBTOCK_TEXT_SCREEN_FRAME_MAX_CELLS];
+  char shown[LIBTOCK_TEXT_SCREEN_FRAME_MAX_CELLS];
+  // `shown` is not known until the first commit clears the screen.
+  bool shown_valid;
+
+  // Snapshot of `desired` being sent, so the app can keep drawing.
+  char sending[LIBTOCK_TEXT_SCREEN_FRAME_MAX_CELLS];
+
+  libtock_text_screen_frame_op_t ops[LIBTOCK_TEXT_SCREEN_FRAME_MAX_OPS];
+  uint8_t num_ops;
+  uint8_t next_op;
+  bool busy;
+  libtock_text_screen_callback_done cb;
+
+  // Alarm ticks at the start of the commit in progress.
+  uint32_t start_ticks;
+  // Duration in ticks and number of operations of the last commit that sent
+  // anything. A commit with nothing to send leaves them unchanged.
+  uint32_t last_update_ticks;
+  uint8_t last_update_ops;
+} libtock_text_screen_frame_t;
+
+// Set up a frame for a `width`x`height` screen. The frame starts out blank.
+returncode_t libtock_text_screen_frame_init(libtock_text_screen_frame_t* frame, uint8_t width, uint8_t height);
+
+// Fill the frame with spaces.
+void libtock_text_screen_frame_clear(libtock_text_screen_frame_t* frame);
+
+// Write `str` into the frame starting at (`col`, `row`). Text past the end of
+// the row is dropped.
+void libtock_text_screen_frame_print(libtock_text_screen_frame_t* frame, uint8_t col, uint8_t row, const char* str);
+
+// Replace row `row` with `str`, padded with spaces.
+void libtock_text_screen_frame_set_line(libtock_text_screen_frame_t* frame, uint8_t row, const char* str);
+
+// Forget what is on the screen, so the next commit redraws everything.
+void libtock_text_screen_frame_invalidate(libtock_text_screen_frame_t* frame);
+
+// Send the changes since the last commit to the screen.
+//
+// `cb` is called once all operations have completed, or on the first failing
+// operation. If nothing changed, `cb` is not called and `RETURNCODE_EALREADY`
+// is returned. Returns `RETURNCODE_EBUSY` if a commit is in progress.
+returncode_t libtock_text_screen_frame_commit(libtock_text_screen_frame_t* frame,
+                                              libtock_text_screen_callback_done cb);
+
+#ifdef __cplusplus
+}
+#endif
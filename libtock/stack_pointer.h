@@ -0,0 +1,26 @@
+#pragma once
+
+// The current stack pointer. Shared by crt0 and the memory profiler, which
+// paint and measure the stack; not meant for apps.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline uint32_t* libtock_stack_pointer(void) {
+  uint32_t* sp;
+#if defined(__thumb__)
+  __asm__ volatile ("mov %0, sp" : "=r" (sp));
+#elif defined(__riscv)
+  __asm__ volatile ("mv %0, sp" : "=r" (sp));
+#else
+#error Unknown architecture
+#endif
+  return sp;
+}
+
+#ifdef __cplusplus
+}
+#endif
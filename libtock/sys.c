@@ -69,6 +69,13 @@ int _kill(pid_t pid, int sig) {
   return -1;
 }
 
+// Highest break reached through `_sbrk`.
+static caddr_t heap_high_water;
+
+void* libtock_heap_high_water(void) {
+  return heap_high_water;
+}
+
 caddr_t _sbrk(int incr) {
   memop_return_t ret;
   ret = memop(1, incr);
@@ -76,5 +83,9 @@ caddr_t _sbrk(int incr) {
     errno = ENOMEM;
     return (caddr_t) -1;
   }
+  caddr_t brk = (caddr_t) ret.data + incr;
+  if (brk > heap_high_water) {
+    heap_high_water = brk;
+  }
   return (caddr_t) ret.data;
 }
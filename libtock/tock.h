@@ -191,6 +191,45 @@ void yield_for(bool*);
 int yield_no_wait(void);
 yield_waitfor_return_t yield_wait_for(uint32_t driver, uint32_t subscribe);
 
+// Alarm ticks spent in crt0 between the start of C startup and `main`:
+// relocating the GOT and data pointers, loading `.data` and zeroing `.bss`.
+// Useful to track how long a process takes to (re)start. 0 if the board has no
+// alarm driver.
+uint32_t libtock_startup_ticks(void);
+
+// An app can define this as `true` to skip zeroing `.bss` in crt0, which saves
+// time at startup for apps with large zero-initialized buffers. Only do so if
+// the kernel is known to zero all process memory before starting and
+// restarting a process; otherwise zero-initialized globals will hold stale
+// values after a restart.
+//
+//   const bool libtock_crt0_kernel_zeroes_bss = true;
+extern const bool libtock_crt0_kernel_zeroes_bss;
+
+// An app can define this as `true` to have crt0 fill the unused part of the
+// stack with `LIBTOCK_STACK_PAINT` before calling `main`, so the deepest stack
+// use can be measured later (see `libtock/services/memory_profile.h`).
+//
+//   const bool libtock_crt0_paint_stack = true;
+extern const bool libtock_crt0_paint_stack;
+
+#define LIBTOCK_STACK_PAINT 0x57ac57acu
+
+// Memory regions set up by crt0. The stack grows down from `stack_top` to
+// `stack_bottom`; the heap starts at `heap_start` and ends at the current
+// break.
+typedef struct {
+  uint32_t* stack_bottom;
+  uint32_t* stack_top;
+  void* heap_start;
+} libtock_memory_layout_t;
+
+void libtock_memory_layout(libtock_memory_layout_t* layout);
+
+// The highest the heap break has been moved by `sbrk`, or NULL if the heap has
+// never grown.
+void* libtock_heap_high_water(void);
+
 void tock_exit(uint32_t completion_code) __attribute__ ((noreturn));
 void tock_restart(uint32_t completion_code) __attribute__ ((noreturn));
 
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+
+# Write a C file defining `libtock_lua_scripts` (see `ltock/ltock.h`) from Lua
+# chunks precompiled with `luac`.
+#
+# Usage:
+#
+#   embed_scripts.py lua_scripts.c build/lua/main.luac build/lua/blink.luac
+#
+# Each script is named after its file, without the extension. The bytecode is
+# `const`, so it stays in flash until Lua loads it.
+
+import os
+import sys
+
+
+def c_name(name):
+    return "".join(c if c.isalnum() else "_" for c in name)
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit("usage: {} OUTPUT.c [SCRIPT.luac ...]".format(sys.argv[0]))
+
+    scripts = []
+    for path in sys.argv[2:]:
+        name = os.path.splitext(os.path.basename(path))[0]
+        with open(path, "rb") as f:
+            scripts.append((name, f.read()))
+
+    names = [name for name, _ in scripts]
+    duplicates = sorted(set(n for n in names if names.count(n) > 1))
+    if duplicates:
+        sys.exit("Lua scripts with the same name: {}".format(", ".join(duplicates)))
+
+    lines = [
+        "// Generated by lua53/embed_scripts.py. Do not edit.",
+        "",
+        "#include <ltock/ltock.h>",
+        "",
+    ]
+    for name, code in scripts:
+        lines.append("static const uint8_t script_{}[{}] = {{".format(c_name(name), len(code)))
+        for i in range(0, len(code), 12):
+            lines.append("  " + " ".join("0x{:02x},".format(b) for b in code[i:i + 12]))
+        lines.append("};")
+        lines.append("")
+    lines.append("const libtock_lua_script_t libtock_lua_scripts[] = {")
+    for name, code in scripts:
+        lines.append('  {{ "{}", script_{}, {} }},'.format(name, c_name(name), len(code)))
+    lines.append("  { NULL, NULL, 0 },")
+    lines.append("};")
+
+    with open(sys.argv[1], "w") as f:
+        f.write("\n".join(lines) + "\n")
+
+
+if __name__ == "__main__":
+    main()
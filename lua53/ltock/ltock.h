@@ -0,0 +1,105 @@
+#pragma once
+
+// Tock support for Lua.
+//
+// - A `lua_Alloc` that serves the whole interpreter from one fixed buffer, so
+//   a script can never take more memory than it was given.
+// - Loading scripts precompiled to bytecode at build time (see `LUA_SCRIPTS`
+//   in the README), so apps can be built without the Lua parser.
+// - Garbage collector tuning for small heaps.
+// - Lua modules for the alarm, GPIO, sensor and console drivers.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../lua/lua.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Free lists: one per 8-byte size up to 128 bytes, then one per power of two.
+#define LIBTOCK_LUA_ARENA_BINS 21
+
+typedef struct {
+  uint8_t* start;
+  uint8_t* end;
+  uint32_t nonempty_bins;
+  uint32_t bins[LIBTOCK_LUA_ARENA_BINS];
+  // Bytes in allocated blocks, including headers, now and at most.
+  uint32_t in_use;
+  uint32_t high_water;
+  // Allocation attempts that found no free block. Lua collects garbage and
+  // retries after such an attempt, so a request may be counted and still
+  // succeed.
+  uint32_t failures;
+} libtock_lua_arena_t;
+
+// Use `size` bytes at `buffer` for an arena. Returns false if the buffer is
+// too small to be useful.
+bool libtock_lua_arena_init(libtock_lua_arena_t* arena, void* buffer, size_t size);
+
+// `lua_Alloc` serving allocations from the `libtock_lua_arena_t` passed as
+// `ud`. When the arena is full Lua runs a full garbage collection and retries
+// before failing with a memory error.
+void* libtock_lua_alloc(void* ud, void* ptr, size_t osize, size_t nsize);
+
+// Create a Lua state whose memory all comes from `arena`, with a panic
+// handler that prints the error. Returns NULL if the arena is too small.
+lua_State* libtock_lua_newstate(libtock_lua_arena_t* arena);
+
+// A script compiled into the app by the build (`LUA_SCRIPTS`).
+typedef struct {
+  const char* name;
+  const uint8_t* bytecode;
+  size_t size;
+} libtock_lua_script_t;
+
+// The app's scripts, terminated by an entry with a NULL name. Generated by the
+// build; empty if the app has none.
+extern const libtock_lua_script_t libtock_lua_scripts[];
+
+// Find the script built from `<name>.lua`, or NULL.
+const libtock_lua_script_t* libtock_lua_find_script(const char* name);
+
+// Load a precompiled script and push it as a function. Returns a Lua status
+// code; on error the message is pushed instead. Only bytecode is accepted.
+int libtock_lua_load_script(lua_State* L, const char* name);
+
+// Make every precompiled script available to `require` through
+// `package.preload`. The package library must be open.
+void libtock_lua_preload_scripts(lua_State* L);
+
+// Set the collector's pause and step multiplier (see the Lua manual). Smaller
+// pauses collect sooner and keep the heap smaller, at the cost of more time in
+// the collector. A pause of 100 and a step multiplier of 200 suit heaps of a
+// few tens of kB.
+void libtock_lua_gc_tune(lua_State* L, int pause, int stepmul);
+
+// Do up to `kb` kB of incremental collection work, for example before waiting
+// for the next event. Returns true if a collection cycle finished.
+bool libtock_lua_gc_idle(lua_State* L, int kb);
+
+// Modules for the Tock drivers, each returning its table:
+//
+// - `alarm`: `delay_ms(ms)`, `now_ms()`.
+// - `gpio`: `count()`, `output(pin)`, `input(pin [, "up"|"down"])`,
+//   `set(pin)`, `clear(pin)`, `toggle(pin)`, `read(pin)`.
+// - `sensors`: `temperature()` (hundredths of a degree C), `humidity()`
+//   (hundredths of a percent), `light()` (lux), `pressure()` (hPa). Each
+//   returns nil and a message if the sensor is missing or fails.
+// - `console`: `write(string)`, `read(n)`.
+//
+// Driver errors are raised as Lua errors unless noted.
+int libtock_lua_open_alarm(lua_State* L);
+int libtock_lua_open_gpio(lua_State* L);
+int libtock_lua_open_sensors(lua_State* L);
+int libtock_lua_open_console(lua_State* L);
+
+// Open the Tock modules as globals with their names above.
+void libtock_lua_open_libs(lua_State* L);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,242 @@
+#include <string.h>
+
+#include "ltock.h"
+
+// Blocks start with a header word holding their size (a multiple of 8,
+// including the header) and two flags. The payload after the header is 8-byte
+// aligned. Free blocks also hold the links of their free list and, in their
+// last word, their size, so a block being freed can find and merge with a
+// free block before it. The arena ends with a zero-sized used block.
+
+#define USED      1u
+#define PREV_USED 2u
+#define FLAGS     3u
+
+#define HEADER 4u
+#define MIN_BLOCK 16u
+
+// Bins up to this size hold blocks of exactly one size.
+#define EXACT_MAX 128u
+#define EXACT_BINS ((EXACT_MAX - MIN_BLOCK) / 8 + 1)
+
+// Free blocks are linked by their offsets from the start of the arena, which
+// keeps a free block at 16 bytes on any host.
+typedef struct {
+  uint32_t header;
+  uint32_t next;
+  uint32_t prev;
+} free_block_t;
+
+#define NONE UINT32_MAX
+
+static inline uint32_t* header_of(void* payload) {
+  return (uint32_t*) ((uint8_t*) payload - HEADER);
+}
+
+static inline uint32_t block_size(const uint32_t* block) {
+  return *block & ~FLAGS;
+}
+
+static inline uint32_t* next_block(uint32_t* block) {
+  return (uint32_t*) ((uint8_t*) block + block_size(block));
+}
+
+static inline void set_footer(uint32_t* block) {
+  *(uint32_t*) ((uint8_t*) block + block_size(block) - 4) = block_size(block);
+}
+
+static unsigned bin_of(uint32_t size) {
+  if (size <= EXACT_MAX) {
+    return (size - MIN_BLOCK) / 8;
+  }
+  unsigned bin = EXACT_BINS - 7 + (31 - __builtin_clz(size));
+  return bin < LIBTOCK_LUA_ARENA_BINS ? bin : LIBTOCK_LUA_ARENA_BINS - 1;
+}
+
+static inline free_block_t* block_at(libtock_lua_arena_t* arena, uint32_t offset) {
+  return (free_block_t*) (arena->start + offset);
+}
+
+static inline uint32_t offset_of(libtock_lua_arena_t* arena, uint32_t* block) {
+  return (uint32_t) ((uint8_t*) block - arena->start);
+}
+
+static void bin_insert(libtock_lua_arena_t* arena, uint32_t* block) {
+  unsigned bin        = bin_of(block_size(block));
+  free_block_t* entry = (free_block_t*) block;
+  uint32_t offset     = offset_of(arena, block);
+  entry->next = arena->bins[bin];
+  entry->prev = NONE;
+  if (entry->next != NONE) {
+    block_at(arena, entry->next)->prev = offset;
+  }
+  arena->bins[bin]      = offset;
+  arena->nonempty_bins |= 1u << bin;
+}
+
+static void bin_remove(libtock_lua_arena_t* arena, uint32_t* block) {
+  unsigned bin        = bin_of(block_size(block));
+  free_block_t* entry = (free_block_t*) block;
+  if (entry->prev != NONE) {
+    block_at(arena, entry->prev)->next = entry->next;
+  } else {
+    arena->bins[bin] = entry->next;
+    if (entry->next == NONE) {
+      arena->nonempty_bins &= ~(1u << bin);
+    }
+  }
+  if (entry->next != NONE) {
+    block_at(arena, entry->next)->prev = entry->prev;
+  }
+}
+
+// Turn `block` (not in any bin) into a free block of `size` bytes, merged with
+// any free block after it, and add it to its bin.
+static void make_free(libtock_lua_arena_t* arena, uint32_t* block, uint32_t size) {
+  uint32_t* next = (uint32_t*) ((uint8_t*) block + size);
+  if (!(*next & USED)) {
+    bin_remove(arena, next);
+    size += block_size(next);
+    next  = (uint32_t*) ((uint8_t*) block + size);
+  }
+  *block = size | (*block & PREV_USED);
+  set_footer(block);
+  *next &= ~PREV_USED;
+  bin_insert(arena, block);
+}
+
+// Mark `block` used with `size` bytes, returning the rest of it to the bins.
+static void take(libtock_lua_arena_t* arena, uint32_t* block, uint32_t size) {
+  uint32_t have = block_size(block);
+  if (have - size >= MIN_BLOCK) {
+    *block = size | USED | (*block & PREV_USED);
+    uint32_t* rest = next_block(block);
+    *rest = PREV_USED;
+    make_free(arena, rest, have - size);
+  } else {
+    *block |= USED;
+    *next_block(block) |= PREV_USED;
+  }
+  arena->in_use += block_size(block);
+  if (arena->in_use > arena->high_water) {
+    arena->high_water = arena->in_use;
+  }
+}
+
+static uint32_t* find_free(libtock_lua_arena_t* arena, uint32_t size) {
+  unsigned bin = bin_of(size);
+  if (bin >= EXACT_BINS) {
+    // Blocks in the bin may be too small; the first that fits is used.
+    for (uint32_t offset = arena->bins[bin]; offset != NONE; offset = block_at(arena, offset)->next) {
+      free_block_t* b = block_at(arena, offset);
+      if (block_size(&b->header) >= size) return &b->header;
+    }
+    bin++;
+  }
+  // Any block in a higher bin fits.
+  uint32_t candidates = bin < 32 ? arena->nonempty_bins & ~((1u << bin) - 1) : 0;
+  if (candidates == 0) return NULL;
+  return &block_at(arena, arena->bins[__builtin_ctz(candidates)])->header;
+}
+
+static uint32_t block_for(size_t payload) {
+  if (payload > UINT32_MAX - HEADER - 7) return UINT32_MAX;
+  uint32_t size = ((uint32_t) payload + HEADER + 7) & ~7u;
+  return size < MIN_BLOCK ? MIN_BLOCK : size;
+}
+
+static void* arena_malloc(libtock_lua_arena_t* arena, size_t payload) {
+  uint32_t size   = block_for(payload);
+  uint32_t* block = find_free(arena, size);
+  if (block == NULL) {
+    arena->failures++;
+    return NULL;
+  }
+  bin_remove(arena, block);
+  take(arena, block, size);
+  return block + 1;
+}
+
+static void arena_free(libtock_lua_arena_t* arena, void* ptr) {
+  uint32_t* block = header_of(ptr);
+  uint32_t size   = block_size(block);
+  arena->in_use -= size;
+
+  if (!(*block & PREV_USED)) {
+    // Merge with the free block before this one.
+    uint32_t prev_size = *(block - 1);
+    uint32_t* prev     = (uint32_t*) ((uint8_t*) block - prev_size);
+    bin_remove(arena, prev);
+    make_free(arena, prev, prev_size + size);
+  } else {
+    make_free(arena, block, size);
+  }
+}
+
+static void* arena_realloc(libtock_lua_arena_t* arena, void* ptr, size_t payload) {
+  uint32_t* block = header_of(ptr);
+  uint32_t have   = block_size(block);
+  uint32_t size   = block_for(payload);
+
+  if (size <= have) {
+    // Shrink in place. Lua relies on this never failing.
+    if (have - size >= MIN_BLOCK) {
+      arena->in_use -= have;
+      take(arena, block, size);
+    }
+    return ptr;
+  }
+
+  // Grow into a free block after this one.
+  uint32_t* next = next_block(block);
+  if (!(*next & USED) && have + block_size(next) >= size) {
+    bin_remove(arena, next);
+    arena->in_use -= have;
+    *block         = (have + block_size(next)) | (*block & PREV_USED);
+    take(arena, block, size);
+    return ptr;
+  }
+
+  void* moved = arena_malloc(arena, payload);
+  if (moved != NULL) {
+    memcpy(moved, ptr, have - HEADER);
+    arena_free(arena, ptr);
+  }
+  return moved;
+}
+
+bool libtock_lua_arena_init(libtock_lua_arena_t* arena, void* buffer, size_t size) {
+  memset(arena, 0, sizeof(*arena));
+  memset(arena->bins, 0xff, sizeof(arena->bins));
+
+  // The first header goes 4 bytes before an 8-byte boundary, so payloads are
+  // 8-byte aligned.
+  uintptr_t start = ((uintptr_t) buffer + HEADER + 7) & ~(uintptr_t) 7;
+  uintptr_t end   = ((uintptr_t) buffer + size) & ~(uintptr_t) 7;
+  if (end < start + MIN_BLOCK) return false;
+
+  arena->start = (uint8_t*) (start - HEADER);
+  arena->end   = (uint8_t*) end;
+
+  // The end marker takes the last word.
+  uint32_t* first = (uint32_t*) arena->start;
+  uint32_t* last  = (uint32_t*) (end - HEADER);
+  *first = PREV_USED;
+  *last  = USED;
+  make_free(arena, first, (uint32_t) ((uint8_t*) last - arena->start));
+  return true;
+}
+
+void* libtock_lua_alloc(void* ud, void* ptr, __attribute__ ((unused)) size_t osize, size_t nsize) {
+  libtock_lua_arena_t* arena = ud;
+  if (nsize == 0) {
+    if (ptr != NULL) {
+      arena_free(arena, ptr);
+    }
+    return NULL;
+  }
+  if (ptr == NULL) {
+    return arena_malloc(arena, nsize);
+  }
+  return arena_realloc(arena, ptr, nsize);
+}
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "../lua/lauxlib.h"
+
+#include "ltock.h"
+
+// Apps that do not set `LUA_SCRIPTS` have no scripts.
+__attribute__ ((weak))
+const libtock_lua_script_t libtock_lua_scripts[] = {
+  { NULL, NULL, 0 },
+};
+
+static int panic(lua_State* L) {
+  const char* msg = lua_tostring(L, -1);
+  printf("Lua panic: %s\n", msg != NULL ? msg : "(error object is not a string)");
+  return 0;
+}
+
+lua_State* libtock_lua_newstate(libtock_lua_arena_t* arena) {
+  lua_State* L = lua_newstate(libtock_lua_alloc, arena);
+  if (L != NULL) {
+    lua_atpanic(L, panic);
+  }
+  return L;
+}
+
+const libtock_lua_script_t* libtock_lua_find_script(const char* name) {
+  for (const libtock_lua_script_t* script = libtock_lua_scripts; script->name != NULL; script++) {
+    if (strcmp(script->name, name) == 0) return script;
+  }
+  return NULL;
+}
+
+int libtock_lua_load_script(lua_State* L, const char* name) {
+  const libtock_lua_script_t* script = libtock_lua_find_script(name);
+  if (script == NULL) {
+    lua_pushfstring(L, "no script '%s'", name);
+    return LUA_ERRFILE;
+  }
+  return luaL_loadbufferx(L, (const char*) script->bytecode, script->size, script->name, "b");
+}
+
+// `package.preload` loader: the script's main function, called with the module
+// name like any other module.
+static int preload(lua_State* L) {
+  const char* name = lua_tostring(L, lua_upvalueindex(1));
+  if (libtock_lua_load_script(L, name) != LUA_OK) {
+    return lua_error(L);
+  }
+  lua_pushvalue(L, 1);
+  lua_call(L, 1, 1);
+  return 1;
+}
+
+void libtock_lua_preload_scripts(lua_State* L) {
+  luaL_getsubtable(L, LUA_REGISTRYINDEX, LUA_PRELOAD_TABLE);
+  for (const libtock_lua_script_t* script = libtock_lua_scripts; script->name != NULL; script++) {
+    lua_pushstring(L, script->name);
+    lua_pushcclosure(L, preload, 1);
+    lua_setfield(L, -2, script->name);
+  }
+  lua_pop(L, 1);
+}
+
+void libtock_lua_gc_tune(lua_State* L, int pause, int stepmul) {
+  lua_gc(L, LUA_GCSETPAUSE, pause);
+  lua_gc(L, LUA_GCSETSTEPMUL, stepmul);
+}
+
+bool libtock_lua_gc_idle(lua_State* L, int kb) {
+  return lua_gc(L, LUA_GCSTEP, kb) != 0;
+}
@@ -0,0 +1,223 @@
+#include <libtock-sync/interface/console.h>
+#include <libtock-sync/sensors/ambient_light.h>
+#include <libtock-sync/sensors/humidity.h>
+#include <libtock-sync/sensors/pressure.h>
+#include <libtock-sync/sensors/temperature.h>
+#include <libtock-sync/services/alarm.h>
+#include <libtock/peripherals/gpio.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/services/alarm.h>
+#include <libtock/tock.h>
+
+#include "../lua/lauxlib.h"
+
+#include "ltock.h"
+
+// Raise a Lua error for a failed driver call.
+static void check(lua_State* L, int ret, const char* what) {
+  if (ret != RETURNCODE_SUCCESS) {
+    luaL_error(L, "%s: %s", what, tock_strrcode(ret));
+  }
+}
+
+static uint32_t check_pin(lua_State* L, int arg) {
+  lua_Integer pin = luaL_checkinteger(L, arg);
+  luaL_argcheck(L, pin >= 0, arg, "pin must not be negative");
+  return (uint32_t) pin;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// alarm
+////////////////////////////////////////////////////////////////////////////////
+
+static int alarm_delay_ms(lua_State* L) {
+  lua_Integer ms = luaL_checkinteger(L, 1);
+  luaL_argcheck(L, ms >= 0, 1, "delay must not be negative");
+  check(L, libtocksync_alarm_delay_ms((uint32_t) ms), "alarm.delay_ms");
+  return 0;
+}
+
+// Milliseconds since the alarm counter started. Wraps with the counter.
+static int alarm_now_ms(lua_State* L) {
+  uint32_t ticks;
+  check(L, libtock_alarm_command_read(&ticks), "alarm.now_ms");
+  lua_pushinteger(L, (lua_Integer) libtock_alarm_ticks_to_ms(ticks));
+  return 1;
+}
+
+static const luaL_Reg alarm_funcs[] = {
+  { "delay_ms", alarm_delay_ms },
+  { "now_ms",   alarm_now_ms   },
+  { NULL,       NULL           },
+};
+
+int libtock_lua_open_alarm(lua_State* L) {
+  luaL_newlib(L, alarm_funcs);
+  return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// gpio
+////////////////////////////////////////////////////////////////////////////////
+
+static int gpio_count(lua_State* L) {
+  int count;
+  check(L, libtock_gpio_count(&count), "gpio.count");
+  lua_pushinteger(L, count);
+  return 1;
+}
+
+static int gpio_output(lua_State* L) {
+  check(L, libtock_gpio_enable_output(check_pin(L, 1)), "gpio.output");
+  return 0;
+}
+
+static int gpio_input(lua_State* L) {
+  static const char* const names[] = { "none", "up", "down", NULL };
+  static const libtock_gpio_input_mode_t modes[] = { libtock_pull_none, libtock_pull_up, libtock_pull_down };
+  uint32_t pin = check_pin(L, 1);
+  int mode     = luaL_checkoption(L, 2, "none", names);
+  check(L, libtock_gpio_enable_input(pin, modes[mode]), "gpio.input");
+  return 0;
+}
+
+static int gpio_set(lua_State* L) {
+  check(L, libtock_gpio_set(check_pin(L, 1)), "gpio.set");
+  return 0;
+}
+
+static int gpio_clear(lua_State* L) {
+  check(L, libtock_gpio_clear(check_pin(L, 1)), "gpio.clear");
+  return 0;
+}
+
+static int gpio_toggle(lua_State* L) {
+  check(L, libtock_gpio_toggle(check_pin(L, 1)), "gpio.toggle");
+  return 0;
+}
+
+static int gpio_read(lua_State* L) {
+  int value;
+  check(L, libtock_gpio_read(check_pin(L, 1), &value), "gpio.read");
+  lua_pushinteger(L, value);
+  return 1;
+}
+
+static const luaL_Reg gpio_funcs[] = {
+  { "count",  gpio_count  },
+  { "output", gpio_output },
+  { "input",  gpio_input  },
+  { "set",    gpio_set    },
+  { "clear",  gpio_clear  },
+  { "toggle", gpio_toggle },
+  { "read",   gpio_read   },
+  { NULL,     NULL        },
+};
+
+int libtock_lua_open_gpio(lua_State* L) {
+  luaL_newlib(L, gpio_funcs);
+  return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// sensors
+////////////////////////////////////////////////////////////////////////////////
+
+// Sensors are often missing or fail transiently, so scripts get nil and a
+// message to handle rather than an error.
+static int push_reading(lua_State* L, returncode_t ret, int value) {
+  if (ret != RETURNCODE_SUCCESS) {
+    lua_pushnil(L);
+    lua_pushstring(L, tock_strrcode(ret));
+    return 2;
+  }
+  lua_pushinteger(L, value);
+  return 1;
+}
+
+static int sensors_temperature(lua_State* L) {
+  int value        = 0;
+  returncode_t ret = libtocksync_temperature_exists() ? libtocksync_temperature_read(&value) : RETURNCODE_ENODEVICE;
+  return push_reading(L, ret, value);
+}
+
+static int sensors_humidity(lua_State* L) {
+  int value        = 0;
+  returncode_t ret = libtocksync_humidity_exists() ? libtocksync_humidity_read(&value) : RETURNCODE_ENODEVICE;
+  return push_reading(L, ret, value);
+}
+
+static int sensors_light(lua_State* L) {
+  int value        = 0;
+  returncode_t ret = libtocksync_ambient_light_exists() ? libtocksync_ambient_light_read_intensity(&value) : RETURNCODE_ENODEVICE;
+  return push_reading(L, ret, value);
+}
+
+static int sensors_pressure(lua_State* L) {
+  int value        = 0;
+  returncode_t ret = libtocksync_pressure_exists() ? libtocksync_pressure_read(&value) : RETURNCODE_ENODEVICE;
+  return push_reading(L, ret, value);
+}
+
+static const luaL_Reg sensors_funcs[] = {
+  { "temperature", sensors_temperature },
+  { "humidity",    sensors_humidity    },
+  { "light",       sensors_light       },
+  { "pressure",    sensors_pressure    },
+  { NULL,          NULL                },
+};
+
+int libtock_lua_open_sensors(lua_State* L) {
+  luaL_newlib(L, sensors_funcs);
+  return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// console
+////////////////////////////////////////////////////////////////////////////////
+
+static int console_write(lua_State* L) {
+  size_t len;
+  const char* str = luaL_checklstring(L, 1, &len);
+  int written;
+  check(L, libtocksync_console_write((const uint8_t*) str, len, &written), "console.write");
+  lua_pushinteger(L, written);
+  return 1;
+}
+
+// Read up to `n` bytes, blocking until the console driver returns them.
+static int console_read(lua_State* L) {
+  lua_Integer n = luaL_checkinteger(L, 1);
+  luaL_argcheck(L, n > 0, 1, "length must be positive");
+  luaL_Buffer b;
+  uint8_t* buf = (uint8_t*) luaL_buffinitsize(L, &b, (size_t) n);
+  int read;
+  check(L, libtocksync_console_read(buf, (uint32_t) n, &read), "console.read");
+  luaL_pushresultsize(&b, (size_t) read);
+  return 1;
+}
+
+static const luaL_Reg console_funcs[] = {
+  { "write", console_write },
+  { "read",  console_read  },
+  { NULL,    NULL          },
+};
+
+int libtock_lua_open_console(lua_State* L) {
+  luaL_newlib(L, console_funcs);
+  return 1;
+}
+
+void libtock_lua_open_libs(lua_State* L) {
+  static const luaL_Reg modules[] = {
+    { "alarm",   libtock_lua_open_alarm   },
+    { "gpio",    libtock_lua_open_gpio    },
+    { "sensors", libtock_lua_open_sensors },
+    { "console", libtock_lua_open_console },
+    { NULL,      NULL                     },
+  };
+  for (const luaL_Reg* m = modules; m->func != NULL; m++) {
+    luaL_requiref(L, m->name, m->func, 1);
+    lua_pop(L, 1);
+  }
+}
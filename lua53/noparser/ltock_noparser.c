@@ -0,0 +1,21 @@
+// Replacements for the Lua lexer and parser, linked into apps built with
+// `LUA_NO_PARSER=1`. As the app defines these, the linker no longer pulls the
+// lexer, parser and code generator out of the Lua library, and only
+// precompiled chunks can be loaded.
+
+#include "../lua/ldo.h"
+#include "../lua/llex.h"
+#include "../lua/lobject.h"
+#include "../lua/lparser.h"
+
+void luaX_init(__attribute__ ((unused)) lua_State* L) {}
+
+LClosure* luaY_parser(lua_State* L,
+                      __attribute__ ((unused)) ZIO* z,
+                      __attribute__ ((unused)) Mbuffer* buff,
+                      __attribute__ ((unused)) Dyndata* dyd,
+                      const char* name,
+                      __attribute__ ((unused)) int firstchar) {
+  luaO_pushfstring(L, "%s: Lua parser not included (LUA_NO_PARSER)", name);
+  luaD_throw(L, LUA_ERRSYNTAX);
+}
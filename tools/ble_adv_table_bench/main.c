@@ -0,0 +1,276 @@
+// Correctness check and throughput benchmark for the BLE advertisement table.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libtock/net/ble_adv_table.h>
+
+// Advertisements in the synthetic streams, each with its length and RSSI.
+#define STREAM_LEN 200000
+
+typedef struct {
+  uint8_t pdu[LIBTOCK_BLE_ADV_PDU_MAX_SIZE];
+  int len;
+  int8_t rssi;
+} adv_t;
+
+static adv_t stream[STREAM_LEN];
+
+static int failures = 0;
+
+static double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void check(bool ok, const char* what, long step) {
+  if (!ok) {
+    if (failures < 10) {
+      printf("FAIL: %s (advertisement %ld)\n", what, step);
+    }
+    failures++;
+  }
+}
+
+// A stream of advertisements from `devices` devices. Most devices repeat the
+// same data; one in eight updates a counter in it now and then, like a
+// sensor beacon. Some devices are heard far more often than others.
+static void make_stream(int devices, unsigned seed) {
+  srand(seed);
+  for (int i = 0; i < STREAM_LEN; i++) {
+    adv_t* a = &stream[i];
+    // Skew towards low device numbers.
+    int r   = rand() % devices;
+    int dev = (rand() & 1) ? r : r * r / devices;
+
+    a->pdu[0] = (dev % 3 == 0 ? 0x00 : 0x02) | (dev & 1 ? 0x40 : 0);
+    int data_len = 3 + dev % 29;
+    a->len    = 2 + LIBTOCK_BLE_ADDRESS_SIZE + data_len;
+    a->pdu[1] = LIBTOCK_BLE_ADDRESS_SIZE + data_len;
+    // Addresses of nearby devices often share their upper bytes.
+    uint8_t* address = &a->pdu[2];
+    address[0] = dev;
+    address[1] = dev >> 8;
+    address[2] = 0x5a;
+    address[3] = 0xc3;
+    address[4] = 0x00;
+    address[5] = dev % 4 == 3 ? 0x3b : 0xe4;
+    uint8_t* data = &a->pdu[8];
+    for (int j = 0; j < data_len; j++) {
+      data[j] = dev * 7 + j;
+    }
+    if (dev % 8 == 0) {
+      data[0] = (i / 1000) & 0xff;
+    }
+    a->rssi = (dev % 16 == 5) ? LIBTOCK_BLE_RSSI_UNKNOWN : -40 - (dev + i) % 50;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reference: an array searched linearly, most recently heard first, as the
+// forward_list in the ble_passive_scanning example used to be.
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  int count;
+  int capacity;
+  libtock_ble_adv_device_t devices[1024];
+} ref_table_t;
+
+static libtock_ble_adv_update_t ref_update(ref_table_t* t, const uint8_t* pdu, int len, int8_t rssi, uint32_t now) {
+  const uint8_t* address = pdu + 2;
+  bool random_address    = (pdu[0] & 0x40) != 0;
+  uint8_t pdu_type       = pdu[0] & 0x0f;
+  uint8_t data_len       = len - 8;
+
+  libtock_ble_adv_update_t result = LIBTOCK_BLE_ADV_NEW;
+  libtock_ble_adv_device_t d;
+  int i;
+  for (i = 0; i < t->count; i++) {
+    if (t->devices[i].random_address == random_address &&
+        memcmp(t->devices[i].address, address, LIBTOCK_BLE_ADDRESS_SIZE) == 0) {
+      break;
+    }
+  }
+  if (i < t->count) {
+    d      = t->devices[i];
+    result = (d.pdu_type == pdu_type && d.data_len == data_len && memcmp(d.data, pdu + 8, data_len) == 0) ?
+             LIBTOCK_BLE_ADV_SEEN : LIBTOCK_BLE_ADV_CHANGED;
+  } else {
+    if (t->count == t->capacity) {
+      t->count--;
+    }
+    i = t->count++;
+    memset(&d, 0, sizeof(d));
+    memcpy(d.address, address, LIBTOCK_BLE_ADDRESS_SIZE);
+    d.random_address = random_address;
+    d.first_seen     = now;
+  }
+  memmove(&t->devices[1], &t->devices[0], i * sizeof(d));
+
+  d.pdu_type = pdu_type;
+  d.data_len = data_len;
+  memcpy(d.data, pdu + 8, data_len);
+  d.seen++;
+  d.last_seen = now;
+  d.rssi_last = rssi;
+  if (rssi != LIBTOCK_BLE_RSSI_UNKNOWN) {
+    if (d.rssi_count == 0 || rssi < d.rssi_min) d.rssi_min = rssi;
+    if (d.rssi_count == 0 || rssi > d.rssi_max) d.rssi_max = rssi;
+    d.rssi_count++;
+    d.rssi_sum += rssi;
+  }
+  t->devices[0] = d;
+  return result;
+}
+
+static bool same_device(const libtock_ble_adv_device_t* a, const libtock_ble_adv_device_t* b) {
+  return memcmp(a->address, b->address, LIBTOCK_BLE_ADDRESS_SIZE) == 0 &&
+         a->random_address == b->random_address && a->pdu_type == b->pdu_type &&
+         a->data_len == b->data_len && memcmp(a->data, b->data, a->data_len) == 0 &&
+         a->seen == b->seen && a->first_seen == b->first_seen && a->last_seen == b->last_seen &&
+         a->rssi_last == b->rssi_last && a->rssi_count == b->rssi_count && a->rssi_sum == b->rssi_sum &&
+         (a->rssi_count == 0 || (a->rssi_min == b->rssi_min && a->rssi_max == b->rssi_max));
+}
+
+static void test_against_reference(uint16_t capacity, uint16_t slot_count, int devices) {
+  static libtock_ble_adv_device_t entries[1024];
+  static uint16_t slots[2048];
+  static ref_table_t ref;
+
+  libtock_ble_adv_table_t table;
+  check(libtock_ble_adv_table_init(&table, entries, capacity, slots, slot_count) == RETURNCODE_SUCCESS,
+        "init", -1);
+  ref.count    = 0;
+  ref.capacity = capacity;
+
+  make_stream(devices, capacity * 31 + devices);
+  for (long i = 0; i < STREAM_LEN; i++) {
+    adv_t* a = &stream[i];
+    libtock_ble_adv_device_t* device;
+    libtock_ble_adv_update_t got = libtock_ble_adv_table_update(&table, a->pdu, a->len, a->rssi, i, &device);
+    libtock_ble_adv_update_t want = ref_update(&ref, a->pdu, a->len, a->rssi, i);
+    check(got == want, "update result", i);
+    check(device != NULL && same_device(device, &ref.devices[0]), "device entry", i);
+    check(table.count == ref.count, "count", i);
+
+    // Now and then, walk the whole table and drop the stalest devices.
+    if (i % 9973 == 0) {
+      int n = 0;
+      for (libtock_ble_adv_device_t* d = libtock_ble_adv_table_newest(&table); d != NULL;
+           d = libtock_ble_adv_table_older(&table, d), n++) {
+        check(n < ref.count && same_device(d, &ref.devices[n]), "recency order", i);
+        check(libtock_ble_adv_table_find(&table, d->address, d->random_address) == d, "find", i);
+      }
+      check(n == ref.count, "iteration length", i);
+
+      uint32_t before = i - 2000;
+      int removed     = libtock_ble_adv_table_expire(&table, before);
+      int kept        = ref.count;
+      while (kept > 0 && (int32_t) (ref.devices[kept - 1].last_seen - before) < 0) {
+        kept--;
+      }
+      check(removed == ref.count - kept, "expire", i);
+      ref.count = kept;
+    }
+  }
+
+  // Unknown devices and malformed advertisements.
+  uint8_t address[LIBTOCK_BLE_ADDRESS_SIZE] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+  check(libtock_ble_adv_table_find(&table, address, false) == NULL, "find unknown", -1);
+  check(libtock_ble_adv_table_update(&table, stream[0].pdu, 7, 0, 0, NULL) == LIBTOCK_BLE_ADV_INVALID,
+        "short advertisement", -1);
+  check(libtock_ble_adv_table_update(&table, stream[0].pdu, LIBTOCK_BLE_ADV_PDU_MAX_SIZE + 1, 0, 0, NULL) ==
+        LIBTOCK_BLE_ADV_INVALID, "long advertisement", -1);
+
+  libtock_ble_adv_table_clear(&table);
+  check(table.count == 0 && libtock_ble_adv_table_newest(&table) == NULL, "clear", -1);
+}
+
+static void test_rssi_mean(void) {
+  libtock_ble_adv_device_t d = { 0 };
+  check(libtock_ble_adv_device_rssi_mean(&d) == LIBTOCK_BLE_RSSI_UNKNOWN, "mean of nothing", -1);
+  d.rssi_count = 3;
+  d.rssi_sum   = -200;
+  check(libtock_ble_adv_device_rssi_mean(&d) == -67, "mean rounding", -1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Benchmark
+////////////////////////////////////////////////////////////////////////////////
+
+static double bench_table(uint16_t capacity, int* new_devices) {
+  static libtock_ble_adv_device_t entries[1024];
+  static uint16_t slots[2048];
+  libtock_ble_adv_table_t table;
+  uint16_t slot_count = 1;
+  while (slot_count < 2 * capacity) slot_count <<= 1;
+  libtock_ble_adv_table_init(&table, entries, capacity, slots, slot_count);
+
+  int fresh    = 0;
+  double start = now_seconds();
+  for (int round = 0; round < 5; round++) {
+    for (long i = 0; i < STREAM_LEN; i++) {
+      fresh += libtock_ble_adv_table_update(&table, stream[i].pdu, stream[i].len, stream[i].rssi, i, NULL) ==
+               LIBTOCK_BLE_ADV_NEW;
+    }
+  }
+  *new_devices = fresh;
+  return (now_seconds() - start) * 1e9 / (5.0 * STREAM_LEN);
+}
+
+static double bench_reference(uint16_t capacity) {
+  static ref_table_t ref;
+  ref.count    = 0;
+  ref.capacity = capacity;
+
+  int fresh    = 0;
+  double start = now_seconds();
+  for (int round = 0; round < 5; round++) {
+    for (long i = 0; i < STREAM_LEN; i++) {
+      fresh += ref_update(&ref, stream[i].pdu, stream[i].len, stream[i].rssi, i) == LIBTOCK_BLE_ADV_NEW;
+    }
+  }
+  // Keep the work from being optimized away.
+  if (fresh < 0) printf("%d\n", fresh);
+  return (now_seconds() - start) * 1e9 / (5.0 * STREAM_LEN);
+}
+
+int main(void) {
+  test_rssi_mean();
+  test_against_reference(1, 2, 4);
+  test_against_reference(10, 16, 8);
+  test_against_reference(10, 16, 40);
+  test_against_reference(64, 128, 300);
+  test_against_reference(256, 512, 200);
+  test_against_reference(1000, 2048, 3000);
+  if (failures != 0) {
+    printf("%d checks failed\n", failures);
+    return 1;
+  }
+  printf("Table matches the reference.\n\n");
+
+  static const struct {
+    uint16_t capacity;
+    int devices;
+  } cases[] = {
+    { 10,   8    },
+    { 32,   100  },
+    { 64,   50   },
+    { 256,  200  },
+    { 256,  2000 },
+    { 1024, 800  },
+  };
+  printf("%8s %8s %12s %14s %14s\n", "capacity", "devices", "new devices", "table ns/adv", "linear ns/adv");
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    make_stream(cases[i].devices, 1);
+    int fresh;
+    double table_ns  = bench_table(cases[i].capacity, &fresh);
+    double linear_ns = bench_reference(cases[i].capacity);
+    printf("%8u %8d %12d %14.1f %14.1f\n", cases[i].capacity, cases[i].devices, fresh, table_ns, linear_ns);
+  }
+  return 0;
+}
@@ -0,0 +1,225 @@
+// Known-answer tests and throughput benchmark for the software crypto kernels.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_CYCLES 1
+#endif
+
+#include <libtock/crypto/aes128_software.h>
+#include <libtock/crypto/hmac_sha256_software.h>
+#include <libtock/crypto/sha256_software.h>
+#include <libtock/peripherals/crc_software.h>
+
+#define BENCH_LEN 16384
+
+static int failures = 0;
+
+static void unhex(const char* hex, uint8_t* out) {
+  size_t len = strlen(hex) / 2;
+  for (size_t i = 0; i < len; i++) {
+    unsigned int byte;
+    sscanf(&hex[i * 2], "%2x", &byte);
+    out[i] = byte;
+  }
+}
+
+static void check(const char* what, const uint8_t* got, const char* expected_hex) {
+  uint8_t expected[64];
+  size_t len = strlen(expected_hex) / 2;
+  unhex(expected_hex, expected);
+  if (memcmp(got, expected, len) != 0) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+static void test_sha256(void) {
+  uint8_t digest[32];
+
+  libtock_sha256_software((const uint8_t*) "abc", 3, digest);
+  check("SHA-256 abc", digest, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+  const char* two_blocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+  libtock_sha256_software((const uint8_t*) two_blocks, strlen(two_blocks), digest);
+  check("SHA-256 two blocks", digest, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+  // One million 'a's, fed in uneven chunks to exercise the partial block path.
+  static uint8_t a[1000];
+  memset(a, 'a', sizeof(a));
+  libtock_sha256_software_t ctx;
+  libtock_sha256_software_init(&ctx);
+  size_t left = 1000000;
+  for (size_t step = 1; left > 0; step = (step * 7) % 997 + 1) {
+    size_t n = step < left ? step : left;
+    libtock_sha256_software_update(&ctx, a, n);
+    left -= n;
+  }
+  libtock_sha256_software_finish(&ctx, digest);
+  check("SHA-256 million a", digest, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+static void test_hmac(void) {
+  uint8_t mac[32];
+  uint8_t key[131];
+
+  const char* data = "what do ya want for nothing?";
+  libtock_hmac_sha256_software((const uint8_t*) "Jefe", 4, (const uint8_t*) data, strlen(data), mac);
+  check("HMAC-SHA256 RFC 4231 case 2", mac, "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+
+  // Key longer than one block.
+  memset(key, 0xaa, sizeof(key));
+  const char* large = "Test Using Larger Than Block-Size Key - Hash Key First";
+  libtock_hmac_sha256_software(key, sizeof(key), (const uint8_t*) large, strlen(large), mac);
+  check("HMAC-SHA256 RFC 4231 case 6", mac, "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54");
+}
+
+static void test_aes(void) {
+  libtock_aes128_software_t ctx;
+  uint8_t key[16], iv[16], in[64], out[64];
+
+  // FIPS 197 appendix C.1.
+  unhex("000102030405060708090a0b0c0d0e0f", key);
+  unhex("00112233445566778899aabbccddeeff", in);
+  libtock_aes128_software_init(&ctx, LIBTOCK_AES128_SOFTWARE_ECB, true, key, NULL);
+  libtock_aes128_software_crypt(&ctx, in, out, 16);
+  check("AES-128 ECB encrypt", out, "69c4e0d86a7b0430d8cdb78070b4c55a");
+  libtock_aes128_software_init(&ctx, LIBTOCK_AES128_SOFTWARE_ECB, false, key, NULL);
+  libtock_aes128_software_crypt(&ctx, out, out, 16);
+  check("AES-128 ECB decrypt", out, "00112233445566778899aabbccddeeff");
+
+  // SP 800-38A F.2.1 and F.5.1.
+  const char* plain =
+    "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+    "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710";
+  unhex("2b7e151628aed2a6abf7158809cf4f3c", key);
+  unhex(plain, in);
+
+  unhex("000102030405060708090a0b0c0d0e0f", iv);
+  libtock_aes128_software_init(&ctx, LIBTOCK_AES128_SOFTWARE_CBC, true, key, iv);
+  libtock_aes128_software_crypt(&ctx, in, out, 16);
+  libtock_aes128_software_crypt(&ctx, &in[16], &out[16], 48);
+  check("AES-128 CBC encrypt", out,
+        "7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b2"
+        "73bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7");
+  libtock_aes128_software_init(&ctx, LIBTOCK_AES128_SOFTWARE_CBC, false, key, iv);
+  libtock_aes128_software_crypt(&ctx, out, out, 64);
+  check("AES-128 CBC decrypt", out, plain);
+
+  unhex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff", iv);
+  libtock_aes128_software_init(&ctx, LIBTOCK_AES128_SOFTWARE_CTR, true, key, iv);
+  libtock_aes128_software_crypt(&ctx, in, out, 32);
+  libtock_aes128_software_crypt(&ctx, &in[32], &out[32], 32);
+  check("AES-128 CTR", out,
+        "874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff"
+        "5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee");
+}
+
+static void test_crc(void) {
+  static const struct {
+    libtock_crc_alg_t alg;
+    uint32_t output;
+    const char* input;
+  } cases[] = {
+    { LIBTOCK_CRC_16CCITT, 0x00001541, "ABCDEFG"                        },
+    { LIBTOCK_CRC_16CCITT, 0x0000B881, "01234567ABCDEFGHI"              },
+    { LIBTOCK_CRC_32,      0x0E6F94BC, "ABCDEFG"                        },
+    { LIBTOCK_CRC_32,      0x44050CDA, "A man, a plan, a canal, Panama" },
+    { LIBTOCK_CRC_32C,     0x2C775665, "ABCDEFG"                        },
+    { LIBTOCK_CRC_32C,     0xB5DDEB44, "A man, a plan, a canal, Panama" },
+  };
+
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    uint32_t crc = libtock_crc_software_compute((const uint8_t*) cases[i].input, strlen(cases[i].input),
+                                                cases[i].alg);
+    if (crc != cases[i].output) {
+      printf("FAIL: CRC case %zu: %08x, expected %08x\n", i, crc, cases[i].output);
+      failures++;
+    }
+  }
+}
+
+static double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline unsigned long long now_cycles(void) {
+#ifdef HAVE_CYCLES
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+// Run `op` over BENCH_LEN bytes repeatedly for about 200 ms.
+#define BENCH(label, op)                                                          \
+        do {                                                                      \
+          long iterations = 0;                                                    \
+          double start    = now_seconds();                                        \
+          unsigned long long start_cycles = now_cycles();                         \
+          double elapsed;                                                         \
+          do {                                                                    \
+            op;                                                                   \
+            iterations++;                                                         \
+            elapsed = now_seconds() - start;                                      \
+          } while (elapsed < 0.2);                                                \
+          double bytes = (double) iterations * BENCH_LEN;                         \
+          printf("  %-24s %8.1f MB/s", label, bytes / elapsed / 1e6);              \
+          if (HAVE_CYCLES_VALUE) {                                                \
+            printf(" %8.1f cycles/byte", (now_cycles() - start_cycles) / bytes);  \
+          }                                                                       \
+          printf("\n");                                                           \
+        } while (0)
+
+#ifdef HAVE_CYCLES
+#define HAVE_CYCLES_VALUE 1
+#else
+#define HAVE_CYCLES_VALUE 0
+#endif
+
+int main(void) {
+  test_sha256();
+  test_hmac();
+  test_aes();
+  test_crc();
+  if (failures > 0) {
+    printf("%d checks failed\n", failures);
+    return 1;
+  }
+  printf("All checks passed\n\n");
+
+  uint8_t* data = malloc(BENCH_LEN);
+  for (int i = 0; i < BENCH_LEN; i++) {
+    data[i] = rand();
+  }
+  uint8_t digest[32];
+  static const uint8_t key[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+  static const uint8_t iv[16]  = {0};
+  libtock_aes128_software_t aes;
+  volatile uint32_t sink;
+
+  printf("%d byte buffers\n", BENCH_LEN);
+  BENCH("SHA-256", libtock_sha256_software(data, BENCH_LEN, digest));
+  BENCH("HMAC-SHA256", libtock_hmac_sha256_software(key, sizeof(key), data, BENCH_LEN, digest));
+
+  libtock_aes128_software_init(&aes, LIBTOCK_AES128_SOFTWARE_CTR, true, key, iv);
+  BENCH("AES-128 CTR", libtock_aes128_software_crypt(&aes, data, data, BENCH_LEN));
+  libtock_aes128_software_init(&aes, LIBTOCK_AES128_SOFTWARE_CBC, true, key, iv);
+  BENCH("AES-128 CBC encrypt", libtock_aes128_software_crypt(&aes, data, data, BENCH_LEN));
+  libtock_aes128_software_init(&aes, LIBTOCK_AES128_SOFTWARE_CBC, false, key, iv);
+  BENCH("AES-128 CBC decrypt", libtock_aes128_software_crypt(&aes, data, data, BENCH_LEN));
+
+  BENCH("CRC-32", sink = libtock_crc_software_compute(data, BENCH_LEN, LIBTOCK_CRC_32));
+  BENCH("CRC-32C", sink = libtock_crc_software_compute(data, BENCH_LEN, LIBTOCK_CRC_32C));
+  BENCH("CRC-16 CCITT", sink = libtock_crc_software_compute(data, BENCH_LEN, LIBTOCK_CRC_16CCITT));
+  (void) sink;
+
+  free(data);
+  return 0;
+}
@@ -0,0 +1,233 @@
+// Correctness check and throughput benchmark for the screen blitter.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libtock/display/screen_blit.h>
+
+#define WIDTH  320
+#define HEIGHT 240
+
+static const struct {
+  libtock_screen_format_t format;
+  const char* name;
+} formats[] = {
+  { MONO,      "MONO"      },
+  { RGB_233,   "RGB_233"   },
+  { RGB_565,   "RGB_565"   },
+  { RGB_888,   "RGB_888"   },
+  { ARGB_8888, "ARGB_8888" },
+};
+#define NUM_FORMATS (sizeof(formats) / sizeof(formats[0]))
+
+static int failures = 0;
+
+static double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void surface_alloc(libtock_screen_blit_surface_t* s, libtock_screen_format_t format) {
+  s->width  = WIDTH;
+  s->height = HEIGHT;
+  s->format = format;
+  s->buffer = aligned_alloc(4, (libtock_screen_blit_buffer_size(WIDTH, HEIGHT, format) + 3) & ~3u);
+  memset(s->buffer, 0, libtock_screen_blit_buffer_size(WIDTH, HEIGHT, format));
+}
+
+static void surface_random(libtock_screen_blit_surface_t* s) {
+  size_t len = libtock_screen_blit_buffer_size(s->width, s->height, s->format);
+  for (size_t i = 0; i < len; i++) {
+    s->buffer[i] = rand();
+  }
+}
+
+// Reference pixel access, one pixel at a time.
+static uint32_t ref_get(const libtock_screen_blit_surface_t* s, int x, int y) {
+  size_t i = (size_t) y * s->width + x;
+  switch (s->format) {
+    case MONO:      return (s->buffer[x + (y / 8) * s->width] >> (y % 8)) & 1;
+    case RGB_233:   return s->buffer[i];
+    case RGB_565:   return s->buffer[i * 2] | (s->buffer[i * 2 + 1] << 8);
+    case RGB_888:   return s->buffer[i * 3] | (s->buffer[i * 3 + 1] << 8) | (s->buffer[i * 3 + 2] << 16);
+    case ARGB_8888: return s->buffer[i * 4] | (s->buffer[i * 4 + 1] << 8) | (s->buffer[i * 4 + 2] << 16) |
+                           ((uint32_t) s->buffer[i * 4 + 3] << 24);
+  }
+  return 0;
+}
+
+static void check(bool ok, const char* what, const char* format) {
+  if (!ok) {
+    printf("FAIL: %s (%s)\n", what, format);
+    failures++;
+  }
+}
+
+static void test_fill(libtock_screen_format_t format, const char* name) {
+  libtock_screen_blit_surface_t s;
+  surface_alloc(&s, format);
+  surface_random(&s);
+
+  libtock_screen_blit_surface_t before = s;
+  size_t len = libtock_screen_blit_buffer_size(WIDTH, HEIGHT, format);
+  before.buffer = malloc(len);
+  memcpy(before.buffer, s.buffer, len);
+
+  uint32_t color = libtock_screen_blit_color(format, 0x12, 0xAB, 0xCD);
+  libtock_screen_blit_fill_rect(&s, -3, 5, 37, 19, color);
+
+  bool ok = true;
+  for (int y = 0; y < HEIGHT; y++) {
+    for (int x = 0; x < WIDTH; x++) {
+      bool inside = x < 34 && y >= 5 && y < 24;
+      ok &= ref_get(&s, x, y) == (inside ? color : ref_get(&before, x, y));
+    }
+  }
+  check(ok, "fill_rect", name);
+  free(before.buffer);
+  free(s.buffer);
+}
+
+static void test_copy(libtock_screen_format_t format, const char* name) {
+  libtock_screen_blit_surface_t src, dst;
+  surface_alloc(&src, format);
+  surface_alloc(&dst, format);
+  surface_random(&src);
+
+  libtock_screen_blit_copy_rect(&dst, 10, 3, &src, 7, 11, 101, 45);
+
+  bool ok = true;
+  for (int y = 0; y < 45; y++) {
+    for (int x = 0; x < 101; x++) {
+      ok &= ref_get(&dst, 10 + x, 3 + y) == ref_get(&src, 7 + x, 11 + y);
+    }
+  }
+  check(ok, "copy_rect", name);
+  free(src.buffer);
+  free(dst.buffer);
+}
+
+static void test_convert(libtock_screen_format_t format, const char* name) {
+  // Convert a known color from every format to this one.
+  for (size_t i = 0; i < NUM_FORMATS; i++) {
+    libtock_screen_blit_surface_t src, dst;
+    surface_alloc(&src, formats[i].format);
+    surface_alloc(&dst, format);
+
+    libtock_screen_blit_fill_rect(&src, 0, 0, WIDTH, HEIGHT,
+                                  libtock_screen_blit_color(formats[i].format, 0xFF, 0xFF, 0xFF));
+    libtock_screen_blit_copy_rect(&dst, 0, 0, &src, 0, 0, WIDTH, HEIGHT);
+
+    uint32_t white = libtock_screen_blit_color(format, 0xFF, 0xFF, 0xFF);
+    check(ref_get(&dst, 17, 9) == white && ref_get(&dst, WIDTH - 1, HEIGHT - 1) == white, "convert", name);
+    free(src.buffer);
+    free(dst.buffer);
+  }
+}
+
+static void test_blend(libtock_screen_format_t format, const char* name) {
+  libtock_screen_blit_surface_t src, dst;
+  surface_alloc(&src, ARGB_8888);
+  surface_alloc(&dst, format);
+
+  // Transparent source leaves the destination alone, opaque source replaces it.
+  uint32_t black = libtock_screen_blit_color(format, 0, 0, 0);
+  libtock_screen_blit_fill_rect(&dst, 0, 0, WIDTH, HEIGHT, black);
+  libtock_screen_blit_fill_rect(&src, 0, 0, WIDTH, HEIGHT, 0x00FFFFFF);
+  libtock_screen_blit_fill_rect(&src, 0, 0, 10, 10, 0xFFFFFFFF);
+  libtock_screen_blit_blend_rect(&dst, 0, 0, &src, 0, 0, WIDTH, HEIGHT);
+
+  uint32_t white = libtock_screen_blit_color(format, 0xFF, 0xFF, 0xFF);
+  check(ref_get(&dst, 5, 5) == white && ref_get(&dst, 50, 50) == black, "blend_rect", name);
+  free(src.buffer);
+  free(dst.buffer);
+}
+
+static void test_glyph(libtock_screen_format_t format, const char* name) {
+  // 10x2 glyph: alternating columns on the first row, the second row empty.
+  static const uint8_t glyph[] = { 0xAA, 0x80, 0x00, 0x00 };
+  libtock_screen_blit_surface_t dst;
+  surface_alloc(&dst, format);
+
+  uint32_t color = libtock_screen_blit_color(format, 0xFF, 0xFF, 0xFF);
+  libtock_screen_blit_glyph(&dst, 3, 4, glyph, 10, 2, color);
+
+  bool ok = true;
+  for (int x = 0; x < 10; x++) {
+    ok &= ref_get(&dst, 3 + x, 4) == ((x % 2 == 0) ? color : 0);
+    ok &= ref_get(&dst, 3 + x, 5) == 0;
+  }
+  check(ok, "glyph", name);
+  free(dst.buffer);
+}
+
+// Run `op` repeatedly for about 100 ms and print megapixels per second.
+#define BENCH(label, pixels_per_op, op)                                        \
+        do {                                                                   \
+          long iterations = 0;                                                 \
+          double start    = now_seconds();                                     \
+          double elapsed;                                                      \
+          do {                                                                 \
+            op;                                                                \
+            iterations++;                                                      \
+            elapsed = now_seconds() - start;                                   \
+          } while (elapsed < 0.1);                                             \
+          printf("  %-24s %10.1f MPix/s\n", label,                             \
+                 (double) iterations * (pixels_per_op) / elapsed / 1e6);       \
+        } while (0)
+
+static void bench(libtock_screen_format_t format, const char* name) {
+  libtock_screen_blit_surface_t dst, src, argb;
+  surface_alloc(&dst, format);
+  surface_alloc(&src, format);
+  surface_alloc(&argb, ARGB_8888);
+  surface_random(&src);
+  surface_random(&argb);
+
+  libtock_screen_blit_surface_t rgb565;
+  surface_alloc(&rgb565, RGB_565);
+  surface_random(&rgb565);
+
+  static uint8_t glyph[16 * 2];
+  memset(glyph, 0x5A, sizeof(glyph));
+
+  printf("%s\n", name);
+  BENCH("fill_rect", WIDTH * HEIGHT,
+        libtock_screen_blit_fill_rect(&dst, 0, 0, WIDTH, HEIGHT, (uint32_t) iterations));
+  BENCH("copy_rect", WIDTH * HEIGHT,
+        libtock_screen_blit_copy_rect(&dst, 0, 0, &src, 0, 0, WIDTH, HEIGHT));
+  BENCH("convert from RGB_565", WIDTH * HEIGHT,
+        libtock_screen_blit_copy_rect(&dst, 0, 0, &rgb565, 0, 0, WIDTH, HEIGHT));
+  BENCH("blend from ARGB_8888", WIDTH * HEIGHT,
+        libtock_screen_blit_blend_rect(&dst, 0, 0, &argb, 0, 0, WIDTH, HEIGHT));
+  BENCH("glyph 16x16", 16 * 16,
+        libtock_screen_blit_glyph(&dst, (int) (iterations % (WIDTH - 16)), 8, glyph, 16, 16, 1));
+
+  free(dst.buffer);
+  free(src.buffer);
+  free(argb.buffer);
+  free(rgb565.buffer);
+}
+
+int main(void) {
+  for (size_t i = 0; i < NUM_FORMATS; i++) {
+    test_fill(formats[i].format, formats[i].name);
+    test_copy(formats[i].format, formats[i].name);
+    test_convert(formats[i].format, formats[i].name);
+    test_blend(formats[i].format, formats[i].name);
+    test_glyph(formats[i].format, formats[i].name);
+  }
+  if (failures > 0) {
+    printf("%d checks failed\n", failures);
+    return 1;
+  }
+  printf("All checks passed\n\n");
+
+  for (size_t i = 0; i < NUM_FORMATS; i++) {
+    bench(formats[i].format, formats[i].name);
+  }
+  return 0;
+}
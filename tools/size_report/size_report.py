@@ -0,0 +1,262 @@
+#!/usr/bin/env python3
+
+# Break down the flash and RAM used by a Tock app by library and by symbol.
+#
+# Usage:
+#
+#   size_report.py build/cortex-m4/cortex-m4.Map
+#   size_report.py --baseline size-baseline/cortex-m4.json \
+#       --output build/cortex-m4/cortex-m4.size.json build/cortex-m4/cortex-m4.Map
+#
+# The input is the linker map written next to each ELF. Every input section
+# the linker kept is attributed to the library (archive) and object it came
+# from. Apps are built with `-ffunction-sections -fdata-sections`, so nearly
+# every input section holds a single function or variable, named after the
+# section.
+#
+# With `--baseline`, the report is compared with a report saved by an earlier
+# build and growth is flagged. `--limit` makes the script fail if flash use
+# grew by more than that many bytes, in total or for any one library.
+
+import argparse
+import json
+import os
+import re
+import sys
+
+# Output sections of `userland_generic.ld` stored in flash, and those taking
+# RAM. `.got` and `.data` are in both: they are copied from flash at startup.
+# The stack is left out, as its size is set by `STACK_SIZE` rather than by the
+# code.
+FLASH_SECTIONS = {".crt0_header", ".wfr.app_state", ".text", ".got", ".data"}
+RAM_SECTIONS = {".got", ".data", ".bss"}
+
+# Prefixes of the per-function and per-variable sections, longest first.
+SECTION_PREFIXES = [
+    ".text.startup.",
+    ".text.unlikely.",
+    ".text.hot.",
+    ".data.rel.ro.local.",
+    ".data.rel.ro.",
+    ".data.rel.local.",
+    ".data.rel.",
+    ".srodata.",
+    ".rodata.",
+    ".sdata.",
+    ".sbss.",
+    ".text.",
+    ".data.",
+    ".bss.",
+]
+
+OUTPUT_SECTION = re.compile(r"^(\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?\s*$")
+INPUT_SECTION = re.compile(r"^ (\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+))?$")
+CONTINUATION = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+)$")
+LINKER_DATA = re.compile(r"^\s+0x[0-9a-fA-F]+\s+0x([0-9a-fA-F]+)\s+(LONG|SHORT|BYTE|QUAD)\b")
+FILL = re.compile(r"^ \*fill\*\s+0x[0-9a-fA-F]+\s+0x([0-9a-fA-F]+)")
+ARCHIVE_MEMBER = re.compile(r"^(.*)\((.*)\)$")
+
+LINKER = "(linker)"
+
+
+def origin(path):
+    """Return the library and object an input file path refers to."""
+    m = ARCHIVE_MEMBER.match(path)
+    if m:
+        library = os.path.basename(m.group(1))
+        if library.endswith(".a"):
+            library = library[:-2]
+        return library, m.group(2)
+    if ".ltrans" in path:
+        # Code generated by link-time optimization cannot be traced back to
+        # the library it came from.
+        return "(lto)", os.path.basename(path)
+    if path.endswith(".o"):
+        return "app", os.path.basename(path)
+    return LINKER, path
+
+
+def symbol_name(section, obj):
+    for prefix in SECTION_PREFIXES:
+        if section.startswith(prefix):
+            return section[len(prefix):]
+    # Code and data not split into sections, for example from assembly files
+    # or libraries built without `-ffunction-sections`.
+    return "{} ({})".format(section, obj)
+
+
+def parse_map(path):
+    """Return `{(library, object, symbol): [flash, ram]}` for a map file."""
+    sizes = {}
+
+    def add(library, obj, symbol, size):
+        if size == 0 or output is None:
+            return
+        entry = sizes.setdefault((library, obj, symbol), [0, 0])
+        if output in FLASH_SECTIONS:
+            entry[0] += size
+        if output in RAM_SECTIONS:
+            entry[1] += size
+
+    with open(path, errors="replace") as f:
+        lines = iter(f.read().splitlines())
+
+    # Skip the archive member list, discarded sections and memory map.
+    for line in lines:
+        if line.startswith("Linker script and memory map"):
+            break
+
+    output = None
+    pending = None
+    for line in lines:
+        if pending is not None:
+            # The input section name was too long and the rest of the entry
+            # is on this line.
+            m = CONTINUATION.match(line)
+            if m:
+                library, obj = origin(m.group(3).strip())
+                add(library, obj, symbol_name(pending, obj), int(m.group(2), 16))
+            pending = None
+            continue
+
+        if line.startswith("."):
+            m = OUTPUT_SECTION.match(line)
+            name = m.group(1) if m else None
+            output = name if name in FLASH_SECTIONS or name in RAM_SECTIONS else None
+            continue
+        if output is None or not line.strip():
+            continue
+
+        m = FILL.match(line)
+        if m:
+            add(LINKER, "", "(padding)", int(m.group(1), 16))
+            continue
+        m = LINKER_DATA.match(line)
+        if m:
+            add(LINKER, "", "(linker script data)", int(m.group(1), 16))
+            continue
+        m = INPUT_SECTION.match(line)
+        if m and not m.group(1).startswith("*"):
+            if m.group(2) is None:
+                pending = m.group(1)
+            else:
+                library, obj = origin(m.group(4).strip())
+                add(library, obj, symbol_name(m.group(1), obj), int(m.group(3), 16))
+
+    return sizes
+
+
+def make_report(map_path):
+    sizes = parse_map(map_path)
+    libraries = {}
+    for (library, _, _), (flash, ram) in sizes.items():
+        entry = libraries.setdefault(library, {"flash": 0, "ram": 0})
+        entry["flash"] += flash
+        entry["ram"] += ram
+    symbols = [
+        {"symbol": symbol, "library": library, "object": obj, "flash": flash, "ram": ram}
+        for (library, obj, symbol), (flash, ram) in sizes.items()
+    ]
+    symbols.sort(key=lambda s: (-s["flash"], -s["ram"], s["symbol"]))
+    return {
+        "map": map_path,
+        "flash": sum(l["flash"] for l in libraries.values()),
+        "ram": sum(l["ram"] for l in libraries.values()),
+        "libraries": libraries,
+        "symbols": symbols,
+    }
+
+
+def signed(value):
+    return "{:+d}".format(value) if value else "0"
+
+
+def print_report(report, top):
+    print("Size report for {}".format(report["map"]))
+    print("  {:>8} {:>8}  {}".format("flash", "ram", "library"))
+    for name, lib in sorted(report["libraries"].items(), key=lambda l: -l[1]["flash"]):
+        print("  {:>8} {:>8}  {}".format(lib["flash"], lib["ram"], name))
+    print("  {:>8} {:>8}  total".format(report["flash"], report["ram"]))
+    print()
+    print("  Largest {} symbols:".format(top))
+    for s in report["symbols"][:top]:
+        print("  {:>8} {:>8}  {} [{}]".format(s["flash"], s["ram"], s["symbol"], s["library"]))
+
+
+def compare(report, baseline, top, limit):
+    """Print what changed since `baseline`. Returns False if flash grew by
+    more than `limit` bytes overall or in one library."""
+    ok = True
+
+    def over(growth):
+        return limit is not None and growth > limit
+
+    print()
+    flash = report["flash"] - baseline["flash"]
+    ram = report["ram"] - baseline["ram"]
+    flag = "  !" if over(flash) else ""
+    print("Change since baseline: flash {} ({} -> {}), ram {}{}".format(
+        signed(flash), baseline["flash"], report["flash"], signed(ram), flag))
+    ok = ok and not over(flash)
+
+    names = sorted(set(report["libraries"]) | set(baseline["libraries"]))
+    zero = {"flash": 0, "ram": 0}
+    for name in names:
+        new = report["libraries"].get(name, zero)
+        old = baseline["libraries"].get(name, zero)
+        growth = new["flash"] - old["flash"]
+        if growth == 0 and new["ram"] == old["ram"]:
+            continue
+        flag = "  !" if over(growth) else ""
+        print("  {:>8} {:>8}  {}{}".format(signed(growth), signed(new["ram"] - old["ram"]), name, flag))
+        ok = ok and not over(growth)
+
+    def key(s):
+        return (s["library"], s["object"], s["symbol"])
+
+    old_symbols = {key(s): s for s in baseline["symbols"]}
+    new_symbols = {key(s): s for s in report["symbols"]}
+    changes = []
+    for k in set(old_symbols) | set(new_symbols):
+        new = new_symbols.get(k, zero)
+        old = old_symbols.get(k, zero)
+        if new["flash"] != old["flash"] or new["ram"] != old["ram"]:
+            state = "new" if k not in old_symbols else "removed" if k not in new_symbols else ""
+            changes.append((new["flash"] - old["flash"], new["ram"] - old["ram"], k, state))
+    if changes:
+        changes.sort(key=lambda c: (-abs(c[0]), -abs(c[1]), c[2]))
+        print()
+        print("  Largest symbol changes:")
+        for flash, ram, (library, _, symbol), state in changes[:top]:
+            note = " ({})".format(state) if state else ""
+            print("  {:>8} {:>8}  {} [{}]{}".format(signed(flash), signed(ram), symbol, library, note))
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Per-library and per-symbol size report from a linker map.")
+    parser.add_argument("map", help="linker map file of the app")
+    parser.add_argument("--output", help="save the report as JSON, to use as a later baseline")
+    parser.add_argument("--baseline", help="JSON report to compare with; ignored if it does not exist")
+    parser.add_argument("--limit", type=int, help="fail if flash grew by more than this many bytes")
+    parser.add_argument("--top", type=int, default=20, help="symbols to list (default 20)")
+    args = parser.parse_args()
+
+    report = make_report(args.map)
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(report, f, indent=1, sort_keys=True)
+            f.write("\n")
+
+    print_report(report, args.top)
+
+    ok = True
+    if args.baseline and os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            ok = compare(report, json.load(f), args.top, args.limit)
+    if not ok:
+        sys.exit("Flash use grew by more than {} bytes.".format(args.limit))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,144 @@
+// Host build of the binary logger. Writes a capture that `make check` decodes
+// and compares against the same messages formatted by printf, and measures
+// the cost of a log call against snprintf.
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_CYCLES 1
+#endif
+
+#include <libtock/interface/console.h>
+#include <libtock/services/log.h>
+
+#define ITERATIONS 1000000
+
+// Not used with LIBTOCK_LOG_OUTPUT_MANUAL.
+returncode_t libtock_console_write(__attribute__ ((unused)) const uint8_t* buffer,
+                                   __attribute__ ((unused)) uint32_t len,
+                                   __attribute__ ((unused)) libtock_console_callback_write cb) {
+  return RETURNCODE_ENOSUPPORT;
+}
+
+static uint8_t log_buffer[4096];
+
+static void drain(FILE* f) {
+  const uint8_t* data;
+  uint32_t len;
+  while ((len = libtock_log_peek(&data)) > 0) {
+    if (f != NULL) fwrite(data, 1, len, f);
+    libtock_log_consume(len);
+  }
+}
+
+// Each message is logged and printed with the same arguments.
+#define BOTH(LOG, FMT, ...) do {               \
+          LOG(FMT, __VA_ARGS__);               \
+          fprintf(expected, FMT "\n", __VA_ARGS__); \
+} while (0)
+
+static void write_capture(void) {
+  FILE* capture  = fopen("capture.bin", "wb");
+  FILE* expected = fopen("expected.txt", "w");
+
+  libtock_log_init(log_buffer, sizeof(log_buffer), LIBTOCK_LOG_OUTPUT_MANUAL);
+
+  int temperature = -12;
+  unsigned int millivolts = 3300;
+  const char* name = "sensor0";
+  BOTH(libtock_log_info, "sample %d from %s: %u mV", temperature, name, millivolts);
+  BOTH(libtock_log_warn, "rssi %d, lqi 0x%02x", -87, 0x7fu);
+  BOTH(libtock_log_debug, "uptime %llu us, delta %lld", 123456789012ull, -42ll);
+  BOTH(libtock_log_error, "ratio %.3f, scale %g", 0.125f, 1.5e-3);
+  BOTH(libtock_log_trace, "char %c, padded [%5d] [%-4s]", 'x', 42, "ab");
+  BOTH(libtock_log_info, "100%% done, %s", "ok");
+  libtock_log_info("no arguments");
+  fprintf(expected, "no arguments\n");
+
+  drain(capture);
+  fclose(capture);
+  fclose(expected);
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t cycles(void) {
+#ifdef HAVE_CYCLES
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static void report(const char* what, double seconds, uint64_t cycle_count, uint32_t bytes) {
+  printf("%-24s %7.1f ns/call", what, seconds * 1e9 / ITERATIONS);
+#ifdef HAVE_CYCLES
+  printf(" %7.1f cycles/call", (double) cycle_count / ITERATIONS);
+#else
+  (void) cycle_count;
+#endif
+  printf(" %4lu bytes/call\n", (unsigned long) bytes);
+}
+
+static void benchmark(void) {
+  static char text[128];
+  volatile int value = 1234;
+  const char* name   = "sensor0";
+  // Keeps the compiler from turning snprintf into a string copy.
+  const char* volatile empty = "";
+
+  libtock_log_init(log_buffer, sizeof(log_buffer), LIBTOCK_LOG_OUTPUT_MANUAL);
+
+  // One record, for its size.
+  libtock_log_info("sample %d from %s: %u mV", value, name, 3300u);
+  uint32_t log_bytes = libtock_log_pending();
+  drain(NULL);
+
+  double t = now();
+  uint64_t c = cycles();
+  for (int i = 0; i < ITERATIONS; i++) {
+    libtock_log_info("sample %d from %s: %u mV", value, name, 3300u);
+    drain(NULL);
+  }
+  report("log (3 args)", now() - t, cycles() - c, log_bytes);
+
+  uint32_t printf_bytes = snprintf(text, sizeof(text), "sample %d from %s: %u mV\n", value, name, 3300u);
+  t = now();
+  c = cycles();
+  for (int i = 0; i < ITERATIONS; i++) {
+    snprintf(text, sizeof(text), "sample %d from %s: %u mV\n", value, name, 3300u);
+  }
+  report("snprintf (3 args)", now() - t, cycles() - c, printf_bytes);
+
+  libtock_log_info("link up");
+  log_bytes = libtock_log_pending();
+  drain(NULL);
+  t = now();
+  c = cycles();
+  for (int i = 0; i < ITERATIONS; i++) {
+    libtock_log_info("link up");
+    drain(NULL);
+  }
+  report("log (no args)", now() - t, cycles() - c, log_bytes);
+
+  printf_bytes = snprintf(text, sizeof(text), "link up%s\n", empty);
+  t = now();
+  c = cycles();
+  for (int i = 0; i < ITERATIONS; i++) {
+    snprintf(text, sizeof(text), "link up%s\n", empty);
+  }
+  report("snprintf (no args)", now() - t, cycles() - c, printf_bytes);
+}
+
+int main(void) {
+  write_capture();
+  benchmark();
+  return 0;
+}
@@ -0,0 +1,238 @@
+#!/usr/bin/env python3
+
+# Decode binary log records written by `libtock/services/log.h`.
+#
+# The format strings are not on the device. They are read from the
+# `.tock_log` section of the app's ELF file, which must be the exact build
+# that produced the records.
+#
+# Usage:
+#
+#   tock_log_decode.py build/cortex-m4/cortex-m4.elf < capture.bin
+#   tock_log_decode.py build/cortex-m4/cortex-m4.elf /dev/ttyACM0
+#
+# Records are COBS-encoded and end with a zero byte. Each record is a varint
+# call-site ID followed by the arguments. The ID is the offset of the call
+# site's entry in `.tock_log` divided by four, plus one; ID 0 reports how many
+# records were dropped. An entry is
+#
+#   uint32_t types;   // argument type tags, four bits each, first in the low bits
+#   uint32_t level;
+#   char text[];      // "file:line\0format\0"
+
+import argparse
+import re
+import struct
+import sys
+
+LEVELS = ["TRACE", "DEBUG", "INFO", "WARN", "ERROR"]
+
+ARG_I32 = 1
+ARG_U32 = 2
+ARG_I64 = 3
+ARG_U64 = 4
+ARG_F32 = 5
+ARG_F64 = 6
+ARG_STR = 7
+ARG_PTR = 8
+
+CONVERSION = re.compile(
+    r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|j|z|t|L)?([diouxXeEfFgGaAcspn%])"
+)
+
+
+def read_log_section(path):
+    with open(path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF":
+        sys.exit("{}: not an ELF file".format(path))
+
+    is64 = elf[4] == 2
+    endian = "<" if elf[5] == 1 else ">"
+    if is64:
+        shoff, = struct.unpack_from(endian + "Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", elf, 0x3A)
+        header = endian + "IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from(endian + "I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", elf, 0x2E)
+        header = endian + "IIIIIIIIII"
+
+    sections = [
+        struct.unpack_from(header, elf, shoff + i * shentsize) for i in range(shnum)
+    ]
+    names = sections[shstrndx]
+    for s in sections:
+        name_offset = names[4] + s[0]
+        name = elf[name_offset : elf.index(b"\0", name_offset)]
+        if name == b".tock_log":
+            return elf[s[4] : s[4] + s[5]], endian
+    sys.exit("{}: no .tock_log section; does the app log anything?".format(path))
+
+
+class CallSite:
+    def __init__(self, types, level, location, fmt):
+        self.types = []
+        while types != 0:
+            self.types.append(types & 0xF)
+            types >>= 4
+        self.level = LEVELS[level] if level < len(LEVELS) else str(level)
+        self.location = location
+        self.fmt = fmt
+
+
+class Decoder:
+    def __init__(self, section, endian):
+        self.section = section
+        self.endian = endian
+        self.sites = {}
+
+    def site(self, id):
+        if id not in self.sites:
+            offset = (id - 1) * 4
+            if offset + 8 > len(self.section):
+                return None
+            types, level = struct.unpack_from(self.endian + "II", self.section, offset)
+            location_end = self.section.index(b"\0", offset + 8)
+            fmt_end = self.section.index(b"\0", location_end + 1)
+            location = self.section[offset + 8 : location_end].decode(errors="replace")
+            fmt = self.section[location_end + 1 : fmt_end].decode(errors="replace")
+            self.sites[id] = CallSite(types, level, location, fmt)
+        return self.sites[id]
+
+    def decode(self, record):
+        p = 0
+
+        def varint():
+            nonlocal p
+            value = 0
+            shift = 0
+            while True:
+                byte = record[p]
+                p += 1
+                value |= (byte & 0x7F) << shift
+                shift += 7
+                if byte < 0x80:
+                    return value
+
+        def zigzag(value):
+            return (value >> 1) ^ -(value & 1)
+
+        id = varint()
+        if id == 0:
+            return "[DROPPED] {} records".format(varint())
+
+        site = self.site(id)
+        if site is None:
+            raise ValueError("unknown call site {}".format(id))
+
+        args = []
+        for tag in site.types:
+            if tag in (ARG_I32, ARG_I64):
+                args.append(zigzag(varint()))
+            elif tag in (ARG_U32, ARG_U64, ARG_PTR):
+                args.append(varint())
+            elif tag == ARG_F32:
+                args.append(struct.unpack_from(self.endian + "f", record, p)[0])
+                p += 4
+            elif tag == ARG_F64:
+                args.append(struct.unpack_from(self.endian + "d", record, p)[0])
+                p += 8
+            elif tag == ARG_STR:
+                length = varint()
+                args.append(record[p : p + length].decode(errors="replace"))
+                p += length
+            else:
+                raise ValueError("unknown argument type {}".format(tag))
+
+        return "[{}] {}: {}".format(site.level, site.location, format_c(site.fmt, args))
+
+
+def format_c(fmt, args):
+    args = list(args)
+
+    def next_arg():
+        return args.pop(0) if args else 0
+
+    def convert(m):
+        flags, width, precision, _, conv = m.groups()
+        if conv == "%":
+            return "%"
+        if width == "*":
+            width = str(next_arg())
+        if precision == "*":
+            precision = str(next_arg())
+        spec = "%" + flags + (width or "") + ("." + precision if precision is not None else "")
+        value = next_arg()
+        if conv in "diu":
+            return (spec + "d") % int(value)
+        if conv in "oxX":
+            # C prints negative numbers as their two's complement.
+            value = int(value)
+            if value < 0:
+                value &= (1 << 64) - 1 if value < -(1 << 31) else (1 << 32) - 1
+            return (spec + conv) % value
+        if conv in "eEfFgGaA":
+            return (spec + ("f" if conv in "aA" else conv)) % float(value)
+        if conv == "c":
+            return (spec + "c") % chr(int(value) & 0xFF)
+        if conv == "s":
+            return (spec + "s") % value
+        if conv == "p":
+            return "0x%x" % int(value)
+        return ""
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def cobs_decode(frame):
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if code == 0 or i + code > len(frame):
+            raise ValueError("bad COBS frame")
+        out += frame[i + 1 : i + code]
+        i += code
+        if code != 0xFF and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def frames(stream):
+    pending = bytearray()
+    while True:
+        chunk = stream.read1(4096) if hasattr(stream, "read1") else stream.read(4096)
+        if not chunk:
+            return
+        pending += chunk
+        while True:
+            end = pending.find(b"\0")
+            if end < 0:
+                break
+            yield bytes(pending[:end])
+            del pending[: end + 1]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode libtock binary log records.")
+    parser.add_argument("elf", help="ELF file of the app that wrote the log")
+    parser.add_argument("input", nargs="?", help="captured log or serial device (default: stdin)")
+    parser.add_argument("-v", "--verbose", action="store_true", help="report undecodable records")
+    args = parser.parse_args()
+
+    decoder = Decoder(*read_log_section(args.elf))
+    stream = open(args.input, "rb", buffering=0) if args.input else sys.stdin.buffer
+
+    for frame in frames(stream):
+        if not frame:
+            continue
+        try:
+            print(decoder.decode(cobs_decode(frame)), flush=True)
+        except (ValueError, IndexError, struct.error) as e:
+            if args.verbose:
+                print("[?] {} ({} bytes: {})".format(e, len(frame), frame.hex()), flush=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -5,6 +5,7 @@
 #include <u8g2.h>
 
 #include <libtock-sync/display/screen.h>
+#include <libtock-sync/services/screen_flush.h>
 
 #include "u8g2-tock.h"
 
@@ -17,6 +18,11 @@ static size_t page_size_bytes(u8g2_t* u8g2) {
   return cnt;
 }
 
+// Copy of what is currently on the screen, used to only send the tile rows
+// that changed.
+static uint8_t* shadow_buf = NULL;
+static bool shadow_valid   = false;
+
 // Default display_info struct used to interface with the library. We modify
 // this when we learn about the screen from the kernel.
 static u8x8_display_info_t u8x8_ssd1306_tock =
@@ -72,11 +78,11 @@ static uint8_t u8x8_d_ssd1306_tock(u8x8_t *u8x8,
   return 1;
 }
 
-// Initialize the u8g2 library for Tock use. Call this before using the rest of
-// the library.
-int u8g2_tock_init(u8g2_t *u8g2) {
+// Set up the u8g2 struct with a full screen buffer. Returns the number of
+// bytes in the buffer, or 0 on failure.
+static size_t tock_setup(u8g2_t *u8g2) {
   if (!libtocksync_screen_exists()) {
-    return -1;
+    return 0;
   }
 
   // Since we use syscalls mostly don't need this. Just need to setup
@@ -86,14 +92,56 @@ int u8g2_tock_init(u8g2_t *u8g2) {
   // Allocate the buffer for the screen.
   size_t screen_bytes = (u8g2_GetU8x8(u8g2)->display_info->pixel_width * u8g2_GetU8x8(u8g2)->display_info->pixel_height) / 8;
   if (screen_bytes == 0) {
-    return -1;
+    return 0;
   }
   uint8_t* buf = (uint8_t*) calloc(1, screen_bytes);
+  if (buf == NULL) {
+    return 0;
+  }
 
   // Setup the u8g2 struct.
   uint8_t tile_buf_height = u8g2_GetU8x8(u8g2)->display_info->tile_height;
   u8g2_SetupBuffer(u8g2, buf, tile_buf_height, u8g2_ll_hvline_vertical_top_lsb, U8G2_R0);
 
+  return screen_bytes;
+}
+
+// Initialize the u8g2 library for Tock use. Call this before using the rest of
+// the library.
+int u8g2_tock_init(u8g2_t *u8g2) {
+  if (tock_setup(u8g2) == 0) {
+    return -1;
+  }
+  return 0;
+}
+
+int u8g2_tock_init_double_buffered(u8g2_t *u8g2) {
+  size_t screen_bytes = tock_setup(u8g2);
+  if (screen_bytes == 0) {
+    return -1;
+  }
+
+  // Two transfer buffers, so the app can draw the next frame while the last
+  // one is sent, and the shadow copy of the screen.
+  uint8_t* transfer_a = (uint8_t*) calloc(1, screen_bytes);
+  uint8_t* transfer_b = (uint8_t*) calloc(1, screen_bytes);
+  uint8_t* shadow     = (uint8_t*) calloc(1, screen_bytes);
+  int ret = -1;
+  if (transfer_a != NULL && transfer_b != NULL && shadow != NULL) {
+    ret = libtock_screen_flush_init(transfer_a, transfer_b, screen_bytes, NULL);
+  }
+  if (ret != RETURNCODE_SUCCESS) {
+    free(transfer_a);
+    free(transfer_b);
+    free(shadow);
+    free(u8g2->tile_buf_ptr);
+    u8g2->tile_buf_ptr = NULL;
+    shadow_buf = NULL;
+    return ret;
+  }
+
+  shadow_buf   = shadow;
+  shadow_valid = false;
   return 0;
 }
 
@@ -106,16 +154,56 @@ void u8g2_ClearBuffer(u8g2_t *u8g2) {
   memset(u8g2->tile_buf_ptr, 0, page_size_bytes(u8g2));
 }
 
-// Send entire buffer via Tock syscalls.
+// Send the buffer via Tock syscalls.
+//
+// After `u8g2_tock_init_double_buffered()`, only the tile rows that changed
+// since the last call are sent. The changed rows are copied into a transfer
+// buffer and sent in the background, so this returns without waiting for the
+// screen. Otherwise the whole buffer is sent and this waits for the screen.
 void u8g2_SendBuffer(u8g2_t *u8g2) {
+  const u8x8_display_info_t* info = u8g2_GetU8x8(u8g2)->display_info;
+
+  if (shadow_buf == NULL) {
+    // Set the frame to the entire region.
+    libtocksync_screen_set_frame(0, 0, info->pixel_width, info->pixel_height);
 
-  // Set the frame to the entire region.
-  uint16_t width = u8g2_GetU8x8(u8g2)->display_info->pixel_width;
-  uint16_t height = u8g2_GetU8x8(u8g2)->display_info->pixel_height;
-  libtocksync_screen_set_frame(0, 0, width, height);
+    // Write the data to the screen.
+    libtocksync_screen_write(u8g2->tile_buf_ptr, page_size_bytes(u8g2), page_size_bytes(u8g2));
+    return;
+  }
+
+  // Each tile row is 8 pixels high, one byte per column.
+  size_t row_bytes = info->pixel_width;
+  size_t page_rows = u8g2->tile_buf_height;
+  size_t page_row  = u8g2->tile_curr_row;
+  if (page_row + page_rows > info->tile_height) {
+    page_rows = info->tile_height - page_row;
+  }
+  uint8_t* shadow = shadow_buf + page_row * row_bytes;
 
-  // Write the data to the screen.
-  libtocksync_screen_write(u8g2->tile_buf_ptr, page_size_bytes(u8g2), page_size_bytes(u8g2));
+  size_t first = 0, count = page_rows;
+  if (shadow_valid) {
+    libtock_screen_flush_dirty_rows(shadow, u8g2->tile_buf_ptr, row_bytes, page_rows, &first, &count);
+  }
+  bool end_of_frame = page_row + page_rows >= info->tile_height;
+  if (end_of_frame) {
+    shadow_valid = true;
+  }
+  if (count == 0) return;
+
+  uint8_t* transfer = libtock_screen_flush_back_buffer();
+  libtocksync_screen_flush_wait_buffer(transfer);
+
+  size_t bytes = count * row_bytes;
+  memcpy(transfer, u8g2->tile_buf_ptr + first * row_bytes, bytes);
+  memcpy(shadow + first * row_bytes, transfer, bytes);
+
+  returncode_t ret = libtock_screen_flush_submit(transfer, 0, (page_row + first) * 8, info->pixel_width, count * 8,
+                                                 bytes, end_of_frame);
+  if (ret != RETURNCODE_SUCCESS) {
+    // The screen no longer matches the shadow copy, resend everything.
+    shadow_valid = false;
+  }
 }
 
 
@@ -5,3 +5,11 @@
 // Call in the app that uses the u8g2 library to initialize the library and the
 // u8g2_t object.
 int u8g2_tock_init(u8g2_t *u8g2);
+
+// Like `u8g2_tock_init()`, but send frames in the background and only send the
+// tile rows that changed.
+//
+// This needs three more screen-sized buffers on the heap (two transfer buffers
+// and a copy of what is on the screen), so only use it in apps with the heap to
+// spare.
+int u8g2_tock_init_double_buffered(u8g2_t *u8g2);